@@ -0,0 +1,124 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "KisImagePyramidBenchmark.h"
+
+#include <QTest>
+
+#include <KoColor.h>
+#include <KoColorSpace.h>
+#include <KoColorSpaceRegistry.h>
+
+#include "kis_image.h"
+#include "kis_paint_device.h"
+#include "kis_update_info.h"
+#include "canvas/kis_image_pyramid.h"
+
+/**
+ * Measures the time needed for updating the pyramid of the QPainter
+ * canvas after a dirty rect of a given size has been reported by the
+ * image. The reported time is the time per dirty rect.
+ */
+
+const int IMAGE_WIDTH = 8000;
+const int IMAGE_HEIGHT = 6000;
+const int PYRAMID_HEIGHT = 4;
+
+void KisImagePyramidBenchmark::initTestCase()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    m_image = new KisImage(0, IMAGE_WIDTH, IMAGE_HEIGHT, cs, "pyramid benchmark image");
+
+    KisPaintDeviceSP projection = m_image->projection();
+
+    qsrand(1);
+
+    const int cellSize = 100;
+    KoColor color(cs);
+
+    for (int y = 0; y < IMAGE_HEIGHT; y += cellSize) {
+        for (int x = 0; x < IMAGE_WIDTH; x += cellSize) {
+            color.fromQColor(QColor(qrand() % 256, qrand() % 256, qrand() % 256, qrand() % 256));
+            projection->fill(QRect(x, y, cellSize, cellSize), color);
+        }
+    }
+}
+
+void KisImagePyramidBenchmark::cleanupTestCase()
+{
+    m_image.clear();
+}
+
+static void addDirtyRectRows()
+{
+    QTest::addColumn<QRect>("dirtyRect");
+
+    QTest::newRow("64x64") << QRect(1000, 1000, 64, 64);
+    QTest::newRow("256x256") << QRect(1000, 1000, 256, 256);
+    QTest::newRow("1024x1024") << QRect(1000, 1000, 1024, 1024);
+    QTest::newRow("full-image") << QRect(0, 0, IMAGE_WIDTH, IMAGE_HEIGHT);
+}
+
+void KisImagePyramidBenchmark::benchmarkUpdateDirtyRect_data()
+{
+    addDirtyRectRows();
+}
+
+void KisImagePyramidBenchmark::benchmarkUpdateDirtyRect()
+{
+    QFETCH(QRect, dirtyRect);
+
+    KisImagePyramid pyramid(PYRAMID_HEIGHT);
+    pyramid.setMonitorProfile(m_image->colorSpace()->profile(),
+                              KoColorConversionTransformation::internalRenderingIntent(),
+                              KoColorConversionTransformation::internalConversionFlags());
+    pyramid.setImage(m_image);
+
+    KisPPUpdateInfoSP info = new KisPPUpdateInfo();
+    info->dirtyImageRectVar = dirtyRect;
+
+    QBENCHMARK {
+        pyramid.updateCache(dirtyRect);
+        pyramid.recalculateCache(info);
+    }
+}
+
+void KisImagePyramidBenchmark::benchmarkDownscaledPlanes_data()
+{
+    addDirtyRectRows();
+}
+
+void KisImagePyramidBenchmark::benchmarkDownscaledPlanes()
+{
+    QFETCH(QRect, dirtyRect);
+
+    KisImagePyramid pyramid(PYRAMID_HEIGHT);
+    pyramid.setMonitorProfile(m_image->colorSpace()->profile(),
+                              KoColorConversionTransformation::internalRenderingIntent(),
+                              KoColorConversionTransformation::internalConversionFlags());
+    pyramid.setImage(m_image);
+
+    KisPPUpdateInfoSP info = new KisPPUpdateInfo();
+    info->dirtyImageRectVar = dirtyRect;
+
+    QBENCHMARK {
+        pyramid.recalculateCache(info);
+    }
+}
+
+QTEST_MAIN(KisImagePyramidBenchmark)
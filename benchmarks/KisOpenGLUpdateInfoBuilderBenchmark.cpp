@@ -0,0 +1,120 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "KisOpenGLUpdateInfoBuilderBenchmark.h"
+
+#include <QTest>
+#include <QElapsedTimer>
+
+#include <KoColor.h>
+#include <KoColorSpace.h>
+#include <KoColorSpaceRegistry.h>
+
+#include "kis_paint_device.h"
+#include "kis_sequential_iterator.h"
+#include "kis_update_info.h"
+#include "opengl/KisOpenGLUpdateInfoBuilder.h"
+#include "opengl/kis_texture_tile_info_pool.h"
+
+/**
+ * The benchmark measures only the CPU part of the canvas update: fetching
+ * the projection pixels and converting them into the display color space.
+ * No openGL context is needed.
+ */
+
+namespace {
+
+const int textureSize = 256;
+const int textureBorder = 8;
+
+KisPaintDeviceSP createDevice(const KoColorSpace *cs, const QRect &rc)
+{
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+
+    qsrand(1);
+
+    KoColor color(cs);
+    KisSequentialIterator it(dev, rc);
+    while (it.nextPixel()) {
+        color.fromQColor(QColor(qrand() % 256, qrand() % 256, qrand() % 256, 255));
+        memcpy(it.rawData(), color.data(), cs->pixelSize());
+    }
+
+    return dev;
+}
+
+}
+
+void KisOpenGLUpdateInfoBuilderBenchmark::benchmarkBuildUpdateInfo_data()
+{
+    QTest::addColumn<QSize>("viewportSize");
+    QTest::addColumn<bool>("needsConversion");
+    QTest::addColumn<bool>("useConversionCache");
+
+    QTest::newRow("4k") << QSize(3840, 2160) << false << false;
+    QTest::newRow("4k-conversion") << QSize(3840, 2160) << true << false;
+    QTest::newRow("4k-conversion-cached") << QSize(3840, 2160) << true << true;
+    QTest::newRow("8k") << QSize(7680, 4320) << false << false;
+    QTest::newRow("8k-conversion") << QSize(7680, 4320) << true << false;
+    QTest::newRow("8k-conversion-cached") << QSize(7680, 4320) << true << true;
+}
+
+void KisOpenGLUpdateInfoBuilderBenchmark::benchmarkBuildUpdateInfo()
+{
+    QFETCH(QSize, viewportSize);
+    QFETCH(bool, needsConversion);
+    QFETCH(bool, useConversionCache);
+
+    const QRect rc(QPoint(), viewportSize);
+
+    const KoColorSpace *dstColorSpace = KoColorSpaceRegistry::instance()->rgb8();
+    const KoColorSpace *srcColorSpace =
+        needsConversion ? KoColorSpaceRegistry::instance()->rgb16() : dstColorSpace;
+
+    KisPaintDeviceSP dev = createDevice(srcColorSpace, rc);
+
+    KisTextureTileInfoPoolRegistry poolRegistry;
+    KisTextureTileInfoPoolSP pool = poolRegistry.getPool(textureSize, textureSize);
+
+    KisOpenGLUpdateInfoBuilder builder;
+    builder.setTextureInfoPool(pool);
+    builder.setConversionOptions(
+        ConversionOptions(dstColorSpace,
+                          KoColorConversionTransformation::internalRenderingIntent(),
+                          KoColorConversionTransformation::internalConversionFlags()));
+    builder.setTextureBorder(textureBorder);
+    builder.setEffectiveTextureSize(QSize(textureSize - 2 * textureBorder,
+                                          textureSize - 2 * textureBorder));
+
+    qint64 totalTiles = 0;
+    qint64 totalNanoseconds = 0;
+    QElapsedTimer timer;
+
+    QBENCHMARK {
+        timer.start();
+        KisOpenGLUpdateInfoSP info = builder.buildUpdateInfo(rc, dev, rc, 0, true, useConversionCache);
+        totalNanoseconds += timer.nsecsElapsed();
+        totalTiles += info->tileList.size();
+    }
+
+    if (totalNanoseconds > 0) {
+        qDebug() << "Tiles per second:" << qreal(totalTiles) * 1e9 / totalNanoseconds;
+    }
+}
+
+QTEST_MAIN(KisOpenGLUpdateInfoBuilderBenchmark)
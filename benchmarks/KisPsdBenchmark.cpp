@@ -0,0 +1,131 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "KisPsdBenchmark.h"
+
+#include <QTest>
+
+#include <KoColor.h>
+#include <KoColorSpaceRegistry.h>
+
+#include "KisPart.h"
+#include "KisDocument.h"
+#include "kis_image.h"
+#include "kis_group_layer.h"
+#include "kis_paint_layer.h"
+#include "kis_paint_device.h"
+#include "kis_iterator_ng.h"
+
+namespace {
+
+const int numLayers = 200;
+const QRect imageRect(0, 0, 1000, 1000);
+const QString psdMimeType("image/vnd.adobe.photoshop");
+
+QString benchmarkFileName()
+{
+    return QDir::currentPath() + QDir::separator() + "psd_benchmark.psd";
+}
+
+/**
+ * Every layer gets a few flat rectangles, which are packed well by RLE,
+ * and a strip of noise, which is not
+ */
+void fillLayer(KisPaintDeviceSP dev, int layerIndex)
+{
+    const KoColorSpace *cs = dev->colorSpace();
+
+    for (int i = 0; i < 4; i++) {
+        const QRect rc(qrand() % imageRect.width(), qrand() % imageRect.height(),
+                       50 + qrand() % 300, 50 + qrand() % 300);
+
+        dev->fill(rc & imageRect, KoColor(QColor(qrand() % 256, qrand() % 256, qrand() % 256), cs));
+    }
+
+    const QRect noiseRect(0, (layerIndex * 37) % (imageRect.height() - 64), imageRect.width(), 64);
+
+    KisSequentialIterator it(dev, noiseRect);
+    while (it.nextPixel()) {
+        quint8 *pixel = it.rawData();
+        for (int i = 0; i < 4; i++) {
+            pixel[i] = qrand() % 256;
+        }
+    }
+}
+
+KisImageSP createBenchmarkImage()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisImageSP image = new KisImage(0, imageRect.width(), imageRect.height(), cs, "psd benchmark");
+
+    qsrand(1);
+
+    for (int i = 0; i < numLayers; i++) {
+        KisPaintLayerSP layer = new KisPaintLayer(image, QString("layer %1").arg(i), OPACITY_OPAQUE_U8, cs);
+        fillLayer(layer->paintDevice(), i);
+        image->addNode(layer, image->root());
+    }
+
+    image->initialRefreshGraph();
+
+    return image;
+}
+
+}
+
+void KisPsdBenchmark::initTestCase()
+{
+    QScopedPointer<KisDocument> doc(KisPart::instance()->createDocument());
+    doc->setCurrentImage(createBenchmarkImage());
+    doc->setFileBatchMode(true);
+
+    QVERIFY(doc->exportDocumentSync(QUrl::fromLocalFile(benchmarkFileName()), psdMimeType.toLatin1()));
+}
+
+void KisPsdBenchmark::cleanupTestCase()
+{
+    QFile::remove(benchmarkFileName());
+}
+
+void KisPsdBenchmark::benchmarkExport()
+{
+    QScopedPointer<KisDocument> doc(KisPart::instance()->createDocument());
+    doc->setFileBatchMode(true);
+    QVERIFY(doc->importDocument(QUrl::fromLocalFile(benchmarkFileName())));
+    QCOMPARE(doc->image()->root()->childCount(), numLayers);
+
+    const QString fileName = QDir::currentPath() + QDir::separator() + "psd_benchmark_export.psd";
+
+    QBENCHMARK_ONCE {
+        QVERIFY(doc->exportDocumentSync(QUrl::fromLocalFile(fileName), psdMimeType.toLatin1()));
+    }
+
+    QFile::remove(fileName);
+}
+
+void KisPsdBenchmark::benchmarkImport()
+{
+    QBENCHMARK_ONCE {
+        QScopedPointer<KisDocument> doc(KisPart::instance()->createDocument());
+        doc->setFileBatchMode(true);
+        QVERIFY(doc->importDocument(QUrl::fromLocalFile(benchmarkFileName())));
+        QCOMPARE(doc->image()->root()->childCount(), numLayers);
+    }
+}
+
+QTEST_MAIN(KisPsdBenchmark)
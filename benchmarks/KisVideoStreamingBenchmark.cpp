@@ -0,0 +1,168 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "KisVideoStreamingBenchmark.h"
+
+#include <QTest>
+#include <QProcess>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+
+#include <testutil.h>
+#include "kis_time_range.h"
+#include "dialogs/KisAsyncAnimationFramesSaveDialog.h"
+#include "dialogs/KisAsyncAnimationFramesStreamDialog.h"
+#include "KisAnimationFramesStream.h"
+#include "KisAsyncAnimationFramesStreamingRenderer.h"
+#include "kis_image_animation_interface.h"
+#include "KisPart.h"
+#include "KisDocument.h"
+#include "kis_image.h"
+
+namespace {
+
+KisDocument* loadTestDocument()
+{
+    const QString fileName = TestUtil::fetchDataFileLazy("miloor_turntable_002.kra", true);
+    if (!QFileInfo(fileName).exists()) return 0;
+
+    KisDocument *doc = KisPart::instance()->createDocument();
+    if (!doc->loadNativeFormat(fileName)) {
+        delete doc;
+        return 0;
+    }
+
+    doc->image()->barrierLock();
+    doc->image()->unlock();
+
+    return doc;
+}
+
+qint64 directorySize(const QString &path)
+{
+    qint64 size = 0;
+
+    QDir dir(path);
+    Q_FOREACH (const QFileInfo &info, dir.entryInfoList(QDir::Files)) {
+        size += info.size();
+    }
+
+    return size;
+}
+
+QStringList encoderArgs(const QString &resultFile)
+{
+    return QStringList()
+        << "-c:v" << "libx264"
+        << "-pix_fmt" << "yuv420p"
+        << "-y" << resultFile;
+}
+
+}
+
+void KisVideoStreamingBenchmark::initTestCase()
+{
+    m_ffmpegPath = QStandardPaths::findExecutable("ffmpeg");
+}
+
+void KisVideoStreamingBenchmark::testImageSequenceEncoding()
+{
+    if (m_ffmpegPath.isEmpty()) {
+        QSKIP("ffmpeg is not found in PATH");
+    }
+
+    QScopedPointer<KisDocument> doc(loadTestDocument());
+    QVERIFY(doc);
+
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+
+    const KisTimeRange range = doc->image()->animationInterface()->fullClipRange();
+    const QString resultFile = QDir(tempDir.path()).filePath("result.mp4");
+
+    QElapsedTimer timer;
+    timer.start();
+
+    KisAsyncAnimationFramesSaveDialog dlg(doc->image(), range, QDir(tempDir.path()).filePath("frame.png"), 0, 0);
+    dlg.setBatchMode(true);
+    QCOMPARE(dlg.regenerateRange(0), KisAsyncAnimationFramesSaveDialog::RenderComplete);
+
+    const qint64 renderingTime = timer.elapsed();
+
+    // the peak disk usage is reached when the video is already encoded,
+    // but the sequence is not yet removed
+    QProcess ffmpeg;
+    ffmpeg.start(m_ffmpegPath, QStringList()
+                 << "-r" << "24"
+                 << "-start_number" << QString::number(range.start())
+                 << "-i" << dlg.savedFilesMask()
+                 << encoderArgs(resultFile));
+
+    QVERIFY(ffmpeg.waitForFinished(-1));
+    QCOMPARE(ffmpeg.exitCode(), 0);
+
+    qDebug() << "Image sequence:"
+             << "Rendering:" << renderingTime
+             << "Total time:" << timer.elapsed()
+             << "Peak disk usage:" << directorySize(tempDir.path());
+}
+
+void KisVideoStreamingBenchmark::testStreamingEncoding()
+{
+    if (m_ffmpegPath.isEmpty()) {
+        QSKIP("ffmpeg is not found in PATH");
+    }
+
+    QScopedPointer<KisDocument> doc(loadTestDocument());
+    QVERIFY(doc);
+
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+
+    KisImageSP image = doc->image();
+    const KisTimeRange range = image->animationInterface()->fullClipRange();
+    const QString resultFile = QDir(tempDir.path()).filePath("result.mp4");
+
+    QElapsedTimer timer;
+    timer.start();
+
+    KisAnimationFramesStream stream(range, 2 * QThread::idealThreadCount());
+
+    const QStringList args = QStringList()
+        << "-f" << "rawvideo"
+        << "-pix_fmt" << KisAsyncAnimationFramesStreamingRenderer::pixelFormat()
+        << "-s" << QString("%1x%2").arg(image->width()).arg(image->height())
+        << "-r" << "24"
+        << "-i" << "-"
+        << encoderArgs(resultFile);
+
+    QVERIFY(stream.start(m_ffmpegPath, args, QDir(tempDir.path()).filePath("log_encode.log")));
+
+    KisAsyncAnimationFramesStreamDialog dlg(image, range, &stream);
+    dlg.setBatchMode(true);
+    QCOMPARE(dlg.regenerateRange(0), KisAsyncAnimationFramesStreamDialog::RenderComplete);
+
+    QVERIFY(stream.finish());
+
+    qDebug() << "Streaming:"
+             << "Total time:" << timer.elapsed()
+             << "Peak disk usage:" << directorySize(tempDir.path())
+             << "Piped data:" << stream.bytesWritten();
+}
+
+QTEST_MAIN(KisVideoStreamingBenchmark)
@@ -42,6 +42,7 @@
 
 #include <KoColorSpace.h>
 #include <KoCompositeOp.h>
+#include <KoCompositeOpRegistry.h>
 #include <KoColorSpaceRegistry.h>
 
 #include <KoColorSpaceTraits.h>
@@ -322,13 +323,32 @@ bool compareTwoOpsPixels(QVector<Tile> &tiles, channel_type prec) {
     return true;
 }
 
-bool compareTwoOps(bool haveMask, const KoCompositeOp *op1, const KoCompositeOp *op2)
+/**
+ * Zeroes the mask in spans of 24 pixels, which do not match the
+ * vector size, so both vector and scalar parts of the zero runs
+ * are exercised
+ */
+void makeMaskSparse(quint8 *mask)
+{
+    for (int i = 0; i < numPixels; i++) {
+        if ((i / 24) % 2) {
+            mask[i] = 0;
+        }
+    }
+}
+
+bool compareTwoOps(bool haveMask, const KoCompositeOp *op1, const KoCompositeOp *op2, bool sparseMask = false)
 {
     Q_ASSERT(op1->colorSpace()->pixelSize() == op2->colorSpace()->pixelSize());
     const quint32 pixelSize = op1->colorSpace()->pixelSize();
     const int alignment = 16;
     QVector<Tile> tiles = generateTiles(2, alignment, alignment, ALPHA_RANDOM, ALPHA_RANDOM, op1->colorSpace()->pixelSize());
 
+    if (sparseMask) {
+        makeMaskSparse(tiles[0].mask);
+        makeMaskSparse(tiles[1].mask);
+    }
+
     KoCompositeOp::ParameterInfo params;
     params.dstRowStride  = 4 * rowStride;
     params.srcRowStride  = 4 * rowStride;
@@ -710,6 +730,73 @@ void KisCompositionBenchmark::compareRgbF32OverOps()
     delete opAct;
 }
 
+void KisCompositionBenchmark::compareAlphaDarkenOpsSparseMask()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KoCompositeOp *opAct = KoOptimizedCompositeOpFactory::createAlphaDarkenOp32(cs);
+    KoCompositeOp *opExp = new KoCompositeOpAlphaDarken<KoBgrU8Traits>(cs);
+
+    QVERIFY(compareTwoOps(true, opAct, opExp, true));
+
+    delete opExp;
+    delete opAct;
+}
+
+void KisCompositionBenchmark::compareOverOpsSparseMask()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KoCompositeOp *opAct = KoOptimizedCompositeOpFactory::createOverOp32(cs);
+    KoCompositeOp *opExp = new KoCompositeOpOver<KoBgrU8Traits>(cs);
+
+    QVERIFY(compareTwoOps(true, opAct, opExp, true));
+
+    delete opExp;
+    delete opAct;
+}
+
+void KisCompositionBenchmark::checkGenericOpSkipsTransparentRuns()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    const KoCompositeOp *op = cs->compositeOp(COMPOSITE_MULT);
+
+    QVector<Tile> tiles = generateTiles(1, 0, 0, ALPHA_RANDOM, ALPHA_RANDOM, 4);
+    Tile &tile = tiles.first();
+
+    makeMaskSparse(tile.mask);
+
+    for (int i = 0; i < numPixels; i++) {
+        if ((i / 40) % 3 == 0) {
+            tile.src[4 * i + alpha_pos] = 0;
+        }
+    }
+
+    const QByteArray initialDst((const char*)tile.dst, 4 * numPixels);
+
+    KoCompositeOp::ParameterInfo params;
+    params.dstRowStart   = tile.dst;
+    params.dstRowStride  = 4 * rowStride;
+    params.srcRowStart   = tile.src;
+    params.srcRowStride  = 4 * rowStride;
+    params.maskRowStart  = tile.mask;
+    params.maskRowStride = rowStride;
+    params.rows          = processRect.height();
+    params.cols          = processRect.width();
+    params.opacity       = 0.5;
+    params.flow          = 1.0;
+    params.channelFlags  = QBitArray();
+
+    op->composite(params);
+
+    for (int i = 0; i < numPixels; i++) {
+        if (tile.mask[i] && tile.src[4 * i + alpha_pos]) continue;
+
+        // pixels with zero mask or transparent source must stay untouched
+        QVERIFY(!memcmp(tile.dst + 4 * i, initialDst.constData() + 4 * i, 4));
+    }
+
+    freeTiles(tiles, 0, 0);
+}
+
 void KisCompositionBenchmark::testRgb8CompositeAlphaDarkenLegacy()
 {
     const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
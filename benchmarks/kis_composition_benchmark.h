@@ -46,6 +46,10 @@ private Q_SLOTS:
     void compareOverOpsNoMask();
     void compareRgbF32OverOps();
 
+    void compareAlphaDarkenOpsSparseMask();
+    void compareOverOpsSparseMask();
+    void checkGenericOpSkipsTransparentRuns();
+
     void testRgb8CompositeAlphaDarkenLegacy();
     void testRgb8CompositeAlphaDarkenOptimized();
 
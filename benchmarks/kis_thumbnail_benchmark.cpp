@@ -157,5 +157,27 @@ void KisThumbnailBenchmark::benchmarkCreateThumbnailHiQcreateThumbOversample4x()
     image.save("createThumbnailHiQcreateThumbOversample4x.png");
 }
 
+void KisThumbnailBenchmark::benchmarkCreateThumbnailAfterLocalChange()
+{
+    QImage image;
+
+    KoColor color(m_colorSpace);
+    color.fromQColor(Qt::red);
+
+    // warm up the thumbnail shadow of the device
+    image = m_dev->createThumbnail(4 * THUMBNAIL_WIDTH, 4 * THUMBNAIL_HEIGHT, QRect());
+
+    int i = 0;
+
+    QBENCHMARK{
+        // a dab-sized change, like the one made by a single brush stroke
+        m_dev->fill(QRect(100 + (i++ % 50) * 100, 3000, 100, 100), color);
+        m_dev->setDirty();
+
+        image = m_dev->createThumbnail(4 * THUMBNAIL_WIDTH, 4 * THUMBNAIL_HEIGHT, QRect());
+    }
+
+    image.save("createThumbnailAfterLocalChange.png");
+}
 
 QTEST_MAIN(KisThumbnailBenchmark)
@@ -49,6 +49,8 @@ private Q_SLOTS:
     void benchmarkCreateThumbnailHiQcreateThumbOversample3x();
     void benchmarkCreateThumbnailHiQcreateThumbOversample4x();
 
+    void benchmarkCreateThumbnailAfterLocalChange();
+
 };
 
 
@@ -83,6 +83,41 @@ const Eigen::Matrix<qreal, Eigen::Dynamic, Eigen::Dynamic>* KisConvolutionKernel
     return &(d->data);
 }
 
+bool KisConvolutionKernel::separate(Eigen::Matrix<qreal, Eigen::Dynamic, 1> *vertical,
+                                   Eigen::Matrix<qreal, 1, Eigen::Dynamic> *horizontal) const
+{
+    typedef Eigen::Matrix<qreal, Eigen::Dynamic, Eigen::Dynamic> KernelMatrix;
+
+    const KernelMatrix &m = d->data;
+    if (!m.size()) return false;
+
+    /**
+     * Use the biggest element as a pivot: the kernel has rank 1 iff
+     * it is equal to the product of the pivot's column and row
+     * (with the pivot normalized out)
+     */
+    KernelMatrix::Index pivotRow = 0;
+    KernelMatrix::Index pivotColumn = 0;
+    const qreal pivotAbs = m.cwiseAbs().maxCoeff(&pivotRow, &pivotColumn);
+    if (pivotAbs == 0.0) return false;
+
+    const Eigen::Matrix<qreal, Eigen::Dynamic, 1> v = m.col(pivotColumn) / m(pivotRow, pivotColumn);
+    const Eigen::Matrix<qreal, 1, Eigen::Dynamic> h = m.row(pivotRow);
+
+    const qreal maxError = (m - v * h).cwiseAbs().maxCoeff();
+    if (maxError > 1e-6 * pivotAbs) return false;
+
+    if (vertical) {
+        *vertical = v;
+    }
+
+    if (horizontal) {
+        *horizontal = h;
+    }
+
+    return true;
+}
+
 KisConvolutionKernelSP KisConvolutionKernel::fromQImage(const QImage& image)
 {
     KisConvolutionKernelSP kernel = new KisConvolutionKernel(image.width(), image.height(), 0, 0);
@@ -47,6 +47,20 @@ public:
     Eigen::Matrix<qreal, Eigen::Dynamic, Eigen::Dynamic>& data();
     const Eigen::Matrix<qreal, Eigen::Dynamic, Eigen::Dynamic> * data() const;
 
+    /**
+     * Checks if the kernel is separable, that is, if it can be
+     * represented as a product of a vertical (column) and a horizontal
+     * (row) vectors: K = v * h. Such kernels (e.g. Gaussian or box
+     * blur) can be applied in two 1D passes, which costs O(w + h)
+     * per pixel instead of O(w * h).
+     *
+     * @param vertical if not null, receives the vertical vector
+     * @param horizontal if not null, receives the horizontal vector
+     * @return true if the kernel has rank 1
+     */
+    bool separate(Eigen::Matrix<qreal, Eigen::Dynamic, 1> *vertical = 0,
+                  Eigen::Matrix<qreal, 1, Eigen::Dynamic> *horizontal = 0) const;
+
     static KisConvolutionKernelSP fromQImage(const QImage& image);
     static KisConvolutionKernelSP fromMaskGenerator(KisMaskGenerator *, qreal angle = 0.0);
     static KisConvolutionKernelSP fromMatrix(Eigen::Matrix<qreal, Eigen::Dynamic, Eigen::Dynamic> matrix, qreal offset, qreal factor);
@@ -50,6 +50,7 @@
 
 #include "kis_convolution_worker.h"
 #include "kis_convolution_worker_spatial.h"
+#include "kis_convolution_worker_separable.h"
 
 #include "config_convolution.h"
 
@@ -58,23 +59,61 @@
 #endif
 
 
-bool KisConvolutionPainter::useFFTImplemenation(const KisConvolutionKernelSP kernel) const
+/**
+ * The cost model estimates the number of multiply-add operations
+ * needed per pixel per channel for every engine:
+ *
+ * - spatial worker: kw * kh
+ * - separable worker: kw + kh, but its passes are vectorized, so
+ *   they are counted at half price
+ * - FFT worker: does not depend on the kernel size, approximated by
+ *   a constant, which keeps the original threshold of 5x5 kernels
+ *   for the non-separable case
+ */
+#define FFT_COST_PER_PIXEL 20.0
+#define FFT_THRESHOLD_SIZE 5
+
+KisConvolutionPainter::TestingEnginePreference
+KisConvolutionPainter::chooseEngine(const KisConvolutionKernelSP kernel) const
 {
-    bool result = false;
+    const bool isSeparable = kernel->separate();
+
+    if (m_enginePreference == SPATIAL) {
+        return SPATIAL;
+    } else if (m_enginePreference == SEPARABLE) {
+        return isSeparable ? SEPARABLE : SPATIAL;
+    }
+
+#ifdef HAVE_FFTW3
+    if (m_enginePreference == FFTW) {
+        return FFTW;
+    }
+#endif
+
+    const qreal spatialCost = kernel->width() * kernel->height();
+    const qreal separableCost = isSeparable ?
+        0.5 * (kernel->width() + kernel->height()) : spatialCost;
+
+    TestingEnginePreference engine = separableCost < spatialCost ? SEPARABLE : SPATIAL;
+    const qreal cost = qMin(spatialCost, separableCost);
 
 #ifdef HAVE_FFTW3
-    #define THRESHOLD_SIZE 5
+    if (kernel->width() > FFT_THRESHOLD_SIZE &&
+        kernel->height() > FFT_THRESHOLD_SIZE &&
+        FFT_COST_PER_PIXEL < cost) {
 
-    result =
-        m_enginePreference == FFTW ||
-        (m_enginePreference == NONE &&
-         kernel->width() > THRESHOLD_SIZE &&
-         kernel->height() > THRESHOLD_SIZE);
+        engine = FFTW;
+    }
 #else
-    Q_UNUSED(kernel);
+    Q_UNUSED(cost);
 #endif
 
-    return result;
+    return engine;
+}
+
+bool KisConvolutionPainter::useFFTImplemenation(const KisConvolutionKernelSP kernel) const
+{
+    return chooseEngine(kernel) == FFTW;
 }
 
 template<class factory>
@@ -82,18 +121,21 @@ KisConvolutionWorker<factory>* KisConvolutionPainter::createWorker(const KisConv
                                                                    KisPainter *painter,
                                                                    KoUpdater *progress)
 {
-    KisConvolutionWorker<factory> *worker;
+    KisConvolutionWorker<factory> *worker = 0;
 
+    switch (chooseEngine(kernel)) {
 #ifdef HAVE_FFTW3
-    if (useFFTImplemenation(kernel)) {
+    case FFTW:
         worker = new KisConvolutionWorkerFFT<factory>(painter, progress);
-    } else {
+        break;
+#endif
+    case SEPARABLE:
+        worker = new KisConvolutionWorkerSeparable<factory>(painter, progress);
+        break;
+    default:
         worker = new KisConvolutionWorkerSpatial<factory>(painter, progress);
+        break;
     }
-#else
-    Q_UNUSED(kernel);
-    worker = new KisConvolutionWorkerSpatial<factory>(painter, progress);
-#endif
 
     return worker;
 }
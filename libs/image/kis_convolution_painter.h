@@ -79,6 +79,7 @@ protected:
     enum TestingEnginePreference {
         NONE,
         SPATIAL,
+        SEPARABLE,
         FFTW
     };
 
@@ -94,6 +95,13 @@ private:
 
      bool useFFTImplemenation(const KisConvolutionKernelSP kernel) const;
 
+     /**
+      * Chooses the cheapest engine for the kernel using a simple cost
+      * model (see the implementation). SEPARABLE is returned only for
+      * rank 1 kernels, FFTW only if it is available.
+      */
+     TestingEnginePreference chooseEngine(const KisConvolutionKernelSP kernel) const;
+
 private:
     TestingEnginePreference m_enginePreference;
 };
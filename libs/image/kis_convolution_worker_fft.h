@@ -28,24 +28,132 @@
 #include "kis_math_toolbox.h"
 
 #include <QMutex>
+#include <QMutexLocker>
+#include <QSharedPointer>
 #include <QVector>
 #include <QTextStream>
 #include <QFile>
 #include <QDir>
+#include <QtConcurrent>
 
 #include <fftw3.h>
 
+/**
+ * A pair of in-place FFTW plans for a specific size of the
+ * transform. The plans are created and destroyed under fftwMutex,
+ * but executing them with fftw_execute_dft_*() is thread-safe, so
+ * the same pair is shared by all the tiles and all the workers.
+ */
+struct KisFFTWPlans
+{
+    fftw_plan forward;
+    fftw_plan backward;
+};
+
+typedef QSharedPointer<KisFFTWPlans> KisFFTWPlansSP;
+
 template<class _IteratorFactory_> class KisConvolutionWorkerFFT;
 class KisConvolutionWorkerFFTLock
 {
+private:
+    struct PlanKey {
+        quint32 height;
+        quint32 width;
+
+        bool operator==(const PlanKey &rhs) const {
+            return height == rhs.height && width == rhs.width;
+        }
+    };
+
+    struct CachedPlans {
+        PlanKey key;
+        KisFFTWPlansSP plans;
+    };
+
+    /**
+     * The most recently used plans are kept in the cache, so that
+     * the blur filters, which are usually applied many times with
+     * the same kernel, do not pay for planning on every call.
+     *
+     * The tile size depends on the processed area, so new sizes
+     * appear often. Planning is done with FFTW_ESTIMATE, because
+     * FFTW_MEASURE would block all the FFT workers on the mutex for
+     * the duration of the measurement.
+     */
+    static const int maxCachedPlans = 16;
+
+    static KisFFTWPlansSP fetchPlans(quint32 height, quint32 width)
+    {
+        const PlanKey key = {height, width};
+
+        // evicted plans should be destroyed after the mutex is unlocked
+        KisFFTWPlansSP evictedPlans;
+        QMutexLocker l(&fftwMutex);
+
+        for (int i = 0; i < planCache.size(); i++) {
+            if (planCache[i].key == key) {
+                planCache.move(i, 0);
+                return planCache.first().plans;
+            }
+        }
+
+        const quint32 length = height * (width / 2 + 1);
+
+        /**
+         * The plans are executed on the buffers of the tiles, which
+         * are allocated with fftw_malloc() as well, so plan on a
+         * scratch buffer with the same alignment
+         */
+        fftw_complex *scratch = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * length);
+
+        KisFFTWPlansSP plans(new KisFFTWPlans, &destroyPlans);
+        plans->forward = fftw_plan_dft_r2c_2d(height, width, (double*)scratch, scratch, FFTW_ESTIMATE);
+        plans->backward = fftw_plan_dft_c2r_2d(height, width, scratch, (double*)scratch, FFTW_ESTIMATE);
+
+        fftw_free(scratch);
+
+        CachedPlans item = {key, plans};
+        planCache.prepend(item);
+
+        if (planCache.size() > maxCachedPlans) {
+            evictedPlans = planCache.takeLast().plans;
+        }
+
+        return plans;
+    }
+
+    static void destroyPlans(KisFFTWPlans *plans)
+    {
+        QMutexLocker l(&fftwMutex);
+        fftw_destroy_plan(plans->forward);
+        fftw_destroy_plan(plans->backward);
+        delete plans;
+    }
+
 private:
     static QMutex fftwMutex;
+    static QList<CachedPlans> planCache;
     template<class _IteratorFactory_> friend class KisConvolutionWorkerFFT;
 };
 
 QMutex KisConvolutionWorkerFFTLock::fftwMutex;
+QList<KisConvolutionWorkerFFTLock::CachedPlans> KisConvolutionWorkerFFTLock::planCache;
 
 
+/**
+ * The FFT convolution worker splits the processed area into tiles of
+ * the same size. Every tile is convolved independently in the
+ * overlap-save manner: it reads its own source rect with a margin of
+ * the kernel size, so the overlapping parts never need to be summed
+ * up. All the tiles share the FFTW plans and the spectrum of the
+ * kernel, and the tiles of one row (band) are processed in parallel.
+ *
+ * The source and the destination devices may be the same device,
+ * therefore the results of a band are written to the device only
+ * after the next band has read its source. It means that only two
+ * bands of the results and a few FFT buffers per thread are kept in
+ * memory at any moment.
+ */
 template<class _IteratorFactory_>
 class KisConvolutionWorkerFFT : public KisConvolutionWorker<_IteratorFactory_>
 {
@@ -53,7 +161,8 @@ public:
     KisConvolutionWorkerFFT(KisPainter *painter, KoUpdater *progress)
         : KisConvolutionWorker<_IteratorFactory_>(painter, progress),
           m_currentProgress(0),
-          m_kernelFFT(0)
+          m_kernelFFT(0),
+          m_plans(0)
     {
     }
 
@@ -61,6 +170,41 @@ public:
     {
     }
 
+    struct TileJob {
+        // the tile in the destination coordinates
+        QRect tileRect;
+        // the part of the tile that belongs to the processed area
+        QRect writeRect;
+        // the resulting pixels of writeRect
+        QByteArray result;
+    };
+
+    struct FFTInfo;
+
+    struct TileProcessor {
+        TileProcessor(KisConvolutionWorkerFFT *_worker,
+                      KisPaintDeviceSP _src,
+                      const QPoint &_srcOffset,
+                      const FFTInfo &_info,
+                      const QRect &_dataRect)
+            : worker(_worker),
+              src(_src),
+              srcOffset(_srcOffset),
+              info(_info),
+              dataRect(_dataRect)
+        {
+        }
+
+        inline void operator() (TileJob &job) {
+            worker->processTile(job, src, srcOffset, info, dataRect);
+        }
+
+        KisConvolutionWorkerFFT *worker;
+        KisPaintDeviceSP src;
+        QPoint srcOffset;
+        const FFTInfo &info;
+        QRect dataRect;
+    };
 
     virtual void execute(const KisConvolutionKernelSP kernel, const KisPaintDeviceSP src, QPoint srcPos, QPoint dstPos, QSize areaSize, const QRect& dataRect)
     {
@@ -79,91 +223,86 @@ public:
         addToProgress(0);
         if (isInterrupted()) return;
 
-        const quint32 halfKernelWidth = (kernel->width() - 1) / 2;
-        const quint32 halfKernelHeight = (kernel->height() - 1) / 2;
+        m_halfKernelWidth = (kernel->width() - 1) / 2;
+        m_halfKernelHeight = (kernel->height() - 1) / 2;
 
-        m_fftWidth = areaSize.width() + 4 * halfKernelWidth;
-        m_fftHeight = areaSize.height() + 2 * halfKernelHeight;
+        quint32 tileSizeX, tileSizeY;
+        calculateTileSize(areaSize.width(), kernel->width(), 4 * m_halfKernelWidth, &tileSizeX, &m_fftWidth);
+        calculateTileSize(areaSize.height(), kernel->height(), 2 * m_halfKernelHeight, &tileSizeY, &m_fftHeight);
 
-        /**
-         * FIXME: check whether this "optimization" is needed to
-         * be uncommented. My tests showed about 30% better performance
-         * when the line is commented out (DK).
-         */
-        //optimumDimensions(m_fftWidth, m_fftHeight);
+        const int tileWidth = tileSizeX;
+        const int tileHeight = tileSizeY;
 
         m_fftLength = m_fftHeight * (m_fftWidth / 2 + 1);
         m_extraMem = (m_fftWidth % 2) ? 1 : 2;
 
+        const int numTilesX = (areaSize.width() + tileWidth - 1) / tileWidth;
+        const int numTilesY = (areaSize.height() + tileHeight - 1) / tileHeight;
+
+        /**
+         * The plans are single-threaded: the worker is usually called
+         * from a job of the updater, which already keeps all the cores
+         * busy, and the tiles of a band are processed in parallel anyway.
+         */
+        KisFFTWPlansSP plans = KisConvolutionWorkerFFTLock::fetchPlans(m_fftHeight, m_fftWidth);
+        m_plans = plans.data();
+
         // create and fill kernel
         m_kernelFFT = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * m_fftLength);
         memset(m_kernelFFT, 0, sizeof(fftw_complex) * m_fftLength);
         fftFillKernelMatrix(kernel, m_kernelFFT);
 
+        fftw_execute_dft_r2c(m_plans->forward, (double*)m_kernelFFT, m_kernelFFT);
+
+        addToProgress(10);
+        if (isInterrupted()) return;
+
         // find out which channels need convolving
         QList<KoChannelInfo*> convChannelList = this->convolvableChannelList(src);
 
-        m_channelFFT.resize(convChannelList.count());
-        for (auto i = m_channelFFT.begin(); i != m_channelFFT.end(); ++i) {
-            *i = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * m_fftLength);
-        }
-
         const double kernelFactor = kernel->factor() ? kernel->factor() : 1;
         const double fftScale = 1.0 / (m_fftHeight * m_fftWidth) / kernelFactor;
 
         FFTInfo info (fftScale, convChannelList, kernel, this->m_painter->device()->colorSpace());
-        int cacheRowStride = m_fftWidth + m_extraMem;
+        TileProcessor processor(this, src, srcPos - dstPos, info, dataRect);
 
-        fillCacheFromDevice(src,
-                            QRect(srcPos.x() - halfKernelWidth,
-                                  srcPos.y() - halfKernelHeight,
-                                  m_fftWidth,
-                                  m_fftHeight),
-                            cacheRowStride,
-                            info, dataRect);
-
-        addToProgress(10);
-        if (isInterrupted()) return;
-
-        // calculate number off fft operations required for progress reporting
-        const float progressPerFFT = (100 - 30) / (double)(convChannelList.count() * 2 + 1);
+        const QRect applyRect(dstPos, areaSize);
+        const float progressPerBand = 80.0 / numTilesY;
 
-        // perform FFT
-        fftw_plan fftwPlanForward, fftwPlanBackward;
+        QVector<TileJob> pendingBand;
 
-        KisConvolutionWorkerFFTLock::fftwMutex.lock();
-        fftwPlanForward = fftw_plan_dft_r2c_2d(m_fftHeight, m_fftWidth, (double*)m_kernelFFT, m_kernelFFT, FFTW_ESTIMATE);
-        fftwPlanBackward = fftw_plan_dft_c2r_2d(m_fftHeight, m_fftWidth, m_kernelFFT, (double*)m_kernelFFT, FFTW_ESTIMATE);
-        KisConvolutionWorkerFFTLock::fftwMutex.unlock();
+        for (int tileY = 0; tileY < numTilesY; tileY++) {
+            QVector<TileJob> band(numTilesX);
 
-        fftw_execute(fftwPlanForward);
-        addToProgress(progressPerFFT);
-        if (isInterrupted()) return;
+            for (int tileX = 0; tileX < numTilesX; tileX++) {
+                TileJob &job = band[tileX];
+                job.tileRect = QRect(dstPos.x() + tileX * tileWidth,
+                                     dstPos.y() + tileY * tileHeight,
+                                     tileWidth, tileHeight);
+                job.writeRect = job.tileRect & applyRect;
+            }
 
-        for (auto k = m_channelFFT.begin(); k != m_channelFFT.end(); ++k)
-        {
-            fftw_execute_dft_r2c(fftwPlanForward, (double*)(*k), *k);
-            addToProgress(progressPerFFT);
-            if (isInterrupted()) return;
+            if (band.size() > 1) {
+                QtConcurrent::blockingMap(band, processor);
+            } else {
+                processor(band.first());
+            }
 
-            fftMultiply(*k, m_kernelFFT);
+            /**
+             * The band has read all its source, including the margin
+             * overlapping the previous band, so it is safe to write the
+             * results of the previous band now.
+             */
+            writeBandToDevice(pendingBand);
+            pendingBand = band;
 
-            fftw_execute_dft_c2r(fftwPlanBackward, *k, (double*)*k);
-            addToProgress(progressPerFFT);
+            addToProgress(progressPerBand);
             if (isInterrupted()) return;
         }
 
-        KisConvolutionWorkerFFTLock::fftwMutex.lock();
-        fftw_destroy_plan(fftwPlanForward);
-        fftw_destroy_plan(fftwPlanBackward);
-        KisConvolutionWorkerFFTLock::fftwMutex.unlock();
-
+        writeBandToDevice(pendingBand);
 
-        writeResultToDevice(QRect(dstPos.x(), dstPos.y(), areaSize.width(), areaSize.height()),
-                            cacheRowStride, halfKernelWidth, halfKernelHeight,
-                            info, dataRect);
-
-        addToProgress(20);
+        addToProgress(10);
         cleanUp();
     }
 
@@ -218,8 +357,57 @@ public:
         int alphaRealPos;
     };
 
+    /**
+     * Convolves a single tile. Called concurrently for all the tiles
+     * of a band, so it must not modify the state of the worker.
+     */
+    void processTile(TileJob &job,
+                     KisPaintDeviceSP src,
+                     const QPoint &srcOffset,
+                     const FFTInfo &info,
+                     const QRect &dataRect) {
+
+        QVector<fftw_complex*> channelFFT(info.numChannels());
+        for (auto i = channelFFT.begin(); i != channelFFT.end(); ++i) {
+            *i = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * m_fftLength);
+        }
+
+        const int cacheRowStride = m_fftWidth + m_extraMem;
+
+        fillCacheFromDevice(src,
+                            QRect(job.tileRect.x() + srcOffset.x() - m_halfKernelWidth,
+                                  job.tileRect.y() + srcOffset.y() - m_halfKernelHeight,
+                                  m_fftWidth,
+                                  m_fftHeight),
+                            channelFFT,
+                            cacheRowStride,
+                            info, dataRect);
+
+        for (auto k = channelFFT.begin(); k != channelFFT.end(); ++k) {
+            fftw_execute_dft_r2c(m_plans->forward, (double*)(*k), *k);
+            fftMultiply(*k, m_kernelFFT);
+            fftw_execute_dft_c2r(m_plans->backward, *k, (double*)*k);
+        }
+
+        writeResultToBuffer(job, channelFFT, cacheRowStride, info);
+
+        Q_FOREACH (fftw_complex *channel, channelFFT) {
+            fftw_free(channel);
+        }
+    }
+
+    void writeBandToDevice(QVector<TileJob> &band) {
+        KisPaintDeviceSP dst = this->m_painter->device();
+
+        for (auto it = band.begin(); it != band.end(); ++it) {
+            dst->writeBytes((const quint8*)it->result.constData(), it->writeRect);
+            it->result.clear();
+        }
+    }
+
     void fillCacheFromDevice(KisPaintDeviceSP src,
                              const QRect &rect,
+                             const QVector<fftw_complex*> &channelFFT,
                              const int cacheRowStride,
                              const FFTInfo &info,
                              const QRect &dataRect) {
@@ -234,7 +422,7 @@ public:
         const auto channelPtrBegin = channelPtr.begin();
         const auto channelPtrEnd = channelPtr.end();
 
-        auto iFFt = m_channelFFT.constBegin();
+        auto iFFt = channelFFT.constBegin();
         for (auto i = channelPtrBegin; i != channelPtrEnd; ++i, ++iFFt) {
             *i = (double*)*iFFt;
         }
@@ -308,26 +496,30 @@ public:
         return channelPixelValue;
     }
 
-    void writeResultToDevice(const QRect &rect,
+    void writeResultToBuffer(TileJob &job,
+                             const QVector<fftw_complex*> &channelFFT,
                              const int cacheRowStride,
-                             const int halfKernelWidth,
-                             const int halfKernelHeight,
-                             const FFTInfo &info,
-                             const QRect &dataRect) {
+                             const FFTInfo &info) {
+
+        const QRect &rect = job.writeRect;
+        const KisPaintDeviceSP dst = this->m_painter->device();
+        const int pixelSize = dst->pixelSize();
 
-        typename _IteratorFactory_::HLineIterator hitDst =
-            _IteratorFactory_::createHLineIterator(this->m_painter->device(),
-                                                   rect.x(), rect.y(), rect.width(),
-                                                   dataRect);
+        job.result.resize(rect.width() * rect.height() * pixelSize);
+        quint8 *dstPtr = (quint8*)job.result.data();
 
-        int initialOffset = cacheRowStride * halfKernelHeight + halfKernelWidth;
+        // keep the values of the channels that are not convolved
+        dst->readBytes(dstPtr, rect);
+
+        const QPoint tileOffset = rect.topLeft() - job.tileRect.topLeft();
+        const int initialOffset = cacheRowStride * (m_halfKernelHeight + tileOffset.y()) + m_halfKernelWidth + tileOffset.x();
 
         const int channelCount = info.numChannels();
         QVector<double*> channelPtr(channelCount);
         const auto channelPtrBegin = channelPtr.begin();
         const auto channelPtrEnd = channelPtr.end();
 
-        auto iFFt = m_channelFFT.constBegin();
+        auto iFFt = channelFFT.constBegin();
         for (auto i = channelPtrBegin; i != channelPtrEnd; ++i, ++iFFt) {
             *i = (double*)*iFFt + initialOffset;
         }
@@ -341,8 +533,6 @@ public:
             memcpy(cacheRowStart.data(), channelPtr.data(), channelCount * sizeof(double*));
 
             for (int x = 0; x < rect.width(); ++x) {
-                quint8 *dstPtr = hitDst->rawData();
-
                 if (info.alphaCachePos >= 0) {
                     qreal alphaValue =
                         writeOneChannelFromCache<false>(dstPtr,
@@ -386,15 +576,13 @@ public:
                     }
                 }
 
-                hitDst->nextPixel();
+                dstPtr += pixelSize;
             }
 
             auto iRowStart = cacheRowStartBegin;
             for (auto i = channelPtrBegin; i != channelPtrEnd; ++i, ++iRowStart) {
                 *i = *iRowStart + cacheRowStride;
             }
-
-            hitDst->nextRow();
         }
 
     }
@@ -448,26 +636,40 @@ private:
         }
     }
 
-    void optimumDimensions(quint32& w, quint32& h)
+    static quint32 nextSmoothSize(quint32 size)
     {
-        // FFTW is most efficient when array size is a factor of 2, 3, 5 or 7
-        quint32 optW = w, optH = h;
+        // FFTW is most efficient when the size is a product of 2, 3, 5 and 7
+        for (;; size++) {
+            quint32 value = size;
 
-        while ((optW % 2 != 0) || (optW % 3 != 0) || (optW % 5 != 0) || (optW % 7 != 0))
-            ++optW;
+            while (value % 2 == 0) value /= 2;
+            while (value % 3 == 0) value /= 3;
+            while (value % 5 == 0) value /= 5;
+            while (value % 7 == 0) value /= 7;
 
-        while ((optH % 2 != 0) || (optH % 3 != 0) || (optH % 5 != 0) || (optH % 7 != 0))
-            ++optH;
+            if (value == 1) return size;
+        }
+    }
 
-        quint32 optAreaW = optW * h;
-        quint32 optAreaH = optH * w;
+    /**
+     * Calculates the size of a tile and of its FFT along one axis.
+     * The tiles should be big enough to make the overhead of the
+     * kernel margin small, so the tile is never smaller than twice
+     * the kernel. The area that is not much bigger than one tile is
+     * not split at all.
+     */
+    static void calculateTileSize(quint32 areaSize, quint32 kernelSize, quint32 margin,
+                                  quint32 *tileSize, quint32 *fftSize)
+    {
+        const quint32 preferredTileSize = 512;
 
-        if (optAreaW < optAreaH) {
-            w = optW;
-        }
-        else {
-            h = optH;
+        quint32 size = qMax(preferredTileSize, 2 * kernelSize);
+        if (areaSize <= size + size / 2) {
+            size = areaSize;
         }
+
+        *fftSize = nextSmoothSize(size + margin);
+        *tileSize = *fftSize - margin;
     }
 
     void fftLogMatrix(double* channel, const QString &f)
@@ -523,19 +725,18 @@ private:
         // free kernel fft data
         if (m_kernelFFT) {
             fftw_free(m_kernelFFT);
+            m_kernelFFT = 0;
         }
 
-        Q_FOREACH (fftw_complex *channel, m_channelFFT) {
-            fftw_free(channel);
-        }
-        m_channelFFT.clear();
+        m_plans = 0;
     }
 private:
     quint32 m_fftWidth, m_fftHeight, m_fftLength, m_extraMem;
+    int m_halfKernelWidth, m_halfKernelHeight;
     float m_currentProgress;
 
     fftw_complex* m_kernelFFT;
-    QVector<fftw_complex*> m_channelFFT;
+    KisFFTWPlans *m_plans;
 };
 
 #endif
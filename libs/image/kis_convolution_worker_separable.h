@@ -0,0 +1,342 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KIS_CONVOLUTION_WORKER_SEPARABLE_H
+#define KIS_CONVOLUTION_WORKER_SEPARABLE_H
+
+#include <algorithm>
+#include <QVector>
+
+#include "kis_assert.h"
+#include "kis_convolution_worker.h"
+#include "kis_convolution_kernel.h"
+#include "kis_math_toolbox.h"
+
+/**
+ * A convolution worker for separable (rank 1) kernels. The kernel is
+ * split into a horizontal and a vertical vectors and applied in two
+ * 1D passes, which costs O(kw + kh) per pixel instead of O(kw * kh)
+ * of the spatial worker.
+ *
+ * The source is read row by row exactly once. Every row is unpacked
+ * into per-channel planes of doubles and filtered horizontally. The
+ * last kh filtered rows are kept in a ring buffer, which is filtered
+ * vertically to get one destination row. All the inner loops walk
+ * over contiguous planes, so the compiler can vectorize them.
+ *
+ * The color math (premultiplication by alpha, factor, offset and
+ * clamping) is exactly the same as in KisConvolutionWorkerSpatial.
+ */
+template <class _IteratorFactory_>
+class KisConvolutionWorkerSeparable : public KisConvolutionWorker<_IteratorFactory_>
+{
+public:
+    KisConvolutionWorkerSeparable(KisPainter *painter, KoUpdater *progress)
+        : KisConvolutionWorker<_IteratorFactory_>(painter, progress)
+        , m_alphaCachePos(-1)
+        , m_alphaRealPos(-1)
+    {
+    }
+
+    ~KisConvolutionWorkerSeparable() override {
+    }
+
+    void execute(const KisConvolutionKernelSP kernel, const KisPaintDeviceSP src, QPoint srcPos, QPoint dstPos, QSize areaSize, const QRect& dataRect) override {
+        Eigen::Matrix<qreal, Eigen::Dynamic, 1> vertical;
+        Eigen::Matrix<qreal, 1, Eigen::Dynamic> horizontal;
+
+        const bool isSeparable = kernel->separate(&vertical, &horizontal);
+        KIS_SAFE_ASSERT_RECOVER_RETURN(isSeparable);
+
+        const int kw = horizontal.size();
+        const int kh = vertical.size();
+        const int khalfWidth = (kw - 1) / 2;
+        const int khalfHeight = (kh - 1) / 2;
+
+        /**
+         * The spatial worker multiplies the cache by a reversed
+         * kernel, so store the taps in the reversed order as well
+         */
+        m_horizontalTaps.resize(kw);
+        for (int i = 0; i < kw; i++) {
+            m_horizontalTaps[i] = horizontal(kw - i - 1);
+        }
+
+        m_verticalTaps.resize(kh);
+        for (int i = 0; i < kh; i++) {
+            m_verticalTaps[i] = vertical(kh - i - 1);
+        }
+
+        // Make the area we cover as small as possible
+        if (this->m_painter->selection()) {
+            QRect r = this->m_painter->selection()->selectedRect().intersected(QRect(srcPos, areaSize));
+            dstPos += r.topLeft() - srcPos;
+            srcPos = r.topLeft();
+            areaSize = r.size();
+        }
+
+        if (areaSize.width() == 0 || areaSize.height() == 0)
+            return;
+
+        m_convChannelList = this->convolvableChannelList(src);
+        m_convolveChannelsNo = m_convChannelList.count();
+
+        for (int i = 0; i < m_convChannelList.size(); i++) {
+            if (m_convChannelList[i]->channelType() == KoChannelInfo::ALPHA) {
+                m_alphaCachePos = i;
+                m_alphaRealPos = m_convChannelList[i]->pos();
+            }
+        }
+
+        KisMathToolbox mathToolbox;
+        m_toDoubleFuncPtr = QVector<PtrToDouble>(m_convolveChannelsNo);
+        if (!mathToolbox.getToDoubleChannelPtr(m_convChannelList, m_toDoubleFuncPtr))
+            return;
+
+        m_fromDoubleFuncPtr = QVector<PtrFromDouble>(m_convolveChannelsNo);
+        if (!mathToolbox.getFromDoubleChannelPtr(m_convChannelList, m_fromDoubleFuncPtr))
+            return;
+
+        m_kernelFactor = kernel->factor() ? 1.0 / kernel->factor() : 1;
+        m_minClamp.resize(m_convolveChannelsNo);
+        m_maxClamp.resize(m_convolveChannelsNo);
+        m_absoluteOffset.resize(m_convolveChannelsNo);
+        for (int i = 0; i < m_convolveChannelsNo; ++i) {
+            m_minClamp[i] = mathToolbox.minChannelValue(m_convChannelList[i]);
+            m_maxClamp[i] = mathToolbox.maxChannelValue(m_convChannelList[i]);
+            m_absoluteOffset[i] = (m_maxClamp[i] - m_minClamp[i]) * kernel->offset();
+        }
+
+        const int width = areaSize.width();
+        const int srcRowWidth = width + kw - 1;
+        const int pixelSize = src->colorSpace()->pixelSize();
+
+        // per-channel planes of one source row
+        m_srcRow.resize(m_convolveChannelsNo * srcRowWidth);
+        // ring buffer of kh horizontally filtered rows
+        m_filteredRows.resize(kh * m_convolveChannelsNo * width);
+        // per-channel planes of one destination row
+        m_dstRow.resize(m_convolveChannelsNo * width);
+
+        const bool hasProgressUpdater = this->m_progress;
+        if (hasProgressUpdater) {
+            this->m_progress->setRange(0, areaSize.height());
+            this->m_progress->setValue(0);
+        }
+
+        typename _IteratorFactory_::HLineConstIterator srcRowIt =
+            _IteratorFactory_::createHLineConstIterator(src, srcPos.x() - khalfWidth, srcPos.y() - khalfHeight, srcRowWidth, dataRect);
+
+        typename _IteratorFactory_::HLineIterator hitDst =
+            _IteratorFactory_::createHLineIterator(this->m_painter->device(), dstPos.x(), dstPos.y(), width, dataRect);
+
+        typename _IteratorFactory_::HLineConstIterator hitSrc =
+            _IteratorFactory_::createHLineConstIterator(src, srcPos.x(), srcPos.y(), width, dataRect);
+
+        const int totalSrcRows = areaSize.height() + kh - 1;
+
+        for (int srcRow = 0; srcRow < totalSrcRows; srcRow++) {
+            loadRow(srcRowIt, srcRowWidth);
+            srcRowIt->nextRow();
+
+            qreal *filteredRow = m_filteredRows.data() + (srcRow % kh) * m_convolveChannelsNo * width;
+            filterRowHorizontally(filteredRow, width, srcRowWidth);
+
+            if (srcRow < kh - 1) continue;
+
+            /**
+             * The ring buffer now contains all the rows needed for
+             * the destination row. The oldest of them is the one
+             * that is going to be overwritten next.
+             */
+            const int oldestRow = (srcRow + 1) % kh;
+            filterColumnsVertically(oldestRow, width);
+
+            int column = 0;
+            do {
+                quint8 *dstPtr = hitDst->rawData();
+
+                // write original channel values
+                memcpy(dstPtr, hitSrc->oldRawData(), pixelSize);
+                writePixel(dstPtr, column, width);
+
+                column++;
+                hitSrc->nextPixel();
+            } while (hitDst->nextPixel());
+
+            hitDst->nextRow();
+            hitSrc->nextRow();
+
+            if (hasProgressUpdater) {
+                const int dstRow = srcRow - kh + 1;
+                this->m_progress->setValue(dstRow);
+
+                if (this->m_progress->interrupted()) {
+                    return;
+                }
+            }
+        }
+    }
+
+private:
+    template <class Iterator>
+    inline void loadRow(Iterator &it, int srcRowWidth) {
+        int x = 0;
+
+        do {
+            const quint8 *data = it->oldRawData();
+
+            // no alpha is rare case, so just multiply by 1.0 in that case
+            const qreal alphaValue = m_alphaRealPos >= 0 ?
+                m_toDoubleFuncPtr[m_alphaCachePos](data, m_alphaRealPos) : 1.0;
+
+            for (int k = 0; k < m_convolveChannelsNo; ++k) {
+                qreal *plane = m_srcRow.data() + k * srcRowWidth;
+
+                if (k != m_alphaCachePos) {
+                    const quint32 channelPos = m_convChannelList[k]->pos();
+                    plane[x] = m_toDoubleFuncPtr[k](data, channelPos) * alphaValue;
+                } else {
+                    plane[x] = alphaValue;
+                }
+            }
+
+            x++;
+        } while (it->nextPixel());
+    }
+
+    inline void filterRowHorizontally(qreal *filteredRow, int width, int srcRowWidth) {
+        const int kw = m_horizontalTaps.size();
+
+        for (int k = 0; k < m_convolveChannelsNo; ++k) {
+            const qreal *srcPlane = m_srcRow.constData() + k * srcRowWidth;
+            qreal *dstPlane = filteredRow + k * width;
+
+            std::fill(dstPlane, dstPlane + width, 0.0);
+
+            for (int tap = 0; tap < kw; tap++) {
+                const qreal weight = m_horizontalTaps[tap];
+                if (weight == 0.0) continue;
+
+                const qreal *srcPtr = srcPlane + tap;
+                for (int x = 0; x < width; x++) {
+                    dstPlane[x] += weight * srcPtr[x];
+                }
+            }
+        }
+    }
+
+    inline void filterColumnsVertically(int oldestRow, int width) {
+        const int kh = m_verticalTaps.size();
+        const int rowStride = m_convolveChannelsNo * width;
+
+        std::fill(m_dstRow.begin(), m_dstRow.end(), 0.0);
+
+        for (int tap = 0; tap < kh; tap++) {
+            const qreal weight = m_verticalTaps[tap];
+            if (weight == 0.0) continue;
+
+            const qreal *srcRow = m_filteredRows.constData() + ((oldestRow + tap) % kh) * rowStride;
+            qreal *dstRow = m_dstRow.data();
+
+            for (int i = 0; i < rowStride; i++) {
+                dstRow[i] += weight * srcRow[i];
+            }
+        }
+    }
+
+    inline void limitValue(qreal *value, qreal lowBound, qreal highBound) {
+        if (*value > highBound) {
+            *value = highBound;
+        } else if (!(*value >= lowBound)) {  // value < lowBound or value == NaN
+            // IEEE compliant comparisons with NaN are always false
+            *value = lowBound;
+        }
+    }
+
+    template <bool additionalMultiplierActive>
+    inline qreal writeOneChannel(quint8 *dstPtr, int channel, qreal convoResult, qreal additionalMultiplier = 0.0) {
+        qreal channelPixelValue;
+        if (additionalMultiplierActive) {
+            channelPixelValue = (convoResult * m_kernelFactor) * additionalMultiplier + m_absoluteOffset[channel];
+        } else {
+            channelPixelValue = convoResult * m_kernelFactor + m_absoluteOffset[channel];
+        }
+
+        limitValue(&channelPixelValue, m_minClamp[channel], m_maxClamp[channel]);
+
+        const quint32 channelPos = m_convChannelList[channel]->pos();
+        m_fromDoubleFuncPtr[channel](dstPtr, channelPos, channelPixelValue);
+
+        return channelPixelValue;
+    }
+
+    inline void writePixel(quint8 *dstPtr, int column, int width) {
+        const qreal *convoResults = m_dstRow.constData() + column;
+
+        if (m_alphaCachePos >= 0) {
+            qreal alphaValue = writeOneChannel<false>(dstPtr, m_alphaCachePos, convoResults[m_alphaCachePos * width]);
+
+            if (alphaValue != 0.0) {
+                qreal alphaValueInv = 1.0 / alphaValue;
+
+                for (int k = 0; k < m_convolveChannelsNo; ++k) {
+                    if (k == m_alphaCachePos) continue;
+                    writeOneChannel<true>(dstPtr, k, convoResults[k * width], alphaValueInv);
+                }
+            } else {
+                for (int k = 0; k < m_convolveChannelsNo; ++k) {
+                    if (k == m_alphaCachePos) continue;
+
+                    const qreal zeroValue = 0.0;
+                    const quint32 channelPos = m_convChannelList[k]->pos();
+                    m_fromDoubleFuncPtr[k](dstPtr, channelPos, zeroValue);
+                }
+            }
+        } else {
+            for (int k = 0; k < m_convolveChannelsNo; ++k) {
+                writeOneChannel<false>(dstPtr, k, convoResults[k * width]);
+            }
+        }
+    }
+
+private:
+    int m_convolveChannelsNo;
+
+    int m_alphaCachePos;
+    int m_alphaRealPos;
+
+    QVector<qreal> m_horizontalTaps;
+    QVector<qreal> m_verticalTaps;
+
+    QVector<qreal> m_srcRow;
+    QVector<qreal> m_filteredRows;
+    QVector<qreal> m_dstRow;
+
+    QVector<qreal> m_minClamp;
+    QVector<qreal> m_maxClamp;
+    QVector<qreal> m_absoluteOffset;
+
+    qreal m_kernelFactor;
+    QList<KoChannelInfo *> m_convChannelList;
+    QVector<PtrToDouble> m_toDoubleFuncPtr;
+    QVector<PtrFromDouble> m_fromDoubleFuncPtr;
+};
+
+
+#endif
@@ -20,6 +20,9 @@
 #include "kis_histogram.h"
 
 #include <QVector>
+#include <QThread>
+#include <QSharedPointer>
+#include <QtConcurrent>
 
 #include "kis_image.h"
 #include "kis_paint_layer.h"
@@ -28,6 +31,80 @@
 #include "kis_debug.h"
 #include "kis_iterator_ng.h"
 
+namespace {
+
+/**
+ * The histogram is collected in horizontal strips, whose height is a
+ * multiple of the tile size. Every strip is fed into its own partial producer, so the
+ * threads never touch the same bins, and the partial producers are merged
+ * in the end.
+ */
+struct KisHistogramStrip {
+    QRect rect;
+    QSharedPointer<KoHistogramProducer> producer;
+};
+
+const int stripAlignment = 64;
+const int minPixelsPerStrip = 64 * 1024;
+
+void addRectToProducer(KisPaintDeviceSP dev, const QRect &rc, KoHistogramProducer *producer)
+{
+    KisSequentialConstIterator srcIt(dev, rc);
+    const KoColorSpace* cs = dev->colorSpace();
+
+    int numConseqPixels = srcIt.nConseqPixels();
+    while (srcIt.nextPixels(numConseqPixels)) {
+
+        numConseqPixels = srcIt.nConseqPixels();
+        producer->addRegionToBin(srcIt.oldRawData(), 0, numConseqPixels, cs);
+    }
+}
+
+QVector<KisHistogramStrip> splitIntoStrips(const QRect &bounds)
+{
+    const int maxStrips = 4 * QThread::idealThreadCount();
+    const int numStrips =
+        qBound(1,
+               qMin(bounds.width() * bounds.height() / minPixelsPerStrip,
+                    bounds.height() / stripAlignment),
+               maxStrips);
+
+    QVector<KisHistogramStrip> strips;
+
+    if (numStrips <= 1) {
+        KisHistogramStrip strip;
+        strip.rect = bounds;
+        strips.append(strip);
+        return strips;
+    }
+
+    const int stripHeight =
+        (bounds.height() / numStrips + stripAlignment - 1) / stripAlignment * stripAlignment;
+
+    for (int y = bounds.top(); y <= bounds.bottom(); y += stripHeight) {
+        KisHistogramStrip strip;
+        strip.rect = QRect(bounds.left(), y, bounds.width(), stripHeight) & bounds;
+        strips.append(strip);
+    }
+
+    return strips;
+}
+
+struct StripProcessor {
+    StripProcessor(KisPaintDeviceSP dev) : m_dev(dev) {}
+
+    typedef void result_type;
+
+    void operator()(KisHistogramStrip &strip) {
+        addRectToProducer(m_dev, strip.rect, strip.producer.data());
+    }
+
+private:
+    KisPaintDeviceSP m_dev;
+};
+
+}
+
 KisHistogram::KisHistogram(const KisPaintLayerSP layer,
                            KoHistogramProducer *producer,
                            const enumHistogramType type)
@@ -85,23 +162,36 @@ void KisHistogram::updateHistogram()
         return;
     }
 
-    KisSequentialConstIterator srcIt(m_paintDevice, m_bounds);
-    const KoColorSpace* cs = m_paintDevice->colorSpace();
-
     // Let the producer do it's work
     m_producer->clear();
 
-
     // XXX: the original code depended on their being a selection mask in the iterator
     //      if the paint device had a selection. When we changed that to passing an
     //      explicit selection to the createRectIterator call, that broke because
     //      paint devices didn't know about their selections anymore.
     //      updateHistogram should get a selection parameter.
-    int numConseqPixels = srcIt.nConseqPixels();
-    while (srcIt.nextPixels(numConseqPixels)) {
 
-        numConseqPixels = srcIt.nConseqPixels();
-        m_producer->addRegionToBin(srcIt.oldRawData(), 0, numConseqPixels, cs);
+    QVector<KisHistogramStrip> strips = splitIntoStrips(m_bounds);
+
+    if (strips.size() > 1) {
+        for (int i = 0; i < strips.size(); i++) {
+            strips[i].producer.reset(m_producer->createPartialProducer());
+
+            if (!strips[i].producer) {
+                strips.clear();
+                break;
+            }
+        }
+    }
+
+    if (strips.size() > 1) {
+        QtConcurrent::blockingMap(strips, StripProcessor(m_paintDevice));
+
+        Q_FOREACH (const KisHistogramStrip &strip, strips) {
+            m_producer->merge(strip.producer.data());
+        }
+    } else {
+        addRectToProducer(m_paintDevice, m_bounds, m_producer);
     }
 
     computeHistogram();
@@ -538,6 +538,27 @@ void KisImageConfig::setUseOnDiskAnimationCacheSwapping(bool value)
     m_config.writeEntry("useOnDiskAnimationCacheSwapping", value);
 }
 
+bool KisImageConfig::useCompressedAnimationCache(bool defaultValue) const
+{
+    return defaultValue ? true : m_config.readEntry("useCompressedAnimationCache", true);
+}
+
+void KisImageConfig::setUseCompressedAnimationCache(bool value)
+{
+    m_config.writeEntry("useCompressedAnimationCache", value);
+}
+
+int KisImageConfig::animationCacheSizeLimit(bool defaultValue) const
+{
+    // in MiB
+    return defaultValue ? 4096 : m_config.readEntry("animationCacheSizeLimit", 4096);
+}
+
+void KisImageConfig::setAnimationCacheSizeLimit(int value)
+{
+    m_config.writeEntry("animationCacheSizeLimit", value);
+}
+
 QString KisImageConfig::animationCacheDir(bool defaultValue) const
 {
     return safelyGetWritableTempLocation("animation_cache", "animationCacheDir", defaultValue);
@@ -123,6 +123,12 @@ public:
     bool useOnDiskAnimationCacheSwapping(bool defaultValue = false) const;
     void setUseOnDiskAnimationCacheSwapping(bool value);
 
+    bool useCompressedAnimationCache(bool defaultValue = false) const;
+    void setUseCompressedAnimationCache(bool value);
+
+    int animationCacheSizeLimit(bool defaultValue = false) const;
+    void setAnimationCacheSizeLimit(int value);
+
     QString animationCacheDir(bool defaultValue = false) const;
     void setAnimationCacheDir(const QString &value);
 
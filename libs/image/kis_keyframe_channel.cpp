@@ -442,6 +442,11 @@ KisTimeRange KisKeyframeChannel::identicalFrames(int time) const
     return affectedFrames(time);
 }
 
+quint64 KisKeyframeChannel::frameContentHash(int time) const
+{
+    return quint64(identicalFrames(time).start());
+}
+
 int KisKeyframeChannel::keyframeRowIndexOf(KisKeyframeSP keyframe) const
 {
     KeyframesMap::const_iterator it = m_d->keys.constBegin();
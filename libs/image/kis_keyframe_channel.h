@@ -103,6 +103,17 @@ public:
      */
     KisTimeRange identicalFrames(int time) const;
 
+    /**
+     * Calculates a hash of the value the channel gives at \p time. Two
+     * frames with equal hashes are guaranteed to get identical results
+     * from the channel, even when they are not adjacent, e.g. when the
+     * value returns back to the previous one.
+     *
+     * The default implementation identifies the frame by the beginning of
+     * its identical frames range.
+     */
+    virtual quint64 frameContentHash(int time) const;
+
     int keyframeCount() const;
 
     int keyframeRowIndexOf(KisKeyframeSP keyframe) const;
@@ -413,6 +413,9 @@ public:
 
     void generateLodCloneDevice(KisPaintDeviceSP dst, const QRect &originalRect, int lod);
 
+    struct ThumbnailShadow;
+    KisPaintDeviceSP thumbnailSource(QRect *imageRect, const QSize &thumbnailSize);
+
     void tesingFetchLodDevice(KisPaintDeviceSP targetDevice);
 
 
@@ -570,6 +573,9 @@ private:
 
     FramesHash m_frames;
     int m_nextFreeFrameId;
+
+    QList<QSharedPointer<ThumbnailShadow>> m_thumbnailShadows;
+    QMutex m_thumbnailShadowsLock;
 };
 
 const KisDefaultBoundsSP KisPaintDevice::Private::transitionalDefaultBounds = new KisDefaultBounds();
@@ -740,6 +746,8 @@ void KisPaintDevice::Private::updateLodDataManager(KisDataManager *srcDataManage
     InternalSequentialConstIterator srcIntIt(StrategyPolicy(currentStrategy(), srcDataManager, srcOffset.x(), srcOffset.y()), srcRect);
     InternalSequentialIterator dstIntIt(StrategyPolicy(currentStrategy(), dstDataManager, dstOffset.x(), dstOffset.y()), dstRect);
 
+    int dstNumConseqPixels = dstIntIt.nConseqPixels();
+
     int rowsRemaining = srcRect.height();
     while (rowsRemaining > 0) {
 
@@ -766,11 +774,13 @@ void KisPaintDevice::Private::updateLodDataManager(KisDataManager *srcDataManage
             blendDataPtr = blendData.data();
 
             int colsRemaining = dstRect.width();
-            while (colsRemaining > 0 && dstIntIt.nextPixel()) {
-                mixOp->mixColors(blendDataPtr, weights.data(), srcCellSize, dstIntIt.rawData());
-                blendDataPtr += srcCellStride;
+            while (colsRemaining > 0 && dstIntIt.nextPixels(dstNumConseqPixels)) {
+                dstNumConseqPixels = qMin(dstIntIt.nConseqPixels(), colsRemaining);
+
+                mixOp->mixColorsRows(blendDataPtr, weights.data(), srcCellSize, dstNumConseqPixels, dstIntIt.rawData());
+                blendDataPtr += dstNumConseqPixels * srcCellStride;
 
-                colsRemaining--;
+                colsRemaining -= dstNumConseqPixels;
             }
 
             // reset counters
@@ -813,6 +823,174 @@ void KisPaintDevice::Private::generateLodCloneDevice(KisPaintDeviceSP dst, const
                          originalRect, lod);
 }
 
+/**
+ * A box-filtered copy of the device downscaled by 2^lod. Thumbnails
+ * are sampled from the shadow instead of the full-resolution data, so
+ * that they don't alias and don't need to touch every tile of a huge
+ * device. The shadow is kept in sync incrementally: the revisions of
+ * the source tiles are compared with the ones the shadow was
+ * generated from and only the changed tiles are downsampled again.
+ */
+struct KisPaintDevice::Private::ThumbnailShadow
+{
+    /**
+     * The weights of updateLodDataManager() fit into the mixing op
+     * only while a cell has no more than 256 pixels.
+     */
+    static const int maxLod = 4;
+
+    /**
+     * Smaller levels make the shadow take too much memory in
+     * comparison to the device itself.
+     */
+    static const int minLod = 2;
+
+    static const int maxLevels = 2;
+
+    ThumbnailShadow(int _lod) : lod(_lod) {}
+
+    int lod;
+    KisPaintDeviceSP device;
+
+    const KoColorSpace *colorSpace = 0;
+    KisDataManager *sourceDataManager = 0;
+    QPoint sourceOffset;
+    QByteArray defaultPixel;
+
+    /**
+     * The tile-aligned rect (in data manager coordinates) the shadow is
+     * synchronized with and the revisions of its tiles, row by row
+     */
+    QRect syncedRect;
+    QVector<quint64> revisions;
+};
+
+KisPaintDeviceSP KisPaintDevice::Private::thumbnailSource(QRect *imageRect, const QSize &thumbnailSize)
+{
+    if (defaultBounds->currentLevelOfDetail() ||
+        defaultBounds->wrapAroundMode() ||
+        thumbnailSize.isEmpty() || imageRect->isEmpty()) {
+
+        return 0;
+    }
+
+    const qreal scale = qMin(qreal(imageRect->width()) / thumbnailSize.width(),
+                             qreal(imageRect->height()) / thumbnailSize.height());
+    const int lod = qMin(int(std::floor(std::log2(scale))), int(ThumbnailShadow::maxLod));
+    if (lod < ThumbnailShadow::minLod) return 0;
+
+    Data *srcData = currentNonLodData();
+    KisDataManager *srcDataManager = srcData->dataManager().data();
+    const QPoint srcOffset(srcData->x(), srcData->y());
+    const QByteArray defaultPixel(reinterpret_cast<const char*>(srcDataManager->defaultPixel()),
+                                  srcDataManager->pixelSize());
+
+    QMutexLocker l(&m_thumbnailShadowsLock);
+
+    QSharedPointer<ThumbnailShadow> shadow;
+    for (auto it = m_thumbnailShadows.begin(); it != m_thumbnailShadows.end(); ++it) {
+        if ((*it)->lod == lod) {
+            shadow = *it;
+            m_thumbnailShadows.erase(it);
+            break;
+        }
+    }
+
+    if (!shadow) {
+        shadow = toQShared(new ThumbnailShadow(lod));
+        while (m_thumbnailShadows.size() >= ThumbnailShadow::maxLevels) {
+            m_thumbnailShadows.removeLast();
+        }
+    }
+    m_thumbnailShadows.prepend(shadow);
+
+    if (!shadow->device ||
+        shadow->colorSpace != srcData->colorSpace() ||
+        shadow->sourceDataManager != srcDataManager ||
+        shadow->sourceOffset != srcOffset ||
+        shadow->defaultPixel != defaultPixel) {
+
+        shadow->device = new KisPaintDevice(srcData->colorSpace());
+        shadow->device->setDefaultPixel(KoColor(srcDataManager->defaultPixel(), srcData->colorSpace()));
+
+        shadow->colorSpace = srcData->colorSpace();
+        shadow->sourceDataManager = srcDataManager;
+        shadow->sourceOffset = srcOffset;
+        shadow->defaultPixel = defaultPixel;
+        shadow->syncedRect = QRect();
+        shadow->revisions.clear();
+    }
+
+    const QRect srcExtent = srcDataManager->extent();
+    const QRect checkRect = shadow->syncedRect | srcExtent;
+    const QVector<quint64> revisions = srcDataManager->tileRevisions(checkRect);
+
+    const int tileWidth = KisTileData::WIDTH;
+    const int tileHeight = KisTileData::HEIGHT;
+
+    QRegion dirtyRegion;
+
+    if (!checkRect.isEmpty()) {
+        const int firstColumn = checkRect.x() / tileWidth;
+        const int firstRow = checkRect.y() / tileHeight;
+        const int numColumns = checkRect.width() / tileWidth;
+        const int numRows = checkRect.height() / tileHeight;
+
+        KIS_SAFE_ASSERT_RECOVER_RETURN_VALUE(revisions.size() == numColumns * numRows, 0);
+
+        auto rectToTiles = [tileWidth, tileHeight] (const QRect &rc) {
+            return rc.isEmpty() ? QRect() :
+                QRect(rc.x() / tileWidth, rc.y() / tileHeight,
+                      rc.width() / tileWidth, rc.height() / tileHeight);
+        };
+
+        const QRect oldTiles = rectToTiles(shadow->syncedRect);
+        const QRect newTiles = rectToTiles(srcExtent);
+
+        for (int row = 0; row < numRows; row++) {
+            int spanStart = -1;
+
+            for (int column = 0; column <= numColumns; column++) {
+                bool dirty = false;
+
+                if (column < numColumns) {
+                    const QPoint tile(firstColumn + column, firstRow + row);
+                    const quint64 revision = revisions[row * numColumns + column];
+
+                    /**
+                     * The tiles outside the old synced rect were not present
+                     * in the device, so the shadow has the default pixel there
+                     */
+                    dirty = oldTiles.contains(tile) ?
+                        shadow->revisions[(tile.y() - oldTiles.y()) * oldTiles.width() + tile.x() - oldTiles.x()] != revision :
+                        newTiles.contains(tile);
+                }
+
+                if (dirty && spanStart < 0) {
+                    spanStart = column;
+                } else if (!dirty && spanStart >= 0) {
+                    dirtyRegion += QRect((firstColumn + spanStart) * tileWidth,
+                                         (firstRow + row) * tileHeight,
+                                         (column - spanStart) * tileWidth,
+                                         tileHeight).translated(srcOffset);
+                    spanStart = -1;
+                }
+            }
+        }
+    }
+
+    Q_FOREACH (const QRect &rc, dirtyRegion.rects()) {
+        updateLodDataManager(srcDataManager, shadow->device->dataManager().data(),
+                             srcOffset, QPoint(), rc, lod);
+    }
+
+    shadow->syncedRect = checkRect;
+    shadow->revisions = revisions;
+
+    *imageRect = KisLodTransform::scaledRect(KisLodTransform::alignedRect(*imageRect, lod), lod);
+    return shadow->device;
+}
+
 void KisPaintDevice::Private::uploadLodDataStruct(LodDataStruct *_dst)
 {
     LodDataStructImpl *dst = dynamic_cast<LodDataStructImpl*>(_dst);
@@ -1681,7 +1859,10 @@ KisPaintDeviceSP KisPaintDevice::createThumbnailDevice(qint32 w, qint32 h, QRect
         outputRect = QRect(0, 0, w, h);
     }
 
-    KisPaintDeviceSP thumbnail = createThumbnailDeviceInternal(this, imageRect.x(), imageRect.y(), imageRect.width(), imageRect.height(),
+    KisPaintDeviceSP shadow = m_d->thumbnailSource(&imageRect, thumbnailSize);
+    const KisPaintDevice *srcDevice = shadow ? shadow.data() : this;
+
+    KisPaintDeviceSP thumbnail = createThumbnailDeviceInternal(srcDevice, imageRect.x(), imageRect.y(), imageRect.width(), imageRect.height(),
                                  thumbnailSize.width(), thumbnailSize.height(), outputRect);
 
     return thumbnail;
@@ -1719,7 +1900,10 @@ KisPaintDeviceSP KisPaintDevice::createThumbnailDeviceOversampled(qint32 w, qint
         outputRect = outputRect.intersected(outputTileRect);
     }
 
-    KisPaintDeviceSP thumbnail = createThumbnailDeviceInternal(this, imageRect.x(), imageRect.y(), imageRect.width(), imageRect.height(),
+    KisPaintDeviceSP shadow = m_d->thumbnailSource(&imageRect, thumbnailOversampledSize);
+    const KisPaintDevice *srcDevice = shadow ? shadow.data() : this;
+
+    KisPaintDeviceSP thumbnail = createThumbnailDeviceInternal(srcDevice, imageRect.x(), imageRect.y(), imageRect.width(), imageRect.height(),
                                  thumbnailOversampledSize.width(), thumbnailOversampledSize.height(), outputRect);
 
     if (oversample != 1. && oversampleAdjusted != 1.) {
@@ -539,6 +539,11 @@ public:
      * the aspect ratio. The width and height of the returned device
      * won't exceed \p maxw and \p maxw, but they may be smaller.
      *
+     * When the thumbnail is much smaller than the device, it is sampled
+     * from a box-filtered low-resolution shadow of the device. The shadow
+     * is kept between the calls and only the tiles changed since the
+     * previous call are downsampled again.
+     *
      * @param maxw: maximum width
      * @param maxh: maximum height
      * @param rect: only this rect will be used for the thumbnail
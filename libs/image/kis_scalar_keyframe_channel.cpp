@@ -23,6 +23,7 @@
 
 #include <kis_global.h>
 #include <kis_dom_utils.h>
+#include <cstring>
 
 struct KisScalarKeyframe : public KisKeyframe
 {
@@ -364,6 +365,17 @@ qreal KisScalarKeyframeChannel::interpolatedValue(int time) const
     return result;
 }
 
+quint64 KisScalarKeyframeChannel::frameContentHash(int time) const
+{
+    const qreal value = interpolatedValue(time);
+
+    quint64 hash = 0;
+    static_assert(sizeof(hash) == sizeof(value), "qreal is expected to be 64-bit");
+    memcpy(&hash, &value, sizeof(hash));
+
+    return hash;
+}
+
 qreal KisScalarKeyframeChannel::currentValue() const
 {
     return interpolatedValue(currentTime());
@@ -45,6 +45,12 @@ public:
     void setInterpolationTangents(KisKeyframeSP keyframe, KisKeyframe::InterpolationTangentsMode, QPointF leftTangent, QPointF rightTangent, KUndo2Command *parentCommand);
 
     qreal interpolatedValue(int time) const;
+
+    /**
+     * The frames of the scalar channel are identical if they have the
+     * same interpolated value
+     */
+    quint64 frameContentHash(int time) const override;
     qreal currentValue() const;
 
     static QPointF interpolate(QPointF point1, QPointF rightTangent, QPointF leftTangent, QPointF point2, qreal t);
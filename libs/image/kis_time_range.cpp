@@ -19,9 +19,11 @@
 #include "kis_time_range.h"
 
 #include <QDebug>
+#include <QSet>
 #include "kis_keyframe_channel.h"
 #include "kis_node.h"
 #include "kis_layer_utils.h"
+#include "kis_clone_layer.h"
 
 struct KisTimeRangeStaticRegistrar {
     KisTimeRangeStaticRegistrar() {
@@ -66,6 +68,58 @@ KisTimeRange KisTimeRange::calculateAffectedFramesRecursive(const KisNode *node,
     return range;
 }
 
+namespace {
+void calculateNodeContentKey(const KisNode *node, int time, bool ignoreVisibility,
+                             QSet<const KisNode*> &clonedSources, QVector<quint64> &key)
+{
+    if (!ignoreVisibility && !node->visible()) return;
+
+    const QMap<QString, KisKeyframeChannel*> channels =
+        node->keyframeChannels();
+
+    key.append(quint64(reinterpret_cast<quintptr>(node)));
+    key.append(quint64(channels.size()));
+
+    for (auto it = channels.constBegin(); it != channels.constEnd(); ++it) {
+        key.append(qHash(it.key()));
+        key.append(it.value()->frameContentHash(time));
+    }
+
+    /**
+     * A clone layer has no channels, but shows the content of its source
+     * at the same time, even when the source itself is hidden.
+     */
+    const KisCloneLayer *clone = dynamic_cast<const KisCloneLayer*>(node);
+    if (clone) {
+        KisLayerSP source = clone->copyFrom();
+
+        if (source && !clonedSources.contains(source.data())) {
+            clonedSources.insert(source.data());
+            calculateNodeContentKey(source.data(), time, true, clonedSources, key);
+            clonedSources.remove(source.data());
+        } else if (source) {
+            // we cannot prove anything about a recursive clone, so
+            // the frame is considered unique
+            key.append(quint64(time));
+        }
+    }
+
+    for (KisNodeSP child = node->firstChild(); child; child = child->nextSibling()) {
+        calculateNodeContentKey(child.data(), time, false, clonedSources, key);
+    }
+}
+}
+
+QVector<quint64> KisTimeRange::calculateFrameContentKeyRecursive(const KisNode *node, int time)
+{
+    QVector<quint64> key;
+    QSet<const KisNode*> clonedSources;
+
+    calculateNodeContentKey(node, time, false, clonedSources, key);
+
+    return key;
+}
+
 KisTimeRange KisTimeRange::calculateNodeIdenticalFrames(const KisNode *node, int time)
 {
     KisTimeRange range = KisTimeRange::infinite(0);
@@ -24,6 +24,7 @@
 #include <algorithm>
 #include <limits>
 #include <QMetaType>
+#include <QVector>
 #include <boost/operators.hpp>
 #include "kis_types.h"
 #include <kis_dom_utils.h>
@@ -133,6 +134,17 @@ public:
     static KisTimeRange calculateNodeIdenticalFrames(const KisNode *node, int time);
     static KisTimeRange calculateNodeAffectedFrames(const KisNode *node, int time);
 
+    /**
+     * Calculates a key identifying the content of the frame \p time composed
+     * from \p node and its visible descendants. The key lists the identities
+     * of the nodes and the values of all their keyframe channels at that
+     * time, so two frames with equal keys are composed identically, even
+     * if they are not adjacent and, therefore, not reported by
+     * calculateIdenticalFramesRecursive(). The sources of the clone layers
+     * are listed as well, even when they are hidden.
+     */
+    static QVector<quint64> calculateFrameContentKeyRecursive(const KisNode *node, int time);
+
 private:
     int m_start;
     int m_end;
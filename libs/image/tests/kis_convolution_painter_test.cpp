@@ -33,6 +33,7 @@
 #include "kis_convolution_kernel.h"
 #include <kis_gaussian_kernel.h>
 #include <kis_mask_generator.h>
+#include <kis_global.h>
 #include "testutil.h"
 
 KisPaintDeviceSP initAsymTestDevice(QRect &imageRect, int &pixelSize, QByteArray &initialData)
@@ -98,6 +99,18 @@ Eigen::Matrix<qreal, 3, 3> initAsymmFilter(qreal &offset, qreal &factor)
     return filter;
 }
 
+Eigen::Matrix<qreal, Eigen::Dynamic, Eigen::Dynamic> initAsymmSeparableFilter()
+{
+    // a product of two non-symmetric vectors of different lengths
+    Eigen::Matrix<qreal, Eigen::Dynamic, 1> vertical(3);
+    vertical << 1.0, 2.0, 5.0;
+
+    Eigen::Matrix<qreal, 1, Eigen::Dynamic> horizontal(5);
+    horizontal << 4.0, 0.0, 1.0, 3.0, 2.0;
+
+    return vertical * horizontal;
+}
+
 void printPixel(QString prefix, int pixelSize, quint8 *data) {
     QString str = prefix;
 
@@ -471,4 +484,178 @@ void KisConvolutionPainterTest::testErode()
     TestUtil::checkQImage(dev->convertToQImage(0, imageRect), "convolution_painter_test", "dilate", "erode5");
 }
 
+void KisConvolutionPainterTest::testKernelSeparation()
+{
+    const qreal radius = 7;
+
+    Eigen::Matrix<qreal, Eigen::Dynamic, Eigen::Dynamic> gaussian =
+        KisGaussianKernel::createVerticalMatrix(radius) *
+        KisGaussianKernel::createHorizontalMatrix(radius);
+
+    KisConvolutionKernelSP kernel = KisConvolutionKernel::fromMatrix(gaussian, 0, gaussian.sum());
+
+    Eigen::Matrix<qreal, Eigen::Dynamic, 1> vertical;
+    Eigen::Matrix<qreal, 1, Eigen::Dynamic> horizontal;
+    QVERIFY(kernel->separate(&vertical, &horizontal));
+
+    QCOMPARE(int(vertical.size()), int(kernel->height()));
+    QCOMPARE(int(horizontal.size()), int(kernel->width()));
+
+    const qreal error = (kernel->data() - vertical * horizontal).cwiseAbs().maxCoeff();
+    QVERIFY(error < 1e-9);
+
+    qreal offset, factor;
+    kernel = KisConvolutionKernel::fromMatrix(initAsymmFilter(offset, factor), offset, factor);
+    QVERIFY(!kernel->separate());
+
+    kernel = KisConvolutionKernel::fromMatrix(initSymmFilter(offset, factor), offset, factor);
+    QVERIFY(!kernel->separate());
+}
+
+void KisConvolutionPainterTest::testSeparableConvolution()
+{
+    QImage qimage(QString(FILES_DATA_DIR) + QDir::separator() + "hakonepa.png");
+
+    KisPaintDeviceSP dev = new KisPaintDevice(KoColorSpaceRegistry::instance()->rgb8());
+    dev->convertFromQImage(qimage, 0, 0, 0);
+
+    const QRect rc(10, 20, qimage.width() - 30, qimage.height() - 40);
+
+    QList<KisConvolutionKernelSP> kernels;
+
+    {
+        Eigen::Matrix<qreal, Eigen::Dynamic, Eigen::Dynamic> gaussian =
+            KisGaussianKernel::createVerticalMatrix(5) *
+            KisGaussianKernel::createHorizontalMatrix(3);
+
+        kernels << KisConvolutionKernel::fromMatrix(gaussian, 0, gaussian.sum());
+        kernels << KisGaussianKernel::createHorizontalKernel(6);
+        kernels << KisGaussianKernel::createVerticalKernel(6);
+
+        // a non-symmetric kernel catches mirrored or transposed passes
+        kernels << KisConvolutionKernel::fromMatrix(initAsymmSeparableFilter(), 0, initAsymmSeparableFilter().sum());
+    }
+
+    Q_FOREACH (KisConvolutionKernelSP kernel, kernels) {
+        QVERIFY(kernel->separate());
+
+        KisPaintDeviceSP spatialDev = new KisPaintDevice(dev->colorSpace());
+        KisConvolutionPainter spatialPainter(spatialDev, KisConvolutionPainter::SPATIAL);
+        spatialPainter.applyMatrix(kernel, dev, rc.topLeft(), rc.topLeft(), rc.size(), BORDER_REPEAT);
+
+        KisPaintDeviceSP separableDev = new KisPaintDevice(dev->colorSpace());
+        KisConvolutionPainter separablePainter(separableDev, KisConvolutionPainter::SEPARABLE);
+        separablePainter.applyMatrix(kernel, dev, rc.topLeft(), rc.topLeft(), rc.size(), BORDER_REPEAT);
+
+        const QImage spatialImage = spatialDev->convertToQImage(0, rc);
+        const QImage separableImage = separableDev->convertToQImage(0, rc);
+
+        // the order of summation differs, so allow rounding errors
+        QPoint errpoint;
+        if (!TestUtil::compareQImages(errpoint, spatialImage, separableImage, 1, 1)) {
+            separableImage.save("separable_convolution.png");
+            QFAIL(QString("Separable convolution differs from the spatial one, first different pixel: %1,%2 ").arg(errpoint.x()).arg(errpoint.y()).toLatin1());
+        }
+    }
+}
+
+void KisConvolutionPainterTest::testSeparableConvolutionAsymm()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+
+    const Eigen::Matrix<qreal, Eigen::Dynamic, Eigen::Dynamic> filter = initAsymmSeparableFilter();
+    const qreal factor = filter.sum();
+    KisConvolutionKernelSP kernel = KisConvolutionKernel::fromMatrix(filter, 0, factor);
+    QVERIFY(kernel->separate());
+
+    const int khalfWidth = (filter.cols() - 1) / 2;
+    const int khalfHeight = (filter.rows() - 1) / 2;
+
+    const QRect rc(0, 0, 20, 20);
+    const QPoint center(10, 10);
+
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+    dev->fill(rc, KoColor(Qt::black, cs));
+    dev->setPixel(center.x(), center.y(), QColor(Qt::white));
+
+    QList<KisConvolutionPainter::TestingEnginePreference> engines;
+    engines << KisConvolutionPainter::SPATIAL;
+    engines << KisConvolutionPainter::SEPARABLE;
+
+    Q_FOREACH (KisConvolutionPainter::TestingEnginePreference engine, engines) {
+        KisPaintDeviceSP dstDev = new KisPaintDevice(cs);
+        KisConvolutionPainter gc(dstDev, engine);
+        gc.applyMatrix(kernel, dev, rc.topLeft(), rc.topLeft(), rc.size(), BORDER_REPEAT);
+
+        /**
+         * The response to a single white pixel should be the kernel
+         * itself, in the same orientation
+         */
+        for (int y = rc.top(); y <= rc.bottom(); y++) {
+            for (int x = rc.left(); x <= rc.right(); x++) {
+                const int row = khalfHeight + y - center.y();
+                const int column = khalfWidth + x - center.x();
+
+                const bool insideKernel =
+                    row >= 0 && row < filter.rows() &&
+                    column >= 0 && column < filter.cols();
+
+                const int expected = insideKernel ? qRound(255.0 * filter(row, column) / factor) : 0;
+
+                QColor c;
+                dstDev->pixel(x, y, &c);
+
+                if (qAbs(c.red() - expected) > 1 ||
+                    qAbs(c.green() - expected) > 1 ||
+                    qAbs(c.blue() - expected) > 1) {
+
+                    QFAIL(QString("Wrong response of engine %1 at %2,%3: expected %4, got %5")
+                          .arg(engine).arg(x).arg(y).arg(expected).arg(c.red()).toLatin1());
+                }
+            }
+        }
+    }
+}
+
+void KisConvolutionPainterTest::testFFTWTiledInPlace()
+{
+    QImage qimage(QString(FILES_DATA_DIR) + QDir::separator() + "hakonepa.png");
+
+    // make the image big enough to be split into several tiles and bands
+    KisPaintDeviceSP dev = new KisPaintDevice(KoColorSpaceRegistry::instance()->rgb8());
+    for (int i = 0; i < 4; i++) {
+        dev->convertFromQImage(qimage, 0, (i % 2) * qimage.width(), (i / 2) * qimage.height());
+    }
+
+    const QRect rc(7, 5, 2 * qimage.width() - 20, 2 * qimage.height() - 10);
+
+    // a disk is not separable, so the kernel cannot be optimized
+    const int radius = 7;
+    Eigen::Matrix<qreal, Eigen::Dynamic, Eigen::Dynamic> disk(2 * radius + 1, 2 * radius + 1);
+    for (int y = 0; y < disk.rows(); y++) {
+        for (int x = 0; x < disk.cols(); x++) {
+            disk(y, x) = pow2(x - radius) + pow2(y - radius) <= pow2(radius) ? 1.0 : 0.0;
+        }
+    }
+
+    KisConvolutionKernelSP kernel = KisConvolutionKernel::fromMatrix(disk, 0, disk.sum());
+
+    KisPaintDeviceSP spatialDev = new KisPaintDevice(dev->colorSpace());
+    KisConvolutionPainter spatialPainter(spatialDev, KisConvolutionPainter::SPATIAL);
+    spatialPainter.applyMatrix(kernel, dev, rc.topLeft(), rc.topLeft(), rc.size(), BORDER_REPEAT);
+
+    // the source and the destination are the same device
+    KisConvolutionPainter fftwPainter(dev, KisConvolutionPainter::FFTW);
+    fftwPainter.applyMatrix(kernel, dev, rc.topLeft(), rc.topLeft(), rc.size(), BORDER_REPEAT);
+
+    const QImage spatialImage = spatialDev->convertToQImage(0, rc);
+    const QImage fftwImage = dev->convertToQImage(0, rc);
+
+    QPoint errpoint;
+    if (!TestUtil::compareQImages(errpoint, spatialImage, fftwImage, 1, 1)) {
+        fftwImage.save("fftw_tiled_convolution.png");
+        QFAIL(QString("Tiled FFTW convolution differs from the spatial one, first different pixel: %1,%2 ").arg(errpoint.x()).arg(errpoint.y()).toLatin1());
+    }
+}
+
 QTEST_MAIN(KisConvolutionPainterTest)
@@ -59,6 +59,12 @@ private Q_SLOTS:
 
     void testDilate();
     void testErode();
+
+    void testKernelSeparation();
+    void testSeparableConvolution();
+    void testSeparableConvolutionAsymm();
+
+    void testFFTWTiledInPlace();
 };
 
 #endif
@@ -22,10 +22,13 @@
 #include <KoColorSpace.h>
 #include <KoColorSpaceRegistry.h>
 #include <KoHistogramProducer.h>
+#include <KoBasicHistogramProducers.h>
+#include <KoChannelInfo.h>
 #include "kis_paint_device.h"
 #include "kis_histogram.h"
 #include "kis_paint_layer.h"
 #include "kis_types.h"
+#include "kis_iterator_ng.h"
 #include "kistest.h"
 
 void KisHistogramTest::testCreation()
@@ -46,5 +49,53 @@ void KisHistogramTest::testCreation()
     }
 }
 
+void KisHistogramTest::testParallelCounting()
+{
+    const KoColorSpace * cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+
+    const QRect rc(10, 20, 1000, 1500);
+
+    qsrand(1);
+
+    KisSequentialIterator it(dev, rc);
+    while (it.nextPixel()) {
+        quint8 *pixel = it.rawData();
+        for (int i = 0; i < 4; i++) {
+            pixel[i] = qrand() % 256;
+        }
+
+        // every tenth pixel is fully transparent
+        if (qrand() % 10 == 0) {
+            pixel[3] = OPACITY_TRANSPARENT_U8;
+        }
+    }
+
+    QList<KoChannelInfo*> channels = cs->channels();
+    QVector<QVector<qint32>> referenceBins(channels.size(), QVector<qint32>(256, 0));
+    qint32 referenceCount = 0;
+
+    KisSequentialConstIterator srcIt(dev, rc);
+    while (srcIt.nextPixel()) {
+        const quint8 *pixel = srcIt.rawDataConst();
+        if (cs->opacityU8(pixel) == OPACITY_TRANSPARENT_U8) continue;
+
+        for (int ch = 0; ch < channels.size(); ch++) {
+            referenceBins[ch][pixel[channels[ch]->pos()]]++;
+        }
+        referenceCount++;
+    }
+
+    KoHistogramProducer *producer = new KoBasicU8HistogramProducer(KoID("RGB8HISTO", "RGB8 Histogram"), cs);
+    KisHistogram histogram(dev, rc, producer, LINEAR);
+
+    QCOMPARE(producer->count(), referenceCount);
+
+    for (int ch = 0; ch < channels.size(); ch++) {
+        for (int bin = 0; bin < 256; bin++) {
+            QCOMPARE(producer->getBinAt(ch, bin), referenceBins[ch][bin]);
+        }
+    }
+}
 
 KISTEST_MAIN(KisHistogramTest)
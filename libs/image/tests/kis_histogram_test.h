@@ -27,6 +27,7 @@ class KisHistogramTest : public QObject
 private Q_SLOTS:
 
     void testCreation();
+    void testParallelCounting();
 
 };
 
@@ -25,6 +25,9 @@
 #include "kis_scalar_keyframe_channel.h"
 #include "kis_raster_keyframe_channel.h"
 #include "kis_node.h"
+#include "kis_image.h"
+#include "kis_paint_layer.h"
+#include "kis_clone_layer.h"
 #include "kis_time_range.h"
 #include "kundo2command.h"
 
@@ -476,6 +479,70 @@ void KisKeyframingTest::testAffectedFrames()
 
 }
 
+void KisKeyframingTest::testFrameContentHash()
+{
+    KisScalarKeyframeChannel *channel = new KisScalarKeyframeChannel(KoID(""), -17, 31, 0);
+
+    KisKeyframeSP key10 = channel->addKeyframe(10);
+    KisKeyframeSP key20 = channel->addKeyframe(20);
+    KisKeyframeSP key30 = channel->addKeyframe(30);
+
+    channel->setScalarValue(key10, 5);
+    channel->setScalarValue(key20, 7);
+    channel->setScalarValue(key30, 5);
+
+    // holds within a keyframe
+    QCOMPARE(channel->frameContentHash(10), channel->frameContentHash(15));
+    QCOMPARE(channel->frameContentHash(20), channel->frameContentHash(29));
+
+    // the value returns back, though the frames are not adjacent
+    QCOMPARE(channel->frameContentHash(15), channel->frameContentHash(35));
+
+    QVERIFY(channel->frameContentHash(15) != channel->frameContentHash(25));
+
+    // interpolated frames have a unique value each
+    channel->setInterpolationMode(key20, KisKeyframe::Linear);
+    QVERIFY(channel->frameContentHash(21) != channel->frameContentHash(22));
+    QCOMPARE(channel->frameContentHash(30), channel->frameContentHash(15));
+
+    delete channel;
+}
+
+void KisKeyframingTest::testFrameContentKeyCloneLayer()
+{
+    KisImageSP image = new KisImage(0, 64, 64, cs, "clone hash test");
+
+    KisPaintLayerSP source = new KisPaintLayer(image, "source", OPACITY_OPAQUE_U8);
+    image->addNode(source);
+
+    KisKeyframeChannel *channel = source->getKeyframeChannel(KisKeyframeChannel::Content.id(), true);
+    channel->addKeyframe(10);
+    channel->addKeyframe(20);
+
+    source->setVisible(false);
+
+    KisNodeSP root = image->root();
+
+    // the hidden layer doesn't affect the frames
+    QCOMPARE(KisTimeRange::calculateFrameContentKeyRecursive(root, 10),
+             KisTimeRange::calculateFrameContentKeyRecursive(root, 20));
+
+    KisLayerSP clone = new KisCloneLayer(source, image, "clone", OPACITY_OPAQUE_U8);
+    image->addNode(clone);
+
+    // ...but the visible clone of it does
+    QCOMPARE(KisTimeRange::calculateFrameContentKeyRecursive(root, 10),
+             KisTimeRange::calculateFrameContentKeyRecursive(root, 15));
+
+    QVERIFY(KisTimeRange::calculateFrameContentKeyRecursive(root, 10) !=
+            KisTimeRange::calculateFrameContentKeyRecursive(root, 20));
+
+    clone->setVisible(false);
+
+    QCOMPARE(KisTimeRange::calculateFrameContentKeyRecursive(root, 10),
+             KisTimeRange::calculateFrameContentKeyRecursive(root, 20));
+}
+
 void KisKeyframingTest::testMovingFrames()
 {
     TestUtil::TestingTimedDefaultBounds *bounds = new TestUtil::TestingTimedDefaultBounds();
@@ -39,6 +39,8 @@ private Q_SLOTS:
     void testRasterFrameFetching();
     void testDeleteFirstRasterChannel();
     void testAffectedFrames();
+    void testFrameContentHash();
+    void testFrameContentKeyCloneLayer();
     void cleanupTestCase();
 
     void testMovingFrames();
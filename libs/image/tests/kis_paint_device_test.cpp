@@ -420,6 +420,33 @@ void KisPaintDeviceTest::testThumbnailDeviceWithOffset()
     QVERIFY(TestUtil::compareQImages(pt, thumb, image));
 }
 
+void KisPaintDeviceTest::testThumbnailIncrementalUpdate()
+{
+    const KoColorSpace * cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+
+    dev->fill(QRect(-100, -100, 1200, 900), KoColor(Qt::white, cs));
+
+    // generates the thumbnail shadow of the device
+    QImage thumb1 = dev->createThumbnail(64, 64, QRect(-100, -100, 1200, 900));
+
+    dev->fill(QRect(300, 200, 70, 90), KoColor(Qt::red, cs));
+    dev->fill(QRect(1050, 750, 200, 200), KoColor(Qt::blue, cs));
+    dev->clear(QRect(-100, -100, 64, 64));
+
+    // updates only the changed tiles of the shadow
+    QImage thumb2 = dev->createThumbnail(64, 64, QRect(-100, -100, 1200, 900));
+
+    // a fresh copy has no shadow yet, so it is generated from scratch
+    KisPaintDeviceSP copy = new KisPaintDevice(*dev);
+    QImage expected = copy->createThumbnail(64, 64, QRect(-100, -100, 1200, 900));
+
+    QVERIFY(thumb1 != thumb2);
+
+    QPoint pt;
+    QVERIFY(TestUtil::compareQImages(pt, expected, thumb2));
+}
+
 void KisPaintDeviceTest::testCaching()
 {
     const KoColorSpace * cs = KoColorSpaceRegistry::instance()->rgb8();
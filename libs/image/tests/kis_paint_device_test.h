@@ -34,6 +34,7 @@ private Q_SLOTS:
     void testCrop();
     void testThumbnail();
     void testThumbnailDeviceWithOffset();
+    void testThumbnailIncrementalUpdate();
     void testCaching();
     void testRegion();
     void testPixel();
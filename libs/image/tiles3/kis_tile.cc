@@ -208,6 +208,12 @@ void KisTile::unlock() const
     DEBUG_LOG_ACTION("unlock");
 }
 
+void KisTile::unlockForWrite()
+{
+    m_tileData->bumpRevision();
+    unlock();
+}
+
 
 #include <stdio.h>
 void KisTile::debugPrintInfo()
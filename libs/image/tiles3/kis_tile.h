@@ -75,6 +75,12 @@ public:
     void lockForWrite();
     void unlock() const;
 
+    /**
+     * Unlocks the tile locked with lockForWrite() and marks its
+     * data as changed, \see KisTileData::revision()
+     */
+    void unlockForWrite();
+
     /* this allows us work directly on tile's data */
     inline quint8 *data() const {
         return m_tileData->data();
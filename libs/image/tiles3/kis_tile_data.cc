@@ -37,6 +37,7 @@ const qint32 KisTileData::WIDTH = __TILE_DATA_WIDTH;
 const qint32 KisTileData::HEIGHT = __TILE_DATA_HEIGHT;
 
 SimpleCache KisTileData::m_cache;
+QAtomicInteger<quint64> KisTileData::m_revisionCounter;
 
 SimpleCache::~SimpleCache()
 {
@@ -69,7 +70,8 @@ KisTileData::KisTileData(qint32 pixelSize, const quint8 *defPixel, KisTileDataSt
       m_usersCount(0),
       m_refCount(0),
       m_pixelSize(pixelSize),
-      m_store(store)
+      m_store(store),
+      m_revision(nextRevision())
 {
     if (checkFreeMemory) {
         m_store->checkFreeMemory();
@@ -98,7 +100,8 @@ KisTileData::KisTileData(const KisTileData& rhs, bool checkFreeMemory)
       m_usersCount(0),
       m_refCount(0),
       m_pixelSize(rhs.m_pixelSize),
-      m_store(rhs.m_store)
+      m_store(rhs.m_store),
+      m_revision(nextRevision())
 {
     if (checkFreeMemory) {
         m_store->checkFreeMemory();
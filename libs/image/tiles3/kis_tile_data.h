@@ -38,12 +38,25 @@ inline quint8* KisTileData::data() const {
 void KisTileData::setData(const quint8 *data) {
     Q_ASSERT(m_data);
     memcpy(m_data, data, m_pixelSize*WIDTH*HEIGHT);
+    bumpRevision();
 }
 
 inline quint32 KisTileData::pixelSize() const {
     return m_pixelSize;
 }
 
+inline quint64 KisTileData::nextRevision() {
+    return m_revisionCounter.fetchAndAddOrdered(1) + 1;
+}
+
+inline quint64 KisTileData::revision() const {
+    return m_revision.loadAcquire();
+}
+
+inline void KisTileData::bumpRevision() {
+    m_revision.storeRelease(nextRevision());
+}
+
 inline bool KisTileData::acquire() {
     /**
      * We need to ensure the clones in the stack are
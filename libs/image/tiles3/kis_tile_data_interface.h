@@ -22,6 +22,7 @@
 
 #include <QReadWriteLock>
 #include <QAtomicInt>
+#include <QAtomicInteger>
 
 #include "kis_lockless_stack.h"
 #include "swap/kis_chunk_allocator.h"
@@ -121,6 +122,18 @@ public:
     inline void setData(const quint8 *data);
     inline quint32 pixelSize() const;
 
+    /**
+     * A number identifying the content of the tile data. Every tile
+     * data gets a unique revision on creation and a new one every
+     * time it is written, so the caches of the data derived from the
+     * tile's pixels can use it for validation.
+     *
+     * The revision is changed *after* the data has been written, so
+     * the reader should fetch the revision *before* reading the data.
+     */
+    inline quint64 revision() const;
+    inline void bumpRevision();
+
     /**
      * Increments usersCount of a TD and refs shared pointer counter
      * Used by KisTile for COW
@@ -223,6 +236,8 @@ public:
 private:
     void fillWithPixel(const quint8 *defPixel);
 
+    static inline quint64 nextRevision();
+
     static quint8* allocateData(const qint32 pixelSize);
     static void freeData(quint8 *ptr, const qint32 pixelSize);
 private:
@@ -316,6 +331,9 @@ private:
     qint32 m_pixelSize;
     //qint32 m_timeStamp;
 
+    QAtomicInteger<quint64> m_revision;
+    static QAtomicInteger<quint64> m_revisionCounter;
+
     KisTileDataStore *m_store;
     static SimpleCache m_cache;
 
@@ -19,6 +19,8 @@
 #ifndef KIS_TILEHASHTABLE_2_H
 #define KIS_TILEHASHTABLE_2_H
 
+#include <QtMath>
+
 #include "kis_shared.h"
 #include "kis_shared_ptr.h"
 #include "3rdparty/lock_free_map/concurrent_map.h"
@@ -114,6 +116,12 @@ public:
     friend class KisTileHashTableIteratorTraits2<T>;
 
 private:
+    static quint64 mapCapacity(qint32 numTiles)
+    {
+        // keep the load factor below 50%, the map needs a power of two
+        return qMax(quint64(8), quint64(qNextPowerOfTwo(quint32(numTiles) * 2)));
+    }
+
     struct MemoryReclaimer {
         MemoryReclaimer(TileType *data) : d(data) {}
 
@@ -256,18 +264,33 @@ KisTileHashTableTraits2<T>::KisTileHashTableTraits2(KisMementoManager *mm)
 
 template <class T>
 KisTileHashTableTraits2<T>::KisTileHashTableTraits2(const KisTileHashTableTraits2<T> &ht, KisMementoManager *mm)
-    : KisTileHashTableTraits2(mm)
+    : m_map(mapCapacity(ht.m_numTiles.load())),
+      m_numTiles(0), m_defaultTileData(0), m_mementoManager(mm)
 {
     setDefaultTileData(ht.m_defaultTileData);
 
     QWriteLocker locker(&ht.m_iteratorLock);
     typename ConcurrentMap<quint32, TileType*>::Iterator iter(ht.m_map);
 
+    /**
+     * The new tiles share the data with the tiles of ht, the data is
+     * copied only when one of the tiles is locked for writing. So the
+     * only per-tile work is creating the wrappers. The map is allocated
+     * to fit all of them at once and nobody can access it until we
+     * return, so we avoid table migrations and per-tile locking here.
+     */
+    qint32 numTiles = 0;
+
     while (iter.isValid()) {
         TileTypeSP tile = new TileType(*iter.getValue(), m_mementoManager);
-        insert(iter.getKey(), tile);
+        TileTypeSP::ref(&tile, tile.data());
+        m_map.assign(iter.getKey(), tile.data());
+        numTiles++;
         iter.next();
     }
+
+    m_numTiles.store(numTiles);
+    m_map.getGC().update(m_map.migrationInProcess());
 }
 
 template <class T>
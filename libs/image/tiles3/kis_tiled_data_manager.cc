@@ -628,7 +628,7 @@ void KisTiledDataManager::setExtent(QRect newRect)
                         }
                     }
                 }
-                tile->unlock();
+                tile->unlockForWrite();
                 iter.next();
             } else {
                 m_extentManager.notifyTileRemoved(tile->col(), tile->row());
@@ -696,6 +696,37 @@ void KisTiledDataManager::writeBytes(const quint8 *data,
     writeBytesBody(data, x, y, width, height, dataRowStride);
 }
 
+QVector<quint64> KisTiledDataManager::tileRevisions(const QRect &rect) const
+{
+    QVector<quint64> revisions;
+    if (rect.isEmpty()) return revisions;
+
+    QReadLocker locker(&m_lock);
+
+    const qint32 firstColumn = xToCol(rect.left());
+    const qint32 lastColumn = xToCol(rect.right());
+    const qint32 firstRow = yToRow(rect.top());
+    const qint32 lastRow = yToRow(rect.bottom());
+
+    revisions.reserve((lastColumn - firstColumn + 1) * (lastRow - firstRow + 1));
+
+    // XXX: Ugly const cast because of the old pixelPtr design copied from tiles1.
+    KisTiledDataManager *dm = const_cast<KisTiledDataManager*>(this);
+
+    for (qint32 row = firstRow; row <= lastRow; ++row) {
+        for (qint32 column = firstColumn; column <= lastColumn; ++column) {
+            bool unused;
+            KisTileSP tile = dm->getReadOnlyTileLazy(column, row, unused);
+
+            tile->lockForRead();
+            revisions << tile->tileData()->revision();
+            tile->unlock();
+        }
+    }
+
+    return revisions;
+}
+
 void KisTiledDataManager::readBytes(quint8 *data,
                                     qint32 x, qint32 y,
                                     qint32 width, qint32 height,
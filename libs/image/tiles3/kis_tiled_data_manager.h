@@ -228,6 +228,14 @@ public:
 
     QRegion region() const;
 
+    /**
+     * Returns the revisions of the tiles covering \p rect, row by row,
+     * \see KisTileData::revision(). A revision changes every time the
+     * tile is written, so the values can be used for validating the
+     * caches of the data derived from the content of the device.
+     */
+    QVector<quint64> tileRevisions(const QRect &rect) const;
+
     void clear(QRect clearRect, quint8 clearValue);
     void clear(QRect clearRect, const quint8 *clearPixel);
     void clear(qint32 x, qint32 y, qint32 w, qint32 h, quint8 clearValue);
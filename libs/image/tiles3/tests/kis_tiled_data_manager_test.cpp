@@ -350,6 +350,80 @@ void KisTiledDataManagerTest::testBitBltRough()
     delete[] buffer;
 }
 
+void KisTiledDataManagerTest::testTileRevisions()
+{
+    quint8 defaultPixel = 0;
+    KisTiledDataManager srcDM(1, &defaultPixel);
+    KisTiledDataManager dstDM(1, &defaultPixel);
+
+    const QRect tileRect(0,0,64,64);
+    quint8 oddPixel1 = 128;
+    quint8 oddPixel2 = 129;
+    quint8 buffer = 0;
+
+    QCOMPARE(srcDM.tileRevisions(QRect(0,0,128,128)).size(), 4);
+    QCOMPARE(srcDM.tileRevisions(QRect(10,10,10,10)).size(), 1);
+    QVERIFY(srcDM.tileRevisions(QRect()).isEmpty());
+
+    srcDM.clear(tileRect, &oddPixel1);
+    const QVector<quint64> initialRevisions = srcDM.tileRevisions(tileRect);
+
+    // reading doesn't change the revision
+    srcDM.readBytes(&buffer, 10, 10, 1, 1);
+    QCOMPARE(srcDM.tileRevisions(tileRect), initialRevisions);
+
+    // writing does
+    srcDM.writeBytes(&oddPixel2, 10, 10, 1, 1);
+    const QVector<quint64> changedRevisions = srcDM.tileRevisions(tileRect);
+    QVERIFY(changedRevisions != initialRevisions);
+
+    // the shared tiles have the same revision...
+    dstDM.bitBltRough(&srcDM, tileRect);
+    QCOMPARE(dstDM.tileRevisions(tileRect), changedRevisions);
+
+    // ...until one of them is written
+    srcDM.writeBytes(&oddPixel1, 10, 10, 1, 1);
+    QVERIFY(srcDM.tileRevisions(tileRect) != changedRevisions);
+    QCOMPARE(dstDM.tileRevisions(tileRect), changedRevisions);
+}
+
+void KisTiledDataManagerTest::testCopyConstructor()
+{
+    quint8 defaultPixel = 0;
+    KisTiledDataManager srcDM(1, &defaultPixel);
+
+    quint8 oddPixel1 = 128;
+    quint8 oddPixel2 = 129;
+
+    QRect rect(0,0,1024,1024);
+    QRect tilesRect(0,0,16,16);
+    QRect clearRect(100,100,100,100);
+
+    srcDM.clear(rect, &oddPixel1);
+
+    KisTiledDataManager dstDM(srcDM);
+
+    QCOMPARE(dstDM.extent(), srcDM.extent());
+    QVERIFY(checkTilesShared(&srcDM, &dstDM, false, false, tilesRect));
+
+    srcDM.clear(clearRect, &oddPixel2);
+
+    quint8 *buffer = new quint8[rect.width()*rect.height()];
+
+    dstDM.readBytes(buffer, rect.x(), rect.y(), rect.width(), rect.height());
+    QVERIFY(checkHole(buffer, oddPixel1, rect,
+                      defaultPixel, rect));
+
+    srcDM.readBytes(buffer, rect.x(), rect.y(), rect.width(), rect.height());
+    QVERIFY(checkHole(buffer, oddPixel2, clearRect,
+                      oddPixel1, rect));
+
+    QVERIFY(checkTilesNotShared(&srcDM, &dstDM, false, false, QRect(1,1,3,3)));
+    QVERIFY(checkTilesShared(&srcDM, &dstDM, false, false, QRect(4,4,12,12)));
+
+    delete[] buffer;
+}
+
 void KisTiledDataManagerTest::testTransactions()
 {
     quint8 defaultPixel = 0;
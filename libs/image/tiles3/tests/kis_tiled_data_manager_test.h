@@ -52,6 +52,8 @@ private Q_SLOTS:
     void testTransactions();
     void testPurgeHistory();
     void testUndoSetDefaultPixel();
+    void testTileRevisions();
+    void testCopyConstructor();
 
     void benchmarkReadOnlyTileLazy();
     void benchmarkSharedPointers();
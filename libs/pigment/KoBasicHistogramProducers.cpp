@@ -18,6 +18,9 @@
 
 #include "KoBasicHistogramProducers.h"
 
+#include <QScopedArrayPointer>
+#include <QVarLengthArray>
+
 #include <QString>
 #include <klocalizedstring.h>
 
@@ -29,6 +32,7 @@
 // #include "Ko_global.h"
 #include "KoIntegerMaths.h"
 #include "KoChannelInfo.h"
+#include "kis_assert.h"
 
 static const KoColorSpace* m_labCs = 0;
 
@@ -103,8 +107,21 @@ void KoBasicHistogramProducer::makeExternalToInternal()
 // ------------ U8 ---------------------
 
 KoBasicU8HistogramProducer::KoBasicU8HistogramProducer(const KoID& id, const KoColorSpace *cs)
-    : KoBasicHistogramProducer(id, 256, cs)
+    : KoBasicHistogramProducer(id, 256, cs),
+      m_alphaPos(-1)
+{
+    Q_FOREACH (const KoChannelInfo *channel, cs->channels()) {
+        if (channel->channelType() == KoChannelInfo::ALPHA) {
+            m_alphaPos = channel->pos();
+        }
+    }
+}
+
+KoHistogramProducer *KoBasicU8HistogramProducer::createPartialProducer() const
 {
+    KoBasicU8HistogramProducer *producer = new KoBasicU8HistogramProducer(*this);
+    producer->clear();
+    return producer;
 }
 
 QString KoBasicU8HistogramProducer::positionToString(qreal pos) const
@@ -112,40 +129,117 @@ QString KoBasicU8HistogramProducer::positionToString(qreal pos) const
     return QString("%1").arg(static_cast<quint8>(pos * UINT8_MAX));
 }
 
+namespace {
+
+/**
+ * Counts the bytes of 8-bit pixels. When the number of channels is known
+ * at compile time, the inner loop is fully unrolled and the compiler is
+ * free to keep the bin pointers in registers. Pass zero as \p channels_nb
+ * to use the number of channels passed at runtime instead.
+ */
+template <int channels_nb>
+void countU8Pixels(const quint8 *src, const quint8 *selectionMask,
+                   quint32 nPixels, int numChannels, int alphaPos,
+                   quint32 **bins, qint32 *count)
+{
+    const int channels = channels_nb ? channels_nb : numChannels;
+    qint32 numCounted = 0;
+
+    for (quint32 i = 0; i < nPixels; i++, src += channels) {
+        if ((selectionMask && !selectionMask[i]) ||
+            (alphaPos >= 0 && src[alphaPos] == OPACITY_TRANSPARENT_U8)) {
+
+            continue;
+        }
+
+        for (int ch = 0; ch < channels; ch++) {
+            bins[ch][src[ch]]++;
+        }
+        numCounted++;
+    }
+
+    *count += numCounted;
+}
+
+}
+
 void KoBasicU8HistogramProducer::addRegionToBin(const quint8 * pixels, const quint8 * selectionMask, quint32 nPixels, const KoColorSpace *cs)
 {
-    quint32 dstPixelSize = m_colorSpace->pixelSize();
-    quint8 *dstPixels = new quint8[nPixels * dstPixelSize];
-    cs->convertPixelsTo(pixels, dstPixels, m_colorSpace, nPixels, KoColorConversionTransformation::IntentAbsoluteColorimetric, KoColorConversionTransformation::Empty);
+    const quint32 pixelSize = m_colorSpace->pixelSize();
 
-    if (selectionMask) {
-        quint8 *dst = dstPixels;
-        while (nPixels > 0) {
-            if (!(m_skipTransparent && cs->opacityU8(pixels) == OPACITY_TRANSPARENT_U8)) {
+    /**
+     * The pixels are converted only when they come in a different color
+     * space, otherwise they are counted right from the source buffer.
+     */
+    QScopedArrayPointer<quint8> convertedPixels;
+    const quint8 *src = pixels;
 
-                for (int i = 0; i < (int)m_colorSpace->channelCount(); i++) {
-                    m_bins[i][m_colorSpace->scaleToU8(dst,i)]++;
-                }
-                m_count++;
-            }
-            dst += dstPixelSize;
-            selectionMask++;
-            nPixels--;
+    if (!(*cs == *m_colorSpace)) {
+        convertedPixels.reset(new quint8[nPixels * pixelSize]);
+        cs->convertPixelsTo(pixels, convertedPixels.data(), m_colorSpace, nPixels, KoColorConversionTransformation::IntentAbsoluteColorimetric, KoColorConversionTransformation::Empty);
+        src = convertedPixels.data();
+    }
+
+    const quint8 *mask = m_skipUnselected ? selectionMask : 0;
+
+    if (pixelSize == quint32(m_channels)) {
+        const int alphaPos = m_skipTransparent ? m_alphaPos : -1;
+
+        QVarLengthArray<quint32*, 8> bins(m_channels);
+        for (int i = 0; i < m_channels; i++) {
+            bins[i] = m_bins[i].data();
+        }
+
+        switch (m_channels) {
+        case 2:
+            countU8Pixels<2>(src, mask, nPixels, m_channels, alphaPos, bins.data(), &m_count);
+            break;
+        case 4:
+            countU8Pixels<4>(src, mask, nPixels, m_channels, alphaPos, bins.data(), &m_count);
+            break;
+        case 5:
+            countU8Pixels<5>(src, mask, nPixels, m_channels, alphaPos, bins.data(), &m_count);
+            break;
+        default:
+            countU8Pixels<0>(src, mask, nPixels, m_channels, alphaPos, bins.data(), &m_count);
+            break;
         }
     } else {
-        quint8 *dst = dstPixels;
-        while (nPixels > 0) {
-            if (!(m_skipTransparent && cs->opacityU8(pixels) == OPACITY_TRANSPARENT_U8)) {
+        for (quint32 i = 0; i < nPixels; i++, src += pixelSize) {
+            if ((mask && !mask[i]) ||
+                (m_skipTransparent && m_colorSpace->opacityU8(src) == OPACITY_TRANSPARENT_U8)) {
 
-                for (int i = 0; i < (int)m_colorSpace->channelCount(); i++) {
-                    m_bins[i][m_colorSpace->scaleToU8(dst,i)]++;
-                }
-                m_count++;
+                continue;
             }
-            dst += dstPixelSize;
-            nPixels--;
+
+            for (int ch = 0; ch < m_channels; ch++) {
+                m_bins[ch][m_colorSpace->scaleToU8(src, ch)]++;
+            }
+            m_count++;
+        }
+    }
+}
+
+void KoBasicHistogramProducer::merge(const KoHistogramProducer *partial)
+{
+    const KoBasicHistogramProducer *other = dynamic_cast<const KoBasicHistogramProducer*>(partial);
+    KIS_SAFE_ASSERT_RECOVER_RETURN(other);
+    KIS_SAFE_ASSERT_RECOVER_RETURN(other->m_channels == m_channels &&
+                                   other->m_nrOfBins == m_nrOfBins);
+
+    for (int i = 0; i < m_channels; i++) {
+        quint32 *dst = m_bins[i].data();
+        const quint32 *src = other->m_bins[i].constData();
+
+        for (int j = 0; j < m_nrOfBins; j++) {
+            dst[j] += src[j];
         }
+
+        m_outLeft[i] += other->m_outLeft[i];
+        m_outRight[i] += other->m_outRight[i];
     }
+
+    m_count += other->m_count;
 }
 
 // ------------ U16 ---------------------
@@ -160,6 +254,13 @@ QString KoBasicU16HistogramProducer::positionToString(qreal pos) const
     return QString("%1").arg(static_cast<quint8>(pos * UINT8_MAX));
 }
 
+KoHistogramProducer *KoBasicU16HistogramProducer::createPartialProducer() const
+{
+    KoBasicU16HistogramProducer *producer = new KoBasicU16HistogramProducer(*this);
+    producer->clear();
+    return producer;
+}
+
 qreal KoBasicU16HistogramProducer::maximalZoom() const
 {
     return 1.0 / 255.0;
@@ -174,9 +275,9 @@ void KoBasicU16HistogramProducer::addRegionToBin(const quint8 * pixels, const qu
     qreal factor = 255.0 / width;
 
     quint32 dstPixelSize = m_colorSpace->pixelSize();
-    quint8 *dstPixels = new quint8[nPixels * dstPixelSize];
-    cs->convertPixelsTo(pixels, dstPixels, m_colorSpace, nPixels, KoColorConversionTransformation::IntentAbsoluteColorimetric, KoColorConversionTransformation::Empty);
-    quint8 *dst = dstPixels;
+    QVector<quint8> dstPixels(nPixels * dstPixelSize);
+    cs->convertPixelsTo(pixels, dstPixels.data(), m_colorSpace, nPixels, KoColorConversionTransformation::IntentAbsoluteColorimetric, KoColorConversionTransformation::Empty);
+    const quint8 *dst = dstPixels.constData();
     QVector<float> channels(m_colorSpace->channelCount());
 
     if (selectionMask) {
@@ -231,6 +332,13 @@ QString KoBasicF32HistogramProducer::positionToString(qreal pos) const
     return QString("%1").arg(static_cast<float>(pos)); // XXX I doubt this is correct!
 }
 
+KoHistogramProducer *KoBasicF32HistogramProducer::createPartialProducer() const
+{
+    KoBasicF32HistogramProducer *producer = new KoBasicF32HistogramProducer(*this);
+    producer->clear();
+    return producer;
+}
+
 qreal KoBasicF32HistogramProducer::maximalZoom() const
 {
     // XXX What _is_ the maximal zoom here? I don't think there is one with floats, so this seems a fine compromis for the moment
@@ -246,9 +354,9 @@ void KoBasicF32HistogramProducer::addRegionToBin(const quint8 * pixels, const qu
     float factor = 255.0 / width;
 
     quint32 dstPixelSize = m_colorSpace->pixelSize();
-    quint8 *dstPixels = new quint8[nPixels * dstPixelSize];
-    cs->convertPixelsTo(pixels, dstPixels, m_colorSpace, nPixels, KoColorConversionTransformation::IntentAbsoluteColorimetric, KoColorConversionTransformation::Empty);
-    quint8 *dst = dstPixels;
+    QVector<quint8> dstPixels(nPixels * dstPixelSize);
+    cs->convertPixelsTo(pixels, dstPixels.data(), m_colorSpace, nPixels, KoColorConversionTransformation::IntentAbsoluteColorimetric, KoColorConversionTransformation::Empty);
+    const quint8 *dst = dstPixels.constData();
     QVector<float> channels(m_colorSpace->channelCount());
 
     if (selectionMask) {
@@ -306,6 +414,13 @@ QString KoBasicF16HalfHistogramProducer::positionToString(qreal pos) const
     return QString("%1").arg(static_cast<float>(pos)); // XXX I doubt this is correct!
 }
 
+KoHistogramProducer *KoBasicF16HalfHistogramProducer::createPartialProducer() const
+{
+    KoBasicF16HalfHistogramProducer *producer = new KoBasicF16HalfHistogramProducer(*this);
+    producer->clear();
+    return producer;
+}
+
 qreal KoBasicF16HalfHistogramProducer::maximalZoom() const
 {
     // XXX What _is_ the maximal zoom here? I don't think there is one with floats, so this seems a fine compromis for the moment
@@ -321,9 +436,9 @@ void KoBasicF16HalfHistogramProducer::addRegionToBin(const quint8 * pixels, cons
     float factor = 255.0 / width;
 
     quint32 dstPixelSize = m_colorSpace->pixelSize();
-    quint8 *dstPixels = new quint8[nPixels * dstPixelSize];
-    cs->convertPixelsTo(pixels, dstPixels, m_colorSpace, nPixels, KoColorConversionTransformation::IntentAbsoluteColorimetric, KoColorConversionTransformation::Empty);
-    quint8 *dst = dstPixels;
+    QVector<quint8> dstPixels(nPixels * dstPixelSize);
+    cs->convertPixelsTo(pixels, dstPixels.data(), m_colorSpace, nPixels, KoColorConversionTransformation::IntentAbsoluteColorimetric, KoColorConversionTransformation::Empty);
+    const quint8 *dst = dstPixels.constData();
     QVector<float> channels(m_colorSpace->channelCount());
 
     if (selectionMask) {
@@ -75,6 +75,8 @@ public:
         return m_outRight.at(externalToInternal(channel));
     }
 
+    void merge(const KoHistogramProducer *partial) override;
+
 protected:
     /**
      * The order in which channels() returns is not the same as the internal representation,
@@ -106,11 +108,15 @@ class KRITAPIGMENT_EXPORT KoBasicU8HistogramProducer : public KoBasicHistogramPr
 public:
     KoBasicU8HistogramProducer(const KoID& id, const KoColorSpace *colorSpace);
     ~KoBasicU8HistogramProducer() override {}
+    KoHistogramProducer *createPartialProducer() const override;
     void addRegionToBin(const quint8 * pixels, const quint8 * selectionMask, quint32 nPixels, const KoColorSpace *colorSpace) override;
     QString positionToString(qreal pos) const override;
     qreal maximalZoom() const override {
         return 1.0;
     }
+
+private:
+    int m_alphaPos;
 };
 
 class KRITAPIGMENT_EXPORT KoBasicU16HistogramProducer : public KoBasicHistogramProducer
@@ -118,6 +124,7 @@ class KRITAPIGMENT_EXPORT KoBasicU16HistogramProducer : public KoBasicHistogramP
 public:
     KoBasicU16HistogramProducer(const KoID& id, const KoColorSpace *colorSpace);
     ~KoBasicU16HistogramProducer() override {}
+    KoHistogramProducer *createPartialProducer() const override;
     void addRegionToBin(const quint8 * pixels, const quint8 * selectionMask, quint32 nPixels, const KoColorSpace *colorSpace) override;
     QString positionToString(qreal pos) const override;
     qreal maximalZoom() const override;
@@ -128,6 +135,7 @@ class KRITAPIGMENT_EXPORT KoBasicF32HistogramProducer : public KoBasicHistogramP
 public:
     KoBasicF32HistogramProducer(const KoID& id, const KoColorSpace *colorSpace);
     ~KoBasicF32HistogramProducer() override {}
+    KoHistogramProducer *createPartialProducer() const override;
     void addRegionToBin(const quint8 * pixels, const quint8 * selectionMask, quint32 nPixels, const KoColorSpace *colorSpace) override;
     QString positionToString(qreal pos) const override;
     qreal maximalZoom() const override;
@@ -140,6 +148,7 @@ class KRITAPIGMENT_EXPORT KoBasicF16HalfHistogramProducer : public KoBasicHistog
 public:
     KoBasicF16HalfHistogramProducer(const KoID& id, const KoColorSpace *colorSpace);
     ~KoBasicF16HalfHistogramProducer() override {}
+    KoHistogramProducer *createPartialProducer() const override;
     void addRegionToBin(const quint8 * pixels, const quint8 * selectionMask, quint32 nPixels, const KoColorSpace *colorSpace) override;
     QString positionToString(qreal pos) const override;
     qreal maximalZoom() const override;
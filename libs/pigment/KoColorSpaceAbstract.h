@@ -28,13 +28,42 @@
 #include <KoColorProfile.h>
 #include <KoColorSpaceMaths.h>
 #include <KoColorSpaceRegistry.h>
+#include <KoColorSpaceTraits.h>
 #include "KoFallBackColorTransformation.h"
 #include "KoLabDarkenColorTransformation.h"
 #include "KoMixColorsOpImpl.h"
+#include "KoOptimizedMixColorsOpFactory.h"
 
 #include "KoConvolutionOpImpl.h"
 #include "KoInvertColorTransformation.h"
 
+namespace _Private {
+
+template<class Traits>
+struct OptimizedMixColorsOpSelector
+{
+    static KoMixColorsOp* create() {
+        return new KoMixColorsOpImpl<Traits>();
+    }
+};
+
+template<>
+struct OptimizedMixColorsOpSelector<KoBgrU8Traits>
+{
+    static KoMixColorsOp* create() {
+        return KoOptimizedMixColorsOpFactory::createMixColorsOp32();
+    }
+};
+
+template<>
+struct OptimizedMixColorsOpSelector<KoRgbF32Traits>
+{
+    static KoMixColorsOp* create() {
+        return KoOptimizedMixColorsOpFactory::createMixColorsOp128();
+    }
+};
+
+}
 
 /**
  * This in an implementation of KoColorSpace which can be used as a base for colorspaces with as many
@@ -51,7 +80,7 @@ class KoColorSpaceAbstract : public KoColorSpace
 {
 public:
     KoColorSpaceAbstract(const QString &id, const QString &name) :
-        KoColorSpace(id, name, new KoMixColorsOpImpl< _CSTrait>(), new KoConvolutionOpImpl< _CSTrait>()) {
+        KoColorSpace(id, name, _Private::OptimizedMixColorsOpSelector<_CSTrait>::create(), new KoConvolutionOpImpl< _CSTrait>()) {
     }
 
     quint32 colorChannelCount() const override {
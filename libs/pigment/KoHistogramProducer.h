@@ -93,6 +93,29 @@ public:
     virtual qint32 getBinAt(qint32 channel, qint32 position) = 0;
     virtual qint32 outOfViewLeft(qint32 channel) = 0;
     virtual qint32 outOfViewRight(qint32 channel) = 0;
+
+    // Methods for feeding the producer from several threads
+
+    /**
+     * Creates a new empty producer with the same settings as this one. The
+     * partial producer can be fed with a part of the image in a separate
+     * thread and then added to this producer with merge().
+     *
+     * The default implementation returns 0, which means that the producer
+     * can be fed from a single thread only.
+     */
+    virtual KoHistogramProducer *createPartialProducer() const {
+        return 0;
+    }
+
+    /**
+     * Adds the bins of \p partial, which has been created with
+     * createPartialProducer(), to the bins of this producer.
+     */
+    virtual void merge(const KoHistogramProducer *partial) {
+        Q_UNUSED(partial);
+    }
+
 protected:
     bool m_skipTransparent;
     bool m_skipUnselected;
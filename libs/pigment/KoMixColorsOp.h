@@ -76,6 +76,29 @@ public:
      */
     virtual void mixColors(const quint8 * const*colors, quint32 nColors, quint8 *dst) const = 0;
     virtual void mixColors(const quint8 *colors, quint32 nColors, quint8 *dst) const = 0;
+
+    /**
+     * Mix \p nRows rows of \p nColors pixels each in one go. Every row
+     * is mixed with the same set of weights and produces a single
+     * destination pixel. It is equivalent to calling mixColors() for
+     * every row, but avoids the per-pixel virtual call and lets the
+     * optimized implementations keep their state between the rows.
+     *
+     * @param colors a pointer toward nRows * nColors consequent source pixels
+     * @param weights the coefficients of the pixels in a row (the sum of
+     *                weights must be equal to 255)
+     * @param nColors the number of pixels in every row
+     * @param nRows the number of rows (and destination pixels)
+     * @param dst a pointer toward nRows consequent destination pixels
+     *
+     * @code
+     * // downscale 2x2 cells, that were rearranged into
+     * // consequent groups of 4 pixels, into a row of pixels
+     * qint16 weights[4] = {64, 64, 64, 63};
+     * mixColorsRows(cells, weights, 4, numCells, dstRow);
+     * @endcode
+     */
+    virtual void mixColorsRows(const quint8 *colors, const qint16 *weights, quint32 nColors, quint32 nRows, quint8 *dst) const = 0;
 };
 
 #endif
@@ -46,6 +46,16 @@ public:
         mixColorsImpl(PointerToArray(colors, _CSTrait::pixelSize), NoWeightsSurrogate(nColors), nColors, dst);
     }
 
+    void mixColorsRows(const quint8 *colors, const qint16 *weights, quint32 nColors, quint32 nRows, quint8 *dst) const override {
+        const int rowStride = nColors * _CSTrait::pixelSize;
+
+        for (quint32 row = 0; row < nRows; row++) {
+            mixColorsImpl(PointerToArray(colors, _CSTrait::pixelSize), WeightsWrapper(weights), nColors, dst);
+            colors += rowStride;
+            dst += _CSTrait::pixelSize;
+        }
+    }
+
 private:
     struct ArrayOfPointers {
         ArrayOfPointers(const quint8 * const* colors)
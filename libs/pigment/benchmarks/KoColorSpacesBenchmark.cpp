@@ -21,8 +21,10 @@
 #include <QTest>
 #include <KoColorSpaceRegistry.h>
 #include <KoColorSpace.h>
+#include <KoMixColorsOp.h>
 
 #define NB_PIXELS 1000000
+#define MIX_KERNEL_SIZE 25
 
 void KoColorSpacesBenchmark::createRowsColumns()
 {
@@ -146,4 +148,64 @@ void KoColorSpacesBenchmark::benchmarkSetAlpha2IndividualCall()
     END_BENCHMARK
 }
 
+void KoColorSpacesBenchmark::benchmarkMixColors_data()
+{
+    createRowsColumns();
+}
+
+void KoColorSpacesBenchmark::benchmarkMixColors()
+{
+    START_BENCHMARK
+
+    /**
+     * Mix every group of MIX_KERNEL_SIZE pixels separately,
+     * the way kernel-based users (e.g. blur) do
+     */
+    const int numGroups = NB_PIXELS / MIX_KERNEL_SIZE;
+    qint16 weights[MIX_KERNEL_SIZE];
+    for (int i = 0; i < MIX_KERNEL_SIZE; i++) {
+        weights[i] = i < 5 ? 11 : 10;
+    }
+
+    KoMixColorsOp *mixOp = colorSpace->mixColorsOp();
+    quint8 *dst = new quint8[pixelSize];
+
+    QBENCHMARK {
+        const quint8* data_it = data;
+        for (int i = 0; i < numGroups; ++i) {
+            mixOp->mixColors(data_it, weights, MIX_KERNEL_SIZE, dst);
+            data_it += MIX_KERNEL_SIZE * pixelSize;
+        }
+    }
+
+    delete[] dst;
+    END_BENCHMARK
+}
+
+void KoColorSpacesBenchmark::benchmarkMixColorsRows_data()
+{
+    createRowsColumns();
+}
+
+void KoColorSpacesBenchmark::benchmarkMixColorsRows()
+{
+    START_BENCHMARK
+
+    const int numGroups = NB_PIXELS / MIX_KERNEL_SIZE;
+    qint16 weights[MIX_KERNEL_SIZE];
+    for (int i = 0; i < MIX_KERNEL_SIZE; i++) {
+        weights[i] = i < 5 ? 11 : 10;
+    }
+
+    KoMixColorsOp *mixOp = colorSpace->mixColorsOp();
+    quint8 *dst = new quint8[numGroups * pixelSize];
+
+    QBENCHMARK {
+        mixOp->mixColorsRows(data, weights, MIX_KERNEL_SIZE, numGroups, dst);
+    }
+
+    delete[] dst;
+    END_BENCHMARK
+}
+
 QTEST_MAIN(KoColorSpacesBenchmark)
@@ -39,6 +39,10 @@ private Q_SLOTS:
     void benchmarkSetAlphaIndividualCall();
     void benchmarkSetAlpha2IndividualCall_data();
     void benchmarkSetAlpha2IndividualCall();
+    void benchmarkMixColors_data();
+    void benchmarkMixColors();
+    void benchmarkMixColorsRows_data();
+    void benchmarkMixColorsRows();
 };
 
 #endif
@@ -22,6 +22,7 @@
 
 #include <KoCompositeOp.h>
 #include "KoCompositeOpFunctions.h"
+#include "KoTransparentRuns.h"
 
 /**
  * A template base class that can be used for most composite modes/ops
@@ -40,6 +41,10 @@
  *        )
  *
  *        where channels_type is _CSTraits::channels_type
+ *
+ *        The class may also shadow the static member transparentSourceIsNoop
+ *        (see below) to let the base class skip the runs of pixels that
+ *        cannot change the destination.
  */
 template<class _CSTraits, class _compositeOp>
 class KoCompositeOpBase : public KoCompositeOp
@@ -49,6 +54,20 @@ class KoCompositeOpBase : public KoCompositeOp
     static const qint32 alpha_pos   = _CSTraits::alpha_pos;
     static const qint32 pixel_size   = _CSTraits::pixelSize;
 
+public:
+    /**
+     * Set to true in _compositeOp if composeColorChannels() leaves the
+     * destination pixel unchanged when the source alpha, the mask or
+     * the opacity is zero, and the destination is either alpha locked,
+     * fully transparent or fully opaque. Then the runs of such pixels
+     * are skipped without calling composeColorChannels() at all.
+     *
+     * Semi-transparent destination pixels are always composed, because
+     * blend() and div() round their color channels even when the source
+     * is transparent, and the result should not depend on skipping.
+     */
+    static const bool transparentSourceIsNoop = false;
+
 public:
     KoCompositeOpBase(const KoColorSpace* cs, const QString& id, const QString& description, const QString& category)
         : KoCompositeOp(cs, id, description, category) { }
@@ -85,6 +104,69 @@ public:
     }
 
 private:
+    /**
+     * Returns the number of pixels starting from the current one that
+     * have either zero opacity, zero mask or fully transparent source,
+     * and that can be skipped without changing the result (see
+     * transparentSourceIsNoop)
+     */
+    template<bool useMask, bool alphaLocked>
+    static inline qint32 skippableRunLength(const channels_type *src, qint32 srcInc,
+                                            const channels_type *dst,
+                                            const quint8 *mask,
+                                            channels_type opacity,
+                                            qint32 maxLength) {
+        using namespace Arithmetic;
+
+        qint32 length = 0;
+
+        if (opacity == zeroValue<channels_type>()) {
+            length = maxLength;
+        } else if (useMask && *mask == 0) {
+            length = KoTransparentRuns::zeroMaskRunLength(mask, maxLength);
+        } else if (alpha_pos != -1 && src[alpha_pos] == zeroValue<channels_type>()) {
+            // a uniform source (srcInc == 0) covers the whole row
+            length = srcInc ?
+                KoTransparentRuns::transparentRunLength<_CSTraits>(reinterpret_cast<const quint8*>(src), maxLength) :
+                maxLength;
+        }
+
+        if (!alphaLocked && alpha_pos != -1) {
+            for (qint32 i = 0; i < length; i++) {
+                const channels_type dstAlpha = dst[alpha_pos];
+
+                if (dstAlpha != zeroValue<channels_type>() &&
+                    dstAlpha != unitValue<channels_type>()) {
+
+                    length = i;
+                    break;
+                }
+
+                dst += channels_nb;
+            }
+        }
+
+        return length;
+    }
+
+    /**
+     * genericComposite() zeroes transparent destination pixels when
+     * not all the channels are processed, so do the same for the
+     * skipped pixels to keep the result independent of skipping.
+     */
+    static inline void clearTransparentPixels(channels_type *dst, qint32 numPixels) {
+        using namespace Arithmetic;
+
+        if (alpha_pos == -1) return;
+
+        for (qint32 i = 0; i < numPixels; i++) {
+            if (dst[alpha_pos] == zeroValue<channels_type>()) {
+                memset(dst, 0, pixel_size);
+            }
+            dst += channels_nb;
+        }
+    }
+
     template<bool useMask, bool alphaLocked, bool allChannelFlags>
     void genericComposite(const KoCompositeOp::ParameterInfo& params, const QBitArray& channelFlags) const {
 
@@ -102,6 +184,25 @@ private:
             const quint8*        mask = maskRowStart;
 
             for(qint32 c=0; c<params.cols; ++c) {
+                if (_compositeOp::transparentSourceIsNoop) {
+                    const qint32 runLength = skippableRunLength<useMask, alphaLocked>(src, srcInc, dst, mask, opacity, params.cols - c);
+
+                    if (runLength) {
+                        if (!allChannelFlags) {
+                            clearTransparentPixels(dst, runLength);
+                        }
+
+                        src += srcInc * runLength;
+                        dst += channels_nb * runLength;
+
+                        if(useMask)
+                            mask += runLength;
+
+                        c += runLength - 1;
+                        continue;
+                    }
+                }
+
                 channels_type srcAlpha = (alpha_pos == -1) ? unitValue<channels_type>() : src[alpha_pos];
                 channels_type dstAlpha = (alpha_pos == -1) ? unitValue<channels_type>() : dst[alpha_pos];
                 channels_type mskAlpha = useMask ? scale<channels_type>(*mask) : unitValue<channels_type>();
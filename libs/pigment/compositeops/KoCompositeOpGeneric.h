@@ -43,6 +43,10 @@ class KoCompositeOpGenericSC: public KoCompositeOpBase< Traits, KoCompositeOpGen
     static const qint32 alpha_pos   = Traits::alpha_pos;
     
 public:
+    // srcAlpha == 0 makes lerp() return the destination, and so does
+    // blend() followed by div() for opaque destination
+    static const bool transparentSourceIsNoop = true;
+
     KoCompositeOpGenericSC(const KoColorSpace* cs, const QString& id, const QString& description, const QString& category)
         : base_class(cs, id, description, category) { }
 
@@ -101,6 +105,10 @@ class KoCompositeOpGenericHSL: public KoCompositeOpBase< Traits, KoCompositeOpGe
     static const qint32 blue_pos  = Traits::blue_pos;
     
 public:
+    // srcAlpha == 0 makes lerp() return the destination, and so does
+    // blend() followed by div() for opaque destination
+    static const bool transparentSourceIsNoop = true;
+
     KoCompositeOpGenericHSL(const KoColorSpace* cs, const QString& id, const QString& description, const QString& category)
         : base_class(cs, id, description, category) { }
     
@@ -94,6 +94,12 @@ struct AlphaDarkenCompositor128 {
 
         const Vc::float_v zeroValue(KoColorSpaceMathsTraits<channels_type>::zeroValue);
 
+        // The source cannot change the destination, since it is
+        // fully transparent
+        if ((src_alpha == zeroValue).isFull()) {
+            return;
+        }
+
         Vc::float_v dst_c1;
         Vc::float_v dst_c2;
         Vc::float_v dst_c3;
@@ -0,0 +1,291 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KOOPTIMIZEDMIXCOLORSOP_H
+#define KOOPTIMIZEDMIXCOLORSOP_H
+
+#include <KoCompositeOp.h>
+#include "KoColorSpaceMaths.h"
+#include "KoColorSpaceTraits.h"
+#include "KoMixColorsOpImpl.h"
+#include "KoStreamedMath.h"
+
+
+/**
+ * An optimized version of the mix colors op for the use in 32-bit
+ * colorspaces with alpha channel placed at the most significant
+ * byte of the pixel: B_G_R_A.
+ *
+ * Only the paths that read the pixels from a consequent array are
+ * vectorized. The array-of-pointers overloads are forwarded to the
+ * generic implementation, since gathering the pixels would eat all
+ * the benefit.
+ *
+ * The sums are calculated in 32-bit integers, exactly like the
+ * generic implementation does, so the result is bit-exact.
+ */
+template<Vc::Implementation _impl>
+class KoOptimizedMixColorsOp32 : public KoMixColorsOpImpl<KoBgrU8Traits>
+{
+    typedef KoMixColorsOpImpl<KoBgrU8Traits> BaseClass;
+    typedef typename KoStreamedMath<_impl>::int_v int_v;
+    typedef typename KoStreamedMath<_impl>::uint_v uint_v;
+
+    static const int pixelSize = 4;
+    static const int alpha_pos = 3;
+
+public:
+    using BaseClass::mixColors;
+
+    void mixColors(const quint8 *colors, const qint16 *weights, quint32 nColors, quint8 *dst) const override {
+        mixColorsImpl<true>(colors, weights, nColors, dst);
+    }
+
+    void mixColors(const quint8 *colors, quint32 nColors, quint8 *dst) const override {
+        mixColorsImpl<false>(colors, 0, nColors, dst);
+    }
+
+    void mixColorsRows(const quint8 *colors, const qint16 *weights, quint32 nColors, quint32 nRows, quint8 *dst) const override {
+        const int rowStride = nColors * pixelSize;
+
+        for (quint32 row = 0; row < nRows; row++) {
+            mixColorsImpl<true>(colors, weights, nColors, dst);
+            colors += rowStride;
+            dst += pixelSize;
+        }
+    }
+
+private:
+    template<bool useWeights>
+    static void mixColorsImpl(const quint8 *colors, const qint16 *weights, quint32 nColors, quint8 *dst) {
+        const int vectorSize = Vc::float_v::size();
+        const quint32 numVectors = nColors / vectorSize;
+
+        qint32 totals[3] = {0, 0, 0};
+        qint32 totalAlpha = 0;
+
+        if (numVectors) {
+            int_v c1Total(Vc::Zero);
+            int_v c2Total(Vc::Zero);
+            int_v c3Total(Vc::Zero);
+            int_v alphaTotal(Vc::Zero);
+
+            const quint32 lowByteMask = 0xFF;
+            const uint_v mask(lowByteMask);
+
+            for (quint32 i = 0; i < numVectors; i++) {
+                uint_v data_i;
+                data_i.load(reinterpret_cast<const quint32*>(colors), Vc::Unaligned);
+
+                int_v alphaTimesWeight = int_v(data_i >> 24);
+
+                if (useWeights) {
+                    int_v weights_i;
+                    weights_i.load(weights, Vc::Unaligned);
+                    alphaTimesWeight *= weights_i;
+                    weights += vectorSize;
+                }
+
+                c1Total += int_v((data_i >> 16) & mask) * alphaTimesWeight;
+                c2Total += int_v((data_i >> 8) & mask) * alphaTimesWeight;
+                c3Total += int_v(data_i & mask) * alphaTimesWeight;
+                alphaTotal += alphaTimesWeight;
+
+                colors += vectorSize * pixelSize;
+            }
+
+            totals[2] = c1Total.sum();
+            totals[1] = c2Total.sum();
+            totals[0] = c3Total.sum();
+            totalAlpha = alphaTotal.sum();
+        }
+
+        for (quint32 i = numVectors * vectorSize; i < nColors; i++) {
+            qint32 alphaTimesWeight = colors[alpha_pos];
+
+            if (useWeights) {
+                alphaTimesWeight *= *weights;
+                weights++;
+            }
+
+            totals[0] += colors[0] * alphaTimesWeight;
+            totals[1] += colors[1] * alphaTimesWeight;
+            totals[2] += colors[2] * alphaTimesWeight;
+            totalAlpha += alphaTimesWeight;
+
+            colors += pixelSize;
+        }
+
+        const int sumOfWeights = useWeights ? 255 : nColors;
+
+        if (totalAlpha > 255 * sumOfWeights) {
+            totalAlpha = 255 * sumOfWeights;
+        }
+
+        if (totalAlpha > 0) {
+            for (int i = 0; i < 3; i++) {
+                dst[i] = qBound(0, totals[i] / totalAlpha, 255);
+            }
+            dst[alpha_pos] = totalAlpha / sumOfWeights;
+        } else {
+            memset(dst, 0, pixelSize);
+        }
+    }
+};
+
+/**
+ * An optimized version of the mix colors op for the use in 128-bit
+ * (floating point) colorspaces with alpha channel placed at the last
+ * channel of the pixel: C1_C2_C3_A.
+ *
+ * The vectorized part of the sum is accumulated in single precision,
+ * so the result may differ from the generic implementation by a few
+ * ULPs.
+ */
+template<Vc::Implementation _impl>
+class KoOptimizedMixColorsOp128 : public KoMixColorsOpImpl<KoRgbF32Traits>
+{
+    typedef KoMixColorsOpImpl<KoRgbF32Traits> BaseClass;
+    typedef typename KoStreamedMath<_impl>::int_v int_v;
+
+    static const int pixelSize = 16;
+    static const int alpha_pos = 3;
+
+    struct Pixel {
+        float red;
+        float green;
+        float blue;
+        float alpha;
+    };
+
+public:
+    using BaseClass::mixColors;
+
+    void mixColors(const quint8 *colors, const qint16 *weights, quint32 nColors, quint8 *dst) const override {
+        mixColorsImpl<true>(colors, weights, nColors, dst);
+    }
+
+    void mixColors(const quint8 *colors, quint32 nColors, quint8 *dst) const override {
+        mixColorsImpl<false>(colors, 0, nColors, dst);
+    }
+
+    void mixColorsRows(const quint8 *colors, const qint16 *weights, quint32 nColors, quint32 nRows, quint8 *dst) const override {
+        const int rowStride = nColors * pixelSize;
+
+        for (quint32 row = 0; row < nRows; row++) {
+            mixColorsImpl<true>(colors, weights, nColors, dst);
+            colors += rowStride;
+            dst += pixelSize;
+        }
+    }
+
+private:
+    template<bool useWeights>
+    static void mixColorsImpl(const quint8 *colors, const qint16 *weights, quint32 nColors, quint8 *dst) {
+        const int vectorSize = Vc::float_v::size();
+        const quint32 numVectors = nColors / vectorSize;
+
+        double totals[3] = {0.0, 0.0, 0.0};
+        double totalAlpha = 0.0;
+
+        if (numVectors) {
+            Vc::float_v c1Total(Vc::Zero);
+            Vc::float_v c2Total(Vc::Zero);
+            Vc::float_v c3Total(Vc::Zero);
+            Vc::float_v alphaTotal(Vc::Zero);
+
+            const Vc::float_v::IndexType indexes(Vc::IndexesFromZero);
+
+            for (quint32 i = 0; i < numVectors; i++) {
+                Vc::float_v c1;
+                Vc::float_v c2;
+                Vc::float_v c3;
+                Vc::float_v alphaTimesWeight;
+
+                Pixel *sp = const_cast<Pixel*>(reinterpret_cast<const Pixel*>(colors));
+                Vc::InterleavedMemoryWrapper<Pixel, Vc::float_v> data(sp);
+                tie(c1, c2, c3, alphaTimesWeight) = data[indexes];
+
+                if (useWeights) {
+                    int_v weights_i;
+                    weights_i.load(weights, Vc::Unaligned);
+                    alphaTimesWeight *= Vc::float_v(weights_i);
+                    weights += vectorSize;
+                }
+
+                c1Total += c1 * alphaTimesWeight;
+                c2Total += c2 * alphaTimesWeight;
+                c3Total += c3 * alphaTimesWeight;
+                alphaTotal += alphaTimesWeight;
+
+                colors += vectorSize * pixelSize;
+            }
+
+            totals[0] = c1Total.sum();
+            totals[1] = c2Total.sum();
+            totals[2] = c3Total.sum();
+            totalAlpha = alphaTotal.sum();
+        }
+
+        for (quint32 i = numVectors * vectorSize; i < nColors; i++) {
+            const float *color = reinterpret_cast<const float*>(colors);
+            double alphaTimesWeight = color[alpha_pos];
+
+            if (useWeights) {
+                alphaTimesWeight *= *weights;
+                weights++;
+            }
+
+            totals[0] += color[0] * alphaTimesWeight;
+            totals[1] += color[1] * alphaTimesWeight;
+            totals[2] += color[2] * alphaTimesWeight;
+            totalAlpha += alphaTimesWeight;
+
+            colors += pixelSize;
+        }
+
+        const int sumOfWeights = useWeights ? 255 : nColors;
+        const double maxAlpha = double(KoColorSpaceMathsTraits<float>::unitValue) * sumOfWeights;
+
+        if (totalAlpha > maxAlpha) {
+            totalAlpha = maxAlpha;
+        }
+
+        float *dstColor = reinterpret_cast<float*>(dst);
+
+        if (totalAlpha > 0) {
+            for (int i = 0; i < 3; i++) {
+                double v = totals[i] / totalAlpha;
+
+                if (v > KoColorSpaceMathsTraits<float>::max) {
+                    v = KoColorSpaceMathsTraits<float>::max;
+                }
+                if (v < KoColorSpaceMathsTraits<float>::min) {
+                    v = KoColorSpaceMathsTraits<float>::min;
+                }
+                dstColor[i] = v;
+            }
+            dstColor[alpha_pos] = totalAlpha / sumOfWeights;
+        } else {
+            memset(dst, 0, pixelSize);
+        }
+    }
+};
+
+#endif // KOOPTIMIZEDMIXCOLORSOP_H
@@ -0,0 +1,39 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KOOPTIMIZEDMIXCOLORSOPFACTORY_H
+#define KOOPTIMIZEDMIXCOLORSOPFACTORY_H
+
+#include "kritapigment_export.h"
+
+class KoMixColorsOp;
+
+/**
+ * Creates the vectorized versions of the mix colors op. The ops are
+ * compiled in a separate per-arch objects module for the same reasons
+ * as the ones in KoOptimizedCompositeOpFactory.
+ */
+class KRITAPIGMENT_EXPORT KoOptimizedMixColorsOpFactory
+{
+public:
+    static KoMixColorsOp* createMixColorsOp32();
+    static KoMixColorsOp* createMixColorsOp128();
+};
+
+#endif /* KOOPTIMIZEDMIXCOLORSOPFACTORY_H */
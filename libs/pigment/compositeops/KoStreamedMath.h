@@ -36,6 +36,8 @@
 #include <KoAlwaysInline.h>
 #include <iostream>
 
+#include "KoTransparentRuns.h"
+
 #define BLOCKDEBUG 0
 
 #if !defined _MSC_VER
@@ -212,6 +214,10 @@ static inline void write_channels_32(quint8 *data,
  * Composes src pixels into dst pixles. Is optimized for 32-bit-per-pixel
  * colorspaces. Uses \p Compositor strategy parameter for doing actual
  * math of the composition
+ *
+ * The \p Compositor must not change the destination where the mask is
+ * zero: the rows and vectors covered by zero mask are skipped without
+ * fetching the pixels.
  */
 template<bool useMask, bool useFlow, class Compositor, int pixelSize>
     static void genericComposite(const KoCompositeOp::ParameterInfo& params)
@@ -264,6 +270,13 @@ template<bool useMask, bool useFlow, class Compositor, int pixelSize>
         const quint8 *src  = srcRowStart;
         quint8       *dst  = dstRowStart;
 
+        if (useMask && KoTransparentRuns::zeroMaskRunLength(mask, params.cols) == params.cols) {
+            srcRowStart  += params.srcRowStride;
+            dstRowStart  += params.dstRowStride;
+            maskRowStart += params.maskRowStride;
+            continue;
+        }
+
         const int pixelsAlignmentMask = vectorSize * sizeof(float) - 1;
         uintptr_t srcPtrValue = reinterpret_cast<uintptr_t>(src);
         uintptr_t dstPtrValue = reinterpret_cast<uintptr_t>(dst);
@@ -318,7 +331,10 @@ template<bool useMask, bool useFlow, class Compositor, int pixelSize>
         }
 
         for (int i = 0; i < blockAlignedVector; i++) {
-            Compositor::template compositeVector<useMask, true, _impl>(src, dst, mask, params.opacity, optionalParams);
+            if (!useMask || KoTransparentRuns::zeroMaskRunLength(mask, vectorSize) < vectorSize) {
+                Compositor::template compositeVector<useMask, true, _impl>(src, dst, mask, params.opacity, optionalParams);
+            }
+
             src += srcVectorInc;
             dst += vectorInc;
 
@@ -328,7 +344,10 @@ template<bool useMask, bool useFlow, class Compositor, int pixelSize>
         }
 
         for (int i = 0; i < blockUnalignedVector; i++) {
-            Compositor::template compositeVector<useMask, false, _impl>(src, dst, mask, params.opacity, optionalParams);
+            if (!useMask || KoTransparentRuns::zeroMaskRunLength(mask, vectorSize) < vectorSize) {
+                Compositor::template compositeVector<useMask, false, _impl>(src, dst, mask, params.opacity, optionalParams);
+            }
+
             src += srcVectorInc;
             dst += vectorInc;
 
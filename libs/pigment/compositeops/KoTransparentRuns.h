@@ -0,0 +1,86 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KOTRANSPARENTRUNS_H
+#define KOTRANSPARENTRUNS_H
+
+#include <string.h>
+#include <QtGlobal>
+
+#include "KoColorSpaceMaths.h"
+
+/**
+ * Helpers for detecting the runs of pixels that cannot change the
+ * destination of a composite op: the pixels with zero mask or with
+ * fully transparent source. Most of the layers and brush dabs are
+ * mostly transparent, so skipping such runs as a whole is much
+ * cheaper than processing every pixel.
+ */
+namespace KoTransparentRuns {
+
+/**
+ * Returns the number of consequent zero bytes at the beginning of
+ * \p mask, but not more than \p maxLength. The mask is checked by
+ * 8-byte words, so sparse masks are skipped at a rate of eight
+ * pixels per comparison. The mask is allowed to be unaligned.
+ */
+inline int zeroMaskRunLength(const quint8 *mask, int maxLength)
+{
+    int length = 0;
+
+    while (length + int(sizeof(quint64)) <= maxLength) {
+        quint64 word;
+        memcpy(&word, mask + length, sizeof(quint64));
+        if (word) break;
+
+        length += sizeof(quint64);
+    }
+
+    while (length < maxLength && !mask[length]) {
+        length++;
+    }
+
+    return length;
+}
+
+/**
+ * Returns the number of consequent fully transparent pixels at the
+ * beginning of \p src, but not more than \p maxLength.
+ */
+template<class Traits>
+inline int transparentRunLength(const quint8 *src, int maxLength)
+{
+    typedef typename Traits::channels_type channels_type;
+
+    const channels_type *pixel = reinterpret_cast<const channels_type*>(src);
+    int length = 0;
+
+    while (length < maxLength &&
+           pixel[Traits::alpha_pos] == KoColorSpaceMathsTraits<channels_type>::zeroValue) {
+
+        pixel += Traits::channels_nb;
+        length++;
+    }
+
+    return length;
+}
+
+}
+
+#endif // KOTRANSPARENTRUNS_H
@@ -2,6 +2,7 @@
 
 #include "KoColorSpaceAbstract.h"
 #include "KoColorSpaceTraits.h"
+#include "KoOptimizedMixColorsOpFactory.h"
 
 #include <cfloat>
 
@@ -386,4 +387,112 @@ void TestKoColorSpaceAbstract::testMixColorsOpU8NoAlphaLinear()
 }
 
 
+void TestKoColorSpaceAbstract::testMixColorsOpRowsU8()
+{
+    /**
+     * Compare the (possibly vectorized) optimized op with the
+     * generic one. Use rows long enough to hit both vector and
+     * scalar tail paths of the optimized implementation.
+     */
+    const int numColors = 37;
+    const int numRows = 5;
+    const int pixelSize = KoBgrU8Traits::pixelSize;
+
+    QScopedPointer<KoMixColorsOp> refOp(new KoMixColorsOpImpl<KoBgrU8Traits>());
+    QScopedPointer<KoMixColorsOp> op(KoOptimizedMixColorsOpFactory::createMixColorsOp32());
+
+    QVector<quint8> pixels(numColors * numRows * pixelSize);
+    for (int i = 0; i < pixels.size(); i++) {
+        pixels[i] = (i * 37 + i / 4 * 11) % 256;
+    }
+
+    QVector<qint16> weights(numColors);
+    int sumOfWeights = 0;
+    for (int i = 0; i < numColors - 1; i++) {
+        weights[i] = 255 / numColors + (i % 3 == 0);
+        sumOfWeights += weights[i];
+    }
+    weights[numColors - 1] = 255 - sumOfWeights;
+
+    QVector<quint8> expected(numRows * pixelSize);
+    for (int row = 0; row < numRows; row++) {
+        refOp->mixColors(pixels.constData() + row * numColors * pixelSize,
+                         weights.constData(), numColors,
+                         expected.data() + row * pixelSize);
+    }
+
+    QVector<quint8> result(numRows * pixelSize);
+
+    op->mixColorsRows(pixels.constData(), weights.constData(), numColors, numRows, result.data());
+    QCOMPARE(result, expected);
+
+    refOp->mixColorsRows(pixels.constData(), weights.constData(), numColors, numRows, result.data());
+    QCOMPARE(result, expected);
+
+    quint8 refPixel[pixelSize];
+    quint8 pixel[pixelSize];
+
+    refOp->mixColors(pixels.constData(), numColors * numRows, refPixel);
+    op->mixColors(pixels.constData(), numColors * numRows, pixel);
+
+    for (int i = 0; i < pixelSize; i++) {
+        QCOMPARE(pixel[i], refPixel[i]);
+    }
+}
+
+void TestKoColorSpaceAbstract::testMixColorsOpRowsF32()
+{
+    /**
+     * The optimized F32 op accumulates the vectorized part in single
+     * precision, so it is compared with the generic op with a
+     * tolerance, but its rows should be exactly the same as its own
+     * per-pixel results.
+     */
+    const int numColors = 37;
+    const int numRows = 5;
+    const int channelsNb = KoRgbF32Traits::channels_nb;
+    const int pixelSize = KoRgbF32Traits::pixelSize;
+
+    QScopedPointer<KoMixColorsOp> refOp(new KoMixColorsOpImpl<KoRgbF32Traits>());
+    QScopedPointer<KoMixColorsOp> op(KoOptimizedMixColorsOpFactory::createMixColorsOp128());
+
+    QVector<float> pixels(numColors * numRows * channelsNb);
+    for (int i = 0; i < pixels.size(); i++) {
+        pixels[i] = ((i * 37 + i / 4 * 11) % 256) / 255.0f;
+    }
+
+    QVector<qint16> weights(numColors);
+    int sumOfWeights = 0;
+    for (int i = 0; i < numColors - 1; i++) {
+        weights[i] = 255 / numColors + (i % 3 == 0);
+        sumOfWeights += weights[i];
+    }
+    weights[numColors - 1] = 255 - sumOfWeights;
+
+    const quint8 *src = reinterpret_cast<const quint8*>(pixels.constData());
+
+    QVector<float> expected(numRows * channelsNb);
+    QVector<float> refExpected(numRows * channelsNb);
+    for (int row = 0; row < numRows; row++) {
+        op->mixColors(src + row * numColors * pixelSize,
+                      weights.constData(), numColors,
+                      reinterpret_cast<quint8*>(expected.data() + row * channelsNb));
+        refOp->mixColors(src + row * numColors * pixelSize,
+                         weights.constData(), numColors,
+                         reinterpret_cast<quint8*>(refExpected.data() + row * channelsNb));
+    }
+
+    QVector<float> result(numRows * channelsNb);
+
+    op->mixColorsRows(src, weights.constData(), numColors, numRows, reinterpret_cast<quint8*>(result.data()));
+    QCOMPARE(result, expected);
+
+    for (int i = 0; i < result.size(); i++) {
+        QVERIFY(qAbs(result[i] - refExpected[i]) < 1e-5);
+    }
+
+    refOp->mixColorsRows(src, weights.constData(), numColors, numRows, reinterpret_cast<quint8*>(result.data()));
+    QCOMPARE(result, refExpected);
+}
+
 QTEST_GUILESS_MAIN(TestKoColorSpaceAbstract)
@@ -0,0 +1,228 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+*/
+
+#include "TestKoCompositeOps.h"
+
+#include <QTest>
+#include <QBitArray>
+#include <QVector>
+
+#include "KoColorSpaceTraits.h"
+#include "compositeops/KoCompositeOpGeneric.h"
+
+/**
+ * Composes the pixels with the color math of \p _compositeOp, but
+ * never skips any of them, which is how the composite ops worked
+ * before the runs of transparent pixels were skipped
+ */
+template<class Traits, class _compositeOp>
+class KoCompositeOpReference : public KoCompositeOpBase<Traits, KoCompositeOpReference<Traits, _compositeOp> >
+{
+    typedef KoCompositeOpBase<Traits, KoCompositeOpReference<Traits, _compositeOp> > base_class;
+    typedef typename Traits::channels_type channels_type;
+
+public:
+    KoCompositeOpReference()
+        : base_class(0, "reference", "reference", "misc") { }
+
+    template<bool alphaLocked, bool allChannelFlags>
+    inline static channels_type composeColorChannels(const channels_type* src, channels_type srcAlpha,
+                                                     channels_type*       dst, channels_type dstAlpha, channels_type maskAlpha,
+                                                     channels_type opacity, const QBitArray& channelFlags) {
+
+        return _compositeOp::template composeColorChannels<alphaLocked, allChannelFlags>(
+            src, srcAlpha, dst, dstAlpha, maskAlpha, opacity, channelFlags);
+    }
+};
+
+template<class channels_type>
+QVector<channels_type> alphaPalette()
+{
+    using namespace Arithmetic;
+
+    QVector<channels_type> palette;
+    palette << zeroValue<channels_type>()
+            << channels_type(KoColorSpaceMathsTraits<channels_type>::epsilon)
+            << unitValue<channels_type>()
+            << halfValue<channels_type>()
+            << scale<channels_type>(quint8(1))
+            << scale<channels_type>(quint8(254));
+    return palette;
+}
+
+template<class Traits>
+void fillPixels(QVector<typename Traits::channels_type> &pixels, int numPixels, int seed, bool isSource)
+{
+    using namespace Arithmetic;
+    typedef typename Traits::channels_type channels_type;
+
+    const QVector<channels_type> alphas = alphaPalette<channels_type>();
+
+    pixels.resize(numPixels * Traits::channels_nb);
+    quint32 random = seed;
+
+    for (int i = 0; i < numPixels; i++) {
+        channels_type *pixel = pixels.data() + i * Traits::channels_nb;
+
+        for (int ch = 0; ch < Traits::channels_nb; ch++) {
+            random = random * 1103515245 + 12345;
+            pixel[ch] = scale<channels_type>(quint8(random >> 16));
+        }
+
+        // the source has long runs of transparent pixels
+        const bool inTransparentRun = isSource && (i / 9) % 3 == 0;
+        pixel[Traits::alpha_pos] = inTransparentRun ?
+            zeroValue<channels_type>() :
+            alphas[(i * (isSource ? 5 : 7) + seed) % alphas.size()];
+    }
+}
+
+QVector<quint8> createMask(int numPixels)
+{
+    QVector<quint8> mask(numPixels);
+
+    const quint8 values[] = {0, 1, 128, 255};
+
+    for (int i = 0; i < numPixels; i++) {
+        // the runs should be long enough to be skipped by words
+        mask[i] = (i / 11) % 2 == 0 ? 0 : values[i % 4];
+    }
+
+    return mask;
+}
+
+/**
+ * Checks that skipping the transparent runs gives exactly the same
+ * result as composing every pixel with \p Op
+ */
+template<class Traits, class Op>
+void testSkippingIsExact()
+{
+    typedef typename Traits::channels_type channels_type;
+
+    const int rows = 3;
+    const int cols = 67;
+    const int numPixels = rows * cols;
+    const int rowStride = cols * Traits::pixelSize;
+
+    Op op(0, "op", "op", "misc");
+    KoCompositeOpReference<Traits, Op> referenceOp;
+
+    QVector<channels_type> src;
+    fillPixels<Traits>(src, numPixels, 1, true);
+
+    QVector<channels_type> initialDst;
+    fillPixels<Traits>(initialDst, numPixels, 2, false);
+
+    const QVector<quint8> mask = createMask(numPixels);
+
+    QList<float> opacities;
+    opacities << 0.0f << 1.0f / 255.0f << 0.5f << 1.0f;
+
+    QBitArray allFlags;
+
+    QBitArray alphaLockedFlags(Traits::channels_nb, true);
+    alphaLockedFlags.clearBit(Traits::alpha_pos);
+
+    QBitArray noRedFlags(Traits::channels_nb, true);
+    noRedFlags.clearBit(Traits::red_pos);
+
+    QList<QBitArray> channelFlags;
+    channelFlags << allFlags << alphaLockedFlags << noRedFlags;
+
+    QList<int> uniformSourcePixels;
+    uniformSourcePixels << -1 << 0 << 10;
+
+    Q_FOREACH (float opacity, opacities) {
+        Q_FOREACH (const QBitArray &flags, channelFlags) {
+            Q_FOREACH (int uniformSourcePixel, uniformSourcePixels) {
+                for (int useMask = 0; useMask < 2; useMask++) {
+                    QVector<channels_type> dst = initialDst;
+                    QVector<channels_type> referenceDst = initialDst;
+
+                    KoCompositeOp::ParameterInfo params;
+
+                    if (uniformSourcePixel >= 0) {
+                        params.srcRowStart = reinterpret_cast<const quint8*>(src.constData() + uniformSourcePixel * Traits::channels_nb);
+                        params.srcRowStride = 0;
+                    } else {
+                        params.srcRowStart = reinterpret_cast<const quint8*>(src.constData());
+                        params.srcRowStride = rowStride;
+                    }
+
+                    params.maskRowStart = useMask ? mask.constData() : 0;
+                    params.maskRowStride = useMask ? cols : 0;
+                    params.rows = rows;
+                    params.cols = cols;
+                    params.opacity = opacity;
+                    params.channelFlags = flags;
+
+                    params.dstRowStart = reinterpret_cast<quint8*>(dst.data());
+                    params.dstRowStride = rowStride;
+                    op.composite(params);
+
+                    params.dstRowStart = reinterpret_cast<quint8*>(referenceDst.data());
+                    referenceOp.composite(params);
+
+                    for (int i = 0; i < numPixels * Traits::channels_nb; i++) {
+                        if (dst[i] != referenceDst[i]) {
+                            QFAIL(QString("Result differs from the reference at pixel %1, channel %2: "
+                                          "opacity %3, flags %4, uniform source %5, mask %6")
+                                  .arg(i / Traits::channels_nb)
+                                  .arg(i % Traits::channels_nb)
+                                  .arg(opacity)
+                                  .arg(flags.count(true))
+                                  .arg(uniformSourcePixel)
+                                  .arg(useMask)
+                                  .toLatin1());
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+template<class Traits>
+void testSkippingIsExactForAllOps()
+{
+    typedef typename Traits::channels_type channels_type;
+
+    testSkippingIsExact<Traits, KoCompositeOpGenericSC<Traits, &cfMultiply<channels_type> > >();
+    testSkippingIsExact<Traits, KoCompositeOpGenericSC<Traits, &cfOverlay<channels_type> > >();
+    testSkippingIsExact<Traits, KoCompositeOpGenericHSL<Traits, &cfColor<HSYType, float> > >();
+    testSkippingIsExact<Traits, KoCompositeOpGenericHSL<Traits, &cfLightness<HSYType, float> > >();
+}
+
+void TestKoCompositeOps::testSkipTransparentU8()
+{
+    testSkippingIsExactForAllOps<KoBgrU8Traits>();
+}
+
+void TestKoCompositeOps::testSkipTransparentU16()
+{
+    testSkippingIsExactForAllOps<KoBgrU16Traits>();
+}
+
+void TestKoCompositeOps::testSkipTransparentF32()
+{
+    testSkippingIsExactForAllOps<KoRgbF32Traits>();
+}
+
+QTEST_GUILESS_MAIN(TestKoCompositeOps)
@@ -22,16 +22,16 @@
 #include "psd_utils.h"
 #include "kis_debug.h"
 #include <QtEndian>
+#include <string.h>
 
 // from gimp's psd-save.c
-static quint32 pack_pb_line (const QByteArray &src,
-                             QByteArray &dst)
+static quint32 pack_pb_line (const quint8 *start,
+                             quint32 length,
+                             quint8 *dst)
 {
-    quint32 length = src.size();
     quint32 remaining = length;
     quint8  i, j;
     quint32 dest_ptr = 0;
-    const char *start = src.constData();
 
     length = 0;
     while (remaining > 0)
@@ -89,7 +89,7 @@ static quint32 pack_pb_line (const QByteArray &src,
 
 
 // from gimp's psd-util.c
-quint32 decode_packbits(const char *src, char* dst, quint16 packed_len, quint32 unpacked_len)
+static quint32 decode_packbits(const char *src, char* dst, quint32 packed_len, quint32 unpacked_len)
 {
     /*
      *  Decode a PackBits chunk.
@@ -247,10 +247,10 @@ QByteArray Compression::compress(QByteArray bytes, Compression::CompressionType
         return bytes;
     case RLE:
     {
-        QByteArray dst;
-        int packed_len = pack_pb_line(bytes, dst);
-        Q_ASSERT(packed_len == dst.size());
-        Q_UNUSED(packed_len);
+        QByteArray dst(rleMaxCompressedSize(bytes.size()), 0);
+        const int packed_len = compressRLE(reinterpret_cast<const quint8*>(bytes.constData()), bytes.size(),
+                                           reinterpret_cast<quint8*>(dst.data()));
+        dst.resize(packed_len);
         return dst;
     }
     case ZIP:
@@ -263,3 +263,27 @@ QByteArray Compression::compress(QByteArray bytes, Compression::CompressionType
     return QByteArray();
 }
 
+int Compression::rleMaxCompressedSize(int unpackedLength)
+{
+    // every literal run of up to 128 bytes takes one extra byte, and
+    // pack_pb_line() may split off the last byte into a separate run
+    return unpackedLength + (unpackedLength + 127) / 128 + 1;
+}
+
+int Compression::compressRLE(const quint8 *src, int length, quint8 *dst)
+{
+    return length > 0 ? pack_pb_line(src, length, dst) : 0;
+}
+
+void Compression::uncompressRLE(const quint8 *src, int packedLength, quint8 *dst, int unpackedLength)
+{
+    if (unpackedLength <= 0) return;
+
+    // decode_packbits leaves the tail of the buffer untouched on broken data
+    memset(dst, 0, unpackedLength);
+
+    if (packedLength > 0) {
+        decode_packbits(reinterpret_cast<const char*>(src), reinterpret_cast<char*>(dst),
+                        packedLength, unpackedLength);
+    }
+}
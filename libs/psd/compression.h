@@ -35,6 +35,24 @@ public:
 
     static QByteArray uncompress(quint32 unpacked_len, QByteArray bytes, CompressionType compressionType);
     static QByteArray compress(QByteArray bytes, CompressionType compressionType);
+
+    /**
+     * PackBits codec working directly on the caller's buffers. The functions
+     * do not allocate any memory and can be called from several threads at
+     * once, so the rows of the channels can be (de)compressed in parallel.
+     */
+
+    /// @return the maximum size of \p unpackedLength bytes packed with RLE
+    static int rleMaxCompressedSize(int unpackedLength);
+
+    /// Packs \p length bytes of \p src into \p dst, which should be at least
+    /// rleMaxCompressedSize(length) bytes long. @return the packed size
+    static int compressRLE(const quint8 *src, int length, quint8 *dst);
+
+    /// Unpacks \p packedLength bytes of \p src into \p unpackedLength bytes
+    /// of \p dst. If the packed data is too short, the rest of \p dst is
+    /// filled with zeros.
+    static void uncompressRLE(const quint8 *src, int packedLength, quint8 *dst, int unpackedLength);
 };
 
 #endif // PSD_COMPRESSION_H
@@ -23,6 +23,7 @@
 
 #include <QBuffer>
 #include <QByteArray>
+#include <QFile>
 #include <QTemporaryFile>
 
 #include <kzip.h>
@@ -100,6 +101,7 @@ KoZipStore::~KoZipStore()
         }
     }
     delete m_pZip;
+    delete m_mappedFile;
 
     // When writing, we write to a temp file that then gets copied over the original filename
     if (d->mode == Write && (!d->localFileName.isEmpty() && !d->url.isEmpty())) {
@@ -115,6 +117,8 @@ void KoZipStore::init(const QByteArray& appIdentification)
     Q_D(KoStore);
 
     m_currentDir = 0;
+    m_mappedFile = 0;
+    m_mappedData = 0;
     d->good = m_pZip->open(d->mode == Write ? QIODevice::WriteOnly : QIODevice::ReadOnly);
 
     if (!d->good)
@@ -177,11 +181,49 @@ bool KoZipStore::openRead(const QString& name)
     // Must cast to KZipFileEntry, not only KArchiveFile, because device() isn't virtual!
     const KZipFileEntry * f = static_cast<const KZipFileEntry *>(entry);
     delete d->stream;
-    d->stream = f->createDevice();
+
+    /**
+     * The stored entries (e.g. the layers' tile data that is already
+     * compressed with LZF) are read directly from the mapped file, so
+     * seeking inside them is free and no data goes through the limited
+     * device of KZip.
+     */
+    const uchar *mappedData = f->encoding() == 0 ? mappedArchiveData() : 0;
+
+    if (mappedData && f->position() >= 0 &&
+        f->position() + f->size() <= m_mappedFile->size()) {
+
+        QBuffer *buffer = new QBuffer();
+        buffer->setData(QByteArray::fromRawData(reinterpret_cast<const char*>(mappedData + f->position()), f->size()));
+        buffer->open(QIODevice::ReadOnly);
+        d->stream = buffer;
+    } else {
+        d->stream = f->createDevice();
+    }
+
     d->size = f->size();
     return true;
 }
 
+const uchar* KoZipStore::mappedArchiveData()
+{
+    Q_D(KoStore);
+
+    if (!m_mappedFile && d->mode == Read && !d->localFileName.isEmpty()) {
+        m_mappedFile = new QFile(d->localFileName);
+
+        if (m_mappedFile->open(QIODevice::ReadOnly)) {
+            m_mappedData = m_mappedFile->map(0, m_mappedFile->size());
+        }
+
+        if (!m_mappedData) {
+            debugStore << "Could not map" << d->localFileName << "into memory, falling back to KZip devices";
+        }
+    }
+
+    return m_mappedData;
+}
+
 qint64 KoZipStore::write(const char* _data, qint64 _len)
 {
     Q_D(KoStore);
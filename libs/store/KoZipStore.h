@@ -24,6 +24,7 @@
 
 class SaveZip;
 class KArchiveDirectory;
+class QFile;
 class QUrl;
 
 class KoZipStore : public KoStore
@@ -59,6 +60,9 @@ protected:
     bool enterAbsoluteDirectory(const QString& path) override;
     bool fileExists(const QString& absPath) const override;
 
+private:
+    const uchar* mappedArchiveData();
+
 private:
 
     // The archive
@@ -67,6 +71,10 @@ private:
     // In "Read" mode this pointer is pointing to the  current directory in the archive to speed up the verification process
     const KArchiveDirectory* m_currentDir;
 
+    // In "Read" mode the stored (uncompressed) entries are read directly from the memory-mapped archive file
+    QFile *m_mappedFile;
+    const uchar *m_mappedData;
+
     Q_DECLARE_PRIVATE(KoStore)
 };
 
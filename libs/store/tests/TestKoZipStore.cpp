@@ -0,0 +1,152 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "TestKoZipStore.h"
+
+#include <KoStore.h>
+
+#include <QBuffer>
+#include <QScopedPointer>
+#include <QTemporaryDir>
+#include <QTest>
+
+namespace {
+
+QByteArray testData(int size, int seed)
+{
+    QByteArray data(size, '\0');
+    for (int i = 0; i < size; i++) {
+        data[i] = char((i * 7 + seed) % 251);
+    }
+    return data;
+}
+
+bool writeEntry(KoStore *store, const QString &name, const QByteArray &data, bool compressed)
+{
+    store->setCompressionEnabled(compressed);
+
+    if (!store->open(name)) return false;
+    const bool result = store->write(data) == data.size();
+    return store->close() && result;
+}
+
+QByteArray readEntry(KoStore *store, const QString &name)
+{
+    QByteArray data;
+
+    if (store->open(name)) {
+        data = store->read(store->size());
+        store->close();
+    }
+
+    return data;
+}
+
+/**
+ * \return the address of the data of the entry when the store reads it
+ * from the memory-mapped archive file, null when it goes through KZip
+ */
+const char* mappedEntryData(KoStore *store, const QString &name)
+{
+    const char *result = 0;
+
+    if (store->open(name)) {
+        QBuffer *buffer = qobject_cast<QBuffer*>(store->device());
+        if (buffer) {
+            result = buffer->data().constData();
+        }
+        store->close();
+    }
+
+    return result;
+}
+
+}
+
+void TestKoZipStore::testStoredAndDeflatedEntries()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.path() + "/test.zip";
+
+    const QByteArray storedData = testData(100000, 1);
+    const QByteArray deflatedData = testData(100000, 2);
+
+    {
+        QScopedPointer<KoStore> store(KoStore::createStore(fileName, KoStore::Write, "application/x-test", KoStore::Zip));
+        QVERIFY(store && !store->bad());
+
+        QVERIFY(writeEntry(store.data(), "layers/stored", storedData, false));
+        QVERIFY(writeEntry(store.data(), "layers/deflated", deflatedData, true));
+        QVERIFY(writeEntry(store.data(), "layers/empty", QByteArray(), false));
+        QVERIFY(store->finalize());
+    }
+
+    QScopedPointer<KoStore> store(KoStore::createStore(fileName, KoStore::Read, "application/x-test", KoStore::Zip));
+    QVERIFY(store && !store->bad());
+
+    QCOMPARE(readEntry(store.data(), "layers/stored"), storedData);
+    QCOMPARE(readEntry(store.data(), "layers/deflated"), deflatedData);
+    QVERIFY(readEntry(store.data(), "layers/empty").isEmpty());
+
+    // the entries can be read more than once
+    QCOMPARE(readEntry(store.data(), "layers/stored"), storedData);
+
+    // the stored entry is not copied, but points into the mapped file...
+    const char *mappedData = mappedEntryData(store.data(), "layers/stored");
+    QVERIFY(mappedData);
+    QVERIFY(mappedEntryData(store.data(), "layers/stored") == mappedData);
+
+    // ...while the deflated one is still decompressed by KZip
+    QVERIFY(!mappedEntryData(store.data(), "layers/deflated"));
+}
+
+void TestKoZipStore::testSeekInStoredEntry()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.path() + "/test.zip";
+
+    const QByteArray data = testData(100000, 3);
+
+    {
+        QScopedPointer<KoStore> store(KoStore::createStore(fileName, KoStore::Write, "application/x-test", KoStore::Zip));
+        QVERIFY(writeEntry(store.data(), "first", testData(1000, 4), false));
+        QVERIFY(writeEntry(store.data(), "second", data, false));
+        QVERIFY(store->finalize());
+    }
+
+    QScopedPointer<KoStore> store(KoStore::createStore(fileName, KoStore::Read, "application/x-test", KoStore::Zip));
+    QVERIFY(store->open("second"));
+    QVERIFY(qobject_cast<QBuffer*>(store->device()));
+
+    QVERIFY(store->seek(50000));
+    QCOMPARE(store->read(100), data.mid(50000, 100));
+
+    QVERIFY(store->seek(10));
+    QCOMPARE(store->read(100), data.mid(10, 100));
+
+    QVERIFY(store->seek(data.size() - 10));
+    QCOMPARE(store->read(100), data.right(10));
+    QVERIFY(store->atEnd());
+
+    QVERIFY(store->close());
+}
+
+QTEST_GUILESS_MAIN(TestKoZipStore)
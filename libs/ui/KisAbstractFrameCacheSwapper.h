@@ -19,6 +19,7 @@
 #define KISABSTRACTFRAMECACHESWAPPER_H
 
 #include "kritaui_export.h"
+#include <QtGlobal>
 
 class QRect;
 
@@ -45,6 +46,13 @@ public:
 
     virtual int frameLevelOfDetail(int frameId) const = 0;
     virtual QRect frameDirtyRect(int frameId) const = 0;
+
+    /**
+     * \return the amount of memory (or disk space) taken by all the
+     * frames in bytes, including the data the swapper keeps for its
+     * own needs. The value is used for budgeting the size of the cache.
+     */
+    virtual qint64 totalDataSize() const = 0;
 };
 
 #endif // KISABSTRACTFRAMECACHESWAPPER_H
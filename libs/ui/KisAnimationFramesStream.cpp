@@ -0,0 +1,265 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "KisAnimationFramesStream.h"
+
+#include <QByteArray>
+#include <QMap>
+#include <QMutex>
+#include <QProcess>
+#include <QThread>
+#include <QWaitCondition>
+
+#include "kis_debug.h"
+#include "kis_time_range.h"
+
+
+struct KisAnimationFramesStream::Private
+{
+    Private(const KisTimeRange &_range, int _maxPendingFrames)
+        : range(_range),
+          maxPendingFrames(qMax(1, _maxPendingFrames)),
+          nextFrame(_range.start())
+    {
+    }
+
+    KisTimeRange range;
+    int maxPendingFrames;
+
+    QString program;
+    QStringList args;
+    QString logPath;
+
+    QMutex mutex;
+    QWaitCondition frameAdded;
+    QWaitCondition frameTaken;
+    QWaitCondition processStarted;
+
+    QMap<int, QByteArray> pendingFrames;
+    QMap<int, QByteArray> pendingCopies;
+    int nextFrame;
+    bool isCancelled = false;
+    bool isStarted = false;
+    bool isFailed = false;
+    qint64 bytesWritten = 0;
+
+    struct WriterThread : public QThread
+    {
+        WriterThread(Private *_d) : d(_d) {}
+
+        void run() override {
+            d->writeFrames();
+        }
+
+        Private *d;
+    };
+
+    QScopedPointer<WriterThread> writer;
+
+    void writeFrames();
+    bool takeNextFrame(QByteArray *data);
+    void setFailed();
+};
+
+bool KisAnimationFramesStream::Private::takeNextFrame(QByteArray *data)
+{
+    QMutexLocker l(&mutex);
+
+    while (!isCancelled && nextFrame <= range.end() &&
+           !pendingFrames.contains(nextFrame) &&
+           !pendingCopies.contains(nextFrame)) {
+
+        frameAdded.wait(&mutex);
+    }
+
+    if (isCancelled || nextFrame > range.end()) return false;
+
+    *data = pendingFrames.contains(nextFrame) ?
+        pendingFrames.take(nextFrame) : pendingCopies.take(nextFrame);
+    nextFrame++;
+
+    frameTaken.wakeAll();
+
+    return true;
+}
+
+void KisAnimationFramesStream::Private::setFailed()
+{
+    QMutexLocker l(&mutex);
+
+    isFailed = true;
+    isCancelled = true;
+
+    frameTaken.wakeAll();
+    processStarted.wakeAll();
+}
+
+void KisAnimationFramesStream::Private::writeFrames()
+{
+    QProcess process;
+    process.setStandardOutputFile(logPath);
+    process.setProcessChannelMode(QProcess::MergedChannels);
+    process.start(program, args);
+
+    if (!process.waitForStarted()) {
+        warnFile << "Failed to start" << program << process.errorString();
+        setFailed();
+        return;
+    }
+
+    {
+        QMutexLocker l(&mutex);
+        isStarted = true;
+        processStarted.wakeAll();
+    }
+
+    QByteArray data;
+
+    while (takeNextFrame(&data)) {
+        if (process.write(data) != data.size()) {
+            setFailed();
+            break;
+        }
+
+        while (process.bytesToWrite() > 0) {
+            // check for cancellation every now and then
+            if (!process.waitForBytesWritten(100) &&
+                process.state() != QProcess::Running) {
+
+                setFailed();
+                break;
+            }
+
+            QMutexLocker l(&mutex);
+            if (isCancelled) break;
+        }
+
+        QMutexLocker l(&mutex);
+        if (isCancelled) break;
+
+        bytesWritten += data.size();
+        data.clear();
+    }
+
+    bool cancelled = false;
+
+    {
+        QMutexLocker l(&mutex);
+        cancelled = isCancelled;
+    }
+
+    if (cancelled) {
+        process.kill();
+        process.waitForFinished();
+        return;
+    }
+
+    process.closeWriteChannel();
+    process.waitForFinished(-1);
+
+    if (process.exitStatus() != QProcess::NormalExit || process.exitCode()) {
+        setFailed();
+    }
+}
+
+KisAnimationFramesStream::KisAnimationFramesStream(const KisTimeRange &range, int maxPendingFrames)
+    : m_d(new Private(range, maxPendingFrames))
+{
+}
+
+KisAnimationFramesStream::~KisAnimationFramesStream()
+{
+    if (m_d->writer) {
+        cancel();
+        m_d->writer->wait();
+    }
+}
+
+bool KisAnimationFramesStream::start(const QString &program, const QStringList &args, const QString &logPath)
+{
+    KIS_SAFE_ASSERT_RECOVER_RETURN_VALUE(!m_d->writer, false);
+
+    m_d->program = program;
+    m_d->args = args;
+    m_d->logPath = logPath;
+
+    m_d->writer.reset(new Private::WriterThread(m_d.data()));
+    m_d->writer->start();
+
+    QMutexLocker l(&m_d->mutex);
+
+    while (!m_d->isStarted && !m_d->isFailed) {
+        m_d->processStarted.wait(&m_d->mutex);
+    }
+
+    return !m_d->isFailed;
+}
+
+void KisAnimationFramesStream::pushFrame(int frame, const QByteArray &data, const QVector<int> &copies)
+{
+    QMutexLocker l(&m_d->mutex);
+
+    KIS_SAFE_ASSERT_RECOVER_RETURN(m_d->range.contains(frame));
+
+    while (!m_d->isCancelled &&
+           frame != m_d->nextFrame &&
+           m_d->pendingFrames.size() >= m_d->maxPendingFrames) {
+
+        m_d->frameTaken.wait(&m_d->mutex);
+    }
+
+    if (m_d->isCancelled || frame < m_d->nextFrame) return;
+
+    m_d->pendingFrames.insert(frame, data);
+
+    Q_FOREACH (int copy, copies) {
+        if (copy >= m_d->nextFrame && m_d->range.contains(copy)) {
+            m_d->pendingCopies.insert(copy, data);
+        }
+    }
+
+    m_d->frameAdded.wakeAll();
+}
+
+void KisAnimationFramesStream::cancel()
+{
+    QMutexLocker l(&m_d->mutex);
+
+    m_d->isCancelled = true;
+    m_d->pendingFrames.clear();
+    m_d->pendingCopies.clear();
+
+    m_d->frameAdded.wakeAll();
+    m_d->frameTaken.wakeAll();
+}
+
+bool KisAnimationFramesStream::finish()
+{
+    KIS_SAFE_ASSERT_RECOVER_RETURN_VALUE(m_d->writer, false);
+
+    m_d->writer->wait();
+
+    QMutexLocker l(&m_d->mutex);
+    return !m_d->isFailed && !m_d->isCancelled && m_d->nextFrame > m_d->range.end();
+}
+
+qint64 KisAnimationFramesStream::bytesWritten() const
+{
+    QMutexLocker l(&m_d->mutex);
+    return m_d->bytesWritten;
+}
@@ -0,0 +1,91 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KISANIMATIONFRAMESSTREAM_H
+#define KISANIMATIONFRAMESSTREAM_H
+
+#include <QScopedPointer>
+#include <QStringList>
+#include <QVector>
+
+#include "kritaui_export.h"
+
+class QByteArray;
+class KisTimeRange;
+
+/**
+ * KisAnimationFramesStream pipes raw animation frames into the standard
+ * input of an external process (e.g. ffmpeg) without storing them on disk.
+ *
+ * The frames are pushed by the rendering threads in arbitrary order and
+ * written into the process by a separate writer thread strictly in the
+ * order of the frame numbers. The number of frames waiting for their turn
+ * is limited: when the limit is reached, pushFrame() blocks the caller until
+ * the writer catches up. The frame the writer is waiting for is never
+ * blocked, so the stream cannot deadlock.
+ */
+class KRITAUI_EXPORT KisAnimationFramesStream
+{
+public:
+    KisAnimationFramesStream(const KisTimeRange &range, int maxPendingFrames);
+    ~KisAnimationFramesStream();
+
+    /**
+     * Starts the process \p program with the arguments \p args and the
+     * writer thread. Output of the process is redirected into \p logPath.
+     *
+     * \return false if the process could not be started
+     */
+    bool start(const QString &program, const QStringList &args, const QString &logPath);
+
+    /**
+     * Passes the data of the \p frame to the writer thread. Can be called
+     * from any thread. The call blocks if too many frames are waiting for
+     * their turn to be written.
+     *
+     * \p copies are the frames that have exactly the same content as \p frame.
+     * They share the data with it and are not counted against the limit of
+     * pending frames, because nobody is going to render them anymore.
+     */
+    void pushFrame(int frame, const QByteArray &data, const QVector<int> &copies = QVector<int>());
+
+    /**
+     * Stops writing the frames and kills the process. All the threads
+     * blocked in pushFrame() are released.
+     */
+    void cancel();
+
+    /**
+     * Waits until all the frames are written and the process exits.
+     *
+     * \return true if all the frames have been written and the process
+     *         has finished successfully
+     */
+    bool finish();
+
+    /**
+     * \return the total amount of frame data written into the process
+     */
+    qint64 bytesWritten() const;
+
+private:
+    struct Private;
+    const QScopedPointer<Private> m_d;
+};
+
+#endif // KISANIMATIONFRAMESSTREAM_H
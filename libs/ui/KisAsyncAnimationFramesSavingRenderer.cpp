@@ -26,6 +26,8 @@
 #include "kis_time_range.h"
 #include "kis_paint_layer.h"
 
+#include <QFile>
+
 
 struct KisAsyncAnimationFramesSavingRenderer::Private
 {
@@ -58,6 +60,7 @@ struct KisAsyncAnimationFramesSavingRenderer::Private
     KisPaintDeviceSP savingDevice;
 
     KisTimeRange range;
+    QHash<int, QVector<int>> frameCopies;
     int sequenceNumberingOffset = 0;
 
 
@@ -66,6 +69,11 @@ struct KisAsyncAnimationFramesSavingRenderer::Private
 
     QByteArray outputMimeType;
     KisPropertiesConfigurationSP exportConfiguration;
+
+    QString frameFilename(int frame) const {
+        const QString frameNumber = QString("%1").arg(frame + sequenceNumberingOffset, 4, 10, QChar('0'));
+        return filenamePrefix + frameNumber + filenameSuffix;
+    }
 };
 
 KisAsyncAnimationFramesSavingRenderer::KisAsyncAnimationFramesSavingRenderer(KisImageSP image,
@@ -73,6 +81,7 @@ KisAsyncAnimationFramesSavingRenderer::KisAsyncAnimationFramesSavingRenderer(Kis
                                                                              const QString &fileNameSuffix,
                                                                              const QByteArray &outputMimeType,
                                                                              const KisTimeRange &range,
+                                                                             const QHash<int, QVector<int>> &frameCopies,
                                                                              const int sequenceNumberingOffset,
                                                                              KisPropertiesConfigurationSP exportConfiguration)
     : m_d(new Private(image, range, sequenceNumberingOffset, exportConfiguration))
@@ -80,6 +89,7 @@ KisAsyncAnimationFramesSavingRenderer::KisAsyncAnimationFramesSavingRenderer(Kis
     m_d->filenamePrefix = fileNamePrefix;
     m_d->filenameSuffix = fileNameSuffix;
     m_d->outputMimeType = outputMimeType;
+    m_d->frameCopies = frameCopies;
 
     connect(this, SIGNAL(sigCompleteRegenerationInternal(int)), SLOT(notifyFrameCompleted(int)));
     connect(this, SIGNAL(sigCancelRegenerationInternal(int)), SLOT(notifyFrameCancelled(int)));
@@ -104,17 +114,21 @@ void KisAsyncAnimationFramesSavingRenderer::frameCompletedCallback(int frame, co
 
     m_d->savingDevice->makeCloneFromRough(image->projection(), image->bounds());
 
-    KisTimeRange range(frame, 1);
-
     KisImportExportFilter::ConversionStatus status = KisImportExportFilter::OK;
 
-    for (int i = range.start(); i <= range.end(); i++) {
-        QString frameNumber = QString("%1").arg(i + m_d->sequenceNumberingOffset, 4, 10, QChar('0'));
-        QString filename = m_d->filenamePrefix + frameNumber + m_d->filenameSuffix;
+    const QString filename = m_d->frameFilename(frame);
 
-        if (!m_d->savingDoc->exportDocumentSync(QUrl::fromLocalFile(filename), m_d->outputMimeType, m_d->exportConfiguration)) {
-            status = KisImportExportFilter::InternalError;
-            break;
+    if (!m_d->savingDoc->exportDocumentSync(QUrl::fromLocalFile(filename), m_d->outputMimeType, m_d->exportConfiguration)) {
+        status = KisImportExportFilter::InternalError;
+    }
+
+    // the frames with the same content are not rendered, just copied
+    if (status == KisImportExportFilter::OK) {
+        Q_FOREACH (int copyFrame, m_d->frameCopies.value(frame)) {
+            if (!QFile::copy(filename, m_d->frameFilename(copyFrame))) {
+                status = KisImportExportFilter::CreationError;
+                break;
+            }
         }
     }
 
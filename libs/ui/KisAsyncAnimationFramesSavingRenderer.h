@@ -21,6 +21,9 @@
 
 #include <KisAsyncAnimationRendererBase.h>
 
+#include <QHash>
+#include <QVector>
+
 class KisDocument;
 class KisTimeRange;
 
@@ -33,6 +36,7 @@ public:
                                           const QString &fileNameSuffix,
                                           const QByteArray &outputMimeType,
                                           const KisTimeRange &range,
+                                          const QHash<int, QVector<int>> &frameCopies,
                                           int sequenceNumberingOffset,
                                           KisPropertiesConfigurationSP exportConfiguration);
     ~KisAsyncAnimationFramesSavingRenderer();
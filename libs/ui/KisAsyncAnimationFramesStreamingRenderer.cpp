@@ -0,0 +1,86 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "KisAsyncAnimationFramesStreamingRenderer.h"
+
+#include <QImage>
+
+#include <KoColorSpace.h>
+#include <KoColorModelStandardIds.h>
+
+#include "kis_image.h"
+#include "kis_paint_device.h"
+#include "KisAnimationFramesStream.h"
+
+
+KisAsyncAnimationFramesStreamingRenderer::KisAsyncAnimationFramesStreamingRenderer(KisAnimationFramesStream *stream,
+                                                                                   const QHash<int, QVector<int>> &frameCopies)
+    : m_stream(stream),
+      m_frameCopies(frameCopies)
+{
+    connect(this, SIGNAL(sigCompleteRegenerationInternal(int)), SLOT(notifyFrameCompleted(int)));
+    connect(this, SIGNAL(sigCancelRegenerationInternal(int)), SLOT(notifyFrameCancelled(int)));
+}
+
+KisAsyncAnimationFramesStreamingRenderer::~KisAsyncAnimationFramesStreamingRenderer()
+{
+}
+
+QString KisAsyncAnimationFramesStreamingRenderer::pixelFormat()
+{
+    // QImage::Format_ARGB32 keeps the pixels as native 32-bit integers
+    return QSysInfo::ByteOrder == QSysInfo::LittleEndian ? "bgra" : "argb";
+}
+
+QByteArray KisAsyncAnimationFramesStreamingRenderer::convertFrame(KisPaintDeviceSP device, const QRect &bounds)
+{
+    const KoColorSpace *cs = device->colorSpace();
+
+    const bool keepProfile =
+        cs->colorModelId() == RGBAColorModelID &&
+        (cs->colorDepthId() == Integer8BitsColorDepthID ||
+         cs->colorDepthId() == Integer16BitsColorDepthID);
+
+    const QImage frameImage =
+        device->convertToQImage(keepProfile ? cs->profile() : 0, bounds).convertToFormat(QImage::Format_ARGB32);
+
+    return QByteArray(reinterpret_cast<const char*>(frameImage.constBits()), frameImage.byteCount());
+}
+
+void KisAsyncAnimationFramesStreamingRenderer::frameCompletedCallback(int frame, const QRegion &requestedRegion)
+{
+    KisImageSP image = requestedImage();
+    if (!image) return;
+
+    KIS_SAFE_ASSERT_RECOVER (requestedRegion == image->bounds()) {
+        emit sigCancelRegenerationInternal(frame);
+        return;
+    }
+
+    const QByteArray data = convertFrame(image->projection(), image->bounds());
+
+    // may block until the encoder catches up
+    m_stream->pushFrame(frame, data, m_frameCopies.value(frame));
+
+    emit sigCompleteRegenerationInternal(frame);
+}
+
+void KisAsyncAnimationFramesStreamingRenderer::frameCancelledCallback(int frame)
+{
+    notifyFrameCancelled(frame);
+}
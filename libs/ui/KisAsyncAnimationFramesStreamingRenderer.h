@@ -0,0 +1,71 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KISASYNCANIMATIONFRAMESSTREAMINGRENDERER_H
+#define KISASYNCANIMATIONFRAMESSTREAMINGRENDERER_H
+
+#include <KisAsyncAnimationRendererBase.h>
+#include "kritaui_export.h"
+
+#include <QHash>
+#include <QVector>
+
+class KisAnimationFramesStream;
+
+/**
+ * Converts the rendered frames into raw 8-bit pixels and pushes them
+ * into a KisAnimationFramesStream. The pixel format is 'bgra' in terms
+ * of ffmpeg on little-endian systems and 'argb' on big-endian ones,
+ * see pixelFormat().
+ */
+class KRITAUI_EXPORT KisAsyncAnimationFramesStreamingRenderer : public KisAsyncAnimationRendererBase
+{
+    Q_OBJECT
+public:
+    KisAsyncAnimationFramesStreamingRenderer(KisAnimationFramesStream *stream,
+                                             const QHash<int, QVector<int>> &frameCopies);
+    ~KisAsyncAnimationFramesStreamingRenderer();
+
+    /**
+     * \return the ffmpeg name of the pixel format of the streamed frames
+     */
+    static QString pixelFormat();
+
+    /**
+     * Converts the \p bounds of \p device into the raw pixels of the
+     * stream. ffmpeg doesn't know anything about the color profiles, so
+     * the integer RGB frames keep the profile of the image, exactly like
+     * they would do when saved into a file. All the other color spaces
+     * are converted into sRGB.
+     */
+    static QByteArray convertFrame(KisPaintDeviceSP device, const QRect &bounds);
+
+protected:
+    void frameCompletedCallback(int frame, const QRegion &requestedRegion) override;
+    void frameCancelledCallback(int frame) override;
+
+Q_SIGNALS:
+    void sigCompleteRegenerationInternal(int frame);
+    void sigCancelRegenerationInternal(int frame);
+
+private:
+    KisAnimationFramesStream *m_stream;
+    QHash<int, QVector<int>> m_frameCopies;
+};
+
+#endif // KISASYNCANIMATIONFRAMESSTREAMINGRENDERER_H
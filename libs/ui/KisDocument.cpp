@@ -268,6 +268,7 @@ public:
         , gridConfig(rhs.gridConfig)
         , savingLock(&savingMutex)
         , batchMode(rhs.batchMode)
+        , savedNodesStates(rhs.savedNodesStates)
     {
         // TODO: clone assistants
     }
@@ -342,6 +343,9 @@ public:
 
     bool batchMode { false };
 
+    QHash<QString, KisSavedNodesState> savedNodesStates;
+    KisSavedNodesState savingNodesState;
+
     void setImageAndInitIdleWatcher(KisImageSP _image) {
         image = _image;
 
@@ -355,6 +359,13 @@ public:
         }
     }
 
+    void commitSavedNodesState(KisSavedNodesState state) {
+        if (state.filePath.isEmpty()) return;
+
+        state.updateFileInfo();
+        savedNodesStates.insert(state.filePath, state);
+    }
+
     class StrippedSafeSavingLocker;
 };
 
@@ -436,6 +447,10 @@ KisDocument::KisDocument(const KisDocument &rhs)
 
     slotConfigChanged();
 
+    // the clone is used for saving, so remember the state of the original
+    // nodes, it will be reported back to rhs after the saving is completed
+    d->savingNodesState.revisions = KisSavedNodesState::fetchRevisions(rhs.d->image->root());
+
     // clone the image with keeping the GUIDs of the layers intact
     // NOTE: we expect the image to be locked!
     setCurrentImage(rhs.image()->clone(true), false);
@@ -693,6 +708,8 @@ bool KisDocument::exportDocumentSync(const QUrl &url, const QByteArray &mimeType
     }
 
     d->savingImage = d->image;
+    d->savingNodesState = KisSavedNodesState();
+    d->savingNodesState.revisions = KisSavedNodesState::fetchRevisions(d->image->root());
 
     const QString fileName = url.toLocalFile();
 
@@ -700,6 +717,13 @@ bool KisDocument::exportDocumentSync(const QUrl &url, const QByteArray &mimeType
         d->importExportManager->
             exportDocument(fileName, fileName, mimeType, false, exportConfiguration);
 
+    if (status == KisImportExportFilter::OK) {
+        d->commitSavedNodesState(d->savingNodesState);
+    } else {
+        d->savedNodesStates.remove(fileName);
+    }
+
+    d->savingNodesState = KisSavedNodesState();
     d->savingImage = 0;
 
     return status == KisImportExportFilter::OK;
@@ -789,6 +813,12 @@ void KisDocument::slotChildCompletedSavingInBackground(KisImportExportFilter::Co
         d->backgroundSaveDocument->d->isAutosaving = false;
     }
 
+    if (status == KisImportExportFilter::OK) {
+        d->commitSavedNodesState(d->backgroundSaveDocument->d->savingNodesState);
+    } else {
+        d->savedNodesStates.remove(d->backgroundSaveJob.filePath);
+    }
+
     d->backgroundSaveDocument.take()->deleteLater();
     d->savingMutex.unlock();
 
@@ -1744,6 +1774,23 @@ KisImageSP KisDocument::savingImage() const
     return d->savingImage;
 }
 
+KisSavedNodesState KisDocument::savedNodesState(const QString &filePath) const
+{
+    return d->savedNodesStates.value(filePath);
+}
+
+KisSavedNodesState::Revisions KisDocument::savingNodesRevisions() const
+{
+    return d->savingNodesState.revisions;
+}
+
+void KisDocument::setSavingNodesFileNames(const QString &filePath, const QString &imageName, const QHash<QUuid, QString> &fileNames)
+{
+    d->savingNodesState.filePath = filePath;
+    d->savingNodesState.imageName = imageName;
+    d->savingNodesState.fileNames = fileNames;
+}
+
 
 void KisDocument::setCurrentImage(KisImageSP image, bool forceInitialUpdate)
 {
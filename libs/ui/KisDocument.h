@@ -39,6 +39,7 @@
 #include <KisReferenceImage.h>
 #include <kis_debug.h>
 #include <KisImportExportUtils.h>
+#include "KisSavedNodesState.h"
 
 #include "kritaui_export.h"
 
@@ -545,6 +546,26 @@ public:
      */
     KisImageSP savingImage() const;
 
+    /**
+     * @return the state of the nodes written into \p filePath by the last
+     * successful saving of the document. Used by the .kra exporter to copy
+     * the unchanged pixel data from the old file instead of encoding it again.
+     */
+    KisSavedNodesState savedNodesState(const QString &filePath) const;
+
+    /**
+     * @return the revisions of the nodes of the image being saved, fetched
+     * when the image was locked for saving
+     */
+    KisSavedNodesState::Revisions savingNodesRevisions() const;
+
+    /**
+     * Called by the .kra exporter when the pixel data of the nodes has been
+     * written into \p filePath. The state is remembered only if the saving
+     * completes successfully.
+     */
+    void setSavingNodesFileNames(const QString &filePath, const QString &imageName, const QHash<QUuid, QString> &fileNames);
+
     /**
      * Set the current image to the specified image and turn undo on.
      */
@@ -113,6 +113,17 @@ FrameInfo::FrameInfo(const QRect &dirtyImageRect, const QRect &imageBounds, int
 {
 }
 
+qint64 frameRawSize(const KisFrameDataSerializer::Frame &frame)
+{
+    qint64 size = 0;
+
+    for (auto it = frame.frameTiles.begin(); it != frame.frameTiles.end(); ++it) {
+        size += qint64(it->rect.width()) * it->rect.height() * frame.pixelSize;
+    }
+
+    return size;
+}
+
 FrameInfo::~FrameInfo()
 {
     KIS_SAFE_ASSERT_RECOVER_RETURN(m_savedFrameDataId >= 0 || m_type == FrameCopy);
@@ -127,8 +138,8 @@ FrameInfo::~FrameInfo()
 
 struct KRITAUI_NO_EXPORT KisFrameCacheStore::Private
 {
-    Private(const QString &frameCachePath)
-        : serializer(frameCachePath)
+    Private(KisFrameDataSerializer::StorageType storageType, const QString &frameCachePath)
+        : serializer(storageType, frameCachePath)
     {
     }
 
@@ -151,7 +162,12 @@ KisFrameCacheStore::KisFrameCacheStore()
 }
 
 KisFrameCacheStore::KisFrameCacheStore(const QString &frameCachePath)
-    : m_d(new Private(frameCachePath))
+    : KisFrameCacheStore(KisFrameDataSerializer::OnDiskStorage, frameCachePath)
+{
+}
+
+KisFrameCacheStore::KisFrameCacheStore(KisFrameDataSerializer::StorageType storageType, const QString &frameCachePath)
+    : m_d(new Private(storageType, frameCachePath))
 {
 }
 
@@ -349,6 +365,28 @@ void KisFrameCacheStore::forgetFrame(int frameId)
     }
 
     m_d->savedFrames.remove(frameId);
+
+    /**
+     * The cached keyframe is not needed anymore when none of the
+     * remaining frames is based on it. Drop it to free the memory.
+     */
+    if (m_d->lastLoadedBaseFrameInfo) {
+        bool isUsed = false;
+
+        Q_FOREACH (FrameInfoSP info, m_d->savedFrames) {
+            if (info == m_d->lastLoadedBaseFrameInfo ||
+                info->baseFrame() == m_d->lastLoadedBaseFrameInfo) {
+
+                isUsed = true;
+                break;
+            }
+        }
+
+        if (!isUsed) {
+            m_d->lastLoadedBaseFrame = KisFrameDataSerializer::Frame();
+            m_d->lastLoadedBaseFrameInfo.clear();
+        }
+    }
 }
 
 bool KisFrameCacheStore::hasFrame(int frameId) const
@@ -367,3 +405,10 @@ QRect KisFrameCacheStore::frameDirtyRect(int frameId) const
     KIS_SAFE_ASSERT_RECOVER_RETURN_VALUE(m_d->savedFrames.contains(frameId), QRect());
     return m_d->savedFrames[frameId]->dirtyImageRect();
 }
+
+qint64 KisFrameCacheStore::totalDataSize() const
+{
+    return m_d->serializer.totalDataSize() +
+        frameRawSize(m_d->lastSavedFullFrame) +
+        frameRawSize(m_d->lastLoadedBaseFrame);
+}
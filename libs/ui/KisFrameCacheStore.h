@@ -23,6 +23,7 @@
 #include "kis_types.h"
 
 #include "opengl/kis_texture_tile_info_pool.h"
+#include "KisFrameDataSerializer.h"
 
 class KisOpenGLUpdateInfoBuilder;
 
@@ -52,6 +53,7 @@ class KRITAUI_EXPORT KisFrameCacheStore
 public:
     KisFrameCacheStore();
     KisFrameCacheStore(const QString &frameCachePath);
+    KisFrameCacheStore(KisFrameDataSerializer::StorageType storageType, const QString &frameCachePath);
 
     ~KisFrameCacheStore();
 
@@ -67,6 +69,15 @@ public:
     int frameLevelOfDetail(int frameId) const;
     QRect frameDirtyRect(int frameId) const;
 
+    /**
+     * \return the amount of memory (or disk space) the store actually
+     * occupies: the compressed data of all the frames, including the
+     * keyframes that have already been forgotten, but are still used
+     * by their difference or copy frames, and the two uncompressed
+     * keyframes cached in memory.
+     */
+    qint64 totalDataSize() const;
+
 private:
     struct Private;
     const QScopedPointer<Private> m_d;
@@ -24,8 +24,10 @@
 
 struct KisFrameCacheSwapper::Private
 {
-    Private(const KisOpenGLUpdateInfoBuilder &_builder, const QString &frameCachePath)
-        : frameStore(frameCachePath),
+    Private(const KisOpenGLUpdateInfoBuilder &_builder,
+            KisFrameDataSerializer::StorageType storageType,
+            const QString &frameCachePath)
+        : frameStore(storageType, frameCachePath),
           builder(_builder)
     {
     }
@@ -40,7 +42,14 @@ KisFrameCacheSwapper::KisFrameCacheSwapper(const KisOpenGLUpdateInfoBuilder &bui
 }
 
 KisFrameCacheSwapper::KisFrameCacheSwapper(const KisOpenGLUpdateInfoBuilder &builder, const QString &frameCachePath)
-    : m_d(new Private(builder, frameCachePath))
+    : KisFrameCacheSwapper(builder, KisFrameDataSerializer::OnDiskStorage, frameCachePath)
+{
+}
+
+KisFrameCacheSwapper::KisFrameCacheSwapper(const KisOpenGLUpdateInfoBuilder &builder,
+                                           KisFrameDataSerializer::StorageType storageType,
+                                           const QString &frameCachePath)
+    : m_d(new Private(builder, storageType, frameCachePath))
 {
 }
 
@@ -82,3 +91,8 @@ QRect KisFrameCacheSwapper::frameDirtyRect(int frameId) const
 {
     return m_d->frameStore.frameDirtyRect(frameId);
 }
+
+qint64 KisFrameCacheSwapper::totalDataSize() const
+{
+    return m_d->frameStore.totalDataSize();
+}
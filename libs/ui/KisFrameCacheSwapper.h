@@ -21,6 +21,7 @@
 #include <QScopedPointer>
 
 #include "KisAbstractFrameCacheSwapper.h"
+#include "KisFrameDataSerializer.h"
 
 class KisOpenGLUpdateInfoBuilder;
 
@@ -35,6 +36,9 @@ class KisOpenGLUpdateInfoBuilder;
  *
  * 2) Pass all the other requests to the lower-level API,
  *    like KisFrameCacheStore
+ *
+ * Depending on the storage type, the compressed frames are kept either
+ * on disk or in memory.
  */
 
 class KRITAUI_EXPORT KisFrameCacheSwapper : public KisAbstractFrameCacheSwapper
@@ -42,6 +46,9 @@ class KRITAUI_EXPORT KisFrameCacheSwapper : public KisAbstractFrameCacheSwapper
 public:
     KisFrameCacheSwapper(const KisOpenGLUpdateInfoBuilder &builder);
     KisFrameCacheSwapper(const KisOpenGLUpdateInfoBuilder &builder, const QString &frameCachePath);
+    KisFrameCacheSwapper(const KisOpenGLUpdateInfoBuilder &builder,
+                         KisFrameDataSerializer::StorageType storageType,
+                         const QString &frameCachePath);
     ~KisFrameCacheSwapper();
 
     // WARNING: after transferring \p info to saveFrame() the object becomes invalid
@@ -57,6 +64,8 @@ public:
 
     QRect frameDirtyRect(int frameId) const override;
 
+    qint64 totalDataSize() const override;
+
 private:
     struct Private;
     const QScopedPointer<Private> m_d;
@@ -21,19 +21,25 @@
 
 #include <QTemporaryDir>
 #include <QElapsedTimer>
+#include <QBuffer>
+#include <QHash>
 
 #include "tiles3/swap/kis_lzf_compression.h"
 
 struct KRITAUI_NO_EXPORT KisFrameDataSerializer::Private
 {
-    Private(const QString &frameCachePath)
-        : framesDir(
-              (!frameCachePath.isEmpty() ? frameCachePath : QDir::tempPath()) +
-              QDir::separator() + "KritaFrameCacheXXXXXX")
+    Private(StorageType _storageType, const QString &frameCachePath)
+        : storageType(_storageType)
     {
-        KIS_SAFE_ASSERT_RECOVER_NOOP(framesDir.isValid());
-        framesDirObject = QDir(framesDir.path());
-        framesDirObject.makeAbsolute();
+        if (storageType == OnDiskStorage) {
+            framesDir.reset(new QTemporaryDir(
+                (!frameCachePath.isEmpty() ? frameCachePath : QDir::tempPath()) +
+                QDir::separator() + "KritaFrameCacheXXXXXX"));
+
+            KIS_SAFE_ASSERT_RECOVER_NOOP(framesDir->isValid());
+            framesDirObject = QDir(framesDir->path());
+            framesDirObject.makeAbsolute();
+        }
     }
 
     QString subfolderNameForFrame(int frameId)
@@ -65,52 +71,45 @@ struct KRITAUI_NO_EXPORT KisFrameDataSerializer::Private
         return reinterpret_cast<quint8*>(compressionBuffer.data());
     }
 
-    QTemporaryDir framesDir;
-    QDir framesDirObject;
-    int nextFrameId = 0;
+    void writeFrame(QIODevice *device, int frameId, const Frame &frame);
+    Frame readFrame(QIODevice *device, int frameId, KisTextureTileInfoPoolSP pool);
 
-    QByteArray compressionBuffer;
-};
-
-KisFrameDataSerializer::KisFrameDataSerializer()
-    : KisFrameDataSerializer(QString())
-{
-}
-
-KisFrameDataSerializer::KisFrameDataSerializer(const QString &frameCachePath)
-    : m_d(new Private(frameCachePath))
-{
-}
-
-KisFrameDataSerializer::~KisFrameDataSerializer()
-{
-}
+    StorageType storageType;
 
-int KisFrameDataSerializer::saveFrame(const KisFrameDataSerializer::Frame &frame)
-{
-    KisLzfCompression compression;
-
-    const int frameId = m_d->generateFrameId();
-
-    const QString frameSubfolder = m_d->subfolderNameForFrame(frameId);
+    QScopedPointer<QTemporaryDir> framesDir;
+    QDir framesDirObject;
 
-    if (!m_d->framesDirObject.exists(frameSubfolder)) {
-        m_d->framesDirObject.mkpath(frameSubfolder);
+    /**
+     * In in-memory mode the frames are stored in exactly the same
+     * (compressed) format as the one used for the files on disk
+     */
+    QHash<int, QByteArray> memoryFrames;
+
+    /**
+     * The sizes of all the stored frames, either in memory or on disk
+     */
+    QHash<int, qint64> frameSizes;
+    qint64 totalDataSize = 0;
+
+    void addFrameSize(int frameId, qint64 size) {
+        frameSizes.insert(frameId, size);
+        totalDataSize += size;
     }
 
-    const QString frameRelativePath = frameSubfolder + QDir::separator() + m_d->fileNameForFrame(frameId);
-
-    if (m_d->framesDirObject.exists(frameRelativePath)) {
-        qWarning() << "WARNING: overwriting existing frame file!" << frameRelativePath;
-        forgetFrame(frameId);
+    void removeFrameSize(int frameId) {
+        totalDataSize -= frameSizes.take(frameId);
     }
 
-    const QString frameFilePath = m_d->framesDirObject.filePath(frameRelativePath);
+    int nextFrameId = 0;
 
-    QFile file(frameFilePath);
-    file.open(QFile::WriteOnly);
+    QByteArray compressionBuffer;
+};
 
-    QDataStream stream(&file);
+void KisFrameDataSerializer::Private::writeFrame(QIODevice *device, int frameId, const Frame &frame)
+{
+    KisLzfCompression compression;
+
+    QDataStream stream(device);
     stream << frameId;
     stream << frame.pixelSize;
 
@@ -125,7 +124,7 @@ int KisFrameDataSerializer::saveFrame(const KisFrameDataSerializer::Frame &frame
 
         const int frameByteSize = frame.pixelSize * tile.rect.width() * tile.rect.height();
         const int maxBufferSize = compression.outputBufferSize(frameByteSize);
-        quint8 *buffer = m_d->getCompressionBuffer(maxBufferSize);
+        quint8 *buffer = getCompressionBuffer(maxBufferSize);
 
         const int compressedSize =
             compression.compress(tile.data.data(), frameByteSize, buffer, maxBufferSize);
@@ -143,13 +142,9 @@ int KisFrameDataSerializer::saveFrame(const KisFrameDataSerializer::Frame &frame
             stream.writeRawData((char*)tile.data.data(), frameByteSize);
         }
     }
-
-    file.close();
-
-    return frameId;
 }
 
-KisFrameDataSerializer::Frame KisFrameDataSerializer::loadFrame(int frameId, KisTextureTileInfoPoolSP pool)
+KisFrameDataSerializer::Frame KisFrameDataSerializer::Private::readFrame(QIODevice *device, int frameId, KisTextureTileInfoPoolSP pool)
 {
     KisLzfCompression compression;
 
@@ -161,13 +156,7 @@ KisFrameDataSerializer::Frame KisFrameDataSerializer::loadFrame(int frameId, Kis
 
     qint64 compressionTime = 0;
 
-    const QString framePath = m_d->filePathForFrame(frameId);
-
-    QFile file(framePath);
-    KIS_SAFE_ASSERT_RECOVER_NOOP(file.exists());
-    if (!file.open(QFile::ReadOnly)) return frame;
-
-    QDataStream stream(&file);
+    QDataStream stream(device);
 
     int numTiles = 0;
 
@@ -196,7 +185,7 @@ KisFrameDataSerializer::Frame KisFrameDataSerializer::loadFrame(int frameId, Kis
 
         if (isCompressed) {
             const int maxBufferSize = compression.outputBufferSize(inputSize);
-            quint8 *buffer = m_d->getCompressionBuffer(maxBufferSize);
+            quint8 *buffer = getCompressionBuffer(maxBufferSize);
             stream.readRawData((char*)buffer, inputSize);
 
             tile.data.allocate(frame.pixelSize);
@@ -223,6 +212,96 @@ KisFrameDataSerializer::Frame KisFrameDataSerializer::loadFrame(int frameId, Kis
         frame.frameTiles.push_back(std::move(tile));
     }
 
+    return frame;
+}
+
+KisFrameDataSerializer::KisFrameDataSerializer()
+    : KisFrameDataSerializer(OnDiskStorage, QString())
+{
+}
+
+KisFrameDataSerializer::KisFrameDataSerializer(const QString &frameCachePath)
+    : KisFrameDataSerializer(OnDiskStorage, frameCachePath)
+{
+}
+
+KisFrameDataSerializer::KisFrameDataSerializer(StorageType storageType, const QString &frameCachePath)
+    : m_d(new Private(storageType, frameCachePath))
+{
+}
+
+KisFrameDataSerializer::~KisFrameDataSerializer()
+{
+}
+
+int KisFrameDataSerializer::saveFrame(const KisFrameDataSerializer::Frame &frame)
+{
+    const int frameId = m_d->generateFrameId();
+
+    if (m_d->storageType == InMemoryStorage) {
+        KIS_SAFE_ASSERT_RECOVER_NOOP(!m_d->memoryFrames.contains(frameId));
+
+        QByteArray &data = m_d->memoryFrames[frameId];
+        data.clear();
+
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::WriteOnly);
+        m_d->writeFrame(&buffer, frameId, frame);
+        buffer.close();
+
+        m_d->addFrameSize(frameId, data.size());
+
+        return frameId;
+    }
+
+    const QString frameSubfolder = m_d->subfolderNameForFrame(frameId);
+
+    if (!m_d->framesDirObject.exists(frameSubfolder)) {
+        m_d->framesDirObject.mkpath(frameSubfolder);
+    }
+
+    const QString frameRelativePath = frameSubfolder + QDir::separator() + m_d->fileNameForFrame(frameId);
+
+    if (m_d->framesDirObject.exists(frameRelativePath)) {
+        qWarning() << "WARNING: overwriting existing frame file!" << frameRelativePath;
+        forgetFrame(frameId);
+    }
+
+    const QString frameFilePath = m_d->framesDirObject.filePath(frameRelativePath);
+
+    QFile file(frameFilePath);
+    file.open(QFile::WriteOnly);
+    m_d->writeFrame(&file, frameId, frame);
+    m_d->addFrameSize(frameId, file.size());
+    file.close();
+
+    return frameId;
+}
+
+KisFrameDataSerializer::Frame KisFrameDataSerializer::loadFrame(int frameId, KisTextureTileInfoPoolSP pool)
+{
+    KisFrameDataSerializer::Frame frame;
+
+    if (m_d->storageType == InMemoryStorage) {
+        auto it = m_d->memoryFrames.find(frameId);
+        KIS_SAFE_ASSERT_RECOVER_RETURN_VALUE(it != m_d->memoryFrames.end(), frame);
+
+        QBuffer buffer(&it.value());
+        buffer.open(QIODevice::ReadOnly);
+        frame = m_d->readFrame(&buffer, frameId, pool);
+        buffer.close();
+
+        return frame;
+    }
+
+    const QString framePath = m_d->filePathForFrame(frameId);
+
+    QFile file(framePath);
+    KIS_SAFE_ASSERT_RECOVER_NOOP(file.exists());
+    if (!file.open(QFile::ReadOnly)) return frame;
+
+    frame = m_d->readFrame(&file, frameId, pool);
+
     file.close();
 
     return frame;
@@ -230,6 +309,15 @@ KisFrameDataSerializer::Frame KisFrameDataSerializer::loadFrame(int frameId, Kis
 
 void KisFrameDataSerializer::moveFrame(int srcFrameId, int dstFrameId)
 {
+    if (m_d->storageType == InMemoryStorage) {
+        KIS_SAFE_ASSERT_RECOVER_RETURN(m_d->memoryFrames.contains(srcFrameId));
+        KIS_SAFE_ASSERT_RECOVER_NOOP(!m_d->memoryFrames.contains(dstFrameId));
+
+        m_d->memoryFrames.insert(dstFrameId, m_d->memoryFrames.take(srcFrameId));
+        m_d->frameSizes.insert(dstFrameId, m_d->frameSizes.take(srcFrameId));
+        return;
+    }
+
     const QString srcFramePath = m_d->filePathForFrame(srcFrameId);
     const QString dstFramePath = m_d->filePathForFrame(dstFrameId);
     KIS_SAFE_ASSERT_RECOVER_RETURN(QFileInfo(srcFramePath).exists());
@@ -239,20 +327,42 @@ void KisFrameDataSerializer::moveFrame(int srcFrameId, int dstFrameId)
     }
 
     QFile::rename(srcFramePath, dstFramePath);
+    m_d->frameSizes.insert(dstFrameId, m_d->frameSizes.take(srcFrameId));
 }
 
 bool KisFrameDataSerializer::hasFrame(int frameId) const
 {
+    if (m_d->storageType == InMemoryStorage) {
+        return m_d->memoryFrames.contains(frameId);
+    }
+
     const QString framePath = m_d->filePathForFrame(frameId);
     return QFileInfo(framePath).exists();
 }
 
 void KisFrameDataSerializer::forgetFrame(int frameId)
 {
+    m_d->removeFrameSize(frameId);
+
+    if (m_d->storageType == InMemoryStorage) {
+        m_d->memoryFrames.remove(frameId);
+        return;
+    }
+
     const QString framePath = m_d->filePathForFrame(frameId);
     QFile::remove(framePath);
 }
 
+qint64 KisFrameDataSerializer::frameDataSize(int frameId) const
+{
+    return m_d->frameSizes.value(frameId, 0);
+}
+
+qint64 KisFrameDataSerializer::totalDataSize() const
+{
+    return m_d->totalDataSize;
+}
+
 boost::optional<qreal> KisFrameDataSerializer::estimateFrameUniqueness(const KisFrameDataSerializer::Frame &lhs, const KisFrameDataSerializer::Frame &rhs, qreal portion)
 {
     if (lhs.pixelSize != rhs.pixelSize) return boost::none;
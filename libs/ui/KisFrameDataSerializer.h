@@ -40,6 +40,10 @@ class QString;
  *    but a preprocessed pixel differences)
  *
  * 2) Compress this data and save it on disk
+ *
+ * In InMemoryStorage mode the compressed data is kept in memory instead
+ * of the disk, which still takes several times less memory than keeping
+ * raw frames.
  */
 
 class KRITAUI_EXPORT KisFrameDataSerializer
@@ -106,9 +110,15 @@ public:
         }
     };
 
+    enum StorageType {
+        OnDiskStorage,
+        InMemoryStorage
+    };
+
 public:
     KisFrameDataSerializer();
     KisFrameDataSerializer(const QString &frameCachePath);
+    KisFrameDataSerializer(StorageType storageType, const QString &frameCachePath);
     ~KisFrameDataSerializer();
 
     int saveFrame(const Frame &frame);
@@ -119,6 +129,16 @@ public:
     bool hasFrame(int frameId) const;
     void forgetFrame(int frameId);
 
+    /**
+     * \return the size of the compressed frame data in bytes
+     */
+    qint64 frameDataSize(int frameId) const;
+
+    /**
+     * \return the size of the compressed data of all the stored frames
+     */
+    qint64 totalDataSize() const;
+
     static boost::optional<qreal> estimateFrameUniqueness(const Frame &lhs, const Frame &rhs, qreal portion);
     static bool subtractFrames(Frame &dst, const Frame &src);
     static void addFrames(Frame &dst, const Frame &src);
@@ -24,6 +24,17 @@
 struct KRITAUI_NO_EXPORT KisInMemoryFrameCacheSwapper::Private
 {
     QMap<int, KisOpenGLUpdateInfoSP> framesMap;
+    qint64 totalDataSize = 0;
+
+    static qint64 frameDataSize(KisOpenGLUpdateInfoSP info) {
+        qint64 size = 0;
+
+        Q_FOREACH (KisTextureTileUpdateInfoSP tile, info->tileList) {
+            size += tile->patchPixelsLength();
+        }
+
+        return size;
+    }
 };
 
 KisInMemoryFrameCacheSwapper::KisInMemoryFrameCacheSwapper()
@@ -41,6 +52,7 @@ void KisInMemoryFrameCacheSwapper::saveFrame(int frameId, KisOpenGLUpdateInfoSP
     KIS_SAFE_ASSERT_RECOVER_NOOP(!m_d->framesMap.contains(frameId));
 
     m_d->framesMap.insert(frameId, info);
+    m_d->totalDataSize += m_d->frameDataSize(info);
 }
 
 KisOpenGLUpdateInfoSP KisInMemoryFrameCacheSwapper::loadFrame(int frameId)
@@ -61,7 +73,7 @@ void KisInMemoryFrameCacheSwapper::moveFrame(int srcFrameId, int dstFrameId)
 void KisInMemoryFrameCacheSwapper::forgetFrame(int frameId)
 {
     KIS_SAFE_ASSERT_RECOVER_RETURN(m_d->framesMap.contains(frameId));
-    m_d->framesMap.remove(frameId);
+    m_d->totalDataSize -= m_d->frameDataSize(m_d->framesMap.take(frameId));
 }
 
 bool KisInMemoryFrameCacheSwapper::hasFrame(int frameId) const
@@ -80,3 +92,8 @@ QRect KisInMemoryFrameCacheSwapper::frameDirtyRect(int frameId) const
     KIS_SAFE_ASSERT_RECOVER_RETURN_VALUE(m_d->framesMap.contains(frameId), QRect());
     return m_d->framesMap[frameId]->dirtyImageRect();
 }
+
+qint64 KisInMemoryFrameCacheSwapper::totalDataSize() const
+{
+    return m_d->totalDataSize;
+}
@@ -45,6 +45,8 @@ public:
 
     QRect frameDirtyRect(int frameId) const override;
 
+    qint64 totalDataSize() const override;
+
 private:
     struct Private;
     const QScopedPointer<Private> m_d;
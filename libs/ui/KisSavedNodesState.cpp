@@ -0,0 +1,87 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "KisSavedNodesState.h"
+
+#include <QFileInfo>
+
+#include "kis_layer_utils.h"
+#include "kis_node.h"
+#include "kis_paint_device.h"
+#include "lazybrush/kis_colorize_mask.h"
+
+
+KisSavedNodesState::Revisions KisSavedNodesState::fetchRevisions(KisNodeSP root)
+{
+    Revisions revisions;
+
+    KisLayerUtils::recursiveApplyNodes(root,
+        [&revisions] (KisNodeSP node) {
+            if (dynamic_cast<KisColorizeMask*>(node.data())) return;
+
+            KisPaintDeviceSP device = node->paintDevice();
+            if (!device || device->keyframeChannel()) return;
+
+            Revision revision;
+            revision.device = device.data();
+            revision.colorSpace = device->colorSpace();
+            revision.sequenceNumber = device->sequenceNumber();
+
+            revisions.insert(node->uuid(), revision);
+        });
+
+    return revisions;
+}
+
+bool KisSavedNodesState::isValid() const
+{
+    if (filePath.isEmpty()) return false;
+
+    const QFileInfo info(filePath);
+
+    return info.exists() &&
+        info.lastModified() == lastModified &&
+        info.size() == fileSize;
+}
+
+QHash<QUuid, QString> KisSavedNodesState::unchangedNodes(const Revisions &currentRevisions) const
+{
+    QHash<QUuid, QString> result;
+
+    for (auto it = fileNames.constBegin(); it != fileNames.constEnd(); ++it) {
+        auto savedRevision = revisions.constFind(it.key());
+        auto currentRevision = currentRevisions.constFind(it.key());
+
+        if (savedRevision != revisions.constEnd() &&
+            currentRevision != currentRevisions.constEnd() &&
+            *savedRevision == *currentRevision) {
+
+            result.insert(it.key(), it.value());
+        }
+    }
+
+    return result;
+}
+
+void KisSavedNodesState::updateFileInfo()
+{
+    const QFileInfo info(filePath);
+
+    lastModified = info.lastModified();
+    fileSize = info.exists() ? info.size() : -1;
+}
@@ -0,0 +1,99 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KISSAVEDNODESSTATE_H
+#define KISSAVEDNODESSTATE_H
+
+#include <QDateTime>
+#include <QHash>
+#include <QString>
+#include <QUuid>
+
+#include "kis_types.h"
+#include "kritaui_export.h"
+
+class KoColorSpace;
+
+/**
+ * KisSavedNodesState remembers which data of the nodes has been written
+ * into a .kra file during the last successful saving. When the same file is
+ * saved again, the pixel data of the nodes, which has not been changed since
+ * then, can be copied from the old file instead of being encoded again.
+ *
+ * The state of a node is represented by the revision of its paint
+ * device. The revision changes on every change of the device's content,
+ * so two equal revisions guarantee that the data is the same. Animated
+ * nodes and colorize masks have no revision, they are always considered
+ * changed.
+ */
+class KRITAUI_EXPORT KisSavedNodesState
+{
+public:
+    struct Revision {
+        const KisPaintDevice *device = 0;
+        const KoColorSpace *colorSpace = 0;
+        int sequenceNumber = 0;
+
+        bool operator==(const Revision &rhs) const {
+            return device == rhs.device &&
+                colorSpace == rhs.colorSpace &&
+                sequenceNumber == rhs.sequenceNumber;
+        }
+
+        bool operator!=(const Revision &rhs) const {
+            return !(*this == rhs);
+        }
+    };
+
+    typedef QHash<QUuid, Revision> Revisions;
+
+public:
+    /**
+     * Fetches the revisions of all the nodes of the \p root's subtree.
+     * The image should be locked.
+     */
+    static Revisions fetchRevisions(KisNodeSP root);
+
+    /**
+     * \return true if the state describes a file, which has not been
+     *         changed on disk since the state was recorded
+     */
+    bool isValid() const;
+
+    /**
+     * \return the file names of the nodes whose revisions are the same
+     *         in \p currentRevisions and in this state
+     */
+    QHash<QUuid, QString> unchangedNodes(const Revisions &currentRevisions) const;
+
+    /**
+     * Remembers the size and the modification time of the saved file
+     */
+    void updateFileInfo();
+
+public:
+    QString filePath;
+    QString imageName;
+    QDateTime lastModified;
+    qint64 fileSize = -1;
+
+    Revisions revisions;
+    QHash<QUuid, QString> fileNames;
+};
+
+#endif // KISSAVEDNODESSTATE_H
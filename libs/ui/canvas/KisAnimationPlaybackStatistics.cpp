@@ -0,0 +1,72 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "KisAnimationPlaybackStatistics.h"
+
+
+KisAnimationPlaybackStatistics::KisAnimationPlaybackStatistics()
+{
+    reset();
+}
+
+void KisAnimationPlaybackStatistics::reset()
+{
+    m_framesShown = 0;
+    m_framesDropped = 0;
+    m_framesPrefetched = 0;
+    m_totalLatency = 0;
+    m_maxLatency = 0;
+}
+
+void KisAnimationPlaybackStatistics::registerFrame(int numFramesAdvanced, qint64 latency, bool prefetched)
+{
+    m_framesShown++;
+    m_framesDropped += qMax(0, numFramesAdvanced - 1);
+
+    if (prefetched) {
+        m_framesPrefetched++;
+    }
+
+    m_totalLatency += latency;
+    m_maxLatency = qMax(m_maxLatency, latency);
+}
+
+int KisAnimationPlaybackStatistics::framesShown() const
+{
+    return m_framesShown;
+}
+
+int KisAnimationPlaybackStatistics::framesDropped() const
+{
+    return m_framesDropped;
+}
+
+int KisAnimationPlaybackStatistics::framesPrefetched() const
+{
+    return m_framesPrefetched;
+}
+
+qreal KisAnimationPlaybackStatistics::averageLatency() const
+{
+    return m_framesShown ? 0.001 * m_totalLatency / m_framesShown : 0.0;
+}
+
+qreal KisAnimationPlaybackStatistics::maxLatency() const
+{
+    return 0.001 * m_maxLatency;
+}
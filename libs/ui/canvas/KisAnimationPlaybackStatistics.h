@@ -0,0 +1,72 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KISANIMATIONPLAYBACKSTATISTICS_H
+#define KISANIMATIONPLAYBACKSTATISTICS_H
+
+#include <QtGlobal>
+
+#include "kritaui_export.h"
+
+/**
+ * Accumulates the statistics of the animation playback: the number of
+ * shown and dropped frames and the latency of the frames upload, that is,
+ * the time spent on fetching the frame from the cache and uploading it to
+ * the canvas.
+ */
+class KRITAUI_EXPORT KisAnimationPlaybackStatistics
+{
+public:
+    KisAnimationPlaybackStatistics();
+
+    void reset();
+
+    /**
+     * Registers a frame shown by the player
+     *
+     * \p numFramesAdvanced the number of frames the playhead has moved
+     *                      since the previously shown frame. Anything
+     *                      greater than 1 means some frames were dropped.
+     * \p latency the time spent on uploading the frame, in microseconds
+     * \p prefetched true if the frame data has been prefetched in background
+     */
+    void registerFrame(int numFramesAdvanced, qint64 latency, bool prefetched);
+
+    int framesShown() const;
+    int framesDropped() const;
+    int framesPrefetched() const;
+
+    /**
+     * \return the average latency of a frame upload in milliseconds
+     */
+    qreal averageLatency() const;
+
+    /**
+     * \return the maximum latency of a frame upload in milliseconds
+     */
+    qreal maxLatency() const;
+
+private:
+    int m_framesShown;
+    int m_framesDropped;
+    int m_framesPrefetched;
+    qint64 m_totalLatency;
+    qint64 m_maxLatency;
+};
+
+#endif // KISANIMATIONPLAYBACKSTATISTICS_H
@@ -50,6 +50,7 @@
 #include "KisPart.h"
 #include "dialogs/KisAsyncAnimationCacheRenderDialog.h"
 #include "KisRollingMeanAccumulatorWrapper.h"
+#include "KisAnimationPlaybackStatistics.h"
 
 
 struct KisAnimationPlayer::Private
@@ -66,6 +67,7 @@ public:
           expectedFrame(0),
           lastTimerInterval(0),
           lastPaintedFrame(0),
+          prefetchFramesCount(0),
           playbackStatisticsCompressor(1000, KisSignalCompressor::FIRST_INACTIVE),
           stopAudioOnScrubbingCompressor(100, KisSignalCompressor::POSTPONE),
           audioOffsetTolerance(-1)
@@ -102,6 +104,9 @@ public:
     int lastTimerInterval;
     int lastPaintedFrame;
 
+    int prefetchFramesCount;
+    KisAnimationPlaybackStatistics playbackStatistics;
+
     KisSignalCompressor playbackStatisticsCompressor;
 
     QScopedPointer<KisSyncedAudioPlayback> syncedAudio;
@@ -111,6 +116,7 @@ public:
     int audioOffsetTolerance;
 
     void stopImpl(bool doUpdates);
+    void prefetchFrames(int frame);
 
     int incFrame(int frame, int inc) {
         frame += inc;
@@ -120,6 +126,14 @@ public:
         return frame;
     }
 
+    int framesDistance(int from, int to) {
+        int numFrames = to - from;
+        if (numFrames < 0) {
+            numFrames += lastFrame - firstFrame + 1;
+        }
+        return numFrames;
+    }
+
     qint64 frameToMSec(int value, int fps) {
         return qreal(value) / fps * 1000.0;
     }
@@ -377,6 +391,10 @@ void KisAnimationPlayer::play()
     m_d->expectedFrame = m_d->firstFrame;
     m_d->lastPaintedFrame = -1;
 
+    m_d->prefetchFramesCount = qMax(0, KisConfig(true).animationPlaybackPrefetchFrames());
+    m_d->playbackStatistics.reset();
+    m_d->prefetchFrames(m_d->firstFrame - 1);
+
     connectCancelSignals();
 
     if (m_d->syncedAudio) {
@@ -399,6 +417,11 @@ void KisAnimationPlayer::Private::stopImpl(bool doUpdates)
     playing = false;
     canvas->setRenderingLimit(QRect());
 
+    if (canvas->frameCache()) {
+        // release the frames prefetched ahead of the playhead
+        canvas->frameCache()->prefetchFrames(QVector<int>());
+    }
+
     if (doUpdates) {
         KisImageAnimationInterface *animation = canvas->image()->animationInterface();
         if (animation->currentUITime() == initialFrame) {
@@ -411,6 +434,19 @@ void KisAnimationPlayer::Private::stopImpl(bool doUpdates)
     emit q->sigPlaybackStopped();
 }
 
+void KisAnimationPlayer::Private::prefetchFrames(int frame)
+{
+    if (!canvas->frameCache() || !prefetchFramesCount) return;
+
+    QVector<int> times;
+
+    for (int i = 1; i <= prefetchFramesCount; i++) {
+        times << incFrame(frame, i);
+    }
+
+    canvas->frameCache()->prefetchFrames(times);
+}
+
 void KisAnimationPlayer::stop()
 {
     m_d->stopImpl(true);
@@ -482,11 +518,16 @@ void KisAnimationPlayer::uploadFrame(int frame)
     }
 
 
+    QElapsedTimer uploadTimer;
+    uploadTimer.start();
+
     bool useFallbackUploadMethod = !m_d->canvas->frameCache();
+    bool framePrefetched = false;
 
     if (m_d->canvas->frameCache() &&
         m_d->canvas->frameCache()->shouldUploadNewFrame(frame, m_d->lastPaintedFrame)) {
 
+        framePrefetched = m_d->canvas->frameCache()->frameIsPrefetched(frame);
 
         if (m_d->canvas->frameCache()->uploadFrame(frame)) {
             m_d->canvas->updateCanvas();
@@ -507,6 +548,12 @@ void KisAnimationPlayer::uploadFrame(int frame)
         animationInterface->switchCurrentTimeAsync(frame);
     }
 
+    const qint64 uploadLatency = uploadTimer.nsecsElapsed() / 1000;
+
+    if (isPlaying()) {
+        m_d->prefetchFrames(frame);
+    }
+
     if (!m_d->realFpsTimer.isValid()) {
         m_d->realFpsTimer.start();
     } else {
@@ -514,10 +561,7 @@ void KisAnimationPlayer::uploadFrame(int frame)
         m_d->realFpsAccumulator(elapsed);
 
         if (m_d->lastPaintedFrame >= 0) {
-            int numFrames = frame - m_d->lastPaintedFrame;
-            if (numFrames < 0) {
-                numFrames += m_d->lastFrame - m_d->firstFrame + 1;
-            }
+            const int numFrames = m_d->framesDistance(m_d->lastPaintedFrame, frame);
 
             m_d->droppedFramesPortion(qreal(int(numFrames != 1)));
 
@@ -532,6 +576,13 @@ void KisAnimationPlayer::uploadFrame(int frame)
         }
     }
 
+    if (isPlaying()) {
+        const int numFrames = m_d->lastPaintedFrame >= 0 ?
+            m_d->framesDistance(m_d->lastPaintedFrame, frame) : 1;
+
+        m_d->playbackStatistics.registerFrame(numFrames, uploadLatency, framePrefetched);
+    }
+
     m_d->lastPaintedFrame = frame;
     emit sigFrameChanged();
 }
@@ -551,6 +602,11 @@ qreal KisAnimationPlayer::framesDroppedPortion() const
     return m_d->droppedFramesPortion.rollingMean();
 }
 
+const KisAnimationPlaybackStatistics& KisAnimationPlayer::playbackStatistics() const
+{
+    return m_d->playbackStatistics;
+}
+
 void KisAnimationPlayer::slotCancelPlayback()
 {
     stop();
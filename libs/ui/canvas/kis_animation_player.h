@@ -26,6 +26,7 @@
 
 
 class KisCanvas2;
+class KisAnimationPlaybackStatistics;
 
 class KRITAUI_EXPORT KisAnimationPlayer : public QObject
 {
@@ -50,6 +51,12 @@ public:
     qreal realFps() const;
     qreal framesDroppedPortion() const;
 
+    /**
+     * \return the statistics of the frames shown since the start of the
+     *         current (or the last) playback
+     */
+    const KisAnimationPlaybackStatistics& playbackStatistics() const;
+
 public Q_SLOTS:
     void slotUpdate();
     void slotCancelPlayback();
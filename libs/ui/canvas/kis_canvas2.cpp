@@ -21,6 +21,7 @@
 
 #include "kis_canvas2.h"
 
+#include <algorithm>
 #include <functional>
 #include <numeric>
 
@@ -108,6 +109,7 @@ public:
         , toolProxy(parent)
         , displayColorConverter(resourceManager, view)
         , regionOfInterestUpdateCompressor(100, KisSignalCompressor::FIRST_INACTIVE)
+        , offscreenUpdatesCompressor(500, KisSignalCompressor::POSTPONE)
     {
     }
 
@@ -135,6 +137,7 @@ public:
     KisDisplayColorConverter displayColorConverter;
 
     KisCanvasUpdatesCompressor projectionUpdatesCompressor;
+    bool prioritizeVisibleUpdates = true;
     KisAnimationPlayer *animationPlayer;
     KisAnimationFrameCacheSP frameCache;
     bool lodAllowedInImage = false;
@@ -147,6 +150,13 @@ public:
     KisSignalCompressor regionOfInterestUpdateCompressor;
     QRect regionOfInterest;
 
+    /**
+     * Uploads the projection updates that were postponed because they
+     * were outside the viewport. Fires when the image has not been
+     * updated for a while.
+     */
+    KisSignalCompressor offscreenUpdatesCompressor;
+
     QRect renderingLimit;
 
     bool effectiveLodAllowedInImage() {
@@ -210,6 +220,7 @@ void KisCanvas2::setup()
     KisConfig cfg(true);
     m_d->vastScrolling = cfg.vastScrolling();
     m_d->lodAllowedInImage = cfg.levelOfDetailEnabled();
+    m_d->prioritizeVisibleUpdates = cfg.prioritizeVisibleCanvasUpdates();
 
     createCanvas(cfg.useOpenGL());
 
@@ -245,6 +256,7 @@ void KisCanvas2::setup()
 
     connect(this, SIGNAL(sigCanvasCacheUpdated()), &m_d->frameRenderStartCompressor, SLOT(start()));
     connect(&m_d->frameRenderStartCompressor, SIGNAL(timeout()), SLOT(updateCanvasProjection()));
+    connect(&m_d->offscreenUpdatesCompressor, SIGNAL(timeout()), SLOT(slotUpdateOffscreenCanvasProjection()));
 
     connect(this, SIGNAL(sigContinueResizeImage(qint32,qint32)), SLOT(finishResizingImage(qint32,qint32)));
 
@@ -604,12 +616,29 @@ void KisCanvas2::startUpdateInPatches(const QRect &imageRect)
         int patchWidth = imageConfig.updatePatchWidth();
         int patchHeight = imageConfig.updatePatchHeight();
 
+        QVector<QRect> patches;
+
         for (int y = 0; y < imageRect.height(); y += patchHeight) {
             for (int x = 0; x < imageRect.width(); x += patchWidth) {
-                QRect patchRect(x, y, patchWidth, patchHeight);
-                startUpdateCanvasProjection(patchRect);
+                patches << QRect(x, y, patchWidth, patchHeight);
             }
         }
+
+        /**
+         * Prepare the visible patches first, so that the user could see
+         * the result as soon as possible
+         */
+        const QRect viewportImageRect = visibleImageRect();
+        if (!viewportImageRect.isEmpty()) {
+            std::stable_partition(patches.begin(), patches.end(),
+                                  [viewportImageRect] (const QRect &rc) {
+                                      return rc.intersects(viewportImageRect);
+                                  });
+        }
+
+        Q_FOREACH (const QRect &patchRect, patches) {
+            startUpdateCanvasProjection(patchRect);
+        }
     }
 }
 
@@ -724,6 +753,13 @@ void KisCanvas2::startResizingImage()
     qint32 w = image->width();
     qint32 h = image->height();
 
+    /**
+     * The pending (and especially the postponed offscreen) updates were
+     * prepared for the old size of the image, the whole image is going
+     * to be updated anyway
+     */
+    m_d->projectionUpdatesCompressor.clear();
+
     emit sigContinueResizeImage(w, h);
 
     QRect imageBounds(0, 0, w, h);
@@ -743,13 +779,52 @@ void KisCanvas2::startUpdateCanvasProjection(const QRect & rc)
     }
 }
 
+QRect KisCanvas2::visibleImageRect() const
+{
+    if (!m_d->prioritizeVisibleUpdates || wrapAroundViewingMode()) {
+        return QRect();
+    }
+
+    return m_d->coordinatesConverter->widgetRectInImagePixels().toAlignedRect();
+}
+
 void KisCanvas2::updateCanvasProjection()
 {
+    /**
+     * If the queue of postponed updates grows too much, there is
+     * no idle time to upload them, so just upload everything
+     */
+    const int maxPostponedUpdates = 64;
+
     QVector<KisUpdateInfoSP> infoObjects;
-    while (KisUpdateInfoSP info = m_d->projectionUpdatesCompressor.takeUpdateInfo()) {
-        infoObjects << info;
+    const int numPostponedUpdates =
+        m_d->projectionUpdatesCompressor.takeUpdateInfos(infoObjects, visibleImageRect());
+
+    if (numPostponedUpdates > maxPostponedUpdates) {
+        /**
+         * The postponed updates never overlap the taken ones that are
+         * newer than them, so appending them to the end is safe
+         */
+        m_d->projectionUpdatesCompressor.takeUpdateInfos(infoObjects);
+        m_d->offscreenUpdatesCompressor.stop();
+    } else if (numPostponedUpdates > 0) {
+        m_d->offscreenUpdatesCompressor.start();
     }
 
+    uploadCanvasProjection(infoObjects);
+}
+
+void KisCanvas2::slotUpdateOffscreenCanvasProjection()
+{
+    QVector<KisUpdateInfoSP> infoObjects;
+    m_d->projectionUpdatesCompressor.takeUpdateInfos(infoObjects);
+    uploadCanvasProjection(infoObjects);
+}
+
+void KisCanvas2::uploadCanvasProjection(const QVector<KisUpdateInfoSP> &infoObjects)
+{
+    if (infoObjects.isEmpty()) return;
+
     QVector<QRect> viewportRects = m_d->canvasWidget->updateCanvasProjection(infoObjects);
 
     const QRect vRect = std::accumulate(viewportRects.constBegin(), viewportRects.constEnd(),
@@ -839,6 +914,11 @@ void KisCanvas2::notifyZoomChanged()
     notifyLevelOfDetailChange();
     updateCanvas(); // update the canvas, because that isn't done when zooming using KoZoomAction
 
+    if (m_d->projectionUpdatesCompressor.hasUpdates()) {
+        // some of the postponed updates might have become visible
+        m_d->frameRenderStartCompressor.start();
+    }
+
     m_d->regionOfInterestUpdateCompressor.start();
 }
 
@@ -949,6 +1029,11 @@ void KisCanvas2::documentOffsetMoved(const QPoint &documentOffset)
 
     updateCanvas();
 
+    if (m_d->projectionUpdatesCompressor.hasUpdates()) {
+        // some of the postponed updates might have become visible
+        m_d->frameRenderStartCompressor.start();
+    }
+
     m_d->regionOfInterestUpdateCompressor.start();
 }
 
@@ -956,6 +1041,7 @@ void KisCanvas2::slotConfigChanged()
 {
     KisConfig cfg(true);
     m_d->vastScrolling = cfg.vastScrolling();
+    m_d->prioritizeVisibleUpdates = cfg.prioritizeVisibleCanvasUpdates();
 
     resetCanvas(cfg.useOpenGL());
     slotSetDisplayProfile(cfg.displayProfile(QApplication::desktop()->screenNumber(this->canvasWidget())));
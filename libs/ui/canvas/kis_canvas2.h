@@ -278,6 +278,7 @@ private Q_SLOTS:
     /// of the canvas representation.
     void startUpdateCanvasProjection(const QRect & rc);
     void updateCanvasProjection();
+    void slotUpdateOffscreenCanvasProjection();
 
 
     /**
@@ -322,6 +323,13 @@ private:
     void createQPainterCanvas();
     void createOpenGLCanvas();
     void updateCanvasWidgetImpl(const QRect &rc = QRect());
+    void uploadCanvasProjection(const QVector<KisUpdateInfoSP> &infoObjects);
+
+    /**
+     * The part of the image visible in the viewport, used for prioritizing
+     * the canvas updates. Empty if prioritizing is not possible.
+     */
+    QRect visibleImageRect() const;
     void setCanvasWidget(KisAbstractCanvasWidget *widget);
     void resetCanvas(bool useOpenGL);
 
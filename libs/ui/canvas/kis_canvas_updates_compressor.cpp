@@ -18,6 +18,11 @@
 
 #include "kis_canvas_updates_compressor.h"
 
+KisCanvasUpdatesCompressor::KisCanvasUpdatesCompressor()
+    : m_processingRequested(false)
+{
+}
+
 bool KisCanvasUpdatesCompressor::putUpdateInfo(KisUpdateInfoSP info)
 {
     const int levelOfDetail = info->levelOfDetail();
@@ -44,11 +49,85 @@ bool KisCanvasUpdatesCompressor::putUpdateInfo(KisUpdateInfoSP info)
 
     m_updatesList.append(info);
 
-    return m_updatesList.size() <= 1;
+    const bool needsRequest = !m_processingRequested;
+    m_processingRequested = true;
+
+    return needsRequest;
+}
+
+int KisCanvasUpdatesCompressor::takeUpdateInfos(QVector<KisUpdateInfoSP> &result, const QRect &viewportImageRect)
+{
+    QMutexLocker l(&m_mutex);
+
+    m_processingRequested = false;
+
+    if (viewportImageRect.isEmpty()) {
+        Q_FOREACH (KisUpdateInfoSP info, m_updatesList) {
+            result << info;
+        }
+        m_updatesList.clear();
+        return 0;
+    }
+
+    /**
+     * Walk from the newest update to the oldest one. An invisible update
+     * may be postponed only when none of the updates we have already
+     * taken overlaps it, otherwise the newer data would be overwritten
+     * by the older one when the postponed update is finally uploaded.
+     * The updates with different levels of detail overwrite each other
+     * in the canvas textures, so they are never reordered as well.
+     *
+     * The viewport rect is defined in the coordinates of the full-size
+     * image, so the updates of the scaled planes are always taken. They
+     * are generated by the instant preview and should be shown as soon
+     * as possible anyway.
+     */
+    QVector<KisUpdateInfoSP> taken;
+    QRect takenRect;
+    QVector<int> takenLevelsOfDetail;
+
+    UpdateInfoList::iterator it = m_updatesList.end();
+    while (it != m_updatesList.begin()) {
+        --it;
+
+        const QRect rc = (*it)->dirtyImageRect();
+        const int levelOfDetail = (*it)->levelOfDetail();
+
+        const bool needsTaking =
+            levelOfDetail > 0 ||
+            rc.intersects(viewportImageRect) ||
+            rc.intersects(takenRect) ||
+            (!takenLevelsOfDetail.isEmpty() &&
+             (takenLevelsOfDetail.size() > 1 ||
+              takenLevelsOfDetail.first() != levelOfDetail));
+
+        if (needsTaking) {
+            taken << *it;
+            takenRect |= rc;
+
+            if (!takenLevelsOfDetail.contains(levelOfDetail)) {
+                takenLevelsOfDetail << levelOfDetail;
+            }
+
+            it = m_updatesList.erase(it);
+        }
+    }
+
+    for (auto infoIt = taken.crbegin(); infoIt != taken.crend(); ++infoIt) {
+        result << *infoIt;
+    }
+
+    return m_updatesList.size();
+}
+
+bool KisCanvasUpdatesCompressor::hasUpdates() const
+{
+    QMutexLocker l(&m_mutex);
+    return !m_updatesList.isEmpty();
 }
 
-KisUpdateInfoSP KisCanvasUpdatesCompressor::takeUpdateInfo()
+void KisCanvasUpdatesCompressor::clear()
 {
     QMutexLocker l(&m_mutex);
-    return !m_updatesList.isEmpty() ? m_updatesList.takeFirst() : 0;
+    m_updatesList.clear();
 }
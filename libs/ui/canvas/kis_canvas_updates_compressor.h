@@ -20,23 +20,58 @@
 #define __KIS_CANVAS_UPDATES_COMPRESSOR_H
 
 #include <QList>
+#include <QVector>
 #include <QMutex>
 #include <QMutexLocker>
 
+#include "kritaui_export.h"
 #include "kis_update_info.h"
 
 
-class KisCanvasUpdatesCompressor
+class KRITAUI_EXPORT KisCanvasUpdatesCompressor
 {
     typedef QList<KisUpdateInfoSP> UpdateInfoList;
 
 public:
+    KisCanvasUpdatesCompressor();
+
+    /**
+     * Adds \p info to the queue of pending updates.
+     *
+     * \return true if the caller should request processing of the
+     *         queue, that is, if no request has been issued since the
+     *         last call to takeUpdateInfos()
+     */
     bool putUpdateInfo(KisUpdateInfoSP info);
-    KisUpdateInfoSP takeUpdateInfo();
+
+    /**
+     * Takes the updates that should be uploaded to the canvas right now
+     * and appends them to \p result in the order they were put.
+     *
+     * If \p viewportImageRect is not empty, only the updates intersecting
+     * it are taken, the rest are kept in the queue to be processed
+     * later. Some invisible updates are taken as well to keep the
+     * upload order safe: an update cannot jump ahead of an older update
+     * that covers the same area or has a different level of detail.
+     *
+     * \return the number of updates left in the queue
+     */
+    int takeUpdateInfos(QVector<KisUpdateInfoSP> &result, const QRect &viewportImageRect = QRect());
+
+    bool hasUpdates() const;
+
+    /**
+     * Drops all the pending updates, including the postponed ones.
+     * Should be called when the size of the image changes: the updates
+     * were prepared for the old bounds of the image and must not be
+     * uploaded to the resized canvas.
+     */
+    void clear();
 
 private:
-    QMutex m_mutex;
+    mutable QMutex m_mutex;
     UpdateInfoList m_updatesList;
+    bool m_processingRequested;
 };
 
 #endif /* __KIS_CANVAS_UPDATES_COMPRESSOR_H */
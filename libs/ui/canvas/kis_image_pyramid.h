@@ -20,6 +20,8 @@
 #define __KIS_IMAGE_PYRAMID
 
 #include <QImage>
+#include <QMutex>
+#include <QRegion>
 #include <QVector>
 #include <QThreadStorage>
 
@@ -27,9 +29,10 @@
 #include <kis_image.h>
 #include <kis_paint_device.h>
 #include "kis_projection_backend.h"
+#include "kritaui_export.h"
 
 
-class KisImagePyramid : QObject, public KisProjectionBackend
+class KRITAUI_EXPORT KisImagePyramid : QObject, public KisProjectionBackend
 {
     Q_OBJECT
 
@@ -73,9 +76,33 @@ public:
 
     void alignSourceRect(QRect& rect, qreal scale) override;
 
+    /**
+     * Auxiliary function. Downsamples two lines in @srcRow0
+     * and @srcRow1 into one line @dstRow
+     * Note: @numSrcPixels must be EVEN
+     */
+    static void downsamplePixels(const quint8 *srcRow0, const quint8 *srcRow1,
+                                 quint8 *dstRow, qint32 numSrcPixels);
+
 private:
+    friend class KisImagePyramidTest;
 
     void retrieveImageData(const QRect &rect);
+
+    /**
+     * Regenerates the area of all the downscaled planes that
+     * depends on @dirtyRect of the original plane
+     */
+    void updateDownscaledPlanes(const QRect &dirtyRect);
+
+    /**
+     * Regenerates the downscaled planes in all the areas of the
+     * original plane that were changed by updateCache() since the
+     * last call. Must be called before reading any downscaled plane,
+     * because the update info of a change may be postponed or even
+     * dropped by the canvas.
+     */
+    void syncDownscaledPlanes();
     void rebuildPyramid();
     void clearPyramid();
 
@@ -87,14 +114,6 @@ private:
     QRect downsampleByFactor2(const QRect& srcRect,
                               KisPaintDevice* src, KisPaintDevice* dst);
 
-    /**
-     * Auxiliary function. Downsamples two lines in @srcRow0
-     * and @srcRow1 into one line @dstRow
-     * Note: @numSrcPixels must be EVEN
-     */
-    void downsamplePixels(const quint8 *srcRow0, const quint8 *srcRow1,
-                          quint8 *dstRow, qint32 numSrcPixels);
-
     /**
      * Searches for the last pyramid plane that can cover
      * canvans on current zoom level
@@ -116,6 +135,14 @@ private Q_SLOTS:
 private:
 
     QVector<KisPaintDeviceSP> m_pyramid;
+
+    /**
+     * The areas of the original plane that are not yet propagated
+     * into the downscaled planes. updateCache() is called from the
+     * image threads, so the region is protected by the lock.
+     */
+    QRegion m_dirtyDownscaledRegion;
+    QMutex m_dirtyDownscaledRegionLock;
     KisImageWSP  m_originalImage;
 
     const KoColorProfile* m_monitorProfile;
@@ -95,9 +95,10 @@ KisPrescaledProjection::KisPrescaledProjection()
 {
     updateSettings();
 
-    // we disable building the pyramid with setting its height to 1
-    // XXX: setting it higher than 1 is broken because it's not updated until you show/hide the layer
-    m_d->projectionBackend = new KisImagePyramid(1);
+    // the pyramid keeps three downscaled planes (down to 1/8), so
+    // zoomed out views are painted from a prescaled plane instead of
+    // scaling the full resolution projection with QPainter
+    m_d->projectionBackend = new KisImagePyramid(4);
 
     connect(KisConfigNotifier::instance(), SIGNAL(configChanged()), SLOT(updateSettings()));
 }
@@ -20,6 +20,7 @@
 #define KIS_PROJECTION_BACKEND
 
 #include "kis_update_info.h"
+#include "kritaui_export.h"
 
 class KoColorProfile;
 class KisImagePatch;
@@ -33,7 +34,7 @@ class KisDisplayFilter;
  * More than that this object can perform some scaling operations
  * that are based on "patches" paradigm
  */
-class KisProjectionBackend
+class KRITAUI_EXPORT KisProjectionBackend
 {
 public:
     virtual ~KisProjectionBackend();
@@ -87,7 +87,7 @@ private:
 };
 
 
-class KisPPUpdateInfo : public KisUpdateInfo
+class KRITAUI_EXPORT KisPPUpdateInfo : public KisUpdateInfo
 {
 public:
     enum TransferType {
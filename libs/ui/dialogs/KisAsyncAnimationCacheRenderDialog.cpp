@@ -87,7 +87,9 @@ int KisAsyncAnimationCacheRenderDialog::calcFirstDirtyFrame(KisAnimationFrameCac
                 }
             }
 
-            if (cache->frameStatus(frame) != KisAnimationFrameCache::Cached) {
+            if (cache->frameStatus(frame) != KisAnimationFrameCache::Cached &&
+                cache->frameFitsIntoBudget(frame)) {
+
                 result = frame;
                 break;
             }
@@ -97,6 +99,70 @@ int KisAsyncAnimationCacheRenderDialog::calcFirstDirtyFrame(KisAnimationFrameCac
     return result;
 }
 
+QList<int> KisAsyncAnimationCacheRenderDialog::calcFirstDirtyFrames(KisAnimationFrameCacheSP cache,
+                                                                     const KisTimeRange &playbackRange,
+                                                                     const KisTimeRange &skipRange,
+                                                                     const QList<int> &framesInProgress,
+                                                                     int maxFrames)
+{
+    QList<int> result;
+
+    KisImageSP image = cache->image();
+    if (!image) return result;
+
+    KisImageAnimationInterface *animation = image->animationInterface();
+    if (!animation->hasAnimation()) return result;
+
+    if (playbackRange.isValid()) {
+        KIS_ASSERT_RECOVER_RETURN_VALUE(!playbackRange.isInfinite(), result);
+
+        for (int frame = playbackRange.start();
+             frame <= playbackRange.end() && result.size() < maxFrames;
+             frame++) {
+
+            if (skipRange.contains(frame)) {
+                if (skipRange.isInfinite()) {
+                    break;
+                } else {
+                    frame = skipRange.end();
+                    continue;
+                }
+            }
+
+            if (cache->frameStatus(frame) == KisAnimationFrameCache::Cached ||
+                !cache->frameFitsIntoBudget(frame)) {
+
+                continue;
+            }
+
+            const KisTimeRange stillFrameRange =
+                KisTimeRange::calculateIdenticalFramesRecursive(image->root(), frame);
+
+            KIS_SAFE_ASSERT_RECOVER_RETURN_VALUE(stillFrameRange.isValid(), result);
+
+            bool isInProgress = false;
+            Q_FOREACH (int busyFrame, framesInProgress) {
+                if (stillFrameRange.contains(busyFrame)) {
+                    isInProgress = true;
+                    break;
+                }
+            }
+
+            if (!isInProgress) {
+                result.append(frame);
+            }
+
+            if (stillFrameRange.isInfinite()) {
+                break;
+            } else {
+                frame = stillFrameRange.end();
+            }
+        }
+    }
+
+    return result;
+}
+
 
 struct KisAsyncAnimationCacheRenderDialog::Private
 {
@@ -31,6 +31,17 @@ public:
 
     static int calcFirstDirtyFrame(KisAnimationFrameCacheSP cache, const KisTimeRange &playbackRange, const KisTimeRange &skipRange);
 
+    /**
+     * Returns up to \p maxFrames dirty frames, not more than one per a range of
+     * identical frames. The ranges containing any of \p framesInProgress are
+     * skipped, so the returned frames can be regenerated in parallel with them.
+     */
+    static QList<int> calcFirstDirtyFrames(KisAnimationFrameCacheSP cache,
+                                           const KisTimeRange &playbackRange,
+                                           const KisTimeRange &skipRange,
+                                           const QList<int> &framesInProgress,
+                                           int maxFrames);
+
 protected:
     QList<int> calcDirtyFrames() const override;
     KisAsyncAnimationRendererBase* createRenderer(KisImageSP image) override;
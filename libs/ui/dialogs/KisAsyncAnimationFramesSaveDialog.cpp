@@ -61,6 +61,13 @@ struct KisAsyncAnimationFramesSaveDialog::Private {
 
     int sequenceNumberingOffset;
     KisPropertiesConfigurationSP exportConfiguration;
+
+    /**
+     * The frames that have exactly the same content as some other frame
+     * of the range are not rendered. Their files are copied from the file
+     * of the first frame with the same content instead.
+     */
+    QHash<int, QVector<int>> frameCopies;
 };
 
 KisAsyncAnimationFramesSaveDialog::KisAsyncAnimationFramesSaveDialog(KisImageSP originalImage,
@@ -141,16 +148,37 @@ KisAsyncAnimationRenderDialogBase::Result KisAsyncAnimationFramesSaveDialog::reg
     return KisAsyncAnimationRenderDialogBase::regenerateRange(viewManager);
 }
 
-QList<int> KisAsyncAnimationFramesSaveDialog::calcDirtyFrames() const
+QList<int> KisAsyncAnimationFramesSaveDialog::calcUniqueFrames(KisImageSP image,
+                                                               const KisTimeRange &range,
+                                                               QHash<int, QVector<int>> *frameCopies)
 {
-    // TODO: optimize!
     QList<int> result;
-    for (int i = m_d->range.start(); i <= m_d->range.end(); i++) {
-        result.append(i);
+    QHash<QVector<quint64>, int> renderedFrames;
+
+    frameCopies->clear();
+
+    for (int i = range.start(); i <= range.end(); i++) {
+        const QVector<quint64> key =
+            KisTimeRange::calculateFrameContentKeyRecursive(image->root(), i);
+
+        auto it = renderedFrames.constFind(key);
+
+        if (it != renderedFrames.constEnd()) {
+            (*frameCopies)[*it].append(i);
+        } else {
+            renderedFrames.insert(key, i);
+            result.append(i);
+        }
     }
+
     return result;
 }
 
+QList<int> KisAsyncAnimationFramesSaveDialog::calcDirtyFrames() const
+{
+    return calcUniqueFrames(m_d->originalImage, m_d->range, &m_d->frameCopies);
+}
+
 KisAsyncAnimationRendererBase *KisAsyncAnimationFramesSaveDialog::createRenderer(KisImageSP image)
 {
     return new KisAsyncAnimationFramesSavingRenderer(image,
@@ -158,6 +186,7 @@ KisAsyncAnimationRendererBase *KisAsyncAnimationFramesSaveDialog::createRenderer
                                                      m_d->filenameSuffix,
                                                      m_d->outputMimeType,
                                                      m_d->range,
+                                                     m_d->frameCopies,
                                                      m_d->sequenceNumberingOffset,
                                                      m_d->exportConfiguration);
 }
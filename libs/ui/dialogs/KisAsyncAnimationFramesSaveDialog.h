@@ -22,6 +22,9 @@
 #include "KisAsyncAnimationRenderDialogBase.h"
 #include "kis_types.h"
 
+#include <QHash>
+#include <QVector>
+
 
 class KRITAUI_EXPORT KisAsyncAnimationFramesSaveDialog : public KisAsyncAnimationRenderDialogBase
 {
@@ -39,6 +42,15 @@ public:
     QString savedFilesMask() const;
     QString savedFilesMaskWildcard() const;
 
+    /**
+     * Returns the frames of \p range that have unique content. For every
+     * such frame, \p frameCopies lists the frames with the same content,
+     * which need not be rendered.
+     */
+    static QList<int> calcUniqueFrames(KisImageSP image,
+                                       const KisTimeRange &range,
+                                       QHash<int, QVector<int>> *frameCopies);
+
 protected:
     QList<int> calcDirtyFrames() const override;
     KisAsyncAnimationRendererBase* createRenderer(KisImageSP image) override;
@@ -0,0 +1,74 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "KisAsyncAnimationFramesStreamDialog.h"
+
+#include <klocalizedstring.h>
+
+#include <kis_image.h>
+#include <kis_time_range.h>
+
+#include "KisAsyncAnimationFramesSaveDialog.h"
+#include <KisAsyncAnimationFramesStreamingRenderer.h>
+
+
+struct KisAsyncAnimationFramesStreamDialog::Private
+{
+    Private(KisImageSP _image, const KisTimeRange &_range, KisAnimationFramesStream *_stream)
+        : originalImage(_image),
+          range(_range),
+          stream(_stream)
+    {
+    }
+
+    KisImageSP originalImage;
+    KisTimeRange range;
+    KisAnimationFramesStream *stream;
+
+    QHash<int, QVector<int>> frameCopies;
+};
+
+KisAsyncAnimationFramesStreamDialog::KisAsyncAnimationFramesStreamDialog(KisImageSP image,
+                                                                         const KisTimeRange &range,
+                                                                         KisAnimationFramesStream *stream)
+    : KisAsyncAnimationRenderDialogBase(i18n("Rendering frames..."), image, 0),
+      m_d(new Private(image, range, stream))
+{
+}
+
+KisAsyncAnimationFramesStreamDialog::~KisAsyncAnimationFramesStreamDialog()
+{
+}
+
+QList<int> KisAsyncAnimationFramesStreamDialog::calcDirtyFrames() const
+{
+    return KisAsyncAnimationFramesSaveDialog::calcUniqueFrames(m_d->originalImage, m_d->range, &m_d->frameCopies);
+}
+
+KisAsyncAnimationRendererBase *KisAsyncAnimationFramesStreamDialog::createRenderer(KisImageSP image)
+{
+    Q_UNUSED(image);
+    return new KisAsyncAnimationFramesStreamingRenderer(m_d->stream, m_d->frameCopies);
+}
+
+void KisAsyncAnimationFramesStreamDialog::initializeRendererForFrame(KisAsyncAnimationRendererBase *renderer, KisImageSP image, int frame)
+{
+    Q_UNUSED(renderer);
+    Q_UNUSED(image);
+    Q_UNUSED(frame);
+}
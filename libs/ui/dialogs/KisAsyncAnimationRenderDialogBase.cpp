@@ -57,18 +57,6 @@ struct RendererPair {
     }
 };
 
-int calculateNumberMemoryAllowedClones(KisImageSP image)
-{
-    KisMemoryStatisticsServer::Statistics stats =
-        KisMemoryStatisticsServer::instance()
-        ->fetchMemoryStatistics(image);
-
-    const qint64 allowedMemory = 0.8 * stats.tilesHardLimit - stats.realMemorySize;
-    const qint64 cloneSize = stats.projectionsSize;
-
-    return cloneSize > 0 ? allowedMemory / cloneSize : 0;
-}
-
 }
 
 
@@ -342,3 +330,15 @@ bool KisAsyncAnimationRenderDialogBase::batchMode() const
 {
     return m_d->isBatchMode;
 }
+
+int KisAsyncAnimationRenderDialogBase::calculateNumberMemoryAllowedClones(KisImageSP image)
+{
+    KisMemoryStatisticsServer::Statistics stats =
+        KisMemoryStatisticsServer::instance()
+        ->fetchMemoryStatistics(image);
+
+    const qint64 allowedMemory = 0.8 * stats.tilesHardLimit - stats.realMemorySize;
+    const qint64 cloneSize = stats.projectionsSize;
+
+    return cloneSize > 0 ? allowedMemory / cloneSize : 0;
+}
@@ -111,6 +111,12 @@ public:
      */
     bool batchMode() const;
 
+    /**
+     * \return the number of clones of \p image that can be created
+     * without exceeding the memory limit
+     */
+    static int calculateNumberMemoryAllowedClones(KisImageSP image);
+
 private Q_SLOTS:
     void slotFrameCompleted(int frame);
     void slotFrameCancelled(int frame);
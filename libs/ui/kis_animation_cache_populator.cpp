@@ -40,9 +40,15 @@
 #include "kis_node_manager.h"
 #include "kis_keyframe_channel.h"
 
+#include "kis_image_config.h"
+
 #include "KisAsyncAnimationCacheRenderer.h"
 #include "dialogs/KisAsyncAnimationCacheRenderDialog.h"
 
+#include <vector>
+#include <memory>
+#include <QtMath>
+
 
 struct KisAnimationCachePopulator::Private
 {
@@ -68,6 +74,30 @@ struct KisAnimationCachePopulator::Private
 
     KisAsyncAnimationCacheRenderer regenerator;
     bool calculateAnimationCacheInBackground = true;
+    bool calculateAnimationCacheInParallel = true;
+
+    /**
+     * Clones of the image that regenerate other frames in parallel with
+     * the main regenerator, which uses the original image. The clones are
+     * created lazily, right before the main regenerator starts its stroke,
+     * because only an idle image can be cloned. They are dropped as soon
+     * as the original image changes, so they never feed stale frames into
+     * the cache. Their number is limited by the user's settings and by the
+     * available memory.
+     */
+    struct CloneWorker {
+        CloneWorker(KisImageSP _image) : image(_image) {}
+
+        KisImageSP image;
+        KisAsyncAnimationCacheRenderer renderer;
+        int frame = -1;
+    };
+
+    std::vector<std::unique_ptr<CloneWorker>> cloneWorkers;
+    KisAnimationFrameCacheSP cloneWorkersCache;
+    KisSignalAutoConnectionsStore cloneWorkersConnections;
+    KisTimeRange cloneWorkersRange;
+    KisTimeRange cloneWorkersSkipRange;
 
 
 
@@ -111,6 +141,10 @@ struct KisAnimationCachePopulator::Private
 
             if (idleCounter >= IDLE_COUNT_THRESHOLD) {
                 if (!tryRequestGeneration()) {
+                    if (cloneFramesInProgress().isEmpty()) {
+                        // all the frames are ready, the clones are not needed anymore
+                        dropCloneWorkers();
+                    }
                     enterState(NotWaitingForAnything);
                 }
                 return;
@@ -179,15 +213,153 @@ struct KisAnimationCachePopulator::Private
         KisImageAnimationInterface *animation = image->animationInterface();
         KisTimeRange currentRange = animation->fullClipRange();
 
-        const int frame = KisAsyncAnimationCacheRenderDialog::calcFirstDirtyFrame(cache, currentRange, skipRange);
+        int frame = -1;
+
+        if (cache == cloneWorkersCache) {
+            // don't pick the frames the clones are busy with
+            const QList<int> frames =
+                KisAsyncAnimationCacheRenderDialog::calcFirstDirtyFrames(cache, currentRange, skipRange,
+                                                                         cloneFramesInProgress(), 1);
+            frame = !frames.isEmpty() ? frames.first() : -1;
+        } else {
+            frame = KisAsyncAnimationCacheRenderDialog::calcFirstDirtyFrame(cache, currentRange, skipRange);
+        }
 
         if (frame >= 0) {
-            return regenerate(cache, frame);
+            if (calculateAnimationCacheInParallel &&
+                state != WaitingForFrame &&
+                cache != cloneWorkersCache) {
+
+                createCloneWorkers(cache);
+            }
+
+            const bool requested = regenerate(cache, frame);
+
+            if (requested && cache == cloneWorkersCache) {
+                cloneWorkersRange = currentRange;
+                cloneWorkersSkipRange = skipRange;
+                regenerateOnClones(cache);
+            }
+
+            return requested;
         }
 
         return false;
     }
 
+    void createCloneWorkers(KisAnimationFrameCacheSP cache)
+    {
+        KisImageSP image = cache->image();
+        if (!image) return;
+
+        KisImageConfig cfg(true);
+        if (cfg.frameRenderingClones() <= 1) return;
+
+        // the image should be idle while cloning, if it is not,
+        // we will try again before the next frame
+        if (!image->tryBarrierLock(true)) return;
+
+        dropCloneWorkers();
+
+        const int numClones =
+            qMin(cfg.frameRenderingClones() - 1,
+                 KisAsyncAnimationRenderDialogBase::calculateNumberMemoryAllowedClones(image));
+
+        const int numThreadsPerWorker = qMax(1, qCeil(qreal(cfg.maxNumberOfThreads()) / (numClones + 1)));
+
+        for (int i = 0; i < numClones; i++) {
+            KisImageSP clone = image->clone(true);
+            clone->setWorkingThreadsLimit(numThreadsPerWorker);
+
+            std::unique_ptr<CloneWorker> worker(new CloneWorker(clone));
+
+            cloneWorkersConnections.addConnection(&worker->renderer, SIGNAL(sigFrameCompleted(int)),
+                                                  q, SLOT(slotCloneWorkerFrameReady()));
+
+            cloneWorkers.push_back(std::move(worker));
+        }
+
+        image->unlock();
+
+        /**
+         * The cache is remembered even when no clones fit into memory,
+         * so that the memory is not rechecked for every frame. The check
+         * is repeated after the image changes.
+         */
+        cloneWorkersCache = cache;
+
+        // any change of the image makes the clones outdated
+        cloneWorkersConnections.addConnection(image->animationInterface(), SIGNAL(sigFramesChanged(KisTimeRange,QRect)),
+                                              q, SLOT(slotDropCloneWorkers()));
+    }
+
+    void dropCloneWorkers()
+    {
+        cloneWorkersConnections.clear();
+
+        for (auto &worker : cloneWorkers) {
+            if (worker->renderer.isActive()) {
+                worker->renderer.cancelCurrentFrameRendering();
+                worker->image->requestStrokeCancellation();
+            }
+
+            // wait until the frame stroke is gone
+            worker->image->barrierLock(true);
+            worker->image->unlock();
+        }
+
+        cloneWorkers.clear();
+        cloneWorkersCache.clear();
+    }
+
+    QList<int> cloneFramesInProgress() const
+    {
+        QList<int> frames;
+
+        for (auto &worker : cloneWorkers) {
+            if (worker->renderer.isActive()) {
+                frames << worker->frame;
+            }
+        }
+
+        return frames;
+    }
+
+    void regenerateOnClones(KisAnimationFrameCacheSP cache)
+    {
+        if (cache != cloneWorkersCache) return;
+
+        QList<int> framesInProgress = cloneFramesInProgress();
+        std::vector<CloneWorker*> idleWorkers;
+
+        if (regenerator.isActive()) {
+            framesInProgress << requestedFrame;
+        }
+
+        for (auto &worker : cloneWorkers) {
+            if (!worker->renderer.isActive()) {
+                idleWorkers.push_back(worker.get());
+            }
+        }
+
+        if (idleWorkers.empty()) return;
+
+        const QList<int> frames =
+            KisAsyncAnimationCacheRenderDialog::calcFirstDirtyFrames(cache,
+                                                                     cloneWorkersRange,
+                                                                     cloneWorkersSkipRange,
+                                                                     framesInProgress,
+                                                                     idleWorkers.size());
+
+        for (int i = 0; i < frames.size(); i++) {
+            CloneWorker *worker = idleWorkers[i];
+
+            worker->frame = frames[i];
+            worker->renderer.setFrameCache(cache);
+            worker->renderer.startFrameRegeneration(worker->image, frames[i]);
+        }
+    }
+
     bool regenerate(KisAnimationFrameCacheSP cache, int frame)
     {
         if (state == WaitingForFrame) {
@@ -202,6 +374,7 @@ struct KisAnimationCachePopulator::Private
          */
         enterState(WaitingForFrame);
 
+        requestedFrame = frame;
         regenerator.setFrameCache(cache);
 
         // if we ever decide to add ROI to background cache
@@ -278,7 +451,9 @@ KisAnimationCachePopulator::KisAnimationCachePopulator(KisPart *part)
 }
 
 KisAnimationCachePopulator::~KisAnimationCachePopulator()
-{}
+{
+    m_d->dropCloneWorkers();
+}
 
 bool KisAnimationCachePopulator::regenerate(KisAnimationFrameCacheSP cache, int frame)
 {
@@ -309,9 +484,33 @@ void KisAnimationCachePopulator::slotRegeneratorFrameReady()
     m_d->enterState(Private::BetweenFrames);
 }
 
+void KisAnimationCachePopulator::slotCloneWorkerFrameReady()
+{
+    KisAnimationFrameCacheSP cache = m_d->cloneWorkersCache;
+
+    if (cache && m_d->part->idleWatcher()->isIdle()) {
+        m_d->regenerateOnClones(cache);
+    }
+
+    if (m_d->state == Private::NotWaitingForAnything) {
+        // let the main loop check if there is anything left to do
+        m_d->enterState(Private::WaitingForIdle);
+    }
+}
+
+void KisAnimationCachePopulator::slotDropCloneWorkers()
+{
+    m_d->dropCloneWorkers();
+}
+
 void KisAnimationCachePopulator::slotConfigChanged()
 {
     KisConfig cfg(true);
     m_d->calculateAnimationCacheInBackground = cfg.calculateAnimationCacheInBackground();
+    m_d->calculateAnimationCacheInParallel = cfg.calculateAnimationCacheInParallel();
+
+    if (!m_d->calculateAnimationCacheInParallel) {
+        m_d->dropCloneWorkers();
+    }
     QTimer::singleShot(1000, this, SLOT(slotRequestRegeneration()));
 }
@@ -48,6 +48,9 @@ private Q_SLOTS:
     void slotRegeneratorFrameCancelled();
     void slotRegeneratorFrameReady();
 
+    void slotCloneWorkerFrameReady();
+    void slotDropCloneWorkers();
+
     void slotConfigChanged();
 
 private:
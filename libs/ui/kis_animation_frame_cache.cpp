@@ -19,6 +19,11 @@
 #include "kis_animation_frame_cache.h"
 
 #include <QMap>
+#include <QHash>
+#include <QMutex>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <limits>
 
 #include "kis_debug.h"
 
@@ -47,10 +52,18 @@ struct KisAnimationFrameCache::Private
         : textures(_textures)
     {
         image = textures->image();
+
+        /**
+         * The frame store decodes the diff-frames using the last loaded
+         * keyframe, so the frames are prefetched one-by-one in the
+         * playback order.
+         */
+        prefetchPool.setMaxThreadCount(1);
     }
 
     ~Private()
     {
+        prefetchPool.waitForDone();
     }
 
     KisOpenGLImageTexturesSP textures;
@@ -59,6 +72,37 @@ struct KisAnimationFrameCache::Private
     QScopedPointer<KisAbstractFrameCacheSwapper> swapper;
     int frameSizeLimit = 777;
 
+    /**
+     * The limit for the size of the data stored in the swapper. When the
+     * limit is exceeded, the frames most distant from the playhead and
+     * least recently used are evicted from the cache.
+     */
+    qint64 cacheSizeLimit = 0;
+
+    struct FrameStats {
+        quint64 lastAccess = 0;
+    };
+
+    QHash<int, FrameStats> frameStats;
+    quint64 accessCounter = 0;
+
+    /**
+     * The minimal eviction score among the frames evicted because of
+     * the size limit. The frames more distant from the playhead are
+     * not worth regenerating in background. -1 means no frames have
+     * been evicted since the last change of the cache.
+     */
+    int evictionHorizon = -1;
+
+    /**
+     * The frames being loaded from the swapper in background ahead of
+     * the playhead. All the accesses to the swapper that may happen
+     * concurrently with the prefetching are serialized by swapperLock.
+     */
+    QMutex swapperLock;
+    QHash<int, QFuture<KisOpenGLUpdateInfoSP>> prefetchedFrames;
+    QThreadPool prefetchPool;
+
     KisOpenGLUpdateInfoSP fetchFrameDataImpl(KisImageSP image, const QRect &requestedRect, int lod);
 
     struct Frame
@@ -108,7 +152,29 @@ struct KisAnimationFrameCache::Private
     KisOpenGLUpdateInfoSP getFrame(int time)
     {
         const int frameId = getFrameIdAtTime(time);
-        return frameId >= 0 ? swapper->loadFrame(frameId) : 0;
+        if (frameId < 0) return 0;
+
+        touchFrame(frameId);
+
+        auto it = prefetchedFrames.find(frameId);
+        if (it != prefetchedFrames.end()) {
+            KisOpenGLUpdateInfoSP info = it->result();
+            prefetchedFrames.erase(it);
+
+            if (info) return info;
+        }
+
+        return loadFrame(frameId);
+    }
+
+    KisOpenGLUpdateInfoSP loadFrame(int frameId)
+    {
+        QMutexLocker l(&swapperLock);
+
+        // the frame might have been dropped while the job was in the queue
+        if (!swapper->hasFrame(frameId)) return 0;
+
+        return swapper->loadFrame(frameId);
     }
 
     void addFrame(KisOpenGLUpdateInfoSP info, const KisTimeRange& range)
@@ -117,7 +183,127 @@ struct KisAnimationFrameCache::Private
 
         const int length = range.isInfinite() ? -1 : range.end() - range.start() + 1;
         newFrames.insert(range.start(), length);
-        swapper->saveFrame(range.start(), info, image->bounds());
+
+        {
+            QMutexLocker l(&swapperLock);
+            swapper->saveFrame(range.start(), info, image->bounds());
+        }
+
+        frameStats[range.start()] = FrameStats();
+        touchFrame(range.start());
+
+        evictFramesIfNeeded();
+    }
+
+    void touchFrame(int frameId)
+    {
+        auto it = frameStats.find(frameId);
+        if (it != frameStats.end()) {
+            it->lastAccess = ++accessCounter;
+        }
+    }
+
+    void moveFrame(int srcFrameId, int dstFrameId)
+    {
+        prefetchedFrames.remove(srcFrameId);
+
+        {
+            QMutexLocker l(&swapperLock);
+            swapper->moveFrame(srcFrameId, dstFrameId);
+        }
+
+        frameStats.insert(dstFrameId, frameStats.take(srcFrameId));
+    }
+
+    void forgetFrame(int frameId)
+    {
+        prefetchedFrames.remove(frameId);
+
+        {
+            QMutexLocker l(&swapperLock);
+            swapper->forgetFrame(frameId);
+        }
+
+        frameStats.remove(frameId);
+    }
+
+    qint64 cacheSize()
+    {
+        QMutexLocker l(&swapperLock);
+        return swapper->totalDataSize();
+    }
+
+    void resetFrames()
+    {
+        newFrames.clear();
+        frameStats.clear();
+        prefetchedFrames.clear();
+        evictionHorizon = -1;
+    }
+
+    /**
+     * The distance (in frames) from the playhead to the moment when the
+     * frame is going to be shown. The frames behind the playhead will be
+     * shown only after the playback wraps around the clip range.
+     */
+    int playheadDistance(int start, int length) const
+    {
+        KisImageSP image = this->image;
+        if (!image) return 0;
+
+        KisImageAnimationInterface *animation = image->animationInterface();
+        const int playhead = animation->currentUITime();
+
+        if (start > playhead) return start - playhead;
+        if (length < 0 || playhead <= start + length - 1) return 0;
+
+        const KisTimeRange range = animation->fullClipRange();
+        if (!range.isValid() || range.isInfinite()) {
+            return playhead - (start + length - 1);
+        }
+
+        const int wrapDistance = qMax(0, range.end() - playhead) + 1;
+
+        return start >= range.start() ?
+            wrapDistance + start - range.start() :
+            wrapDistance + range.duration() + range.start() - start;
+    }
+
+    int evictionScore(int frameId) const
+    {
+        const int distance = playheadDistance(frameId, newFrames.value(frameId, 1));
+        const quint64 age = accessCounter - frameStats.value(frameId).lastAccess;
+
+        return distance + int(qMin(age, quint64(std::numeric_limits<int>::max() / 2)));
+    }
+
+    void evictFramesIfNeeded()
+    {
+        if (!cacheSizeLimit) return;
+
+        /**
+         * The size is measured in the swapper itself, because evicting
+         * a keyframe frees nothing while its difference frames are still
+         * in the cache. Its data is released together with the last of
+         * them.
+         */
+        while (cacheSize() > cacheSizeLimit && !newFrames.isEmpty()) {
+            int victim = -1;
+            int victimScore = -1;
+
+            for (auto it = newFrames.constBegin(); it != newFrames.constEnd(); ++it) {
+                const int score = evictionScore(it.key());
+                if (score > victimScore) {
+                    victim = it.key();
+                    victimScore = score;
+                }
+            }
+
+            forgetFrame(victim);
+            newFrames.remove(victim);
+
+            evictionHorizon = evictionHorizon < 0 ? victimScore : qMin(evictionHorizon, victimScore);
+        }
     }
 
     /**
@@ -151,9 +337,9 @@ struct KisAnimationFrameCache::Private
                     int newLength = frameIsInfinite ? -1 : (end - newStart + 1);
 
                     newFrames.insert(newStart, newLength);
-                    swapper->moveFrame(start, newStart);
+                    moveFrame(start, newStart);
                 } else {
-                    swapper->forgetFrame(start);
+                    forgetFrame(start);
                 }
 
                 it = newFrames.erase(it);
@@ -171,6 +357,11 @@ struct KisAnimationFrameCache::Private
             it++;
         }
 
+        if (cacheChanged) {
+            // the cache has changed, so we may have some space now
+            evictionHorizon = -1;
+        }
+
         return cacheChanged;
     }
 
@@ -227,9 +418,14 @@ KisAnimationFrameCache::~KisAnimationFrameCache()
     Private::caches.remove(m_d->textures);
 }
 
+KisOpenGLUpdateInfoSP KisAnimationFrameCache::frameData(int time)
+{
+    return m_d->getFrame(time);
+}
+
 bool KisAnimationFrameCache::uploadFrame(int time)
 {
-    KisOpenGLUpdateInfoSP info = m_d->getFrame(time);
+    KisOpenGLUpdateInfoSP info = frameData(time);
 
     if (!info) {
         // Do nothing!
@@ -243,6 +439,43 @@ bool KisAnimationFrameCache::uploadFrame(int time)
     return bool(info);
 }
 
+void KisAnimationFrameCache::prefetchFrames(const QVector<int> &times)
+{
+    QVector<int> frameIds;
+
+    Q_FOREACH (int time, times) {
+        const int frameId = m_d->getFrameIdAtTime(time);
+        if (frameId >= 0 && !frameIds.contains(frameId)) {
+            frameIds.append(frameId);
+        }
+    }
+
+    for (auto it = m_d->prefetchedFrames.begin(); it != m_d->prefetchedFrames.end();) {
+        if (!frameIds.contains(it.key())) {
+            it = m_d->prefetchedFrames.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    Private *d = m_d.data();
+
+    Q_FOREACH (int frameId, frameIds) {
+        if (m_d->prefetchedFrames.contains(frameId)) continue;
+
+        m_d->prefetchedFrames.insert(frameId,
+            QtConcurrent::run(&m_d->prefetchPool, [d, frameId] () {
+                return d->loadFrame(frameId);
+            }));
+    }
+}
+
+bool KisAnimationFrameCache::frameIsPrefetched(int time) const
+{
+    const int frameId = m_d->getFrameIdAtTime(time);
+    return frameId >= 0 && m_d->prefetchedFrames.contains(frameId);
+}
+
 bool KisAnimationFrameCache::shouldUploadNewFrame(int newTime, int oldTime) const
 {
     if (oldTime < 0) return true;
@@ -259,6 +492,17 @@ KisAnimationFrameCache::CacheStatus KisAnimationFrameCache::frameStatus(int time
     return m_d->hasFrame(time) ? Cached : Uncached;
 }
 
+bool KisAnimationFrameCache::frameFitsIntoBudget(int time) const
+{
+    if (m_d->evictionHorizon < 0) return true;
+
+    const KisTimeRange range =
+        KisTimeRange::calculateIdenticalFramesRecursive(m_d->image->root(), time);
+
+    const int length = range.isInfinite() ? -1 : range.duration();
+    return m_d->playheadDistance(range.start(), length) < m_d->evictionHorizon;
+}
+
 KisImageWSP KisAnimationFrameCache::image()
 {
     return m_d->image;
@@ -279,17 +523,26 @@ void KisAnimationFrameCache::framesChanged(const KisTimeRange &range, const QRec
 
 void KisAnimationFrameCache::slotConfigChanged()
 {
-    m_d->newFrames.clear();
+    m_d->resetFrames();
 
     KisImageConfig cfg(true);
 
-    if (cfg.useOnDiskAnimationCacheSwapping()) {
-        m_d->swapper.reset(new KisFrameCacheSwapper(m_d->textures->updateInfoBuilder(), cfg.swapDir()));
-    } else {
-        m_d->swapper.reset(new KisInMemoryFrameCacheSwapper());
+    {
+        QMutexLocker l(&m_d->swapperLock);
+
+        if (cfg.useOnDiskAnimationCacheSwapping()) {
+            m_d->swapper.reset(new KisFrameCacheSwapper(m_d->textures->updateInfoBuilder(), cfg.swapDir()));
+        } else if (cfg.useCompressedAnimationCache()) {
+            m_d->swapper.reset(new KisFrameCacheSwapper(m_d->textures->updateInfoBuilder(),
+                                                        KisFrameDataSerializer::InMemoryStorage,
+                                                        QString()));
+        } else {
+            m_d->swapper.reset(new KisInMemoryFrameCacheSwapper());
+        }
     }
 
     m_d->frameSizeLimit = cfg.useAnimationCacheFrameSizeLimit() ? cfg.animationCacheFrameSizeLimit() : 0;
+    m_d->cacheSizeLimit = qint64(qMax(0, cfg.animationCacheSizeLimit())) * 1024 * 1024;
     emit changed();
 }
 
@@ -368,7 +621,7 @@ void KisAnimationFrameCache::dropLowQualityFrames(const KisTimeRange &range, con
         const int frameLod = m_d->swapper->frameLevelOfDetail(frameId);
 
         if (frameLod > m_d->effectiveLevelOfDetail(regionOfInterest) || !frameRect.contains(minimalRect)) {
-            m_d->swapper->forgetFrame(frameId);
+            m_d->forgetFrame(frameId);
             it = m_d->newFrames.erase(it);
         } else {
             ++it;
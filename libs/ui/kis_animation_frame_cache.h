@@ -21,6 +21,7 @@
 
 #include <QImage>
 #include <QObject>
+#include <QVector>
 
 #include "kritaui_export.h"
 #include "kis_types.h"
@@ -53,6 +54,20 @@ public:
 
     bool shouldUploadNewFrame(int newTime, int oldTime) const;
 
+    /**
+     * Starts loading the data of the frames at \p times from the swapper in
+     * a background thread, so that uploadFrame() would not need to decode
+     * it in the GUI thread. The frames that are not cached are skipped. The
+     * frames prefetched earlier, but not present in \p times, are discarded.
+     */
+    void prefetchFrames(const QVector<int> &times);
+
+    /**
+     * \return true if the data of the frame at \p time has been prefetched
+     * or is being prefetched right now
+     */
+    bool frameIsPrefetched(int time) const;
+
     enum CacheStatus {
         Cached,
         Uncached,
@@ -60,6 +75,13 @@ public:
 
     CacheStatus frameStatus(int time) const;
 
+    /**
+     * \return false if the frame is so far from the playhead that it would
+     * be evicted from the cache because of the cache size limit right after
+     * being generated. Such frames are not worth regenerating in background.
+     */
+    bool frameFitsIntoBudget(int time) const;
+
     KisImageWSP image();
 
     KisOpenGLUpdateInfoSP fetchFrameData(int time, KisImageSP image, const QRegion &requestedRegion) const;
@@ -77,6 +99,13 @@ Q_SIGNALS:
     void changed();
 
 private:
+    friend class KisAnimationFramePrefetchTest;
+
+    /**
+     * \return the data of the frame at \p time, taking it from the
+     * prefetched frames when possible
+     */
+    KisOpenGLUpdateInfoSP frameData(int time);
 
     struct Private;
     QScopedPointer<Private> m_d;
@@ -691,6 +691,16 @@ int KisConfig::openGLTextureSize(bool defaultValue) const
     return (defaultValue ? 256 : m_cfg.readEntry("textureSize", 256));
 }
 
+int KisConfig::displayConversionCacheSize(bool defaultValue) const
+{
+    return (defaultValue ? 128 : m_cfg.readEntry("displayConversionCacheSize", 128));
+}
+
+void KisConfig::setDisplayConversionCacheSize(int value)
+{
+    m_cfg.writeEntry("displayConversionCacheSize", value);
+}
+
 bool KisConfig::disableVSync(bool defaultValue) const
 {
     return (defaultValue ? true : m_cfg.readEntry("disableVSync", true));
@@ -1355,6 +1365,16 @@ void KisConfig::setLevelOfDetailEnabled(bool value)
     m_cfg.writeEntry("levelOfDetailEnabled", value);
 }
 
+bool KisConfig::prioritizeVisibleCanvasUpdates(bool defaultValue) const
+{
+    return (defaultValue ? true : m_cfg.readEntry("prioritizeVisibleCanvasUpdates", true));
+}
+
+void KisConfig::setPrioritizeVisibleCanvasUpdates(bool value)
+{
+    m_cfg.writeEntry("prioritizeVisibleCanvasUpdates", value);
+}
+
 KisConfig::OcioColorManagementMode
 KisConfig::ocioColorManagementMode(bool defaultValue) const
 {
@@ -1704,6 +1724,36 @@ void KisConfig::setCompressKra(bool compress)
     m_cfg.writeEntry("compressLayersInKra", compress);
 }
 
+bool KisConfig::parallelKraSaving(bool defaultValue) const
+{
+    return (defaultValue ? true : m_cfg.readEntry("parallelKraSaving", true));
+}
+
+void KisConfig::setParallelKraSaving(bool value)
+{
+    m_cfg.writeEntry("parallelKraSaving", value);
+}
+
+bool KisConfig::parallelKraLoading(bool defaultValue) const
+{
+    return (defaultValue ? true : m_cfg.readEntry("parallelKraLoading", true));
+}
+
+void KisConfig::setParallelKraLoading(bool value)
+{
+    m_cfg.writeEntry("parallelKraLoading", value);
+}
+
+bool KisConfig::incrementalKraSaving(bool defaultValue) const
+{
+    return (defaultValue ? true : m_cfg.readEntry("incrementalKraSaving", true));
+}
+
+void KisConfig::setIncrementalKraSaving(bool value)
+{
+    m_cfg.writeEntry("incrementalKraSaving", value);
+}
+
 bool KisConfig::toolOptionsInDocker(bool defaultValue) const
 {
     return (defaultValue ? true : m_cfg.readEntry("ToolOptionsInDocker", true));
@@ -1852,6 +1902,26 @@ void KisConfig::setAudioOffsetTolerance(int value)
     m_cfg.writeEntry("audioOffsetTolerance", value);
 }
 
+int KisConfig::animationPlaybackPrefetchFrames(bool defaultValue) const
+{
+    return (defaultValue ? 4 : m_cfg.readEntry("animationPlaybackPrefetchFrames", 4));
+}
+
+void KisConfig::setAnimationPlaybackPrefetchFrames(int value)
+{
+    m_cfg.writeEntry("animationPlaybackPrefetchFrames", value);
+}
+
+bool KisConfig::useStreamingVideoExport(bool defaultValue) const
+{
+    return (defaultValue ? true : m_cfg.readEntry("useStreamingVideoExport", true));
+}
+
+void KisConfig::setUseStreamingVideoExport(bool value)
+{
+    m_cfg.writeEntry("useStreamingVideoExport", value);
+}
+
 bool KisConfig::switchSelectionCtrlAlt(bool defaultValue) const
 {
     return defaultValue ? false : m_cfg.readEntry("switchSelectionCtrlAlt", false);
@@ -1944,6 +2014,16 @@ void KisConfig::setCalculateAnimationCacheInBackground(bool value)
     m_cfg.writeEntry("calculateAnimationCacheInBackground", value);
 }
 
+bool KisConfig::calculateAnimationCacheInParallel(bool defaultValue) const
+{
+    return defaultValue ? true : m_cfg.readEntry("calculateAnimationCacheInParallel", true);
+}
+
+void KisConfig::setCalculateAnimationCacheInParallel(bool value)
+{
+    m_cfg.writeEntry("calculateAnimationCacheInParallel", value);
+}
+
 QColor KisConfig::defaultAssistantsColor(bool defaultValue) const
 {
     static const QColor defaultColor = QColor(176, 176, 176, 255);
@@ -190,6 +190,13 @@ public:
 
     int numMipmapLevels(bool defaultValue = false) const;
     int openGLTextureSize(bool defaultValue = false) const;
+
+    /**
+     * The size (in MiB) of the cache of the canvas texture tiles
+     * converted into the display color space
+     */
+    int displayConversionCacheSize(bool defaultValue = false) const;
+    void setDisplayConversionCacheSize(int value);
     int textureOverlapBorder() const;
 
     quint32 getGridMainStyle(bool defaultValue = false) const;
@@ -369,6 +376,13 @@ public:
     bool levelOfDetailEnabled(bool defaultValue = false) const;
     void setLevelOfDetailEnabled(bool value);
 
+    /**
+     * Upload the projection updates that are visible in the viewport
+     * first and postpone the invisible ones till the canvas gets idle
+     */
+    bool prioritizeVisibleCanvasUpdates(bool defaultValue = false) const;
+    void setPrioritizeVisibleCanvasUpdates(bool value);
+
     enum OcioColorManagementMode {
         INTERNAL = 0,
         OCIO_CONFIG,
@@ -501,6 +515,15 @@ public:
     bool compressKra(bool defaultValue = false) const;
     void setCompressKra(bool compress);
 
+    bool parallelKraSaving(bool defaultValue = false) const;
+    void setParallelKraSaving(bool value);
+
+    bool parallelKraLoading(bool defaultValue = false) const;
+    void setParallelKraLoading(bool value);
+
+    bool incrementalKraSaving(bool defaultValue = false) const;
+    void setIncrementalKraSaving(bool value);
+
     bool toolOptionsInDocker(bool defaultValue = false) const;
     void setToolOptionsInDocker(bool inDocker);
 
@@ -534,6 +557,12 @@ public:
     int audioOffsetTolerance(bool defaultValue = false) const;
     void setAudioOffsetTolerance(int value);
 
+    int animationPlaybackPrefetchFrames(bool defaultValue = false) const;
+    void setAnimationPlaybackPrefetchFrames(int value);
+
+    bool useStreamingVideoExport(bool defaultValue = false) const;
+    void setUseStreamingVideoExport(bool value);
+
     bool switchSelectionCtrlAlt(bool defaultValue = false) const;
     void setSwitchSelectionCtrlAlt(bool value);
 
@@ -558,6 +587,9 @@ public:
     bool calculateAnimationCacheInBackground(bool defaultValue = false) const;
     void setCalculateAnimationCacheInBackground(bool value);
 
+    bool calculateAnimationCacheInParallel(bool defaultValue = false) const;
+    void setCalculateAnimationCacheInParallel(bool value);
+
     QColor defaultAssistantsColor(bool defaultValue = false) const;
     void setDefaultAssistantsColor(const QColor &color) const;
 
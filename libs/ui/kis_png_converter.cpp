@@ -37,6 +37,9 @@
 #include <QBuffer>
 #include <QFile>
 #include <QApplication>
+#include <QThread>
+#include <QtConcurrentMap>
+#include <QtEndian>
 
 #include <klocalizedstring.h>
 #include <QUrl>
@@ -409,6 +412,409 @@ void _flush_fn(png_structp png_ptr)
     Q_UNUSED(png_ptr);
 }
 
+namespace
+{
+
+int pngChannelCount(int color_type)
+{
+    switch (color_type) {
+    case PNG_COLOR_TYPE_GRAY:
+    case PNG_COLOR_TYPE_PALETTE:
+        return 1;
+    case PNG_COLOR_TYPE_GRAY_ALPHA:
+        return 2;
+    case PNG_COLOR_TYPE_RGB:
+        return 3;
+    case PNG_COLOR_TYPE_RGB_ALPHA:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * Converts the pixels of \p rect of \p device into PNG rows. The rows
+ * are written one after another with the stride of \p rowStride bytes,
+ * 16-bit samples are written in the native byte order.
+ */
+bool convertRowsToPNG(KisPaintDeviceSP device, const QRect &rect, quint8 *dst, int rowStride,
+                      int color_type, int color_nb_bits, bool alpha,
+                      const png_color *palette, int num_palette)
+{
+    KisSequentialConstIterator it(device, rect);
+
+    for (int row = 0; row < rect.height(); row++, dst += rowStride) {
+        switch (color_type) {
+        case PNG_COLOR_TYPE_GRAY:
+        case PNG_COLOR_TYPE_GRAY_ALPHA:
+            if (color_nb_bits == 16) {
+                quint16 *p = reinterpret_cast<quint16 *>(dst);
+                for (int x = 0; x < rect.width(); x++) {
+                    it.nextPixel();
+                    const quint16 *d = reinterpret_cast<const quint16 *>(it.oldRawData());
+                    *(p++) = d[0];
+                    if (alpha) *(p++) = d[1];
+                }
+            } else {
+                quint8 *p = dst;
+                for (int x = 0; x < rect.width(); x++) {
+                    it.nextPixel();
+                    const quint8 *d = it.oldRawData();
+                    *(p++) = d[0];
+                    if (alpha) *(p++) = d[1];
+                }
+            }
+            break;
+        case PNG_COLOR_TYPE_RGB:
+        case PNG_COLOR_TYPE_RGB_ALPHA:
+            if (color_nb_bits == 16) {
+                quint16 *p = reinterpret_cast<quint16 *>(dst);
+                for (int x = 0; x < rect.width(); x++) {
+                    it.nextPixel();
+                    const quint16 *d = reinterpret_cast<const quint16 *>(it.oldRawData());
+                    *(p++) = d[2];
+                    *(p++) = d[1];
+                    *(p++) = d[0];
+                    if (alpha) *(p++) = d[3];
+                }
+            } else {
+                quint8 *p = dst;
+                for (int x = 0; x < rect.width(); x++) {
+                    it.nextPixel();
+                    const quint8 *d = it.oldRawData();
+                    *(p++) = d[2];
+                    *(p++) = d[1];
+                    *(p++) = d[0];
+                    if (alpha) *(p++) = d[3];
+                }
+            }
+            break;
+        case PNG_COLOR_TYPE_PALETTE: {
+            KisPNGWriteStream writestream(dst, color_nb_bits);
+            for (int x = 0; x < rect.width(); x++) {
+                it.nextPixel();
+                const quint8 *d = it.oldRawData();
+                int i;
+                for (i = 0; i < num_palette; i++) {
+                    if (palette[i].red == d[2] &&
+                            palette[i].green == d[1] &&
+                            palette[i].blue == d[0]) {
+                        break;
+                    }
+                }
+                writestream.setNextValue(i);
+            }
+        }
+            break;
+        default:
+            return false;
+        }
+    }
+
+    return true;
+}
+
+inline int paethPredictor(int a, int b, int c)
+{
+    const int p = a + b - c;
+    const int pa = qAbs(p - a);
+    const int pb = qAbs(p - b);
+    const int pc = qAbs(p - c);
+
+    return (pa <= pb && pa <= pc) ? a : (pb <= pc) ? b : c;
+}
+
+/**
+ * Applies PNG \p filter to \p row, \p prior is the unfiltered previous
+ * row. Returns the sum of the filtered bytes taken as signed values,
+ * which is the heuristic libpng uses to choose the filter of a row.
+ */
+template <int filter>
+int filterPNGRow(const quint8 *row, const quint8 *prior, int rowBytes, int bpp, quint8 *dst)
+{
+    int sum = 0;
+
+    for (int i = 0; i < rowBytes; i++) {
+        const int a = i >= bpp ? row[i - bpp] : 0;
+        const int b = prior[i];
+        const int c = i >= bpp ? prior[i - bpp] : 0;
+
+        int predictor = 0;
+
+        switch (filter) {
+        case PNG_FILTER_VALUE_SUB:
+            predictor = a;
+            break;
+        case PNG_FILTER_VALUE_UP:
+            predictor = b;
+            break;
+        case PNG_FILTER_VALUE_AVG:
+            predictor = (a + b) >> 1;
+            break;
+        case PNG_FILTER_VALUE_PAETH:
+            predictor = paethPredictor(a, b, c);
+            break;
+        default:
+            break;
+        }
+
+        dst[i] = quint8(row[i] - predictor);
+        sum += qAbs(int(qint8(dst[i])));
+    }
+
+    return sum;
+}
+
+/**
+ * A horizontal band of the image that is converted, filtered and
+ * deflated independently of the other bands
+ */
+struct KisPNGBand {
+    KisPNGBand()
+        : y(0), numRows(0), isLast(false), adler(0), uncompressedSize(0), failed(false)
+    {
+    }
+
+    int y;
+    int numRows;
+    bool isLast;
+
+    QByteArray compressedData;
+    uLong adler;
+    int uncompressedSize;
+    bool failed;
+};
+
+/**
+ * Encodes a band into a raw deflate stream. All the bands except the
+ * last one are terminated with a sync flush, which aligns the stream to
+ * a byte boundary without marking the final block. Hence the streams of
+ * the bands can be concatenated into one zlib stream of the IDAT chunks.
+ */
+struct KisPNGBandEncoder {
+    KisPNGBandEncoder(KisPaintDeviceSP _device, const QRect &_imageRect,
+                      int _color_type, int _color_nb_bits, bool _alpha,
+                      const png_color *_palette, int _num_palette, int _compression)
+        : device(_device), imageRect(_imageRect),
+          color_type(_color_type), color_nb_bits(_color_nb_bits), alpha(_alpha),
+          palette(_palette), num_palette(_num_palette), compression(_compression)
+    {
+        const int channels = pngChannelCount(color_type);
+
+        rowBytes = (imageRect.width() * channels * color_nb_bits + 7) / 8;
+        bpp = qMax(1, channels * color_nb_bits / 8);
+
+        // libpng doesn't filter the palette and low bit depth images either
+        useFilters = color_type != PNG_COLOR_TYPE_PALETTE && color_nb_bits >= 8;
+    }
+
+    void operator()(KisPNGBand &band) const;
+
+    KisPaintDeviceSP device;
+    QRect imageRect;
+    int color_type;
+    int color_nb_bits;
+    bool alpha;
+    const png_color *palette;
+    int num_palette;
+    int compression;
+
+    int rowBytes;
+    int bpp;
+    bool useFilters;
+};
+
+void KisPNGBandEncoder::operator()(KisPNGBand &band) const
+{
+    // the first row keeps the last row of the previous band for the filters
+    QVector<quint8> rows((band.numRows + 1) * rowBytes);
+
+    if (band.y > imageRect.y()) {
+        band.failed = !convertRowsToPNG(device, QRect(imageRect.x(), band.y - 1, imageRect.width(), band.numRows + 1),
+                                        rows.data(), rowBytes, color_type, color_nb_bits, alpha, palette, num_palette);
+    } else {
+        band.failed = !convertRowsToPNG(device, QRect(imageRect.x(), band.y, imageRect.width(), band.numRows),
+                                        rows.data() + rowBytes, rowBytes, color_type, color_nb_bits, alpha, palette, num_palette);
+    }
+
+    if (band.failed) return;
+
+#ifndef WORDS_BIGENDIAN
+    if (color_nb_bits > 8) {
+        quint16 *sample = reinterpret_cast<quint16*>(rows.data());
+        quint16 *end = sample + rows.size() / 2;
+        for (; sample < end; ++sample) {
+            *sample = qToBigEndian(*sample);
+        }
+    }
+#endif
+
+    const int filteredRowBytes = rowBytes + 1;
+    QVector<quint8> filtered(band.numRows * filteredRowBytes);
+    QVector<quint8> trial(rowBytes);
+
+    for (int i = 0; i < band.numRows; i++) {
+        const quint8 *prior = rows.constData() + i * rowBytes;
+        const quint8 *row = prior + rowBytes;
+        quint8 *dst = filtered.data() + i * filteredRowBytes;
+
+        dst[0] = PNG_FILTER_VALUE_NONE;
+        memcpy(dst + 1, row, rowBytes);
+
+        if (!useFilters) continue;
+
+        int bestSum = 0;
+        for (int j = 0; j < rowBytes; j++) {
+            bestSum += qAbs(int(qint8(row[j])));
+        }
+
+        int sum = filterPNGRow<PNG_FILTER_VALUE_SUB>(row, prior, rowBytes, bpp, trial.data());
+        if (sum < bestSum) {
+            bestSum = sum;
+            dst[0] = PNG_FILTER_VALUE_SUB;
+            memcpy(dst + 1, trial.constData(), rowBytes);
+        }
+
+        sum = filterPNGRow<PNG_FILTER_VALUE_UP>(row, prior, rowBytes, bpp, trial.data());
+        if (sum < bestSum) {
+            bestSum = sum;
+            dst[0] = PNG_FILTER_VALUE_UP;
+            memcpy(dst + 1, trial.constData(), rowBytes);
+        }
+
+        sum = filterPNGRow<PNG_FILTER_VALUE_AVG>(row, prior, rowBytes, bpp, trial.data());
+        if (sum < bestSum) {
+            bestSum = sum;
+            dst[0] = PNG_FILTER_VALUE_AVG;
+            memcpy(dst + 1, trial.constData(), rowBytes);
+        }
+
+        sum = filterPNGRow<PNG_FILTER_VALUE_PAETH>(row, prior, rowBytes, bpp, trial.data());
+        if (sum < bestSum) {
+            dst[0] = PNG_FILTER_VALUE_PAETH;
+            memcpy(dst + 1, trial.constData(), rowBytes);
+        }
+    }
+
+    rows.clear();
+
+    band.uncompressedSize = filtered.size();
+    band.adler = adler32(adler32(0L, Z_NULL, 0), filtered.constData(), filtered.size());
+
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+
+    // negative window bits generate a raw deflate stream without the zlib wrapper
+    if (deflateInit2(&stream, compression, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        band.failed = true;
+        return;
+    }
+
+    const int flush = band.isLast ? Z_FINISH : Z_SYNC_FLUSH;
+
+    stream.next_in = const_cast<Bytef*>(filtered.constData());
+    stream.avail_in = filtered.size();
+
+    QByteArray &out = band.compressedData;
+    out.resize(int(deflateBound(&stream, filtered.size())) + 16);
+    int written = 0;
+
+    Q_FOREVER {
+        stream.next_out = reinterpret_cast<Bytef*>(out.data()) + written;
+        stream.avail_out = out.size() - written;
+
+        const int result = deflate(&stream, flush);
+        written = out.size() - stream.avail_out;
+
+        if (result == Z_STREAM_ERROR) {
+            band.failed = true;
+            break;
+        }
+
+        if (band.isLast ? result == Z_STREAM_END : stream.avail_out > 0) {
+            break;
+        }
+
+        out.resize(2 * out.size());
+    }
+
+    deflateEnd(&stream);
+    out.resize(written);
+}
+
+/**
+ * Writes the pixel data as a sequence of IDAT chunks. The bands of the
+ * image are encoded in the global thread pool, and written to the file
+ * in order.
+ */
+bool writeIDATInParallel(png_structp png_ptr, KisPaintDeviceSP device, const QRect &imageRect,
+                         int color_type, int color_nb_bits, bool alpha,
+                         const png_color *palette, int num_palette, int compression)
+{
+    KisPNGBandEncoder encoder(device, imageRect, color_type, color_nb_bits, alpha, palette, num_palette, compression);
+
+    // about a megabyte of the pixel data per band, rounded to the tile height
+    const int bandBytes = 1 << 20;
+    int rowsPerBand = qMax(1, bandBytes / (encoder.rowBytes + 1));
+    rowsPerBand = qMax(64, rowsPerBand - rowsPerBand % 64);
+
+    const int bandsPerBatch = 2 * QThread::idealThreadCount();
+
+    // the zlib header, see RFC 1950
+    const int levelFlags = compression < 2 ? 0 : compression < 6 ? 1 : compression == 6 ? 2 : 3;
+    const quint8 cmf = 0x78;
+    quint8 flg = levelFlags << 6;
+    flg += 31 - ((cmf << 8) + flg) % 31;
+
+    uLong adler = adler32(0L, Z_NULL, 0);
+    bool isFirstBand = true;
+
+    for (int batchY = imageRect.y(); batchY < imageRect.bottom() + 1; batchY += bandsPerBatch * rowsPerBand) {
+        QVector<KisPNGBand> bands;
+
+        for (int y = batchY;
+             y < imageRect.bottom() + 1 && bands.size() < bandsPerBatch;
+             y += rowsPerBand) {
+
+            KisPNGBand band;
+            band.y = y;
+            band.numRows = qMin(rowsPerBand, imageRect.bottom() + 1 - y);
+            band.isLast = y + band.numRows > imageRect.bottom();
+            bands.append(band);
+        }
+
+        QtConcurrent::blockingMap(bands, encoder);
+
+        for (int i = 0; i < bands.size(); i++) {
+            KisPNGBand &band = bands[i];
+            if (band.failed) return false;
+
+            adler = adler32_combine(adler, band.adler, band.uncompressedSize);
+
+            if (isFirstBand) {
+                band.compressedData.prepend(char(flg));
+                band.compressedData.prepend(char(cmf));
+                isFirstBand = false;
+            }
+
+            if (band.isLast) {
+                const quint32 trailer = qToBigEndian(quint32(adler));
+                band.compressedData.append(reinterpret_cast<const char*>(&trailer), sizeof(trailer));
+            }
+
+            png_write_chunk(png_ptr, (png_bytep)"IDAT",
+                            reinterpret_cast<png_bytep>(band.compressedData.data()),
+                            band.compressedData.size());
+
+            band.compressedData.clear();
+        }
+    }
+
+    return true;
+}
+
+}
+
 
 KisImageBuilder_Result KisPNGConverter::buildImage(QIODevice* iod)
 {
@@ -831,32 +1237,10 @@ bool KisPNGConverter::saveDeviceToStore(const QString &filename, const QRect &im
             dbgFile << "Could not open for writing:" << filename;
             return false;
         }
-        KisPNGConverter pngconv(0);
-        vKisAnnotationSP_it annotIt = 0;
-        KisMetaData::Store* metaDataStore = 0;
-        if (metaData) {
-            metaDataStore = new KisMetaData::Store(*metaData);
-        }
-        KisPNGOptions options;
-        options.compression = 0;
-        options.interlace = false;
-        options.tryToSaveAsIndexed = false;
-        options.alpha = true;
-        options.saveSRGBProfile = false;
-
-        if (dev->colorSpace()->id() != "RGBA") {
-            dev = new KisPaintDevice(*dev.data());
-            KUndo2Command *cmd = dev->convertTo(KoColorSpaceRegistry::instance()->rgb8());
-            delete cmd;
-        }
-
-        bool success = pngconv.buildFile(&io, imageRect, xRes, yRes, dev, annotIt, annotIt, options, metaDataStore);
-        if (success != KisImageBuilder_RESULT_OK) {
+        if (!saveDeviceToIODevice(&io, imageRect, xRes, yRes, dev, metaData)) {
             dbgFile << "Saving PNG failed:" << filename;
-            delete metaDataStore;
             return false;
         }
-        delete metaDataStore;
         io.close();
         if (!store->close()) {
             return false;
@@ -869,6 +1253,34 @@ bool KisPNGConverter::saveDeviceToStore(const QString &filename, const QRect &im
 
 }
 
+bool KisPNGConverter::saveDeviceToIODevice(QIODevice *io, const QRect &imageRect, const qreal xRes, const qreal yRes, KisPaintDeviceSP dev, KisMetaData::Store* metaData, int compression, bool parallelEncoding)
+{
+    KisPNGConverter pngconv(0);
+    vKisAnnotationSP_it annotIt = 0;
+    KisMetaData::Store* metaDataStore = 0;
+    if (metaData) {
+        metaDataStore = new KisMetaData::Store(*metaData);
+    }
+    KisPNGOptions options;
+    options.compression = compression;
+    options.interlace = false;
+    options.tryToSaveAsIndexed = false;
+    options.alpha = true;
+    options.saveSRGBProfile = false;
+    options.parallelEncoding = parallelEncoding;
+
+    if (dev->colorSpace()->id() != "RGBA") {
+        dev = new KisPaintDevice(*dev.data());
+        KUndo2Command *cmd = dev->convertTo(KoColorSpaceRegistry::instance()->rgb8());
+        delete cmd;
+    }
+
+    KisImageBuilder_Result result = pngconv.buildFile(io, imageRect, xRes, yRes, dev, annotIt, annotIt, options, metaDataStore);
+    delete metaDataStore;
+
+    return result == KisImageBuilder_RESULT_OK;
+}
+
 
 KisImageBuilder_Result KisPNGConverter::buildFile(const QString &filename, const QRect &imageRect, const qreal xRes, const qreal yRes, KisPaintDeviceSP device, vKisAnnotationSP_it annotationsStart, vKisAnnotationSP_it annotationsEnd, KisPNGOptions options, KisMetaData::Store* metaData)
 {
@@ -1194,6 +1606,23 @@ KisImageBuilder_Result KisPNGConverter::buildFile(QIODevice* iodevice, const QRe
     // Write the PNG
     //     png_write_png(png_ptr, info_ptr, PNG_TRANSFORM_IDENTITY, 0);
 
+    if (options.parallelEncoding && !options.interlace) {
+        if (!writeIDATInParallel(png_ptr, device, imageRect, color_type, color_nb_bits, options.alpha,
+                                 palette.data(), num_palette, options.compression)) {
+
+            png_destroy_write_struct(&png_ptr, &info_ptr);
+            return KisImageBuilder_RESULT_FAILURE;
+        }
+
+        // png_write_end() refuses to work when the IDAT chunks were not written by
+        // libpng itself. All the other chunks have already been written by png_write_info().
+        png_write_chunk(png_ptr, (png_bytep)"IEND", 0, 0);
+        png_write_flush(png_ptr);
+
+        png_destroy_write_struct(&png_ptr, &info_ptr);
+        return KisImageBuilder_RESULT_OK;
+    }
+
     struct RowPointersStruct {
         RowPointersStruct(const QSize &size, int pixelSize)
             : numRows(size.height())
@@ -1222,67 +1651,10 @@ KisImageBuilder_Result KisPNGConverter::buildFile(QIODevice* iodevice, const QRe
 
     int row = 0;
     for (int y = imageRect.y(); y < imageRect.y() + imageRect.height(); y++, row++) {
-        KisHLineConstIteratorSP it = device->createHLineConstIteratorNG(imageRect.x(), y, imageRect.width());
+        if (!convertRowsToPNG(device, QRect(imageRect.x(), y, imageRect.width(), 1),
+                              rowPointers.rows[row], 0, color_type, color_nb_bits, options.alpha,
+                              palette.data(), num_palette)) {
 
-        switch (color_type) {
-        case PNG_COLOR_TYPE_GRAY:
-        case PNG_COLOR_TYPE_GRAY_ALPHA:
-            if (color_nb_bits == 16) {
-                quint16 *dst = reinterpret_cast<quint16 *>(rowPointers.rows[row]);
-                do {
-                    const quint16 *d = reinterpret_cast<const quint16 *>(it->oldRawData());
-                    *(dst++) = d[0];
-                    if (options.alpha) *(dst++) = d[1];
-                } while (it->nextPixel());
-            } else {
-                quint8 *dst = rowPointers.rows[row];
-                do {
-                    const quint8 *d = it->oldRawData();
-                    *(dst++) = d[0];
-                    if (options.alpha) *(dst++) = d[1];
-                } while (it->nextPixel());
-            }
-            break;
-        case PNG_COLOR_TYPE_RGB:
-        case PNG_COLOR_TYPE_RGB_ALPHA:
-            if (color_nb_bits == 16) {
-                quint16 *dst = reinterpret_cast<quint16 *>(rowPointers.rows[row]);
-                do {
-                    const quint16 *d = reinterpret_cast<const quint16 *>(it->oldRawData());
-                    *(dst++) = d[2];
-                    *(dst++) = d[1];
-                    *(dst++) = d[0];
-                    if (options.alpha) *(dst++) = d[3];
-                } while (it->nextPixel());
-            } else {
-                quint8 *dst = rowPointers.rows[row];
-                do {
-                    const quint8 *d = it->oldRawData();
-                    *(dst++) = d[2];
-                    *(dst++) = d[1];
-                    *(dst++) = d[0];
-                    if (options.alpha) *(dst++) = d[3];
-                } while (it->nextPixel());
-            }
-            break;
-        case PNG_COLOR_TYPE_PALETTE: {
-            quint8 *dst = rowPointers.rows[row];
-            KisPNGWriteStream writestream(dst, color_nb_bits);
-            do {
-                const quint8 *d = it->oldRawData();
-                int i;
-                for (i = 0; i < num_palette; i++) {
-                    if (palette[i].red == d[2] &&
-                            palette[i].green == d[1] &&
-                            palette[i].blue == d[0]) {
-                        break;
-                    }
-                }
-                writestream.setNextValue(i);
-            } while (it->nextPixel());
-        }
-            break;
-        default:
             return KisImageBuilder_RESULT_UNSUPPORTED;
         }
     }
@@ -55,6 +55,7 @@ struct KisPNGOptions {
         , forceSRGB(false)
         , storeMetaData(false)
         , storeAuthor(false)
+        , parallelEncoding(false)
         , transparencyFillColor(Qt::white)
     {}
 
@@ -69,6 +70,11 @@ struct KisPNGOptions {
     bool forceSRGB;
     bool storeMetaData;
     bool storeAuthor;
+    /**
+     * Deflate horizontal bands of a non-interlaced image in parallel. The
+     * pixel data is written as a sequence of IDAT chunks, one per band.
+     */
+    bool parallelEncoding;
     QList<const KisMetaData::Filter*> filters;
     QColor transparencyFillColor;
 
@@ -124,6 +130,15 @@ public:
      */
     static bool saveDeviceToStore(const QString &filename, const QRect &imageRect, const qreal xRes, const qreal yRes, KisPaintDeviceSP dev, KoStore *store, KisMetaData::Store* metaData = 0);
 
+    /**
+     * @brief saveDeviceToIODevice writes the given paint device as PNG data into \p io, converting it
+     * the same way saveDeviceToStore() does. It can be called from a worker thread.
+     * @param compression the zlib compression level of the pixel data
+     * @param parallelEncoding deflate the bands of the image in the global thread pool
+     * @return true if the saving succeeds
+     */
+    static bool saveDeviceToIODevice(QIODevice *io, const QRect &imageRect, const qreal xRes, const qreal yRes, KisPaintDeviceSP dev, KisMetaData::Store* metaData = 0, int compression = 0, bool parallelEncoding = false);
+
     static bool isColorSpaceSupported(const KoColorSpace *cs);
 
 public Q_SLOTS:
@@ -0,0 +1,101 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "KisDisplayConversionCache.h"
+
+#include <QHash>
+#include <QMutexLocker>
+
+#include "kis_paint_device.h"
+#include "kis_datamanager.h"
+
+
+KisDisplayConversionCache::KisDisplayConversionCache(int maxSizeInBytes)
+    : m_cache(maxSizeInBytes)
+{
+}
+
+void KisDisplayConversionCache::setMaxSize(int maxSizeInBytes)
+{
+    QMutexLocker l(&m_mutex);
+    m_cache.setMaxCost(maxSizeInBytes);
+}
+
+void KisDisplayConversionCache::clear()
+{
+    QMutexLocker l(&m_mutex);
+    m_cache.clear();
+}
+
+KisDisplayConversionCache::Key
+KisDisplayConversionCache::makeKey(KisPaintDeviceSP projection, const KisTextureTileUpdateInfo &tileInfo)
+{
+    Key key;
+    key.patchRect = tileInfo.realPatchRect();
+    key.levelOfDetail = tileInfo.patchLevelOfDetail();
+    key.srcColorSpace = projection->colorSpace();
+
+    const QRect dataRect = key.patchRect.translated(-projection->x(), -projection->y());
+    key.revisions = projection->dataManager()->tileRevisions(dataRect);
+
+    return key;
+}
+
+bool KisDisplayConversionCache::fetch(const Key &key, KisTextureTileUpdateInfo &tileInfo)
+{
+    if (!key.isValid()) return false;
+
+    QMutexLocker l(&m_mutex);
+
+    Patch *patch = m_cache.object(key);
+    if (!patch) return false;
+
+    DataBuffer buffer(patch->colorSpace->pixelSize(), tileInfo.pool());
+    memcpy(buffer.data(), patch->data.constData(), patch->data.size());
+    tileInfo.putPixelData(std::move(buffer), patch->colorSpace);
+
+    return true;
+}
+
+void KisDisplayConversionCache::store(const Key &key, const KisTextureTileUpdateInfo &tileInfo)
+{
+    if (!key.isValid() || !tileInfo.valid()) return;
+
+    const QSize patchSize = tileInfo.realPatchSize();
+    const int dataSize = patchSize.width() * patchSize.height() * tileInfo.pixelSize();
+
+    Patch *patch = new Patch();
+    patch->data = QByteArray(reinterpret_cast<const char*>(tileInfo.data()), dataSize);
+    patch->colorSpace = tileInfo.patchColorSpace();
+
+    QMutexLocker l(&m_mutex);
+    m_cache.insert(key, patch, dataSize);
+}
+
+uint qHash(const KisDisplayConversionCache::Key &key, uint seed)
+{
+    uint hash = qHash(key.patchRect.x(), seed);
+    hash = 31 * hash + qHash(key.patchRect.y(), seed);
+    hash = 31 * hash + qHash(key.levelOfDetail, seed);
+
+    Q_FOREACH (quint64 revision, key.revisions) {
+        hash = 31 * hash + qHash(revision, seed);
+    }
+
+    return hash;
+}
@@ -0,0 +1,107 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KISDISPLAYCONVERSIONCACHE_H
+#define KISDISPLAYCONVERSIONCACHE_H
+
+#include "kritaui_export.h"
+
+#include <QCache>
+#include <QMutex>
+#include <QRect>
+#include <QVector>
+
+#include "kis_types.h"
+#include "kis_texture_tile_update_info.h"
+
+class KoColorSpace;
+
+
+/**
+ * A cache of the texture tile patches that have already been converted
+ * into the display color space.
+ *
+ * The patch is identified by its position and the revisions of the
+ * projection tiles it was read from (see KisTileData::revision()), so
+ * a re-upload of the unchanged data (e.g. after undo or when switching
+ * the level of detail back) doesn't run the color conversion again.
+ *
+ * The cache doesn't know anything about the conversion parameters, so
+ * the owner must clear() it every time they change.
+ *
+ * The cache is thread-safe. The least recently used patches are evicted
+ * when the total size of the cached data exceeds the limit.
+ */
+class KRITAUI_EXPORT KisDisplayConversionCache
+{
+public:
+    struct Key {
+        QRect patchRect;
+        int levelOfDetail = 0;
+        const KoColorSpace *srcColorSpace = 0;
+        QVector<quint64> revisions;
+
+        bool isValid() const {
+            return !revisions.isEmpty();
+        }
+
+        bool operator==(const Key &rhs) const {
+            return patchRect == rhs.patchRect &&
+                levelOfDetail == rhs.levelOfDetail &&
+                srcColorSpace == rhs.srcColorSpace &&
+                revisions == rhs.revisions;
+        }
+    };
+
+public:
+    KisDisplayConversionCache(int maxSizeInBytes);
+
+    void setMaxSize(int maxSizeInBytes);
+    void clear();
+
+    /**
+     * Generates the key for the patch of \p tileInfo. Must be called
+     * *before* the data is read from \p projection
+     */
+    static Key makeKey(KisPaintDeviceSP projection, const KisTextureTileUpdateInfo &tileInfo);
+
+    /**
+     * Fills \p tileInfo with the cached converted data
+     *
+     * \return false if there is no data for \p key in the cache
+     */
+    bool fetch(const Key &key, KisTextureTileUpdateInfo &tileInfo);
+
+    /**
+     * Puts the converted data of \p tileInfo into the cache
+     */
+    void store(const Key &key, const KisTextureTileUpdateInfo &tileInfo);
+
+private:
+    struct Patch {
+        QByteArray data;
+        const KoColorSpace *colorSpace;
+    };
+
+    QMutex m_mutex;
+    QCache<Key, Patch> m_cache;
+};
+
+uint qHash(const KisDisplayConversionCache::Key &key, uint seed = 0);
+
+#endif // KISDISPLAYCONVERSIONCACHE_H
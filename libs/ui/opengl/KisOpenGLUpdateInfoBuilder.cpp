@@ -20,16 +20,23 @@
 // TODO: conversion options into a separate file!
 #include "kis_update_info.h"
 #include "opengl/kis_texture_tile_info_pool.h"
+#include "opengl/KisDisplayConversionCache.h"
 
 #include "KisProofingConfiguration.h"
 
 #include <QReadWriteLock>
 #include <QReadLocker>
 #include <QWriteLocker>
+#include <QtConcurrent>
 
 
 struct KRITAUI_NO_EXPORT KisOpenGLUpdateInfoBuilder::Private
 {
+    Private()
+        : conversionCache(qBound(0, KisConfig(true).displayConversionCacheSize(), 1024) * 1024 * 1024)
+    {
+    }
+
     ConversionOptions conversionOptions;
 
     QBitArray channelFlags;
@@ -44,8 +51,100 @@ struct KRITAUI_NO_EXPORT KisOpenGLUpdateInfoBuilder::Private
 
     KisTextureTileInfoPoolSP pool;
     QReadWriteLock lock;
+
+    /**
+     * Keeps the patches converted into the display color space. Must
+     * be reset on every change of the conversion parameters.
+     */
+    KisDisplayConversionCache conversionCache;
+};
+
+
+namespace {
+
+struct TileDataProcessor
+{
+    TileDataProcessor(KisPaintDeviceSP projection,
+                      const QBitArray &channelFlags,
+                      bool onlyOneChannelSelected,
+                      int selectedChannelIndex)
+        : m_projection(projection),
+          m_channelFlags(channelFlags),
+          m_onlyOneChannelSelected(onlyOneChannelSelected),
+          m_selectedChannelIndex(selectedChannelIndex),
+          m_showSingleChannelAsColor(false)
+    {
+        if (!channelFlags.isEmpty()) {
+            KisConfig cfg(true);
+            m_showSingleChannelAsColor = cfg.showSingleChannelAsColor();
+        }
+    }
+
+    void setConversion(const ConversionOptions &options) {
+        m_conversionOptions = options;
+        m_convertColorSpace = true;
+    }
+
+    void setProofing(const KoColorSpace *dstColorSpace,
+                     KoColorConversionTransformation::ConversionFlags conversionFlags,
+                     KoColorConversionTransformation *proofingTransform) {
+        m_conversionOptions.m_destinationColorSpace = dstColorSpace;
+        m_conversionOptions.m_conversionFlags = conversionFlags;
+        m_proofingTransform = proofingTransform;
+        m_convertColorSpace = true;
+    }
+
+    void setConversionCache(KisDisplayConversionCache *cache) {
+        m_conversionCache = cache;
+    }
+
+    typedef void result_type;
+
+    void operator()(KisTextureTileUpdateInfoSP &tileInfo) const {
+        const bool useCache = m_conversionCache && m_convertColorSpace;
+
+        // the revisions must be fetched before the data is read!
+        KisDisplayConversionCache::Key key;
+        if (useCache) {
+            key = KisDisplayConversionCache::makeKey(m_projection, *tileInfo);
+            if (m_conversionCache->fetch(key, *tileInfo)) return;
+        }
+
+        tileInfo->retrieveData(m_projection, m_channelFlags,
+                               m_onlyOneChannelSelected, m_selectedChannelIndex,
+                               m_showSingleChannelAsColor);
+
+        if (m_convertColorSpace) {
+            const KoColorSpace *srcColorSpace = tileInfo->patchColorSpace();
+
+            if (m_proofingTransform) {
+                tileInfo->proofTo(m_conversionOptions.m_destinationColorSpace, m_conversionOptions.m_conversionFlags, m_proofingTransform);
+            } else {
+                tileInfo->convertTo(m_conversionOptions.m_destinationColorSpace, m_conversionOptions.m_renderingIntent, m_conversionOptions.m_conversionFlags);
+            }
+
+            // caching the unconverted data makes no sense, reading it is cheap
+            if (useCache && tileInfo->patchColorSpace() != srcColorSpace) {
+                m_conversionCache->store(key, *tileInfo);
+            }
+        }
+    }
+
+private:
+    KisPaintDeviceSP m_projection;
+    QBitArray m_channelFlags;
+    bool m_onlyOneChannelSelected;
+    int m_selectedChannelIndex;
+    bool m_showSingleChannelAsColor;
+
+    bool m_convertColorSpace = false;
+    ConversionOptions m_conversionOptions;
+    KoColorConversionTransformation *m_proofingTransform = 0;
+    KisDisplayConversionCache *m_conversionCache = 0;
 };
 
+}
+
 
 KisOpenGLUpdateInfoBuilder::KisOpenGLUpdateInfoBuilder()
     : m_d(new Private)
@@ -58,10 +157,10 @@ KisOpenGLUpdateInfoBuilder::~KisOpenGLUpdateInfoBuilder()
 
 KisOpenGLUpdateInfoSP KisOpenGLUpdateInfoBuilder::buildUpdateInfo(const QRect &rect, KisImageSP srcImage, bool convertColorSpace)
 {
-    return buildUpdateInfo(rect, srcImage->projection(), srcImage->bounds(), srcImage->currentLevelOfDetail(), convertColorSpace);
+    return buildUpdateInfo(rect, srcImage->projection(), srcImage->bounds(), srcImage->currentLevelOfDetail(), convertColorSpace, true);
 }
 
-KisOpenGLUpdateInfoSP KisOpenGLUpdateInfoBuilder::buildUpdateInfo(const QRect &rect, KisPaintDeviceSP projection, const QRect &bounds, int levelOfDetail, bool convertColorSpace)
+KisOpenGLUpdateInfoSP KisOpenGLUpdateInfoBuilder::buildUpdateInfo(const QRect &rect, KisPaintDeviceSP projection, const QRect &bounds, int levelOfDetail, bool convertColorSpace, bool useConversionCache)
 {
     KisOpenGLUpdateInfoSP info = new KisOpenGLUpdateInfo();
 
@@ -151,16 +250,6 @@ KisOpenGLUpdateInfoSP KisOpenGLUpdateInfoBuilder::buildUpdateInfo(const QRect &r
                                                      m_d->pool));
             // Don't update empty tiles
             if (tileInfo->valid()) {
-                tileInfo->retrieveData(projection, channelFlags, m_d->onlyOneChannelSelected, m_d->selectedChannelIndex);
-
-                if (convertColorSpace) {
-                    if (m_d->proofingTransform) {
-                        tileInfo->proofTo(m_d->conversionOptions.m_destinationColorSpace, m_d->proofingConfig->conversionFlags, m_d->proofingTransform.data());
-                    } else {
-                        tileInfo->convertTo(m_d->conversionOptions.m_destinationColorSpace, m_d->conversionOptions.m_renderingIntent, m_d->conversionOptions.m_conversionFlags);
-                    }
-                }
-
                 info->tileList.append(tileInfo);
             }
             else {
@@ -169,6 +258,35 @@ KisOpenGLUpdateInfoSP KisOpenGLUpdateInfoBuilder::buildUpdateInfo(const QRect &r
         }
     }
 
+    /**
+     * The tiles are independent from each other, so their data is
+     * fetched and converted in parallel. The read lock is held by the
+     * calling thread for the whole time of the processing, so the
+     * proofing transform cannot be reset under the feet of the jobs.
+     */
+    TileDataProcessor processor(projection, channelFlags,
+                                m_d->onlyOneChannelSelected, m_d->selectedChannelIndex);
+
+    if (convertColorSpace) {
+        if (m_d->proofingTransform) {
+            processor.setProofing(m_d->conversionOptions.m_destinationColorSpace,
+                                  m_d->proofingConfig->conversionFlags,
+                                  m_d->proofingTransform.data());
+        } else {
+            processor.setConversion(m_d->conversionOptions);
+        }
+
+        if (useConversionCache) {
+            processor.setConversionCache(&m_d->conversionCache);
+        }
+    }
+
+    if (info->tileList.size() > 1) {
+        QtConcurrent::blockingMap(info->tileList, processor);
+    } else if (!info->tileList.isEmpty()) {
+        processor(info->tileList.first());
+    }
+
     info->assignDirtyImageRect(rect);
     info->assignLevelOfDetail(levelOfDetail);
     return info;
@@ -218,6 +336,7 @@ void KisOpenGLUpdateInfoBuilder::setConversionOptions(const ConversionOptions &o
     QWriteLocker lock(&m_d->lock);
 
     m_d->conversionOptions = options;
+    m_d->conversionCache.clear();
 }
 
 void KisOpenGLUpdateInfoBuilder::setChannelFlags(const QBitArray &channelFrags, bool onlyOneChannelSelected, int selectedChannelIndex)
@@ -227,6 +346,7 @@ void KisOpenGLUpdateInfoBuilder::setChannelFlags(const QBitArray &channelFrags,
     m_d->channelFlags = channelFrags;
     m_d->onlyOneChannelSelected = onlyOneChannelSelected;
     m_d->selectedChannelIndex = selectedChannelIndex;
+    m_d->conversionCache.clear();
 }
 
 void KisOpenGLUpdateInfoBuilder::setTextureBorder(int value)
@@ -234,6 +354,7 @@ void KisOpenGLUpdateInfoBuilder::setTextureBorder(int value)
     QWriteLocker lock(&m_d->lock);
 
     m_d->textureBorder = value;
+    m_d->conversionCache.clear();
 }
 
 void KisOpenGLUpdateInfoBuilder::setEffectiveTextureSize(const QSize &size)
@@ -241,6 +362,7 @@ void KisOpenGLUpdateInfoBuilder::setEffectiveTextureSize(const QSize &size)
     QWriteLocker lock(&m_d->lock);
 
     m_d->effectiveTextureSize = size;
+    m_d->conversionCache.clear();
 }
 
 void KisOpenGLUpdateInfoBuilder::setTextureInfoPool(KisTextureTileInfoPoolSP pool)
@@ -248,6 +370,7 @@ void KisOpenGLUpdateInfoBuilder::setTextureInfoPool(KisTextureTileInfoPoolSP poo
     QWriteLocker lock(&m_d->lock);
 
     m_d->pool = pool;
+    m_d->conversionCache.clear();
 }
 
 KisTextureTileInfoPoolSP KisOpenGLUpdateInfoBuilder::textureInfoPool() const
@@ -262,6 +385,7 @@ void KisOpenGLUpdateInfoBuilder::setProofingConfig(KisProofingConfigurationSP co
 
     m_d->proofingConfig = config;
     m_d->proofingTransform.reset();
+    m_d->conversionCache.clear();
 }
 
 KisProofingConfigurationSP KisOpenGLUpdateInfoBuilder::proofingConfig() const
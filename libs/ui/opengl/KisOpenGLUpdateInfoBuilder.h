@@ -50,8 +50,19 @@ public:
     KisOpenGLUpdateInfoBuilder();
     ~KisOpenGLUpdateInfoBuilder();
 
+    /**
+     * Builds the update for the image's projection. The converted
+     * patches are cached, so the unchanged parts of the projection
+     * are not converted again on re-upload.
+     */
     KisOpenGLUpdateInfoSP buildUpdateInfo(const QRect& rect, KisImageSP srcImage, bool convertColorSpace);
-    KisOpenGLUpdateInfoSP buildUpdateInfo(const QRect& rect, KisPaintDeviceSP projection, const QRect &bounds, int levelOfDetail, bool convertColorSpace);
+
+    /**
+     * Builds the update for an arbitrary device. The conversion
+     * cache is used only when \p useConversionCache is set, there is
+     * no point in caching the temporary devices.
+     */
+    KisOpenGLUpdateInfoSP buildUpdateInfo(const QRect& rect, KisPaintDeviceSP projection, const QRect &bounds, int levelOfDetail, bool convertColorSpace, bool useConversionCache = false);
 
     QRect calculatePhysicalTileRect(int col, int row, const QRect &imageBounds, int levelOfDetail) const;
     QRect calculateEffectiveTileRect(int col, int row, const QRect &imageBounds) const;
@@ -158,7 +158,7 @@ public:
     ~KisTextureTileUpdateInfo() {
     }
 
-    void retrieveData(KisPaintDeviceSP projectionDevice, const QBitArray &channelFlags, bool onlyOneChannelSelected, int selectedChannelIndex)
+    void retrieveData(KisPaintDeviceSP projectionDevice, const QBitArray &channelFlags, bool onlyOneChannelSelected, int selectedChannelIndex, bool showSingleChannelAsColor)
     {
         m_patchColorSpace = projectionDevice->colorSpace();
         m_patchPixels.allocate(m_patchColorSpace->pixelSize());
@@ -170,50 +170,43 @@ public:
         // XXX: if the paint colorspace is rgb, we should do the channel swizzling in
         //      the display shader
         if (!channelFlags.isEmpty() && selectedChannelIndex >= 0 && selectedChannelIndex < m_patchColorSpace->channels().size()) {
-            DataBuffer conversionCache(m_patchColorSpace->pixelSize(), m_pool);
-
+            /**
+             * The channels are filtered right in the pooled buffer, every
+             * pixel is read before it is written, so no intermediate copy
+             * of the patch is needed
+             */
             QList<KoChannelInfo*> channelInfo = m_patchColorSpace->channels();
-            int channelSize = channelInfo[selectedChannelIndex]->size();
-            int pixelSize = m_patchColorSpace->pixelSize();
-            quint32 numPixels = m_patchRect.width() * m_patchRect.height();
+            const int channelSize = channelInfo[selectedChannelIndex]->size();
+            const int pixelSize = m_patchColorSpace->pixelSize();
+            const int channelCount = m_patchColorSpace->channelCount();
+            const quint32 numPixels = m_patchRect.width() * m_patchRect.height();
+            quint8 *pixel = m_patchPixels.data();
+
+            if (onlyOneChannelSelected && !showSingleChannelAsColor) {
+                const int selectedChannelPos = channelInfo[selectedChannelIndex]->pos();
 
-            KisConfig cfg(true);
+                quint8 selectedValue[sizeof(double)];
+                KIS_SAFE_ASSERT_RECOVER_RETURN(channelSize <= int(sizeof(selectedValue)));
 
-            if (onlyOneChannelSelected && !cfg.showSingleChannelAsColor()) {
-                int selectedChannelPos = channelInfo[selectedChannelIndex]->pos();
-                for (uint pixelIndex = 0; pixelIndex < numPixels; ++pixelIndex) {
-                    for (uint channelIndex = 0; channelIndex < m_patchColorSpace->channelCount(); ++channelIndex) {
+                for (quint32 pixelIndex = 0; pixelIndex < numPixels; ++pixelIndex, pixel += pixelSize) {
+                    memcpy(selectedValue, pixel + selectedChannelPos, channelSize);
 
+                    for (int channelIndex = 0; channelIndex < channelCount; ++channelIndex) {
                         if (channelInfo[channelIndex]->channelType() == KoChannelInfo::COLOR) {
-                            memcpy(conversionCache.data() + (pixelIndex * pixelSize) + (channelIndex * channelSize),
-                                   m_patchPixels.data() + (pixelIndex * pixelSize) + selectedChannelPos,
-                                   channelSize);
-                        }
-                        else if (channelInfo[channelIndex]->channelType() == KoChannelInfo::ALPHA) {
-                            memcpy(conversionCache.data() + (pixelIndex * pixelSize) + (channelIndex * channelSize),
-                                   m_patchPixels.data() + (pixelIndex * pixelSize) + (channelIndex * channelSize),
-                                   channelSize);
+                            memcpy(pixel + (channelIndex * channelSize), selectedValue, channelSize);
                         }
                     }
                 }
             }
             else {
-                for (uint pixelIndex = 0; pixelIndex < numPixels; ++pixelIndex) {
-                    for (uint channelIndex = 0; channelIndex < m_patchColorSpace->channelCount(); ++channelIndex) {
-                        if (channelFlags.testBit(channelIndex)) {
-                            memcpy(conversionCache.data() + (pixelIndex * pixelSize) + (channelIndex * channelSize),
-                                   m_patchPixels.data() + (pixelIndex * pixelSize) + (channelIndex * channelSize),
-                                   channelSize);
-                        }
-                        else {
-                            memset(conversionCache.data() + (pixelIndex * pixelSize) + (channelIndex * channelSize), 0, channelSize);
+                for (quint32 pixelIndex = 0; pixelIndex < numPixels; ++pixelIndex, pixel += pixelSize) {
+                    for (int channelIndex = 0; channelIndex < channelCount; ++channelIndex) {
+                        if (!channelFlags.testBit(channelIndex)) {
+                            memset(pixel + (channelIndex * channelSize), 0, channelSize);
                         }
                     }
                 }
-
             }
-
-            conversionCache.swap(m_patchPixels);
         }
 
     }
@@ -347,6 +340,10 @@ public:
         m_patchColorSpace = colorSpace;
     }
 
+    inline KisTextureTileInfoPoolSP pool() const {
+        return m_pool;
+    }
+
 private:
     Q_DISABLE_COPY(KisTextureTileUpdateInfo)
 
@@ -0,0 +1,110 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "KisAnimationCachePopulatorTest.h"
+
+#include <QTest>
+#include <QSignalSpy>
+#include <QOpenGLContext>
+#include <QOffscreenSurface>
+#include <testutil.h>
+
+#include "KisPart.h"
+#include "kis_config.h"
+#include "kis_image_config.h"
+#include "kis_animation_cache_populator.h"
+#include "kis_animation_frame_cache.h"
+#include "kis_image_animation_interface.h"
+#include "kis_keyframe_channel.h"
+#include "kis_time_range.h"
+#include "opengl/kis_opengl_image_textures.h"
+
+
+void KisAnimationCachePopulatorTest::testRegenerateOnClones()
+{
+    QOffscreenSurface surface;
+    surface.create();
+
+    QOpenGLContext context;
+    if (!context.create() || !context.makeCurrent(&surface)) {
+        QSKIP("OpenGL context is not available");
+    }
+
+    KisImageConfig imageCfg(false);
+    KisConfig cfg(false);
+
+    const int oldFrameRenderingClones = imageCfg.frameRenderingClones();
+    const bool oldCacheInBackground = cfg.calculateAnimationCacheInBackground();
+    const bool oldCacheInParallel = cfg.calculateAnimationCacheInParallel();
+
+    imageCfg.setFrameRenderingClones(3);
+    cfg.setCalculateAnimationCacheInBackground(true);
+    cfg.setCalculateAnimationCacheInParallel(true);
+
+    const int numFrames = 12;
+
+    TestUtil::MaskParent p(QRect(0,0,64,64));
+    KisImageSP image = p.image;
+
+    // every keyframe makes a separate frame the populator has to render
+    KisKeyframeChannel *channel = p.layer->getKeyframeChannel(KisKeyframeChannel::Content.id(), true);
+    for (int i = 0; i < numFrames; i++) {
+        channel->addKeyframe(i);
+    }
+    image->animationInterface()->setFullClipRange(KisTimeRange::fromTime(0, numFrames - 1));
+    image->waitForDone();
+
+    KisOpenGLImageTexturesSP textures =
+        KisOpenGLImageTextures::getImageTextures(image, 0,
+                                                 KoColorConversionTransformation::IntentPerceptual,
+                                                 KoColorConversionTransformation::Empty);
+    textures->initGL(context.functions());
+
+    KisAnimationFrameCacheSP cache = KisAnimationFrameCache::getFrameCache(textures);
+
+    // only the frames rendered on the original image are reported by it
+    QSignalSpy originalImageFrames(image->animationInterface(), SIGNAL(sigFrameReady(int)));
+
+    KisPart::instance()->cachePopulator()->slotRequestRegeneration();
+
+    auto numCachedFrames = [cache, numFrames] () {
+        int result = 0;
+        for (int i = 0; i < numFrames; i++) {
+            if (cache->frameStatus(i) == KisAnimationFrameCache::Cached) {
+                result++;
+            }
+        }
+        return result;
+    };
+
+    for (int i = 0; i < 300 && numCachedFrames() < numFrames; i++) {
+        QTest::qWait(100);
+    }
+
+    imageCfg.setFrameRenderingClones(oldFrameRenderingClones);
+    cfg.setCalculateAnimationCacheInBackground(oldCacheInBackground);
+    cfg.setCalculateAnimationCacheInParallel(oldCacheInParallel);
+
+    QCOMPARE(numCachedFrames(), numFrames);
+
+    const int numFramesOnClones = numFrames - originalImageFrames.count();
+    QVERIFY2(numFramesOnClones > 1,
+             qPrintable(QString("Only %1 frames were rendered on the clones").arg(numFramesOnClones)));
+}
+
+QTEST_MAIN(KisAnimationCachePopulatorTest)
@@ -0,0 +1,177 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "KisAnimationFramePrefetchTest.h"
+
+#include <QTest>
+#include <QOpenGLContext>
+#include <QOffscreenSurface>
+#include <testutil.h>
+
+#include <KoColor.h>
+#include "kis_image_config.h"
+#include "kis_animation_frame_cache.h"
+#include "kis_image_animation_interface.h"
+#include "kis_keyframe_channel.h"
+#include "kis_time_range.h"
+#include "kis_update_info.h"
+#include "opengl/kis_opengl_image_textures.h"
+#include "opengl/kis_texture_tile_update_info.h"
+
+
+bool compareFrameData(KisOpenGLUpdateInfoSP info1, KisOpenGLUpdateInfoSP info2)
+{
+    KIS_COMPARE_RF(bool(info1), true);
+    KIS_COMPARE_RF(bool(info2), true);
+    KIS_COMPARE_RF(info1->dirtyImageRect(), info2->dirtyImageRect());
+    KIS_COMPARE_RF(info1->levelOfDetail(), info2->levelOfDetail());
+    KIS_COMPARE_RF(info1->tileList.size(), info2->tileList.size());
+
+    for (int i = 0; i < info1->tileList.size(); i++) {
+        KisTextureTileUpdateInfoSP tile1 = info1->tileList[i];
+        KisTextureTileUpdateInfoSP tile2 = info2->tileList[i];
+
+        KIS_COMPARE_RF(tile1->tileCol(), tile2->tileCol());
+        KIS_COMPARE_RF(tile1->tileRow(), tile2->tileRow());
+        KIS_COMPARE_RF(tile1->realPatchRect(), tile2->realPatchRect());
+        KIS_COMPARE_RF(tile1->pixelSize(), tile2->pixelSize());
+
+        const QRect rc = tile1->realPatchRect();
+        const int numBytes = rc.width() * rc.height() * tile1->pixelSize();
+
+        if (memcmp(tile1->data(), tile2->data(), numBytes) != 0) {
+            qWarning() << "Tile pixels differ:" << ppVar(tile1->tileCol()) << ppVar(tile1->tileRow());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void paintFrame(TestUtil::MaskParent &p, int time, const QColor &color)
+{
+    p.image->animationInterface()->switchCurrentTimeAsync(time);
+    p.image->waitForDone();
+
+    KisPaintDeviceSP dev = p.layer->paintDevice();
+    dev->clear();
+    dev->fill(QRect(time * 10, 20, 300, 200), KoColor(color, p.image->colorSpace()));
+    p.layer->setDirty();
+    p.image->waitForDone();
+}
+
+KisOpenGLUpdateInfoSP cacheFrame(KisAnimationFrameCacheSP cache, KisImageSP image, int time)
+{
+    image->animationInterface()->switchCurrentTimeAsync(time);
+    image->waitForDone();
+
+    KisOpenGLUpdateInfoSP info = cache->fetchFrameData(time, image, image->bounds());
+    cache->addConvertedFrameData(info, time);
+
+    return info;
+}
+
+void KisAnimationFramePrefetchTest::testPrefetchedFrames()
+{
+    QOffscreenSurface surface;
+    surface.create();
+
+    QOpenGLContext context;
+    if (!context.create() || !context.makeCurrent(&surface)) {
+        QSKIP("OpenGL context is not available");
+    }
+
+    /**
+     * The compressed swapper decodes the difference frames against the
+     * last loaded keyframe, which is the state the prefetching thread
+     * shares with the synchronous loading.
+     */
+    KisImageConfig cfg(false);
+    const bool oldOnDiskSwapping = cfg.useOnDiskAnimationCacheSwapping();
+    const bool oldCompressedCache = cfg.useCompressedAnimationCache();
+    cfg.setUseOnDiskAnimationCacheSwapping(false);
+    cfg.setUseCompressedAnimationCache(true);
+
+    TestUtil::MaskParent p(QRect(0,0,512,300));
+    KisImageSP image = p.image;
+
+    KisKeyframeChannel *channel = p.layer->getKeyframeChannel(KisKeyframeChannel::Content.id(), true);
+    channel->addKeyframe(5);
+    channel->addKeyframe(10);
+    image->animationInterface()->setFullClipRange(KisTimeRange::fromTime(0, 14));
+
+    paintFrame(p, 0, Qt::red);
+    paintFrame(p, 5, Qt::green);
+    paintFrame(p, 10, Qt::blue);
+
+    KisOpenGLImageTexturesSP textures =
+        KisOpenGLImageTextures::getImageTextures(image, 0,
+                                                 KoColorConversionTransformation::IntentPerceptual,
+                                                 KoColorConversionTransformation::Empty);
+    textures->initGL(context.functions());
+
+    // the swapper is chosen when the cache is created
+    KisAnimationFrameCacheSP cache = new KisAnimationFrameCache(textures);
+
+    cfg.setUseOnDiskAnimationCacheSwapping(oldOnDiskSwapping);
+    cfg.setUseCompressedAnimationCache(oldCompressedCache);
+
+    const QVector<int> keyframes({0, 5, 10});
+    QMap<int, KisOpenGLUpdateInfoSP> renderedFrames;
+
+    Q_FOREACH (int time, keyframes) {
+        renderedFrames[time] = cacheFrame(cache, image, time);
+    }
+
+    // the prefetched frames match the data loaded synchronously
+    cache->prefetchFrames({2, 7, 12});
+
+    Q_FOREACH (int time, keyframes) {
+        QVERIFY(cache->frameIsPrefetched(time));
+
+        KisOpenGLUpdateInfoSP prefetchedInfo = cache->frameData(time);
+        QVERIFY(!cache->frameIsPrefetched(time));
+
+        KisOpenGLUpdateInfoSP loadedInfo = cache->frameData(time);
+
+        QVERIFY(compareFrameData(prefetchedInfo, loadedInfo));
+        QVERIFY(compareFrameData(prefetchedInfo, renderedFrames[time]));
+    }
+
+    // the frames prefetched before the change are not returned after it
+    cache->prefetchFrames({0, 5, 10});
+    QVERIFY(cache->frameIsPrefetched(5));
+
+    paintFrame(p, 5, Qt::yellow);
+    QTest::qWait(100);
+
+    QCOMPARE(cache->frameStatus(5), KisAnimationFrameCache::Uncached);
+    QVERIFY(cache->frameIsPrefetched(0));
+    QVERIFY(cache->frameIsPrefetched(10));
+
+    renderedFrames[5] = cacheFrame(cache, image, 5);
+    QVERIFY(!cache->frameIsPrefetched(5));
+
+    cache->prefetchFrames({5});
+    QVERIFY(cache->frameIsPrefetched(5));
+    QVERIFY(!cache->frameIsPrefetched(0));
+
+    QVERIFY(compareFrameData(cache->frameData(5), renderedFrames[5]));
+}
+
+QTEST_MAIN(KisAnimationFramePrefetchTest)
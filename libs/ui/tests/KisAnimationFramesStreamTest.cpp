@@ -0,0 +1,224 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "KisAnimationFramesStreamTest.h"
+
+#include <QTest>
+#include <algorithm>
+#include <QFile>
+#include <QThread>
+#include <QTemporaryDir>
+#include <QStandardPaths>
+
+#include <KoColor.h>
+#include <KoColorSpace.h>
+#include <KoColorSpaceRegistry.h>
+#include <KoColorModelStandardIds.h>
+
+#include "kis_paint_device.h"
+#include "kis_time_range.h"
+#include "KisAnimationFramesStream.h"
+#include "KisAsyncAnimationFramesStreamingRenderer.h"
+
+namespace {
+
+QByteArray frameData(int frame)
+{
+    return QByteArray(16, char('a' + frame));
+}
+
+QByteArray readAll(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QFile::ReadOnly)) return QByteArray();
+    return file.readAll();
+}
+
+/**
+ * 'cat' writes the frames it gets on its standard input into the
+ * log file of the stream, so we can check what the process received
+ */
+QString catProgram()
+{
+    return QStandardPaths::findExecutable("cat");
+}
+
+struct PushFrameThread : public QThread
+{
+    PushFrameThread(KisAnimationFramesStream *_stream, int _frame)
+        : stream(_stream), frame(_frame) {}
+
+    void run() override {
+        stream->pushFrame(frame, frameData(frame));
+    }
+
+    KisAnimationFramesStream *stream;
+    int frame;
+};
+
+}
+
+void KisAnimationFramesStreamTest::testInOrderDelivery()
+{
+    const QString program = catProgram();
+    if (program.isEmpty()) {
+        QSKIP("'cat' is not available");
+    }
+
+    QTemporaryDir dir;
+    const QString outputPath = dir.path() + "/output.raw";
+
+    KisAnimationFramesStream stream(KisTimeRange::fromTime(0, 7), 10);
+    QVERIFY(stream.start(program, QStringList(), outputPath));
+
+    stream.pushFrame(3, frameData(3));
+    stream.pushFrame(1, frameData(1));
+    stream.pushFrame(4, frameData(4));
+    stream.pushFrame(0, frameData(0));
+    stream.pushFrame(2, frameData(2));
+
+    // the copies are written with the content of the frame they copy
+    stream.pushFrame(5, frameData(5), QVector<int>() << 6 << 7);
+
+    QVERIFY(stream.finish());
+
+    QByteArray expected;
+    for (int i = 0; i <= 5; i++) {
+        expected += frameData(i);
+    }
+    expected += frameData(5);
+    expected += frameData(5);
+
+    QCOMPARE(readAll(outputPath), expected);
+    QCOMPARE(stream.bytesWritten(), qint64(expected.size()));
+}
+
+void KisAnimationFramesStreamTest::testBlockingOnPendingFrames()
+{
+    const QString program = catProgram();
+    if (program.isEmpty()) {
+        QSKIP("'cat' is not available");
+    }
+
+    QTemporaryDir dir;
+    const QString outputPath = dir.path() + "/output.raw";
+
+    KisAnimationFramesStream stream(KisTimeRange::fromTime(0, 3), 2);
+    QVERIFY(stream.start(program, QStringList(), outputPath));
+
+    stream.pushFrame(1, frameData(1));
+    stream.pushFrame(2, frameData(2));
+
+    // two frames are already waiting for frame 0
+    PushFrameThread thread(&stream, 3);
+    thread.start();
+
+    QTest::qWait(300);
+    QVERIFY(!thread.isFinished());
+
+    // the frame the writer is waiting for is never blocked
+    stream.pushFrame(0, frameData(0));
+
+    QVERIFY(thread.wait(5000));
+    QVERIFY(stream.finish());
+
+    QByteArray expected;
+    for (int i = 0; i <= 3; i++) {
+        expected += frameData(i);
+    }
+
+    QCOMPARE(readAll(outputPath), expected);
+}
+
+void KisAnimationFramesStreamTest::testProcessFailure()
+{
+    {
+        KisAnimationFramesStream stream(KisTimeRange::fromTime(0, 3), 2);
+        QVERIFY(!stream.start("krita-nonexistent-program", QStringList(), QString()));
+    }
+
+    const QString program = catProgram();
+    if (program.isEmpty()) {
+        QSKIP("'cat' is not available");
+    }
+
+    QTemporaryDir dir;
+    const QString outputPath = dir.path() + "/output.raw";
+
+    // 'cat' exits with an error without reading the frames
+    KisAnimationFramesStream stream(KisTimeRange::fromTime(0, 3), 1);
+    QVERIFY(stream.start(program, QStringList() << dir.path() + "/nonexistent/file", outputPath));
+
+    for (int i = 0; i <= 3; i++) {
+        stream.pushFrame(i, frameData(i));
+    }
+
+    QVERIFY(!stream.finish());
+
+    // the failed stream never blocks the rendering threads
+    PushFrameThread thread(&stream, 3);
+    thread.start();
+    QVERIFY(thread.wait(5000));
+}
+
+void KisAnimationFramesStreamTest::testConvertFrameKeepsProfile()
+{
+    const KoColorProfile *linearProfile =
+        KoColorSpaceRegistry::instance()->profileByName("sRGB-elle-V2-g10.icc");
+
+    if (!linearProfile) {
+        QSKIP("The linear sRGB profile is not available");
+    }
+
+    const KoColorSpace *cs =
+        KoColorSpaceRegistry::instance()->colorSpace(RGBAColorModelID.id(),
+                                                     Integer8BitsColorDepthID.id(),
+                                                     linearProfile);
+
+    const QRect rc(0, 0, 4, 4);
+
+    // the pixels of RGBA color spaces are stored as BGRA
+    KoColor color(cs);
+    color.data()[0] = 32;
+    color.data()[1] = 64;
+    color.data()[2] = 128;
+    color.data()[3] = 255;
+
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+    dev->fill(rc, color);
+
+    // the values are not converted into sRGB
+    const QByteArray data = KisAsyncAnimationFramesStreamingRenderer::convertFrame(dev, rc);
+    QCOMPARE(data.size(), rc.width() * rc.height() * 4);
+
+    const quint8 *pixel = reinterpret_cast<const quint8*>(data.constData());
+    quint8 bgra[4];
+
+    if (QSysInfo::ByteOrder == QSysInfo::LittleEndian) {
+        std::copy(pixel, pixel + 4, bgra);
+    } else {
+        std::reverse_copy(pixel, pixel + 4, bgra);
+    }
+
+    QCOMPARE(int(bgra[0]), 32);
+    QCOMPARE(int(bgra[1]), 64);
+    QCOMPARE(int(bgra[2]), 128);
+    QCOMPARE(int(bgra[3]), 255);
+}
+
+QTEST_MAIN(KisAnimationFramesStreamTest)
@@ -0,0 +1,68 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "KisAnimationPlaybackStatisticsTest.h"
+
+#include "canvas/KisAnimationPlaybackStatistics.h"
+
+
+void KisAnimationPlaybackStatisticsTest::testDroppedFrames()
+{
+    KisAnimationPlaybackStatistics stats;
+
+    stats.registerFrame(1, 1000, true);
+    stats.registerFrame(1, 1000, true);
+    stats.registerFrame(3, 1000, false);
+    stats.registerFrame(0, 1000, false);
+    stats.registerFrame(2, 1000, true);
+
+    QCOMPARE(stats.framesShown(), 5);
+    QCOMPARE(stats.framesDropped(), 3);
+    QCOMPARE(stats.framesPrefetched(), 3);
+}
+
+void KisAnimationPlaybackStatisticsTest::testLatency()
+{
+    KisAnimationPlaybackStatistics stats;
+
+    QCOMPARE(stats.averageLatency(), 0.0);
+    QCOMPARE(stats.maxLatency(), 0.0);
+
+    stats.registerFrame(1, 2000, false);
+    stats.registerFrame(1, 10000, false);
+    stats.registerFrame(1, 3000, false);
+
+    QCOMPARE(stats.averageLatency(), 5.0);
+    QCOMPARE(stats.maxLatency(), 10.0);
+}
+
+void KisAnimationPlaybackStatisticsTest::testReset()
+{
+    KisAnimationPlaybackStatistics stats;
+
+    stats.registerFrame(4, 5000, true);
+    stats.reset();
+
+    QCOMPARE(stats.framesShown(), 0);
+    QCOMPARE(stats.framesDropped(), 0);
+    QCOMPARE(stats.framesPrefetched(), 0);
+    QCOMPARE(stats.averageLatency(), 0.0);
+    QCOMPARE(stats.maxLatency(), 0.0);
+}
+
+QTEST_MAIN(KisAnimationPlaybackStatisticsTest)
@@ -100,6 +100,33 @@ bool compareUpdateInfo(KisOpenGLUpdateInfoSP info1, KisOpenGLUpdateInfoSP info2)
 }
 
 
+void initUpdateInfoBuilder(KisOpenGLUpdateInfoBuilder &builder, KisTextureTileInfoPoolSP pool)
+{
+    builder.setTextureInfoPool(pool);
+
+    const KoColorSpace *dstColorSpace = KoColorSpaceRegistry::instance()->rgb8();
+    builder.setConversionOptions(
+        ConversionOptions(dstColorSpace,
+                          KoColorConversionTransformation::internalRenderingIntent(),
+                          KoColorConversionTransformation::internalConversionFlags()));
+
+    // TODO: refactor setting texture size in raw values!
+    builder.setTextureBorder(8);
+    builder.setEffectiveTextureSize(QSize(256 - 16, 256 - 16));
+}
+
+qint64 rawFrameSize(KisOpenGLUpdateInfoSP info)
+{
+    qint64 size = 0;
+
+    Q_FOREACH (KisTextureTileUpdateInfoSP tile, info->tileList) {
+        const QRect rc = tile->realPatchRect();
+        size += qint64(rc.width()) * rc.height() * tile->pixelSize();
+    }
+
+    return size;
+}
+
 class TestFramesRenderer : public KisAsyncAnimationRendererBase
 {
     Q_OBJECT
@@ -108,17 +135,7 @@ public:
     TestFramesRenderer()
         : m_pool(m_poolRegistry.getPool(maxTileSize, maxTileSize))
     {
-        m_updateInfoBuilder.setTextureInfoPool(m_pool);
-
-        const KoColorSpace *dstColorSpace = KoColorSpaceRegistry::instance()->rgb8();
-        m_updateInfoBuilder.setConversionOptions(
-            ConversionOptions(dstColorSpace,
-                              KoColorConversionTransformation::internalRenderingIntent(),
-                              KoColorConversionTransformation::internalConversionFlags()));
-
-        // TODO: refactor setting texture size in raw values!
-        m_updateInfoBuilder.setTextureBorder(8);
-        m_updateInfoBuilder.setEffectiveTextureSize(QSize(256 - 16, 256 - 16));
+        initUpdateInfoBuilder(m_updateInfoBuilder, m_pool);
 
         connect(this, SIGNAL(sigCompleteRegenerationInternal(int)), SLOT(notifyFrameCompleted(int)));
         connect(this, SIGNAL(sigCancelRegenerationInternal(int)), SLOT(notifyFrameCancelled(int)));
@@ -192,6 +209,62 @@ void KisFrameCacheStoreTest::test()
 
 }
 
+void KisFrameCacheStoreTest::testTotalDataSize()
+{
+    QRect refRect(QRect(0,0,512,512));
+    TestUtil::MaskParent p(refRect);
+    const KoColor fillColor(Qt::red, p.image->colorSpace());
+    const KoColor changeColor(Qt::blue, p.image->colorSpace());
+
+    KisTextureTileInfoPoolRegistry poolRegistry;
+    KisOpenGLUpdateInfoBuilder builder;
+    initUpdateInfoBuilder(builder, poolRegistry.getPool(maxTileSize, maxTileSize));
+
+    p.layer->paintDevice()->fill(QRect(100,100,300,300), fillColor);
+    p.image->initialRefreshGraph();
+
+    KisFrameCacheStore store(KisFrameDataSerializer::InMemoryStorage, QString());
+    QCOMPARE(store.totalDataSize(), qint64(0));
+
+    const qint64 rawSize = rawFrameSize(builder.buildUpdateInfo(p.image->bounds(), p.image, true));
+    QVERIFY(rawSize > 0);
+
+    // the full frame is counted with its uncompressed copy
+    store.saveFrame(0, builder.buildUpdateInfo(p.image->bounds(), p.image, true), p.image->bounds());
+    const qint64 fullFrameSize = store.totalDataSize();
+    QVERIFY(fullFrameSize > rawSize);
+
+    // the copy frame takes no space
+    store.saveFrame(1, builder.buildUpdateInfo(p.image->bounds(), p.image, true), p.image->bounds());
+    QCOMPARE(store.totalDataSize(), fullFrameSize);
+
+    // the difference frame takes space for the difference only
+    p.layer->paintDevice()->fill(QRect(150,150,100,100), changeColor);
+    p.layer->setDirty(QRect(150,150,100,100));
+    p.image->waitForDone();
+
+    store.saveFrame(2, builder.buildUpdateInfo(p.image->bounds(), p.image, true), p.image->bounds());
+    const qint64 withDiffSize = store.totalDataSize();
+    QVERIFY(withDiffSize > fullFrameSize);
+    QVERIFY(withDiffSize < fullFrameSize + rawSize / 2);
+
+    // loading the difference frame caches its uncompressed keyframe
+    store.loadFrame(2, builder);
+    QCOMPARE(store.totalDataSize(), withDiffSize + rawSize);
+
+    // forgetting the keyframe frees only its uncompressed copy, its data
+    // is still used by the dependent frames
+    store.forgetFrame(0);
+    QCOMPARE(store.totalDataSize(), withDiffSize);
+
+    store.forgetFrame(1);
+    QCOMPARE(store.totalDataSize(), withDiffSize);
+
+    // the last dependent frame releases everything
+    store.forgetFrame(2);
+    QCOMPARE(store.totalDataSize(), qint64(0));
+}
+
 QTEST_MAIN(KisFrameCacheStoreTest)
 
 #include "KisFrameCacheStoreTest.moc"
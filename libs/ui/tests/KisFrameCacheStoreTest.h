@@ -25,6 +25,7 @@ class KisFrameCacheStoreTest : public QObject
     Q_OBJECT
 private Q_SLOTS:
     void test();
+    void testTotalDataSize();
 };
 
 #endif // KISFRAMECACHESTORETEST_H
@@ -79,13 +79,23 @@ bool verifyTestFrame(int frameSeed, const KisFrameDataSerializer::Frame &frame)
 
 
 
+void KisFrameSerializerTest::testFrameDataSerialization_data()
+{
+    QTest::addColumn<int>("storageType");
+
+    QTest::newRow("on-disk") << int(KisFrameDataSerializer::OnDiskStorage);
+    QTest::newRow("in-memory") << int(KisFrameDataSerializer::InMemoryStorage);
+}
+
 void KisFrameSerializerTest::testFrameDataSerialization()
 {
+    QFETCH(int, storageType);
+
     KisTextureTileInfoPoolRegistry poolRegistry;
     KisTextureTileInfoPoolSP pool = poolRegistry.getPool(maxTileSize, maxTileSize);
 
 
-    KisFrameDataSerializer serializer;
+    KisFrameDataSerializer serializer(KisFrameDataSerializer::StorageType(storageType), QString());
 
     KisFrameDataSerializer::Frame testFrame1 = generateTestFrame(2, pool);
     KisFrameDataSerializer::Frame testFrame2 = generateTestFrame(3, pool);
@@ -115,6 +125,10 @@ void KisFrameSerializerTest::testFrameDataSerialization()
     QVERIFY(verifyTestFrame(3, serializer.loadFrame(testFrameId2, pool)));
     QVERIFY(verifyTestFrame(503, serializer.loadFrame(testFrameId3, pool)));
 
+    // the size of the stored data is known for every frame
+    QVERIFY(serializer.frameDataSize(testFrameId3) > 0);
+    QVERIFY(serializer.frameDataSize(testFrameId3) < 100 * maxTileSize * maxTileSize * 4);
+
     serializer.forgetFrame(testFrameId2);
     QCOMPARE(serializer.hasFrame(testFrameId1), true);
     QCOMPARE(serializer.hasFrame(testFrameId2), false);
@@ -0,0 +1,178 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_canvas_updates_compressor_test.h"
+
+#include "canvas/kis_canvas_updates_compressor.h"
+
+
+class TestUpdateInfo : public KisUpdateInfo
+{
+public:
+    TestUpdateInfo(const QRect &rc, int lod = 0)
+        : m_rect(rc),
+          m_levelOfDetail(lod)
+    {
+    }
+
+    QRect dirtyImageRect() const override {
+        return m_rect;
+    }
+
+    int levelOfDetail() const override {
+        return m_levelOfDetail;
+    }
+
+private:
+    QRect m_rect;
+    int m_levelOfDetail;
+};
+
+namespace {
+QVector<QRect> rects(const QVector<KisUpdateInfoSP> &infos)
+{
+    QVector<QRect> result;
+    Q_FOREACH (KisUpdateInfoSP info, infos) {
+        result << info->dirtyImageRect();
+    }
+    return result;
+}
+}
+
+void KisCanvasUpdatesCompressorTest::testCompression()
+{
+    KisCanvasUpdatesCompressor compressor;
+
+    QVERIFY(compressor.putUpdateInfo(new TestUpdateInfo(QRect(0,0,10,10))));
+    QVERIFY(!compressor.putUpdateInfo(new TestUpdateInfo(QRect(20,0,10,10))));
+
+    // contains the first update, which should be dropped
+    QVERIFY(!compressor.putUpdateInfo(new TestUpdateInfo(QRect(0,0,15,15))));
+
+    QVector<KisUpdateInfoSP> infos;
+    QCOMPARE(compressor.takeUpdateInfos(infos), 0);
+
+    QCOMPARE(rects(infos), QVector<QRect>() << QRect(20,0,10,10) << QRect(0,0,15,15));
+    QVERIFY(!compressor.hasUpdates());
+
+    // the next update should request processing again
+    QVERIFY(compressor.putUpdateInfo(new TestUpdateInfo(QRect(0,0,10,10))));
+}
+
+void KisCanvasUpdatesCompressorTest::testTakeAll()
+{
+    KisCanvasUpdatesCompressor compressor;
+
+    compressor.putUpdateInfo(new TestUpdateInfo(QRect(0,0,10,10)));
+    compressor.putUpdateInfo(new TestUpdateInfo(QRect(100,0,10,10)));
+
+    QVector<KisUpdateInfoSP> infos;
+    QCOMPARE(compressor.takeUpdateInfos(infos, QRect()), 0);
+    QCOMPARE(infos.size(), 2);
+}
+
+void KisCanvasUpdatesCompressorTest::testTakeVisible()
+{
+    KisCanvasUpdatesCompressor compressor;
+    const QRect viewport(0,0,50,50);
+
+    compressor.putUpdateInfo(new TestUpdateInfo(QRect(100,0,10,10)));
+    compressor.putUpdateInfo(new TestUpdateInfo(QRect(0,0,10,10)));
+    compressor.putUpdateInfo(new TestUpdateInfo(QRect(200,0,10,10)));
+    compressor.putUpdateInfo(new TestUpdateInfo(QRect(40,40,20,20)));
+
+    QVector<KisUpdateInfoSP> infos;
+    QCOMPARE(compressor.takeUpdateInfos(infos, viewport), 2);
+    QCOMPARE(rects(infos), QVector<QRect>() << QRect(0,0,10,10) << QRect(40,40,20,20));
+    QVERIFY(compressor.hasUpdates());
+
+    // the postponed updates don't block the new requests
+    QVERIFY(compressor.putUpdateInfo(new TestUpdateInfo(QRect(10,10,10,10))));
+
+    infos.clear();
+    QCOMPARE(compressor.takeUpdateInfos(infos), 0);
+    QCOMPARE(rects(infos), QVector<QRect>()
+             << QRect(100,0,10,10) << QRect(200,0,10,10) << QRect(10,10,10,10));
+}
+
+void KisCanvasUpdatesCompressorTest::testOverlappingUpdatesKeepOrder()
+{
+    KisCanvasUpdatesCompressor compressor;
+    const QRect viewport(0,0,50,50);
+
+    compressor.putUpdateInfo(new TestUpdateInfo(QRect(100,0,20,20)));
+    compressor.putUpdateInfo(new TestUpdateInfo(QRect(300,0,10,10)));
+    compressor.putUpdateInfo(new TestUpdateInfo(QRect(40,0,70,10)));
+
+    /**
+     * The visible update overwrites a part of the first invisible one,
+     * so the latter cannot be postponed
+     */
+    QVector<KisUpdateInfoSP> infos;
+    QCOMPARE(compressor.takeUpdateInfos(infos, viewport), 1);
+    QCOMPARE(rects(infos), QVector<QRect>() << QRect(100,0,20,20) << QRect(40,0,70,10));
+}
+
+void KisCanvasUpdatesCompressorTest::testLevelOfDetail()
+{
+    KisCanvasUpdatesCompressor compressor;
+    const QRect viewport(0,0,50,50);
+
+    compressor.putUpdateInfo(new TestUpdateInfo(QRect(100,0,10,10), 0));
+    compressor.putUpdateInfo(new TestUpdateInfo(QRect(200,0,10,10), 1));
+    compressor.putUpdateInfo(new TestUpdateInfo(QRect(300,0,10,10), 0));
+
+    /**
+     * The scaled update is always taken, and it cannot be reordered
+     * with the older update of a different level of detail
+     */
+    QVector<KisUpdateInfoSP> infos;
+    QCOMPARE(compressor.takeUpdateInfos(infos, viewport), 1);
+    QCOMPARE(rects(infos), QVector<QRect>() << QRect(100,0,10,10) << QRect(200,0,10,10));
+}
+
+void KisCanvasUpdatesCompressorTest::testClearOnImageResize()
+{
+    KisCanvasUpdatesCompressor compressor;
+    const QRect viewport(0,0,50,50);
+
+    compressor.putUpdateInfo(new TestUpdateInfo(QRect(0,0,10,10)));
+    compressor.putUpdateInfo(new TestUpdateInfo(QRect(200,200,64,64)));
+    compressor.putUpdateInfo(new TestUpdateInfo(QRect(300,0,64,64)));
+
+    QVector<KisUpdateInfoSP> infos;
+    QCOMPARE(compressor.takeUpdateInfos(infos, viewport), 2);
+    QCOMPARE(rects(infos), QVector<QRect>() << QRect(0,0,10,10));
+
+    /**
+     * The image is cropped to 100x100 while the offscreen updates are
+     * postponed. They are outside the new bounds, so they must never
+     * reach the canvas.
+     */
+    compressor.clear();
+    QVERIFY(!compressor.hasUpdates());
+
+    // the update of the whole cropped image requests processing as usual
+    QVERIFY(compressor.putUpdateInfo(new TestUpdateInfo(QRect(0,0,100,100))));
+
+    infos.clear();
+    QCOMPARE(compressor.takeUpdateInfos(infos, viewport), 0);
+    QCOMPARE(rects(infos), QVector<QRect>() << QRect(0,0,100,100));
+}
+
+QTEST_MAIN(KisCanvasUpdatesCompressorTest)
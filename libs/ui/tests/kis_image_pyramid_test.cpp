@@ -0,0 +1,360 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_image_pyramid_test.h"
+
+#include <KoColorSpaceRegistry.h>
+
+#include "kis_image.h"
+#include "kis_group_layer.h"
+#include "kis_paint_layer.h"
+#include "kis_paint_device.h"
+#include "canvas/kis_image_pyramid.h"
+#include "canvas/kis_update_info.h"
+#include "canvas/kis_coordinates_converter.h"
+#include "canvas/kis_prescaled_projection.h"
+
+
+namespace {
+
+QByteArray randomBytes(int size, quint32 seed)
+{
+    QByteArray bytes(size, 0);
+
+    for (int i = 0; i < size; i++) {
+        seed = seed * 1103515245 + 12345;
+        bytes[i] = char(seed >> 16);
+    }
+
+    return bytes;
+}
+
+/**
+ * The per-channel implementation the pyramid used before the
+ * whole-pixel one, the results should be exactly the same
+ */
+void referenceDownsamplePixels(const quint8 *srcRow0, const quint8 *srcRow1,
+                               quint8 *dstRow, qint32 numSrcPixels)
+{
+    const int pixelSize = 4;
+
+    for (qint32 i = 0; i < numSrcPixels / 2; i++) {
+        for (int ch = 0; ch < pixelSize; ch++) {
+            const int sum =
+                srcRow0[ch] + srcRow1[ch] +
+                srcRow0[ch + pixelSize] + srcRow1[ch + pixelSize];
+
+            dstRow[ch] = sum / 4;
+        }
+
+        dstRow += pixelSize;
+        srcRow0 += 2 * pixelSize;
+        srcRow1 += 2 * pixelSize;
+    }
+}
+
+/**
+ * Paints opaque noise into \p rc of the layer and waits until the
+ * projection of the image is updated
+ */
+void paintNoise(KisImageSP image, KisPaintLayerSP layer, const QRect &rc, quint32 seed)
+{
+    const int pixelSize = layer->paintDevice()->pixelSize();
+
+    QByteArray bytes = randomBytes(rc.width() * rc.height() * pixelSize, seed);
+    for (int i = pixelSize - 1; i < bytes.size(); i += pixelSize) {
+        bytes[i] = char(0xFF);
+    }
+
+    layer->paintDevice()->writeBytes((const quint8*)bytes.constData(), rc);
+    layer->setDirty(rc);
+    image->waitForDone();
+}
+
+KisImageSP createNoiseImage(const QRect &imageRect, KisPaintLayerSP &layer)
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+
+    KisImageSP image = new KisImage(0, imageRect.width(), imageRect.height(), cs, "pyramid test");
+    image->setResolution(100, 100);
+
+    layer = new KisPaintLayer(image, "paint1", OPACITY_OPAQUE_U8, cs);
+    image->addNode(layer, image->root());
+    paintNoise(image, layer, imageRect, 4);
+
+    return image;
+}
+
+QList<QRect> strokeRects(int offset)
+{
+    // odd positions and sizes, so that the rects are aligned by the planes
+    QList<QRect> rects;
+    rects << QRect(13 + offset, 7, 41, 33);
+    rects << QRect(101, 55 + offset, 3, 1);
+    rects << QRect(250, 150, 49 - offset, 51);
+    rects << QRect(offset, 0, 1, 1);
+    return rects;
+}
+
+}
+
+void KisImagePyramidTest::testDownsamplePixels()
+{
+    const int pixelSize = 4;
+    const int maxSrcPixels = 66;
+
+    // the maximum and minimum values check that the lanes do not overflow
+    QByteArray extremes(maxSrcPixels * pixelSize, char(0xFF));
+    for (int i = 0; i < extremes.size(); i += 3) {
+        extremes[i] = 0;
+    }
+
+    QList<QByteArray> rows;
+    rows << randomBytes(maxSrcPixels * pixelSize, 1);
+    rows << randomBytes(maxSrcPixels * pixelSize, 2);
+    rows << QByteArray(maxSrcPixels * pixelSize, char(0xFF));
+    rows << extremes;
+
+    for (int numSrcPixels = 2; numSrcPixels <= maxSrcPixels; numSrcPixels += 2) {
+        for (int i = 0; i < rows.size(); i++) {
+            const QByteArray &row0 = rows[i];
+            const QByteArray &row1 = rows[(i + 1) % rows.size()];
+
+            // one extra pixel checks that nothing is written past the end
+            const int dstSize = (numSrcPixels / 2 + 1) * pixelSize;
+            QByteArray dst(dstSize, char(0x5A));
+            QByteArray expected(dstSize, char(0x5A));
+
+            KisImagePyramid::downsamplePixels((const quint8*)row0.constData(),
+                                              (const quint8*)row1.constData(),
+                                              (quint8*)dst.data(), numSrcPixels);
+
+            referenceDownsamplePixels((const quint8*)row0.constData(),
+                                      (const quint8*)row1.constData(),
+                                      (quint8*)expected.data(), numSrcPixels);
+
+            QCOMPARE(dst, expected);
+        }
+    }
+}
+
+void KisImagePyramidTest::testDownsampleByFactor2_data()
+{
+    QTest::addColumn<QRect>("srcRect");
+
+    QTest::newRow("even") << QRect(0, 0, 300, 460);
+    QTest::newRow("odd-size") << QRect(2, 4, 301, 461);
+    QTest::newRow("odd-origin") << QRect(3, 5, 300, 460);
+    QTest::newRow("odd-both") << QRect(3, 5, 301, 461);
+    QTest::newRow("single-pixel") << QRect(7, 9, 1, 1);
+    QTest::newRow("two-pixels-odd-origin") << QRect(7, 9, 2, 2);
+}
+
+void KisImagePyramidTest::testDownsampleByFactor2()
+{
+    QFETCH(QRect, srcRect);
+
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    const int pixelSize = cs->pixelSize();
+
+    KisPaintDeviceSP src = new KisPaintDevice(cs);
+    KisPaintDeviceSP dst = new KisPaintDevice(cs);
+
+    const QByteArray srcBytes = randomBytes(srcRect.width() * srcRect.height() * pixelSize, 3);
+    src->writeBytes((const quint8*)srcBytes.constData(), srcRect);
+
+    // every source pixel, including the last column and row, should be covered
+    const QRect expectedDstRect(QPoint(srcRect.left() / 2, srcRect.top() / 2),
+                                QPoint(srcRect.right() / 2, srcRect.bottom() / 2));
+
+    KisImagePyramid pyramid(1);
+    const QRect dstRect = pyramid.downsampleByFactor2(srcRect, src.data(), dst.data());
+    QCOMPARE(dstRect, expectedDstRect);
+
+    /**
+     * Calculate the expected result from the aligned source rect, the
+     * pixels outside srcRect are transparent black
+     */
+    const QRect alignedSrcRect(2 * expectedDstRect.x(), 2 * expectedDstRect.y(),
+                               2 * expectedDstRect.width(), 2 * expectedDstRect.height());
+
+    QByteArray alignedSrc(alignedSrcRect.width() * alignedSrcRect.height() * pixelSize, 0);
+    src->readBytes((quint8*)alignedSrc.data(), alignedSrcRect);
+
+    const int srcRowSize = alignedSrcRect.width() * pixelSize;
+    const int dstRowSize = expectedDstRect.width() * pixelSize;
+
+    QByteArray expected(dstRowSize * expectedDstRect.height(), 0);
+    for (int row = 0; row < expectedDstRect.height(); row++) {
+        referenceDownsamplePixels((const quint8*)alignedSrc.constData() + 2 * row * srcRowSize,
+                                  (const quint8*)alignedSrc.constData() + (2 * row + 1) * srcRowSize,
+                                  (quint8*)expected.data() + row * dstRowSize,
+                                  alignedSrcRect.width());
+    }
+
+    QByteArray result(expected.size(), 0);
+    dst->readBytes((quint8*)result.data(), expectedDstRect);
+
+    QCOMPARE(result, expected);
+}
+
+void KisImagePyramidTest::testDownscaledPlanesFollowUpdates()
+{
+    const QRect imageRect(0, 0, 301, 203);
+
+    KisPaintLayerSP layer;
+    KisImageSP image = createNoiseImage(imageRect, layer);
+
+    KisImagePyramid pyramid(4);
+    pyramid.setMonitorProfile(0,
+                              KoColorConversionTransformation::internalRenderingIntent(),
+                              KoColorConversionTransformation::internalConversionFlags());
+    pyramid.setImage(image);
+
+    /**
+     * Every plane should be exactly the same as the one of a pyramid
+     * built from scratch for the current state of the image
+     */
+    auto checkPlanes = [&] () {
+        KisImagePyramid reference(4);
+        reference.setMonitorProfile(0,
+                                    KoColorConversionTransformation::internalRenderingIntent(),
+                                    KoColorConversionTransformation::internalConversionFlags());
+        reference.setImage(image);
+
+        for (int i = 0; i < 4; i++) {
+            const QRect planeRect(0, 0, (imageRect.width() >> i) + 1, (imageRect.height() >> i) + 1);
+            const int size = planeRect.width() * planeRect.height() * 4;
+
+            QByteArray result(size, 0);
+            QByteArray expected(size, 0);
+
+            pyramid.m_pyramid[i]->readBytes((quint8*)result.data(), planeRect);
+            reference.m_pyramid[i]->readBytes((quint8*)expected.data(), planeRect);
+
+            if (result != expected) {
+                return false;
+            }
+        }
+
+        return true;
+    };
+
+    QVERIFY(checkPlanes());
+
+    // only the info of the first update is processed, the canvas
+    // postpones the other ones
+    KisPPUpdateInfoSP info;
+    quint32 seed = 5;
+
+    Q_FOREACH (const QRect &rc, strokeRects(0)) {
+        paintNoise(image, layer, rc, seed++);
+        pyramid.updateCache(rc);
+
+        if (!info) {
+            info = new KisPPUpdateInfo();
+            info->dirtyImageRectVar = rc;
+        }
+    }
+
+    pyramid.recalculateCache(info);
+    QVERIFY(checkPlanes());
+
+    // no info is processed at all, the planes are read by the next
+    // repaint of a zoomed out canvas
+    Q_FOREACH (const QRect &rc, strokeRects(1)) {
+        paintNoise(image, layer, rc, seed++);
+        pyramid.updateCache(rc);
+    }
+
+    KisPPUpdateInfoSP patchInfo = new KisPPUpdateInfo();
+    patchInfo->scaleX = 0.125;
+    patchInfo->scaleY = 0.125;
+    patchInfo->borderWidth = 0;
+    patchInfo->imageRect = imageRect;
+    pyramid.alignSourceRect(patchInfo->imageRect, patchInfo->scaleX);
+
+    pyramid.getNearestPatch(patchInfo);
+    QVERIFY(checkPlanes());
+}
+
+void KisImagePyramidTest::testPrescaledProjectionPostponedUpdates()
+{
+    const QRect imageRect(0, 0, 400, 300);
+
+    KisPaintLayerSP layer;
+    KisImageSP image = createNoiseImage(imageRect, layer);
+
+    KisCoordinatesConverter converter;
+    converter.setResolution(100, 100);
+    converter.setZoom(0.25);
+    converter.setImage(image);
+    converter.setCanvasWidgetSize(QSize(200, 150));
+    converter.setDocumentOffset(QPoint(0, 0));
+
+    KisPrescaledProjection projection;
+    projection.setCoordinatesConverter(&converter);
+    projection.setMonitorProfile(0,
+                                 KoColorConversionTransformation::internalRenderingIntent(),
+                                 KoColorConversionTransformation::internalConversionFlags());
+    projection.setImage(image);
+    projection.notifyCanvasSizeChanged(QSize(200, 150));
+    projection.notifyZoomChanged();
+
+    /**
+     * The canvas processes the info of the first update only, the other
+     * ones are postponed, like the offscreen updates are
+     */
+    bool isFirstUpdate = true;
+    quint32 seed = 5;
+
+    Q_FOREACH (const QRect &rc, strokeRects(0) + strokeRects(1)) {
+        paintNoise(image, layer, rc, seed++);
+        KisUpdateInfoSP info = projection.updateCache(rc);
+
+        if (isFirstUpdate) {
+            projection.recalculateCache(info);
+            isFirstUpdate = false;
+        }
+    }
+
+    KisPrescaledProjection reference;
+    reference.setCoordinatesConverter(&converter);
+    reference.setMonitorProfile(0,
+                                KoColorConversionTransformation::internalRenderingIntent(),
+                                KoColorConversionTransformation::internalConversionFlags());
+    reference.setImage(image);
+    reference.notifyCanvasSizeChanged(QSize(200, 150));
+
+    /**
+     * A zoom change repaints the whole canvas from the planes, so it
+     * should look exactly like a canvas that has just been created
+     */
+    QList<qreal> zoomLevels;
+    zoomLevels << 0.5 << 0.25 << 0.125;
+
+    Q_FOREACH (qreal zoom, zoomLevels) {
+        converter.setZoom(zoom);
+        projection.notifyZoomChanged();
+        reference.notifyZoomChanged();
+
+        QCOMPARE(projection.prescaledQImage(), reference.prescaledQImage());
+    }
+}
+
+QTEST_MAIN(KisImagePyramidTest)
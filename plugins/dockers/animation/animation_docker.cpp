@@ -29,6 +29,7 @@
 #include "kis_action_manager.h"
 #include "kis_image_animation_interface.h"
 #include "kis_animation_player.h"
+#include "KisAnimationPlaybackStatistics.h"
 #include "kis_time_range.h"
 #include "kundo2command.h"
 #include "kis_post_execution_undo_adapter.h"
@@ -373,6 +374,7 @@ void AnimationDocker::updateDropFramesIcon()
     qreal realFps = 0.0;
     qreal framesDropped = 0.0;
     bool isPlaying = false;
+    KisAnimationPlaybackStatistics stats;
 
     KisAnimationPlayer *player =
         m_canvas && m_canvas->animationPlayer() ?
@@ -383,6 +385,7 @@ void AnimationDocker::updateDropFramesIcon()
         realFps = player->realFps();
         framesDropped = player->framesDroppedPortion();
         isPlaying = player->isPlaying();
+        stats = player->playbackStatistics();
     }
 
     KisConfig cfg(true);
@@ -403,12 +406,18 @@ void AnimationDocker::updateDropFramesIcon()
         text = QString("%1 (%2)\n"
                        "%3\n"
                        "%4\n"
-                       "%5")
+                       "%5\n"
+                       "%6\n"
+                       "%7\n"
+                       "%8")
             .arg(KisAnimationUtils::dropFramesActionName)
             .arg(KritaUtils::toLocalizedOnOff(value))
             .arg(i18n("Effective FPS:\t%1", effectiveFps))
             .arg(i18n("Real FPS:\t%1", realFps))
-            .arg(i18n("Frames dropped:\t%1\%", framesDropped * 100));
+            .arg(i18n("Frames dropped:\t%1\%", framesDropped * 100))
+            .arg(i18n("Total frames dropped:\t%1 of %2", stats.framesDropped(), stats.framesShown() + stats.framesDropped()))
+            .arg(i18n("Frame latency:\t%1 ms (max %2 ms)", stats.averageLatency(), stats.maxLatency()))
+            .arg(i18n("Frames prefetched:\t%1 of %2", stats.framesPrefetched(), stats.framesShown()));
     }
 
     m_dropFramesAction->setText(text);
@@ -68,7 +68,7 @@ void HistogramDockerDock::setCanvas(KoCanvasBase * canvas)
 
         m_imageIdleWatcher->setTrackedImage(m_canvas->image());
 
-        connect(m_canvas->image(), SIGNAL(sigImageUpdated(QRect)), this, SLOT(startUpdateCanvasProjection()), Qt::UniqueConnection);
+        connect(m_canvas->image(), SIGNAL(sigImageUpdated(QRect)), this, SLOT(startUpdateCanvasProjection(QRect)), Qt::UniqueConnection);
         connect(m_canvas->image(), SIGNAL(sigColorSpaceChanged(const KoColorSpace*)), this, SLOT(sigColorSpaceChanged(const KoColorSpace*)), Qt::UniqueConnection);
         m_imageIdleWatcher->startCountdown();
     }
@@ -82,8 +82,12 @@ void HistogramDockerDock::unsetCanvas()
     m_imageIdleWatcher->startCountdown();
 }
 
-void HistogramDockerDock::startUpdateCanvasProjection()
+void HistogramDockerDock::startUpdateCanvasProjection(const QRect &rc)
 {
+    // the dirty area is tracked even when the docker is hidden, so
+    // that the histogram is correct when the docker is shown again
+    m_histogramWidget->addDirtyRect(rc);
+
     if (isVisible()) {
         m_imageIdleWatcher->startCountdown();
     }
@@ -24,6 +24,7 @@
 #include <QTime>
 #include <QPainter>
 #include <functional>
+#include <QtConcurrent>
 
 #include "KoChannelInfo.h"
 #include "kis_paint_device.h"
@@ -32,7 +33,8 @@
 #include "kis_canvas2.h"
 
 HistogramDockerWidget::HistogramDockerWidget(QWidget *parent, const char *name, Qt::WindowFlags f)
-    : QLabel(parent, f), m_paintDevice(nullptr), m_smoothHistogram(true)
+    : QLabel(parent, f), m_paintDevice(nullptr), m_smoothHistogram(true),
+      m_computationRunning(false), m_updateRequested(false)
 {
     setObjectName(name);
 }
@@ -52,17 +54,52 @@ void HistogramDockerWidget::setPaintDevice(KisCanvas2* canvas)
         m_bounds = QRect();
         m_histogramData.clear();
     }
+
+    // the cells of the previous image are of no use anymore
+    m_cellCache.reset(new HistogramCellCache());
+    m_dirtyRects.clear();
+}
+
+void HistogramDockerWidget::addDirtyRect(const QRect &rc)
+{
+    const int maxDirtyRects = 64;
+
+    if (m_dirtyRects.size() >= maxDirtyRects) {
+        QRect boundingRect = rc;
+        Q_FOREACH (const QRect &dirtyRect, m_dirtyRects) {
+            boundingRect |= dirtyRect;
+        }
+
+        m_dirtyRects.clear();
+        m_dirtyRects.append(boundingRect);
+    } else {
+        m_dirtyRects.append(rc);
+    }
 }
 
 void HistogramDockerWidget::updateHistogram()
 {
+    /**
+     * The cell cache is not shared between the computation threads,
+     * so the next update is postponed until the current one is finished
+     */
+    if (m_computationRunning) {
+        m_updateRequested = true;
+        return;
+    }
+
     if (!m_paintDevice.isNull()) {
         KisPaintDeviceSP m_devClone = new KisPaintDevice(m_paintDevice->colorSpace());
 
         m_devClone->makeCloneFrom(m_paintDevice, m_bounds);
 
-        HistogramComputationThread *workerThread = new HistogramComputationThread(m_devClone, m_bounds);
+        HistogramComputationThread *workerThread =
+            new HistogramComputationThread(m_devClone, m_bounds, m_cellCache, m_dirtyRects);
+        m_dirtyRects.clear();
+        m_computationRunning = true;
+
         connect(workerThread, &HistogramComputationThread::resultReady, this, &HistogramDockerWidget::receiveNewHistogram);
+        connect(workerThread, &HistogramComputationThread::finished, this, &HistogramDockerWidget::slotComputationFinished);
         connect(workerThread, &HistogramComputationThread::finished, workerThread, &QObject::deleteLater);
         workerThread->start();
     } else {
@@ -71,6 +108,16 @@ void HistogramDockerWidget::updateHistogram()
     }
 }
 
+void HistogramDockerWidget::slotComputationFinished()
+{
+    m_computationRunning = false;
+
+    if (m_updateRequested) {
+        m_updateRequested = false;
+        updateHistogram();
+    }
+}
+
 void HistogramDockerWidget::receiveNewHistogram(HistVector *histogramData)
 {
     m_histogramData = *histogramData;
@@ -154,11 +201,85 @@ void HistogramDockerWidget::paintEvent(QPaintEvent *event)
     }
 }
 
+namespace {
+
+const int nBins = std::numeric_limits<quint8>::max() + 1;
+const int cellSize = 256;
+
+struct CellJob {
+    QRect rect;
+    std::vector<quint32> *bins;
+};
+
+/**
+ * Recounts the partial histogram of a single cell. Every cell has its
+ * own bins, so the cells can be counted in parallel without any locking.
+ */
+struct CellCounter {
+    CellCounter(KisPaintDeviceSP dev, const QRect &extent, quint32 nSkip)
+        : m_dev(dev),
+          m_cs(dev->colorSpace()),
+          m_extent(extent),
+          m_nSkip(nSkip),
+          m_channelCount(dev->channelCount()),
+          m_pixelSize(dev->pixelSize())
+    {
+        // 8-bit color spaces are counted right from the bytes of the pixel
+        m_byteChannels = m_pixelSize == m_channelCount;
+    }
+
+    typedef void result_type;
+
+    void operator()(CellJob &job) {
+        std::vector<quint32> &bins = *job.bins;
+        bins.assign(m_channelCount * nBins, 0);
+
+        const QRect rc = job.rect & m_extent;
+        if (rc.isEmpty()) return;
+
+        quint32 toSkip = m_nSkip;
+
+        KisSequentialConstIterator it(m_dev, rc);
+
+        int numConseqPixels = it.nConseqPixels();
+        while (it.nextPixels(numConseqPixels)) {
+
+            numConseqPixels = it.nConseqPixels();
+            const quint8* pixel = it.rawDataConst();
+
+            for (int k = 0; k < numConseqPixels; ++k, pixel += m_pixelSize) {
+                if (--toSkip) continue;
+                toSkip = m_nSkip;
+
+                if (m_byteChannels) {
+                    for (int chan = 0; chan < m_channelCount; ++chan) {
+                        bins[chan * nBins + pixel[chan]]++;
+                    }
+                } else {
+                    for (int chan = 0; chan < m_channelCount; ++chan) {
+                        bins[chan * nBins + m_cs->scaleToU8(pixel, chan)]++;
+                    }
+                }
+            }
+        }
+    }
+
+private:
+    KisPaintDeviceSP m_dev;
+    const KoColorSpace *m_cs;
+    QRect m_extent;
+    quint32 m_nSkip;
+    int m_channelCount;
+    int m_pixelSize;
+    bool m_byteChannels;
+};
+
+}
+
 void HistogramComputationThread::run()
 {
     const KoColorSpace *cs = m_dev->colorSpace();
     quint32 channelCount = m_dev->channelCount();
-    quint32 pixelSize = m_dev->pixelSize();
 
     quint32 imageSize = m_bounds.width() * m_bounds.height();
     quint32 nSkip = 1 + (imageSize >> 20); //for speed use about 1M pixels for computing histograms
@@ -166,30 +287,62 @@ void HistogramComputationThread::run()
     //allocate space for the histogram data
     bins.resize((int)channelCount);
     for (auto &bin : bins) {
-        bin.resize(std::numeric_limits<quint8>::max() + 1);
+        bin.resize(nBins);
     }
 
-    QRect bounds = m_dev->exactBounds();
-    if (bounds.isEmpty())
-        return;
+    HistogramCellCache &cache = *m_cache;
 
-    quint32 toSkip = nSkip;
+    /**
+     * When the image is resized or converted, all the cells of the cache
+     * become invalid and the whole image is recounted.
+     */
+    const bool cacheIsValid = cache.bounds == m_bounds && cache.colorSpace == cs;
 
-    KisSequentialConstIterator it(m_dev, m_dev->exactBounds());
+    if (!cacheIsValid) {
+        cache.bounds = m_bounds;
+        cache.colorSpace = cs;
+        cache.cellRects.clear();
 
-    int numConseqPixels = it.nConseqPixels();
-    while (it.nextPixels(numConseqPixels)) {
+        for (int y = m_bounds.top(); y <= m_bounds.bottom(); y += cellSize) {
+            for (int x = m_bounds.left(); x <= m_bounds.right(); x += cellSize) {
+                cache.cellRects.append(QRect(x, y, cellSize, cellSize) & m_bounds);
+            }
+        }
 
-        numConseqPixels = it.nConseqPixels();
-        const quint8* pixel = it.rawDataConst();
-        for (int k = 0; k < numConseqPixels; ++k) {
-            if (--toSkip == 0) {
-                for (int chan = 0; chan < (int)channelCount; ++chan) {
-                    bins[chan][cs->scaleToU8(pixel, chan)]++;
-                }
-                toSkip = nSkip;
+        cache.cells.clear();
+        cache.cells.resize(cache.cellRects.size());
+    }
+
+    QVector<CellJob> jobs;
+
+    for (int i = 0; i < cache.cellRects.size(); i++) {
+        const QRect &cellRect = cache.cellRects[i];
+        bool isDirty = !cacheIsValid;
+
+        for (auto it = m_dirtyRects.constBegin(); !isDirty && it != m_dirtyRects.constEnd(); ++it) {
+            isDirty = it->intersects(cellRect);
+        }
+
+        if (isDirty) {
+            CellJob job;
+            job.rect = cellRect;
+            job.bins = &cache.cells[i];
+            jobs.append(job);
+        }
+    }
+
+    QtConcurrent::blockingMap(jobs, CellCounter(m_dev, m_dev->exactBounds(), nSkip));
+
+    for (const std::vector<quint32> &cell : cache.cells) {
+        if (cell.empty()) continue;
+
+        for (int chan = 0; chan < (int)channelCount; ++chan) {
+            const quint32 *src = cell.data() + chan * nBins;
+            quint32 *dst = bins[chan].data();
+
+            for (int i = 0; i < nBins; ++i) {
+                dst[i] += src[i];
             }
-            pixel += pixelSize;
         }
     }
 
@@ -23,19 +23,39 @@
 #include <QWidget>
 #include <QLabel>
 #include <QThread>
+#include <QSharedPointer>
+#include <QVector>
 #include "kis_types.h"
 #include <vector>
 
 class KisCanvas2;
+class KoColorSpace;
 
 typedef std::vector<std::vector<quint32> > HistVector; //Don't use QVector here - it's too slow for this purpose
 
+/**
+ * The histogram of the image is kept as a set of partial histograms of
+ * its cells. After a stroke only the cells touched by the stroke are
+ * recounted, all the other cells are taken from the cache.
+ */
+struct HistogramCellCache
+{
+    QRect bounds;
+    const KoColorSpace *colorSpace = 0;
+    QVector<QRect> cellRects;
+    std::vector<std::vector<quint32> > cells; // [cell][channel * nBins + bin]
+};
+
+typedef QSharedPointer<HistogramCellCache> HistogramCellCacheSP;
+
 
 class HistogramComputationThread : public QThread
 {
     Q_OBJECT
 public:
-    HistogramComputationThread(KisPaintDeviceSP _dev, const QRect& _bounds) : m_dev(_dev), m_bounds(_bounds)
+    HistogramComputationThread(KisPaintDeviceSP _dev, const QRect& _bounds,
+                               HistogramCellCacheSP _cache, const QVector<QRect> &_dirtyRects)
+        : m_dev(_dev), m_bounds(_bounds), m_cache(_cache), m_dirtyRects(_dirtyRects)
     {}
 
     void run() override;
@@ -46,6 +66,8 @@ Q_SIGNALS:
 private:
     KisPaintDeviceSP m_dev;
     QRect m_bounds;
+    HistogramCellCacheSP m_cache;
+    QVector<QRect> m_dirtyRects;
     HistVector bins;
 };
 
@@ -60,15 +82,29 @@ public:
     void setPaintDevice(KisCanvas2* canvas);
     void paintEvent(QPaintEvent *event) override;
 
+    /**
+     * Marks the area of the image that should be recounted on the next
+     * update of the histogram
+     */
+    void addDirtyRect(const QRect &rc);
+
 public Q_SLOTS:
     void updateHistogram();
     void receiveNewHistogram(HistVector*);
 
+private Q_SLOTS:
+    void slotComputationFinished();
+
 private:
     KisPaintDeviceSP m_paintDevice;
     HistVector m_histogramData;
     QRect m_bounds;
     bool m_smoothHistogram;
+
+    HistogramCellCacheSP m_cellCache;
+    QVector<QRect> m_dirtyRects;
+    bool m_computationRunning;
+    bool m_updateRequested;
 };
 
 #endif // HISTOGRAMDOCKERWIDGET_H
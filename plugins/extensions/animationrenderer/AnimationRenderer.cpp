@@ -101,30 +101,47 @@ void AnimaterionRenderer::slotRenderAnimation()
                 .arg(extension);
 
 
+        KisPropertiesConfigurationSP videoConfig = dlgAnimationRenderer.getVideoConfiguration();
+        KisPropertiesConfigurationSP encoderConfig = videoConfig ? dlgAnimationRenderer.getEncoderConfiguration() : 0;
+
+        /**
+         * When the user doesn't want to keep the image sequence, the frames
+         * are piped directly into the encoder and never hit the disk. Gif
+         * encoding needs two passes over the frames, so it always goes
+         * through the saved sequence.
+         */
+        const bool streamFrames =
+            kisConfig.useStreamingVideoExport() &&
+            videoConfig && encoderConfig &&
+            videoConfig->getBool("delete_sequence", false) &&
+            QFileInfo(videoConfig->getString("filename")).suffix().toLower() != "gif";
+
         const bool batchMode = false; // TODO: fetch correctly!
-        KisAsyncAnimationFramesSaveDialog exporter(doc->image(),
-                                                   KisTimeRange::fromTime(sequenceConfig->getInt("first_frame"), sequenceConfig->getInt("last_frame")),
-                                                   baseFileName,
-                                                   sequenceConfig->getInt("sequence_start"),
-                                                   dlgAnimationRenderer.getFrameExportConfiguration());
-        exporter.setBatchMode(batchMode);
 
+        KisAsyncAnimationFramesSaveDialog::Result result = KisAsyncAnimationFramesSaveDialog::RenderComplete;
+        QString savedFilesMask;
+
+        if (!streamFrames) {
+            KisAsyncAnimationFramesSaveDialog exporter(doc->image(),
+                                                       KisTimeRange::fromTime(sequenceConfig->getInt("first_frame"), sequenceConfig->getInt("last_frame")),
+                                                       baseFileName,
+                                                       sequenceConfig->getInt("sequence_start"),
+                                                       dlgAnimationRenderer.getFrameExportConfiguration());
+            exporter.setBatchMode(batchMode);
 
-        KisAsyncAnimationFramesSaveDialog::Result result =
-            exporter.regenerateRange(viewManager()->mainWindow()->viewManager());
+            result = exporter.regenerateRange(viewManager()->mainWindow()->viewManager());
+            savedFilesMask = exporter.savedFilesMask();
+        }
 
         // the folder could have been read-only or something else could happen
         if (result == KisAsyncAnimationFramesSaveDialog::RenderComplete) {
-            QString savedFilesMask = exporter.savedFilesMask();
-
-            KisPropertiesConfigurationSP videoConfig = dlgAnimationRenderer.getVideoConfiguration();
             if (videoConfig) {
                 kisConfig.setExportConfiguration("ANIMATION_RENDERER", videoConfig);
 
-                KisPropertiesConfigurationSP encoderConfig = dlgAnimationRenderer.getEncoderConfiguration();
                 if (encoderConfig) {
                     kisConfig.setExportConfiguration("FFMPEG_CONFIG", encoderConfig);
                     encoderConfig->setProperty("savedFilesMask", savedFilesMask);
+                    encoderConfig->setProperty("stream_frames", streamFrames);
                 }
 
                 const QString fileName = videoConfig->getString("filename");
@@ -158,7 +175,7 @@ void AnimaterionRenderer::slotRenderAnimation()
                 if (res != KisImportExportFilter::OK) {
                     QMessageBox::critical(0, i18nc("@title:window", "Krita"), i18n("Could not render animation:\n%1", doc->errorMessage()));
                 }
-                if (videoConfig->getBool("delete_sequence", false)) {
+                if (!streamFrames && videoConfig->getBool("delete_sequence", false)) {
                     QDir d(sequenceConfig->getString("directory"));
                     QStringList sequenceFiles = d.entryList(QStringList() << sequenceConfig->getString("basename") + "*." + extension, QDir::Files);
                     Q_FOREACH(const QString &f, sequenceFiles) {
@@ -20,6 +20,8 @@
 
 #include "exr_converter.h"
 
+#include <exception>
+
 #include <half.h>
 
 #include <ImfAttribute.h>
@@ -34,6 +36,7 @@
 #include <QMessageBox>
 #include <QDomDocument>
 #include <QThread>
+#include <QtConcurrentMap>
 
 #include <QFileInfo>
 
@@ -123,6 +126,20 @@ void ExrPaintLayerInfo::updateImageType(ImageType channelType)
     }
 }
 
+struct ExrLayerDecodeJob {
+    ExrLayerDecodeJob()
+        : info(0)
+        , alphaWasModified(false)
+        , failed(false)
+    {
+    }
+
+    const ExrPaintLayerInfo *info;
+    KisPaintLayerSP layer;
+    bool alphaWasModified;
+    bool failed;
+};
+
 struct ExrPaintLayerSaveInfo {
     QString name; ///< name of the layer with a "." at the end (ie "group1.group2.layer1.")
     KisPaintLayerSP layer;
@@ -146,14 +163,35 @@ struct EXRConverter::Private {
     QString errorMessage;
 
     template <class WrapperType>
-    void unmultiplyAlpha(typename WrapperType::pixel_type *pixel);
+    static bool unmultiplyAlpha(typename WrapperType::pixel_type *pixel);
 
     template<typename _T_>
-    void decodeData4(Imf::InputFile& file, ExrPaintLayerInfo& info, KisPaintLayerSP layer, int width, int xstart, int ystart, int height, Imf::PixelType ptype);
+    static bool decodeData4(Imf::InputFile& file, const ExrPaintLayerInfo& info, KisPaintDeviceSP dev, int width, int xstart, int ystart, int height, Imf::PixelType ptype);
 
     template<typename _T_>
-    void decodeData1(Imf::InputFile& file, ExrPaintLayerInfo& info, KisPaintLayerSP layer, int width, int xstart, int ystart, int height, Imf::PixelType ptype);
+    static bool decodeData1(Imf::InputFile& file, const ExrPaintLayerInfo& info, KisPaintDeviceSP dev, int width, int xstart, int ystart, int height, Imf::PixelType ptype);
+
+    static bool decodeLayer(Imf::InputFile& file, const ExrPaintLayerInfo& info, KisPaintDeviceSP dev, int width, int xstart, int ystart, int height);
+
+    /**
+     * Decodes a single layer into its paint device. Every layer is read
+     * through its own Imf::InputFile, so that several layers can be
+     * decoded at the same time.
+     */
+    struct LayerDecoder {
+        LayerDecoder(const QString &_filename, int _width, int _xstart, int _ystart, int _height)
+            : filename(_filename), width(_width), xstart(_xstart), ystart(_ystart), height(_height)
+        {
+        }
 
+        void operator()(ExrLayerDecodeJob &job) const;
+
+        QString filename;
+        int width;
+        int xstart;
+        int ystart;
+        int height;
+    };
 
     QDomDocument loadExtraLayersInfo(const Imf::Header &header);
     bool checkExtraLayersInfoConsistent(const QDomDocument &doc, std::set<std::string> exrLayerNames);
@@ -293,12 +331,13 @@ struct GrayPixelWrapper
 };
 
 template <class WrapperType>
-void EXRConverter::Private::unmultiplyAlpha(typename WrapperType::pixel_type *pixel)
+bool EXRConverter::Private::unmultiplyAlpha(typename WrapperType::pixel_type *pixel)
 {
     typedef typename WrapperType::pixel_type pixel_type;
     typedef typename WrapperType::channel_type channel_type;
 
     WrapperType srcPixel(*pixel);
+    bool alphaWasModified = false;
 
     if (!srcPixel.checkMultipliedColorsConsistent()) {
 
@@ -328,6 +367,8 @@ void EXRConverter::Private::unmultiplyAlpha(typename WrapperType::pixel_type *pi
     } else if (srcPixel.alpha() > 0.0) {
         srcPixel.setUnmultiplied(srcPixel.pixel, srcPixel.alpha());
     }
+
+    return alphaWasModified;
 }
 
 template <typename T, typename Pixel, int size, int alphaPos>
@@ -348,72 +389,113 @@ void multiplyAlpha(Pixel *pixel)
     }
 }
 
+/**
+ * The maximum number of scanlines decoded or encoded in one go. It is a
+ * multiple of the paint device tile size and of the largest line block
+ * of the EXR compression methods, so the blocks never split a compressed
+ * chunk of the file.
+ */
+const int exrBlockRows = 256;
+
+/**
+ * The height of the stripes of a block that are filled in parallel on
+ * export, equal to the paint device tile size
+ */
+const int exrStripeRows = 64;
+
+/**
+ * The limit for the size of the intermediate pixel buffers. On import
+ * the limit is shared between the layers that are decoded at the same
+ * time, on export between all the layers of the image.
+ */
+const int exrBufferLimit = 64 * 1024 * 1024;
+
+int exrBlockRowsForBuffer(int bytesPerRow, int height)
+{
+    int rows = bytesPerRow > 0 ? exrBufferLimit / bytesPerRow : exrBlockRows;
+
+    if (rows > exrStripeRows) {
+        rows -= rows % exrStripeRows;
+    }
+
+    return qBound(1, qMin(rows, height), exrBlockRows);
+}
+
 template<typename _T_>
-void EXRConverter::Private::decodeData4(Imf::InputFile& file, ExrPaintLayerInfo& info, KisPaintLayerSP layer, int width, int xstart, int ystart, int height, Imf::PixelType ptype)
+bool EXRConverter::Private::decodeData4(Imf::InputFile& file, const ExrPaintLayerInfo& info, KisPaintDeviceSP dev, int width, int xstart, int ystart, int height, Imf::PixelType ptype)
 {
     typedef Rgba<_T_> Rgba;
 
-    QVector<Rgba> pixels(width * height);
+    const int blockRows = exrBlockRowsForBuffer(int(sizeof(Rgba)) * width * QThread::idealThreadCount(), height);
+    QVector<Rgba> pixels(width * blockRows);
 
     bool hasAlpha = info.channelMap.contains("A");
+    bool alphaWasModified = false;
+
+    for (int y = ystart; y < ystart + height; y += blockRows) {
+        const int numRows = qMin(blockRows, ystart + height - y);
 
-    Imf::FrameBuffer frameBuffer;
-    Rgba* frameBufferData = (pixels.data()) - xstart - ystart * width;
-    frameBuffer.insert(info.channelMap["R"].toLatin1().constData(),
-            Imf::Slice(ptype, (char *) &frameBufferData->r,
-                       sizeof(Rgba) * 1,
-                       sizeof(Rgba) * width));
-    frameBuffer.insert(info.channelMap["G"].toLatin1().constData(),
-            Imf::Slice(ptype, (char *) &frameBufferData->g,
-                       sizeof(Rgba) * 1,
-                       sizeof(Rgba) * width));
-    frameBuffer.insert(info.channelMap["B"].toLatin1().constData(),
-            Imf::Slice(ptype, (char *) &frameBufferData->b,
-                       sizeof(Rgba) * 1,
-                       sizeof(Rgba) * width));
-    if (hasAlpha) {
-        frameBuffer.insert(info.channelMap["A"].toLatin1().constData(),
-                Imf::Slice(ptype, (char *) &frameBufferData->a,
+        Imf::FrameBuffer frameBuffer;
+        Rgba* frameBufferData = (pixels.data()) - xstart - y * width;
+        frameBuffer.insert(info.channelMap["R"].toLatin1().constData(),
+                Imf::Slice(ptype, (char *) &frameBufferData->r,
+                           sizeof(Rgba) * 1,
+                           sizeof(Rgba) * width));
+        frameBuffer.insert(info.channelMap["G"].toLatin1().constData(),
+                Imf::Slice(ptype, (char *) &frameBufferData->g,
+                           sizeof(Rgba) * 1,
+                           sizeof(Rgba) * width));
+        frameBuffer.insert(info.channelMap["B"].toLatin1().constData(),
+                Imf::Slice(ptype, (char *) &frameBufferData->b,
                            sizeof(Rgba) * 1,
                            sizeof(Rgba) * width));
-    }
-
-    file.setFrameBuffer(frameBuffer);
-    file.readPixels(ystart, height + ystart - 1);
-    Rgba *rgba = pixels.data();
-
-    QRect paintRegion(xstart, ystart, width, height);
-    KisSequentialIterator it(layer->paintDevice(), paintRegion);
-    while (it.nextPixel()) {
         if (hasAlpha) {
-            unmultiplyAlpha<RgbPixelWrapper<_T_> >(rgba);
+            frameBuffer.insert(info.channelMap["A"].toLatin1().constData(),
+                    Imf::Slice(ptype, (char *) &frameBufferData->a,
+                               sizeof(Rgba) * 1,
+                               sizeof(Rgba) * width));
         }
 
-        typename KoRgbTraits<_T_>::Pixel* dst = reinterpret_cast<typename KoRgbTraits<_T_>::Pixel*>(it.rawData());
+        file.setFrameBuffer(frameBuffer);
+        file.readPixels(y, y + numRows - 1);
+        Rgba *rgba = pixels.data();
+
+        QRect paintRegion(xstart, y, width, numRows);
+        KisSequentialIterator it(dev, paintRegion);
+        while (it.nextPixel()) {
+            if (hasAlpha) {
+                alphaWasModified |= unmultiplyAlpha<RgbPixelWrapper<_T_> >(rgba);
+            }
 
-        dst->red = rgba->r;
-        dst->green = rgba->g;
-        dst->blue = rgba->b;
-        if (hasAlpha) {
-            dst->alpha = rgba->a;
-        } else {
-            dst->alpha = 1.0;
-        }
+            typename KoRgbTraits<_T_>::Pixel* dst = reinterpret_cast<typename KoRgbTraits<_T_>::Pixel*>(it.rawData());
 
-        ++rgba;
+            dst->red = rgba->r;
+            dst->green = rgba->g;
+            dst->blue = rgba->b;
+            if (hasAlpha) {
+                dst->alpha = rgba->a;
+            } else {
+                dst->alpha = 1.0;
+            }
+
+            ++rgba;
+        }
     }
+
+    return alphaWasModified;
 }
 
 template<typename _T_>
-void EXRConverter::Private::decodeData1(Imf::InputFile& file, ExrPaintLayerInfo& info, KisPaintLayerSP layer, int width, int xstart, int ystart, int height, Imf::PixelType ptype)
+bool EXRConverter::Private::decodeData1(Imf::InputFile& file, const ExrPaintLayerInfo& info, KisPaintDeviceSP dev, int width, int xstart, int ystart, int height, Imf::PixelType ptype)
 {
     typedef typename GrayPixelWrapper<_T_>::channel_type channel_type;
     typedef typename GrayPixelWrapper<_T_>::pixel_type pixel_type;
 
-    KIS_ASSERT_RECOVER_RETURN(
-                layer->paintDevice()->colorSpace()->colorModelId() == GrayAColorModelID);
+    KIS_ASSERT_RECOVER_RETURN_VALUE(
+                dev->colorSpace()->colorModelId() == GrayAColorModelID, false);
 
-    QVector<pixel_type> pixels(width * height);
+    const int blockRows = exrBlockRowsForBuffer(int(sizeof(pixel_type)) * width * QThread::idealThreadCount(), height);
+    QVector<pixel_type> pixels(width * blockRows);
 
     Q_ASSERT(info.channelMap.contains("G"));
     dbgFile << "G -> " << info.channelMap["G"];
@@ -421,41 +503,101 @@ void EXRConverter::Private::decodeData1(Imf::InputFile& file, ExrPaintLayerInfo&
     bool hasAlpha = info.channelMap.contains("A");
     dbgFile << "Has Alpha:" << hasAlpha;
 
+    bool alphaWasModified = false;
 
-    Imf::FrameBuffer frameBuffer;
-    pixel_type* frameBufferData = (pixels.data()) - xstart - ystart * width;
-    frameBuffer.insert(info.channelMap["G"].toLatin1().constData(),
-            Imf::Slice(ptype, (char *) &frameBufferData->gray,
-                       sizeof(pixel_type) * 1,
-                       sizeof(pixel_type) * width));
+    for (int y = ystart; y < ystart + height; y += blockRows) {
+        const int numRows = qMin(blockRows, ystart + height - y);
 
-    if (hasAlpha) {
-        frameBuffer.insert(info.channelMap["A"].toLatin1().constData(),
-                Imf::Slice(ptype, (char *) &frameBufferData->alpha,
+        Imf::FrameBuffer frameBuffer;
+        pixel_type* frameBufferData = (pixels.data()) - xstart - y * width;
+        frameBuffer.insert(info.channelMap["G"].toLatin1().constData(),
+                Imf::Slice(ptype, (char *) &frameBufferData->gray,
                            sizeof(pixel_type) * 1,
                            sizeof(pixel_type) * width));
-    }
 
-    file.setFrameBuffer(frameBuffer);
-    file.readPixels(ystart, height + ystart - 1);
+        if (hasAlpha) {
+            frameBuffer.insert(info.channelMap["A"].toLatin1().constData(),
+                    Imf::Slice(ptype, (char *) &frameBufferData->alpha,
+                               sizeof(pixel_type) * 1,
+                               sizeof(pixel_type) * width));
+        }
 
-    pixel_type *srcPtr = pixels.data();
+        file.setFrameBuffer(frameBuffer);
+        file.readPixels(y, y + numRows - 1);
 
-    QRect paintRegion(xstart, ystart, width, height);
-    KisSequentialIterator it(layer->paintDevice(), paintRegion);
-    do {
+        pixel_type *srcPtr = pixels.data();
 
-        if (hasAlpha) {
-            unmultiplyAlpha<GrayPixelWrapper<_T_> >(srcPtr);
+        QRect paintRegion(xstart, y, width, numRows);
+        KisSequentialIterator it(dev, paintRegion);
+        while (it.nextPixel()) {
+
+            if (hasAlpha) {
+                alphaWasModified |= unmultiplyAlpha<GrayPixelWrapper<_T_> >(srcPtr);
+            }
+
+            pixel_type* dstPtr = reinterpret_cast<pixel_type*>(it.rawData());
+
+            dstPtr->gray = srcPtr->gray;
+            dstPtr->alpha = hasAlpha ? srcPtr->alpha : channel_type(1.0);
+
+            ++srcPtr;
         }
+    }
+
+    return alphaWasModified;
+}
 
-        pixel_type* dstPtr = reinterpret_cast<pixel_type*>(it.rawData());
+bool EXRConverter::Private::decodeLayer(Imf::InputFile& file, const ExrPaintLayerInfo& info, KisPaintDeviceSP dev, int width, int xstart, int ystart, int height)
+{
+    bool alphaWasModified = false;
+
+    switch (info.channelMap.size()) {
+    case 1:
+    case 2:
+        // Decode the data
+        switch (info.imageType) {
+        case IT_FLOAT16:
+            alphaWasModified = decodeData1<half>(file, info, dev, width, xstart, ystart, height, Imf::HALF);
+            break;
+        case IT_FLOAT32:
+            alphaWasModified = decodeData1<float>(file, info, dev, width, xstart, ystart, height, Imf::FLOAT);
+            break;
+        case IT_UNKNOWN:
+        case IT_UNSUPPORTED:
+            qFatal("Impossible error");
+        }
+        break;
+    case 3:
+    case 4:
+        // Decode the data
+        switch (info.imageType) {
+        case IT_FLOAT16:
+            alphaWasModified = decodeData4<half>(file, info, dev, width, xstart, ystart, height, Imf::HALF);
+            break;
+        case IT_FLOAT32:
+            alphaWasModified = decodeData4<float>(file, info, dev, width, xstart, ystart, height, Imf::FLOAT);
+            break;
+        case IT_UNKNOWN:
+        case IT_UNSUPPORTED:
+            qFatal("Impossible error");
+        }
+        break;
+    default:
+        qFatal("Invalid number of channels: %i", info.channelMap.size());
+    }
 
-        dstPtr->gray = srcPtr->gray;
-        dstPtr->alpha = hasAlpha ? srcPtr->alpha : channel_type(1.0);
+    return alphaWasModified;
+}
 
-        ++srcPtr;
-    } while (it.nextPixel());
+void EXRConverter::Private::LayerDecoder::operator()(ExrLayerDecodeJob &job) const
+{
+    try {
+        Imf::InputFile file(QFile::encodeName(filename));
+        job.alphaWasModified = decodeLayer(file, *job.info, job.layer->paintDevice(), width, xstart, ystart, height);
+    } catch (const std::exception &e) {
+        warnFile << "Failed to decode EXR layer" << job.info->name << ":" << e.what();
+        job.failed = true;
+    }
 }
 
 bool recCheckGroup(const ExrGroupLayerInfo& group, QStringList list, int idx1, int idx2)
@@ -795,7 +937,9 @@ KisImageBuilder_Result EXRConverter::decode(const QString &filename)
         d->image->addNode(info.groupLayer, groupLayerParent);
     }
 
-    // Load the layers
+    // Create the layers
+    QVector<ExrLayerDecodeJob> decodeJobs;
+
     for (int i = informationObjects.size() - 1; i >= 0; --i) {
         ExrPaintLayerInfo& info = informationObjects[i];
         if (info.colorSpace) {
@@ -808,40 +952,6 @@ KisImageBuilder_Result EXRConverter::decode(const QString &filename)
                 return KisImageBuilder_RESULT_FAILURE;
             }
 
-            switch (info.channelMap.size()) {
-            case 1:
-            case 2:
-                // Decode the data
-                switch (info.imageType) {
-                case IT_FLOAT16:
-                    d->decodeData1<half>(file, info, layer, width, dx, dy, height, Imf::HALF);
-                    break;
-                case IT_FLOAT32:
-                    d->decodeData1<float>(file, info, layer, width, dx, dy, height, Imf::FLOAT);
-                    break;
-                case IT_UNKNOWN:
-                case IT_UNSUPPORTED:
-                    qFatal("Impossible error");
-                }
-                break;
-            case 3:
-            case 4:
-                // Decode the data
-                switch (info.imageType) {
-                case IT_FLOAT16:
-                    d->decodeData4<half>(file, info, layer, width, dx, dy, height, Imf::HALF);
-                    break;
-                case IT_FLOAT32:
-                    d->decodeData4<float>(file, info, layer, width, dx, dy, height, Imf::FLOAT);
-                    break;
-                case IT_UNKNOWN:
-                case IT_UNSUPPORTED:
-                    qFatal("Impossible error");
-                }
-                break;
-            default:
-                qFatal("Invalid number of channels: %i", info.channelMap.size());
-            }
             // Check if should set the channels
             if (!info.remappedChannels.isEmpty()) {
                 QList<KisMetaData::Value> values;
@@ -853,13 +963,31 @@ KisImageBuilder_Result EXRConverter::decode(const QString &filename)
                 }
                 layer->metaData()->addEntry(KisMetaData::Entry(KisMetaData::SchemaRegistry::instance()->create("http://krita.org/exrchannels/1.0/" , "exrchannels"), "channelsmap", values));
             }
-            // Add the layer
-            KisGroupLayerSP groupLayerParent = (info.parent) ? info.parent->groupLayer : d->image->rootLayer();
-            d->image->addNode(layer, groupLayerParent);
+
+            ExrLayerDecodeJob job;
+            job.info = &info;
+            job.layer = layer;
+            decodeJobs.append(job);
         } else {
             dbgFile << "No decoding " << info.name << " with " << info.channelMap.size() << " channels, and lack of a color space";
         }
     }
+
+    // Decode the layers straight into their paint devices, several layers at a time
+    QtConcurrent::blockingMap(decodeJobs, Private::LayerDecoder(filename, width, dx, dy, height));
+
+    // Add the layers
+    Q_FOREACH (const ExrLayerDecodeJob &job, decodeJobs) {
+        if (job.failed) {
+            return KisImageBuilder_RESULT_FAILURE;
+        }
+
+        d->alphaWasModified |= job.alphaWasModified;
+
+        KisGroupLayerSP groupLayerParent = (job.info->parent) ? job.info->parent->groupLayer : d->image->rootLayer();
+        d->image->addNode(job.layer, groupLayerParent);
+    }
+
     // Set projectionColor to opaque
     d->image->setDefaultProjectionColor(KoColor(Qt::transparent, colorSpace));
 
@@ -914,7 +1042,7 @@ class Encoder
 public:
     virtual ~Encoder() {}
     virtual void prepareFrameBuffer(Imf::FrameBuffer*, int line) = 0;
-    virtual void encodeData(int line) = 0;
+    virtual void encodeData(int line, int numLines) = 0;
 
 };
 
@@ -922,16 +1050,17 @@ template<typename _T_, int size, int alphaPos>
 class EncoderImpl : public Encoder
 {
 public:
-    EncoderImpl(Imf::OutputFile* _file, const ExrPaintLayerSaveInfo* _info, int width) : file(_file), info(_info), pixels(width), m_width(width) {}
+    EncoderImpl(Imf::OutputFile* _file, const ExrPaintLayerSaveInfo* _info, int width, int blockRows) : file(_file), info(_info), pixels(width * blockRows), m_width(width), m_firstLine(0) {}
     ~EncoderImpl() override {}
     void prepareFrameBuffer(Imf::FrameBuffer*, int line) override;
-    void encodeData(int line) override;
+    void encodeData(int line, int numLines) override;
 private:
     typedef ExrPixel_<_T_, size> ExrPixel;
     Imf::OutputFile* file;
     const ExrPaintLayerSaveInfo* info;
     QVector<ExrPixel> pixels;
     int m_width;
+    int m_firstLine;
 };
 
 template<typename _T_, int size, int alphaPos>
@@ -939,6 +1068,7 @@ void EncoderImpl<_T_, size, alphaPos>::prepareFrameBuffer(Imf::FrameBuffer* fram
 {
     int xstart = 0;
     int ystart = 0;
+    m_firstLine = line;
     ExrPixel* frameBufferData = (pixels.data()) - xstart - (ystart + line) * m_width;
     for (int k = 0; k < size; ++k) {
         frameBuffer->insert(info->channels[k].toUtf8(),
@@ -949,12 +1079,12 @@ void EncoderImpl<_T_, size, alphaPos>::prepareFrameBuffer(Imf::FrameBuffer* fram
 }
 
 template<typename _T_, int size, int alphaPos>
-void EncoderImpl<_T_, size, alphaPos>::encodeData(int line)
+void EncoderImpl<_T_, size, alphaPos>::encodeData(int line, int numLines)
 {
-    ExrPixel *rgba = pixels.data();
-    KisHLineIteratorSP it = info->layer->paintDevice()->createHLineIteratorNG(0, line, m_width);
-    do {
-        const _T_* dst = reinterpret_cast < const _T_* >(it->oldRawData());
+    ExrPixel *rgba = pixels.data() + (line - m_firstLine) * m_width;
+    KisSequentialConstIterator it(info->layer->paintDevice(), QRect(0, line, m_width, numLines));
+    while (it.nextPixel()) {
+        const _T_* dst = reinterpret_cast < const _T_* >(it.oldRawData());
 
         for (int i = 0; i < size; ++i) {
             rgba->data[i] = dst[i];
@@ -965,40 +1095,40 @@ void EncoderImpl<_T_, size, alphaPos>::encodeData(int line)
         }
 
         ++rgba;
-    } while (it->nextPixel());
+    }
 }
 
-Encoder* encoder(Imf::OutputFile& file, const ExrPaintLayerSaveInfo& info, int width)
+Encoder* encoder(Imf::OutputFile& file, const ExrPaintLayerSaveInfo& info, int width, int blockRows)
 {
     dbgFile << "Create encoder for" << info.layer->name() << info.channels << info.layer->colorSpace()->channelCount();
     switch (info.layer->colorSpace()->channelCount()) {
     case 1: {
         if (info.layer->colorSpace()->colorDepthId() == Float16BitsColorDepthID) {
             Q_ASSERT(info.pixelType == Imf::HALF);
-            return new EncoderImpl < half, 1, -1 > (&file, &info, width);
+            return new EncoderImpl < half, 1, -1 > (&file, &info, width, blockRows);
         } else if (info.layer->colorSpace()->colorDepthId() == Float32BitsColorDepthID) {
             Q_ASSERT(info.pixelType == Imf::FLOAT);
-            return new EncoderImpl < float, 1, -1 > (&file, &info, width);
+            return new EncoderImpl < float, 1, -1 > (&file, &info, width, blockRows);
         }
         break;
     }
     case 2: {
         if (info.layer->colorSpace()->colorDepthId() == Float16BitsColorDepthID) {
             Q_ASSERT(info.pixelType == Imf::HALF);
-            return new EncoderImpl<half, 2, 1>(&file, &info, width);
+            return new EncoderImpl<half, 2, 1>(&file, &info, width, blockRows);
         } else if (info.layer->colorSpace()->colorDepthId() == Float32BitsColorDepthID) {
             Q_ASSERT(info.pixelType == Imf::FLOAT);
-            return new EncoderImpl<float, 2, 1>(&file, &info, width);
+            return new EncoderImpl<float, 2, 1>(&file, &info, width, blockRows);
         }
         break;
     }
     case 4: {
         if (info.layer->colorSpace()->colorDepthId() == Float16BitsColorDepthID) {
             Q_ASSERT(info.pixelType == Imf::HALF);
-            return new EncoderImpl<half, 4, 3>(&file, &info, width);
+            return new EncoderImpl<half, 4, 3>(&file, &info, width, blockRows);
         } else if (info.layer->colorSpace()->colorDepthId() == Float32BitsColorDepthID) {
             Q_ASSERT(info.pixelType == Imf::FLOAT);
-            return new EncoderImpl<float, 4, 3>(&file, &info, width);
+            return new EncoderImpl<float, 4, 3>(&file, &info, width, blockRows);
         }
         break;
     }
@@ -1008,23 +1138,56 @@ Encoder* encoder(Imf::OutputFile& file, const ExrPaintLayerSaveInfo& info, int w
     return 0;
 }
 
+struct ExrEncodeJob {
+    ExrEncodeJob() : encoder(0), line(0), numLines(0) {}
+    ExrEncodeJob(Encoder *_encoder, int _line, int _numLines) : encoder(_encoder), line(_line), numLines(_numLines) {}
+
+    Encoder *encoder;
+    int line;
+    int numLines;
+};
+
+struct ExrStripeEncoder {
+    void operator()(ExrEncodeJob &job) const {
+        job.encoder->encodeData(job.line, job.numLines);
+    }
+};
+
 void encodeData(Imf::OutputFile& file, const QList<ExrPaintLayerSaveInfo>& informationObjects, int width, int height)
 {
+    int bytesPerRow = 0;
+    Q_FOREACH (const ExrPaintLayerSaveInfo& info, informationObjects) {
+        bytesPerRow += info.layer->colorSpace()->pixelSize() * width;
+    }
+
+    const int blockRows = exrBlockRowsForBuffer(bytesPerRow, height);
+
     QList<Encoder*> encoders;
     Q_FOREACH (const ExrPaintLayerSaveInfo& info, informationObjects) {
-        encoders.push_back(encoder(file, info, width));
+        encoders.push_back(encoder(file, info, width, blockRows));
     }
 
-    for (int y = 0; y < height; ++y) {
+    /**
+     * The lines of a block are fetched from the paint devices of all the
+     * layers in parallel, one stripe per job, and then compressed by
+     * OpenEXR in its own thread pool.
+     */
+    for (int y = 0; y < height; y += blockRows) {
+        const int numLines = qMin(blockRows, height - y);
+
         Imf::FrameBuffer frameBuffer;
+        QVector<ExrEncodeJob> jobs;
+
         Q_FOREACH (Encoder* encoder, encoders) {
             encoder->prepareFrameBuffer(&frameBuffer, y);
+
+            for (int line = y; line < y + numLines; line += exrStripeRows) {
+                jobs.append(ExrEncodeJob(encoder, line, qMin(exrStripeRows, y + numLines - line)));
+            }
         }
         file.setFrameBuffer(frameBuffer);
-        Q_FOREACH (Encoder* encoder, encoders) {
-            encoder->encodeData(y);
-        }
-        file.writePixels(1);
+        QtConcurrent::blockingMap(jobs, ExrStripeEncoder());
+        file.writePixels(numLines);
     }
     qDeleteAll(encoders);
 }
@@ -25,6 +25,12 @@
 
 #include <half.h>
 #include <KisMimeDatabase.h>
+#include <KoColorSpaceRegistry.h>
+#include <KoColorModelStandardIds.h>
+#include <KoColorSpaceTraits.h>
+
+#include "kis_paint_layer.h"
+#include "kis_iterator_ng.h"
 #include "filestest.h"
 
 #ifndef FILES_DATA_DIR
@@ -89,6 +95,58 @@ void KisExrTest::testRoundTrip()
 
 }
 
+void KisExrTest::testRoundTripLayers()
+{
+    // the height spans several blocks of scanlines, and the last one is partial
+    const QRect imageRect(0, 0, 300, 700);
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->colorSpace(RGBAColorModelID.id(), Float16BitsColorDepthID.id(), "");
+
+    KisImageSP image = new KisImage(0, imageRect.width(), imageRect.height(), cs, "layered exr");
+    QList<KisPaintLayerSP> layers;
+
+    for (int i = 0; i < 3; i++) {
+        KisPaintLayerSP layer = new KisPaintLayer(image, QString("layer%1").arg(i), OPACITY_OPAQUE_U8, cs);
+
+        // opaque pixels survive the alpha premultiplication unchanged
+        KisSequentialIterator it(layer->paintDevice(), imageRect);
+        while (it.nextPixel()) {
+            KoRgbTraits<half>::Pixel *pixel = reinterpret_cast<KoRgbTraits<half>::Pixel*>(it.rawData());
+            pixel->red = half(float(it.x()) / imageRect.width());
+            pixel->green = half(float(it.y()) / imageRect.height());
+            pixel->blue = half(float(i + 1) / 4);
+            pixel->alpha = half(1.0f);
+        }
+
+        image->addNode(layer, image->root());
+        layers << layer;
+    }
+
+    image->initialRefreshGraph();
+
+    QScopedPointer<KisDocument> doc(KisPart::instance()->createDocument());
+    doc->setCurrentImage(image);
+    doc->setFileBatchMode(true);
+
+    const QString fileName = QDir::currentPath() + QDir::separator() + "test_layers.exr";
+    QVERIFY(doc->exportDocumentSync(QUrl::fromLocalFile(fileName), "image/x-exr"));
+
+    QScopedPointer<KisDocument> doc2(KisPart::instance()->createDocument());
+    doc2->setFileBatchMode(true);
+    QVERIFY(doc2->importDocument(QUrl::fromLocalFile(fileName)));
+    QVERIFY(doc2->image());
+    QCOMPARE(doc2->image()->bounds(), imageRect);
+
+    Q_FOREACH (KisPaintLayerSP layer, layers) {
+        KisNodeSP node = doc2->image()->root()->findChildByName(layer->name());
+        QVERIFY(node);
+
+        QPoint pt;
+        QVERIFY(TestUtil::comparePaintDevices(pt, layer->paintDevice(), node->paintDevice()));
+    }
+
+    QFile::remove(fileName);
+}
+
 KISTEST_MAIN(KisExrTest)
 
 
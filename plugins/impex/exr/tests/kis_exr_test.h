@@ -27,6 +27,7 @@ class KisExrTest : public QObject
 private Q_SLOTS:
     void testFiles();
     void testRoundTrip();
+    void testRoundTripLayers();
 };
 
 #endif
@@ -43,7 +43,12 @@ public:
     ~KraConverter() override;
 
     KisImageBuilder_Result buildImage(QIODevice *io);
-    KisImageBuilder_Result buildFile(QIODevice *io);
+    /**
+     * Saves the document into \p io. If \p filename is set, the unchanged
+     * pixel data of the nodes may be copied from the file saved into the
+     * same location last time.
+     */
+    KisImageBuilder_Result buildFile(QIODevice *io, const QString &filename = QString());
     /**
      * Retrieve the constructed image
      */
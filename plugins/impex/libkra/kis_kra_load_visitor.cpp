@@ -65,6 +65,8 @@
 #include "kis_dom_utils.h"
 #include "kis_raster_keyframe_channel.h"
 #include "kis_paint_device_frames_interface.h"
+#include "kis_image_config.h"
+#include "kis_kra_parallel_device_decoder.h"
 
 using namespace KRA;
 
@@ -103,6 +105,7 @@ KisKraLoadVisitor::KisKraLoadVisitor(KisImageSP image,
     , m_keyframeFilenames(keyframeFilenames)
     , m_name(name)
     , m_shapeController(shapeController)
+    , m_decoder(0)
 {
     m_store->pushDirectory();
     if (m_name.startsWith("/")) {
@@ -126,12 +129,37 @@ KisKraLoadVisitor::KisKraLoadVisitor(KisImageSP image,
     m_syntaxVersion = syntaxVersion;
 }
 
+KisKraLoadVisitor::~KisKraLoadVisitor()
+{
+    delete m_decoder;
+}
+
 void KisKraLoadVisitor::setExternalUri(const QString &uri)
 {
     m_external = true;
     m_uri = uri;
 }
 
+void KisKraLoadVisitor::decodeDevicesInParallel()
+{
+    KIS_SAFE_ASSERT_RECOVER_RETURN(!m_decoder);
+
+    // the compressed data of a layer is usually much smaller than the layer
+    // itself, so the limit is needed only for really huge images
+    const qint64 maxBufferedBytes = 256 * 1024 * 1024;
+
+    m_decoder = new KisKraParallelDeviceDecoder(KisImageConfig(true).maxNumberOfThreads(), maxBufferedBytes);
+}
+
+void KisKraLoadVisitor::waitForDecodedDevices()
+{
+    if (!m_decoder) return;
+
+    Q_FOREACH (const QString &location, m_decoder->waitForDone()) {
+        m_warningMessages << i18n("Could not read pixel data: %1.", location);
+    }
+}
+
 bool KisKraLoadVisitor::visit(KisExternalLayer * layer)
 {
     bool result = false;
@@ -191,10 +219,15 @@ bool KisKraLoadVisitor::visit(KisPaintLayer *layer)
     loadNodeKeyframes(layer);
 
     dbgFile << "Visit: " << layer->name() << " colorSpace: " << layer->colorSpace()->id();
-    if (!loadPaintDevice(layer->paintDevice(), getLocation(layer))) {
+
+    /**
+     * The profile is assigned before the pixel data is loaded, because
+     * the data may be decoded in background
+     */
+    if (!loadProfile(layer->paintDevice(), getLocation(layer, DOT_ICC))) {
         return false;
     }
-    if (!loadProfile(layer->paintDevice(), getLocation(layer, DOT_ICC))) {
+    if (!loadPaintDevice(layer->paintDevice(), getLocation(layer))) {
         return false;
     }
     if (!loadMetaData(layer)) {
@@ -250,6 +283,9 @@ bool KisKraLoadVisitor::visit(KisAdjustmentLayer* layer)
         KisSelectionSP selection = new KisSelection();
         KisPixelSelectionSP pixelSelection = selection->pixelSelection();
         result = loadPaintDevice(pixelSelection, getLocation(layer, ".selection"));
+
+        // the layer makes a copy of the selection
+        waitForDecodedDevices();
         layer->setInternalSelection(selection);
     } else if (m_syntaxVersion == 2) {
         result = loadSelection(getLocation(layer), layer->internalSelection());
@@ -278,6 +314,9 @@ bool KisKraLoadVisitor::visit(KisGeneratorLayer *layer)
     loadNodeKeyframes(layer);
     result = loadSelection(getLocation(layer), layer->internalSelection());
     result = loadFilterConfiguration(layer->filter().data(), getLocation(layer, DOT_FILTERCONFIG));
+
+    // the generator will read the selection while updating
+    waitForDecodedDevices();
     layer->update();
     result = visitAll(layer);
     return result;
@@ -429,6 +468,9 @@ bool KisKraLoadVisitor::visit(KisColorizeMask *mask)
     mask->setKeyStrokesDirect(QList<KisLazyFillTools::KeyStroke>::fromVector(strokes));
 
     loadPaintDevice(mask->coloringProjection(), COLORIZE_COLORING_DEVICE);
+
+    // the mask will regenerate its cache from the loaded devices
+    waitForDecodedDevices();
     mask->resetCache();
 
     m_store->popDirectory();
@@ -454,6 +496,10 @@ struct SimpleDevicePolicy
     void setDefaultPixel(KisPaintDeviceSP dev, const KoColor &defaultPixel) const {
         return dev->setDefaultPixel(defaultPixel);
     }
+
+    int frameId() const {
+        return -1;
+    }
 };
 
 struct FramedDevicePolicy
@@ -469,6 +515,10 @@ struct FramedDevicePolicy
         return dev->framesInterface()->setFrameDefaultPixel(defaultPixel, m_frameId);
     }
 
+    int frameId() const {
+        return m_frameId;
+    }
+
     int m_frameId;
 };
 
@@ -526,6 +576,15 @@ bool KisKraLoadVisitor::loadPaintDeviceFrame(KisPaintDeviceSP device, const QStr
     }
 
     if (m_store->open(location)) {
+        if (m_decoder) {
+            // the tiles will be decompressed in background
+            const QByteArray data = m_store->read(m_store->size());
+            m_store->close();
+
+            m_decoder->addDevice(device, policy.frameId(), data, location);
+            return true;
+        }
+
         if (!policy.read(device, m_store->device())) {
             m_warningMessages << i18n("Could not read pixel data: %1.", location);
             device->disconnect();
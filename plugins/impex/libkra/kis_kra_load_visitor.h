@@ -30,6 +30,7 @@
 #include "kritalibkra_export.h"
 
 class KisFilterConfiguration;
+class KisKraParallelDeviceDecoder;
 class KoStore;
 class KoShapeControllerBase;
 
@@ -46,9 +47,24 @@ public:
                       const QString & name,
                       int syntaxVersion);
 
+    ~KisKraLoadVisitor() override;
+
 public:
     void setExternalUri(const QString &uri);
 
+    /**
+     * Makes the visitor decompress the pixel data of the devices in
+     * background threads instead of doing that right when the node is
+     * visited. waitForDecodedDevices() must be called after the visitor
+     * has been accepted by the root node.
+     */
+    void decodeDevicesInParallel();
+
+    /**
+     * Waits until all the devices are decoded
+     */
+    void waitForDecodedDevices();
+
     bool visit(KisNode*) override {
         return true;
     }
@@ -103,6 +119,7 @@ private:
     QStringList m_errorMessages;
     QStringList m_warningMessages;
     KoShapeControllerBase *m_shapeController;
+    KisKraParallelDeviceDecoder *m_decoder;
 };
 
 #endif // KIS_KRA_LOAD_VISITOR_H_
@@ -419,7 +419,12 @@ void KisKraLoader::loadBinaryData(KoStore * store, KisImageSP image, const QStri
         visitor.setExternalUri(uri);
     }
 
+    if (KisConfig(true).parallelKraLoading()) {
+        visitor.decodeDevicesInParallel();
+    }
+
     image->rootLayer()->accept(visitor);
+    visitor.waitForDecodedDevices();
     if (!visitor.errorMessages().isEmpty()) {
         m_d->errorMessages.append(visitor.errorMessages());
     }
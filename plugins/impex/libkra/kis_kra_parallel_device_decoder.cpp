@@ -0,0 +1,144 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_kra_parallel_device_decoder.h"
+
+#include <QBuffer>
+#include <QByteArray>
+#include <QMutex>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include "kis_paint_device.h"
+#include "kis_paint_device_frames_interface.h"
+
+struct KisKraParallelDeviceDecoder::Private
+{
+    struct DecodeRunnable : public QRunnable
+    {
+        DecodeRunnable(Private *_d, KisPaintDeviceSP _device, int _frameId,
+                       const QByteArray &_data, const QString &_location)
+            : d(_d), device(_device), frameId(_frameId), data(_data), location(_location)
+        {
+        }
+
+        void run() override {
+            d->decode(this);
+        }
+
+        Private *d;
+        KisPaintDeviceSP device;
+        int frameId;
+        QByteArray data;
+        QString location;
+    };
+
+    qint64 maxBufferedBytes = 0;
+
+    QThreadPool pool;
+    QMutex mutex;
+    QWaitCondition jobFinished;
+
+    qint64 bufferedBytes = 0;
+    QStringList failedLocations;
+    QList<KisPaintDeviceSP> failedDevices;
+
+    void decode(DecodeRunnable *job);
+};
+
+KisKraParallelDeviceDecoder::KisKraParallelDeviceDecoder(int numThreads, qint64 maxBufferedBytes)
+    : m_d(new Private)
+{
+    m_d->pool.setMaxThreadCount(qMax(1, numThreads));
+    m_d->maxBufferedBytes = maxBufferedBytes;
+}
+
+KisKraParallelDeviceDecoder::~KisKraParallelDeviceDecoder()
+{
+    m_d->pool.waitForDone();
+}
+
+void KisKraParallelDeviceDecoder::addDevice(KisPaintDeviceSP device, int frameId, const QByteArray &data, const QString &location)
+{
+    {
+        QMutexLocker l(&m_d->mutex);
+
+        /**
+         * If there is nothing in the queue, the device is accepted
+         * regardless of its size
+         */
+        while (m_d->bufferedBytes > 0 &&
+               m_d->bufferedBytes + data.size() > m_d->maxBufferedBytes) {
+
+            m_d->jobFinished.wait(&m_d->mutex);
+        }
+
+        m_d->bufferedBytes += data.size();
+    }
+
+    m_d->pool.start(new Private::DecodeRunnable(m_d.data(), device, frameId, data, location));
+}
+
+QStringList KisKraParallelDeviceDecoder::waitForDone()
+{
+    m_d->pool.waitForDone();
+
+    QMutexLocker l(&m_d->mutex);
+
+    /**
+     * The devices are disconnected in the calling thread, because the
+     * other frames of the same device might have still been decoded
+     * when the failure happened
+     */
+    Q_FOREACH (KisPaintDeviceSP device, m_d->failedDevices) {
+        device->disconnect();
+    }
+    m_d->failedDevices.clear();
+
+    QStringList failedLocations;
+    failedLocations.swap(m_d->failedLocations);
+
+    return failedLocations;
+}
+
+void KisKraParallelDeviceDecoder::Private::decode(DecodeRunnable *job)
+{
+    QBuffer buffer(&job->data);
+    buffer.open(QIODevice::ReadOnly);
+
+    const bool result =
+        job->frameId >= 0 ?
+        job->device->framesInterface()->readFrame(&buffer, job->frameId) :
+        job->device->read(&buffer);
+
+    buffer.close();
+
+    QMutexLocker l(&mutex);
+
+    if (!result) {
+        failedLocations << job->location;
+
+        if (!failedDevices.contains(job->device)) {
+            failedDevices << job->device;
+        }
+    }
+
+    bufferedBytes -= job->data.size();
+    jobFinished.wakeAll();
+}
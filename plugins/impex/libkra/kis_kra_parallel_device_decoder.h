@@ -0,0 +1,66 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KIS_KRA_PARALLEL_DEVICE_DECODER_H
+#define KIS_KRA_PARALLEL_DEVICE_DECODER_H
+
+#include <QScopedPointer>
+#include <QStringList>
+
+#include "kis_types.h"
+
+class QByteArray;
+
+/**
+ * KisKraParallelDeviceDecoder decompresses the tiles of paint devices in a
+ * pool of threads, while the loading visitor continues reading the store.
+ *
+ * The store itself can be read by one thread only, so the visitor reads the
+ * compressed data of the device and passes it to the decoder, which
+ * decompresses the tiles into the device in background. The amount of the
+ * compressed data waiting for decoding is limited: when the limit is reached,
+ * addDevice() blocks until some of the devices are decoded.
+ */
+class KisKraParallelDeviceDecoder
+{
+public:
+    KisKraParallelDeviceDecoder(int numThreads, qint64 maxBufferedBytes);
+    ~KisKraParallelDeviceDecoder();
+
+    /**
+     * Starts decoding of \p data into the \p frameId of \p device.
+     * If \p frameId is -1, the data is read into the device as a whole.
+     * \p location is used for error reporting only.
+     */
+    void addDevice(KisPaintDeviceSP device, int frameId, const QByteArray &data, const QString &location);
+
+    /**
+     * Waits until all the added devices are decoded. The devices that
+     * failed to decode are disconnected, like the sequential loading does.
+     *
+     * \return the locations of the devices that failed to load since
+     *         the previous call to waitForDone()
+     */
+    QStringList waitForDone();
+
+private:
+    struct Private;
+    const QScopedPointer<Private> m_d;
+};
+
+#endif // KIS_KRA_PARALLEL_DEVICE_DECODER_H
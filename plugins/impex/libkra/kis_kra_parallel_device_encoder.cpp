@@ -0,0 +1,217 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_kra_parallel_device_encoder.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QPair>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QVector>
+#include <QWaitCondition>
+
+#include "kis_assert.h"
+#include "kis_paint_device.h"
+#include "kis_paint_device_frames_interface.h"
+#include "kis_paint_device_writer.h"
+
+namespace {
+
+class KisByteArrayPaintDeviceWriter : public KisPaintDeviceWriter
+{
+public:
+    KisByteArrayPaintDeviceWriter(QByteArray *data)
+        : m_data(data)
+    {
+    }
+
+    bool write(const QByteArray &data) override {
+        m_data->append(data);
+        return true;
+    }
+
+    bool write(const char* data, qint64 length) override {
+        m_data->append(data, length);
+        return true;
+    }
+
+private:
+    QByteArray *m_data;
+};
+
+}
+
+struct KisKraParallelDeviceEncoder::Private
+{
+    struct Job {
+        KisPaintDeviceSP device;
+        int frameId = -1;
+        QByteArray data;
+        bool result = false;
+        bool isScheduled = false;
+        bool isFinished = false;
+        bool isTaken = false;
+    };
+
+    struct EncodeRunnable : public QRunnable
+    {
+        EncodeRunnable(Private *_d, Job *_job) : d(_d), job(_job) {}
+
+        void run() override {
+            d->encodeJob(job);
+        }
+
+        Private *d;
+        Job *job;
+    };
+
+    typedef QPair<const KisPaintDevice*, int> JobKey;
+
+    int maxPendingDevices = 1;
+    qint64 maxBufferedBytes = 0;
+
+    QVector<Job> jobs;
+    QHash<JobKey, int> jobIndexes;
+
+    QThreadPool pool;
+    QMutex mutex;
+    QWaitCondition jobFinished;
+
+    bool isStarted = false;
+    int nextJob = 0;
+    int numPendingJobs = 0;
+    qint64 bufferedBytes = 0;
+
+    void scheduleJobs();
+    void encodeJob(Job *job);
+};
+
+KisKraParallelDeviceEncoder::KisKraParallelDeviceEncoder(int numThreads, int maxPendingDevices, qint64 maxBufferedBytes)
+    : m_d(new Private)
+{
+    m_d->pool.setMaxThreadCount(qMax(1, numThreads));
+    m_d->maxPendingDevices = qMax(1, maxPendingDevices);
+    m_d->maxBufferedBytes = maxBufferedBytes;
+}
+
+KisKraParallelDeviceEncoder::~KisKraParallelDeviceEncoder()
+{
+    {
+        QMutexLocker l(&m_d->mutex);
+        m_d->nextJob = m_d->jobs.size();
+    }
+
+    m_d->pool.waitForDone();
+}
+
+void KisKraParallelDeviceEncoder::addDevice(KisPaintDeviceSP device, int frameId)
+{
+    KIS_SAFE_ASSERT_RECOVER_RETURN(!m_d->isStarted);
+
+    const Private::JobKey key(device.data(), frameId);
+    if (m_d->jobIndexes.contains(key)) return;
+
+    Private::Job job;
+    job.device = device;
+    job.frameId = frameId;
+
+    m_d->jobIndexes.insert(key, m_d->jobs.size());
+    m_d->jobs.append(job);
+}
+
+void KisKraParallelDeviceEncoder::start()
+{
+    QMutexLocker l(&m_d->mutex);
+
+    m_d->isStarted = true;
+    m_d->scheduleJobs();
+}
+
+KisKraParallelDeviceEncoder::Result
+KisKraParallelDeviceEncoder::takeData(KisPaintDeviceSP device, int frameId, QByteArray *data)
+{
+    QMutexLocker l(&m_d->mutex);
+
+    auto it = m_d->jobIndexes.constFind(Private::JobKey(device.data(), frameId));
+    if (it == m_d->jobIndexes.constEnd()) return NotEncoded;
+
+    Private::Job &job = m_d->jobs[*it];
+    if (job.isTaken) return NotEncoded;
+
+    job.isTaken = true;
+
+    /**
+     * The visitor has requested the devices in a different order, so
+     * just let it write the device directly
+     */
+    if (!job.isScheduled) return NotEncoded;
+
+    while (!job.isFinished) {
+        m_d->jobFinished.wait(&m_d->mutex);
+    }
+
+    *data = job.data;
+    const bool result = job.result;
+
+    m_d->bufferedBytes -= job.data.size();
+    m_d->numPendingJobs--;
+    job.data = QByteArray();
+    job.device = 0;
+
+    m_d->scheduleJobs();
+
+    return result ? Encoded : Failed;
+}
+
+void KisKraParallelDeviceEncoder::Private::scheduleJobs()
+{
+    while (nextJob < jobs.size() &&
+           numPendingJobs < maxPendingDevices &&
+           bufferedBytes < maxBufferedBytes) {
+
+        Job &job = jobs[nextJob++];
+        if (job.isTaken) continue;
+
+        job.isScheduled = true;
+        numPendingJobs++;
+
+        pool.start(new EncodeRunnable(this, &job));
+    }
+}
+
+void KisKraParallelDeviceEncoder::Private::encodeJob(Job *job)
+{
+    QByteArray data;
+    KisByteArrayPaintDeviceWriter writer(&data);
+
+    const bool result =
+        job->frameId >= 0 ?
+        job->device->framesInterface()->writeFrame(writer, job->frameId) :
+        job->device->write(writer);
+
+    QMutexLocker l(&mutex);
+
+    job->data = data;
+    job->result = result;
+    job->isFinished = true;
+    bufferedBytes += data.size();
+
+    jobFinished.wakeAll();
+}
@@ -0,0 +1,82 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KIS_KRA_PARALLEL_DEVICE_ENCODER_H
+#define KIS_KRA_PARALLEL_DEVICE_ENCODER_H
+
+#include <QScopedPointer>
+
+#include "kis_types.h"
+
+class QByteArray;
+
+/**
+ * KisKraParallelDeviceEncoder compresses the tiles of paint devices into
+ * memory buffers in a pool of threads, while the saving visitor writes the
+ * already encoded devices into the store.
+ *
+ * The devices are encoded in the order of addDevice() calls, which is
+ * expected to be the order in which the visitor requests them. The number
+ * of devices being encoded or waiting to be written, and the amount of the
+ * buffered data are limited, so the encoder can run only a few devices ahead
+ * of the visitor.
+ *
+ * The encoded data is exactly the same as the one the device writes into
+ * the store directly, so the resulting file doesn't depend on whether the
+ * encoder is used or not.
+ */
+class KisKraParallelDeviceEncoder
+{
+public:
+    enum Result {
+        NotEncoded,
+        Encoded,
+        Failed
+    };
+
+public:
+    KisKraParallelDeviceEncoder(int numThreads, int maxPendingDevices, qint64 maxBufferedBytes);
+    ~KisKraParallelDeviceEncoder();
+
+    /**
+     * Adds the \p frameId of \p device to the queue of encoding.
+     * If \p frameId is -1, the device is written as a whole.
+     */
+    void addDevice(KisPaintDeviceSP device, int frameId = -1);
+
+    /**
+     * Starts encoding of the added devices
+     */
+    void start();
+
+    /**
+     * Waits until the \p frameId of \p device is encoded and moves the
+     * resulting data into \p data.
+     *
+     * \return NotEncoded if the device has never been added or its encoding
+     *         has not been started yet. In such a case the caller should
+     *         write the device itself.
+     */
+    Result takeData(KisPaintDeviceSP device, int frameId, QByteArray *data);
+
+private:
+    struct Private;
+    const QScopedPointer<Private> m_d;
+};
+
+#endif // KIS_KRA_PARALLEL_DEVICE_ENCODER_H
@@ -55,7 +55,9 @@
 #include <metadata/kis_meta_data_io_backend.h>
 
 #include "kis_config.h"
+#include "kis_image_config.h"
 #include "kis_store_paintdevice_writer.h"
+#include "kis_kra_parallel_device_encoder.h"
 #include "flake/kis_shape_selection.h"
 
 #include "kis_raster_keyframe_channel.h"
@@ -76,11 +78,14 @@ KisKraSaveVisitor::KisKraSaveVisitor(KoStore *store, const QString & name, QMap<
     , m_name(name)
     , m_nodeFileNames(nodeFileNames)
     , m_writer(new KisStorePaintDeviceWriter(store))
+    , m_encoder(0)
+    , m_previousStore(0)
 {
 }
 
 KisKraSaveVisitor::~KisKraSaveVisitor()
 {
+    delete m_encoder;
     delete m_writer;
 }
 
@@ -130,7 +135,7 @@ bool KisKraSaveVisitor::visit(KisExternalLayer * layer)
 
 bool KisKraSaveVisitor::visit(KisPaintLayer *layer)
 {
-    if (!savePaintDevice(layer->paintDevice(), getLocation(layer))) {
+    if (!savePaintDevice(layer->paintDevice(), getLocation(layer), getPreviousLocation(layer))) {
         m_errorMessages << i18n("Failed to save the pixel data for layer %1.", layer->name());
         return false;
     }
@@ -315,12 +320,106 @@ QStringList KisKraSaveVisitor::errorMessages() const
     return m_errorMessages;
 }
 
+void KisKraSaveVisitor::encodeDevicesInParallel(KisNodeSP root)
+{
+    KIS_SAFE_ASSERT_RECOVER_RETURN(!m_encoder);
+
+    const int numThreads = KisImageConfig(true).maxNumberOfThreads();
+
+    /**
+     * Every pending device may take as much memory as its compressed
+     * data, so limit the amount of the buffered data as well as the number
+     * of the devices encoded ahead of the visitor.
+     */
+    const qint64 maxBufferedBytes = 256 * 1024 * 1024;
+
+    m_encoder = new KisKraParallelDeviceEncoder(numThreads, 2 * numThreads, maxBufferedBytes);
+    collectDevices(root.data());
+    m_encoder->start();
+}
+
+void KisKraSaveVisitor::setPreviousFile(KoStore *previousStore, const QString &previousName, const QHash<QUuid, QString> &unchangedNodes)
+{
+    KIS_SAFE_ASSERT_RECOVER_NOOP(!m_encoder);
+
+    m_previousStore = previousStore;
+    m_previousName = previousName;
+    m_unchangedNodes = unchangedNodes;
+}
+
+void KisKraSaveVisitor::collectDevices(KisNode *node)
+{
+    /**
+     * The devices should be collected in exactly the same order as
+     * they are saved by the visit() methods. If the order differs, the
+     * result is still correct, but the devices are encoded sequentially.
+     */
+
+    if (!getPreviousLocation(node).isEmpty()) {
+        // the data will be copied from the previous file
+    } else if (KisPaintLayer *layer = dynamic_cast<KisPaintLayer*>(node)) {
+        collectDevice(layer->paintDevice());
+    } else if (KisColorizeMask *mask = dynamic_cast<KisColorizeMask*>(node)) {
+        Q_FOREACH (const KisLazyFillTools::KeyStroke &stroke, mask->fetchKeyStrokesDirect()) {
+            collectDevice(stroke.dev);
+        }
+        collectDevice(mask->coloringProjection());
+    } else {
+        KisSelectionSP selection;
+
+        if (KisAdjustmentLayer *layer = dynamic_cast<KisAdjustmentLayer*>(node)) {
+            selection = layer->internalSelection();
+        } else if (KisGeneratorLayer *layer = dynamic_cast<KisGeneratorLayer*>(node)) {
+            selection = layer->internalSelection();
+        } else if (dynamic_cast<KisFilterMask*>(node) ||
+                   dynamic_cast<KisTransparencyMask*>(node) ||
+                   dynamic_cast<KisSelectionMask*>(node)) {
+
+            selection = static_cast<KisMask*>(node)->selection();
+        }
+
+        if (selection && selection->hasPixelSelection()) {
+            collectDevice(selection->pixelSelection());
+        }
+    }
+
+    KisNodeSP child = node->lastChild();
+    while (child) {
+        collectDevices(child.data());
+        child = child->prevSibling();
+    }
+}
+
+void KisKraSaveVisitor::collectDevice(KisPaintDeviceSP device)
+{
+    if (!device) return;
+
+    KisPaintDeviceFramesInterface *frameInterface = device->framesInterface();
+    QList<int> frames;
+
+    if (frameInterface) {
+        frames = frameInterface->frames();
+    }
+
+    if (!frameInterface || frames.count() <= 1) {
+        m_encoder->addDevice(device);
+    } else {
+        Q_FOREACH (int frameId, frames) {
+            m_encoder->addDevice(device, frameId);
+        }
+    }
+}
+
 struct SimpleDevicePolicy
 {
     bool write(KisPaintDeviceSP dev, KisPaintDeviceWriter &store) {
         return dev->write(store);
     }
 
+    int frameId() const {
+        return -1;
+    }
+
     KoColor defaultPixel(KisPaintDeviceSP dev) const {
         return dev->defaultPixel();
     }
@@ -335,6 +434,10 @@ struct FramedDevicePolicy
         return dev->framesInterface()->writeFrame(store, m_frameId);
     }
 
+    int frameId() const {
+        return m_frameId;
+    }
+
     KoColor defaultPixel(KisPaintDeviceSP dev) const {
         return dev->framesInterface()->frameDefaultPixel(m_frameId);
     }
@@ -343,12 +446,28 @@ struct FramedDevicePolicy
 };
 
 bool KisKraSaveVisitor::savePaintDevice(KisPaintDeviceSP device,
-                                        QString location)
+                                        QString location,
+                                        const QString &previousLocation)
 {
     // Layer data
     KisConfig cfg(true);
     m_store->setCompressionEnabled(cfg.compressKra());
 
+    QByteArray previousData;
+    QByteArray previousDefaultPixel;
+
+    if (!previousLocation.isEmpty() &&
+        readPreviousData(previousLocation, &previousData) &&
+        readPreviousData(previousLocation + ".defaultpixel", &previousDefaultPixel)) {
+
+        const bool result =
+            writeData(location, previousData) &&
+            writeData(location + ".defaultpixel", previousDefaultPixel);
+
+        m_store->setCompressionEnabled(true);
+        return result;
+    }
+
     KisPaintDeviceFramesInterface *frameInterface = device->framesInterface();
     QList<int> frames;
 
@@ -382,7 +501,19 @@ template<class DevicePolicy>
 bool KisKraSaveVisitor::savePaintDeviceFrame(KisPaintDeviceSP device, QString location, DevicePolicy policy)
 {
     if (m_store->open(location)) {
-        if (!policy.write(device, *m_writer)) {
+        QByteArray encodedData;
+        const KisKraParallelDeviceEncoder::Result encoderResult =
+            m_encoder ?
+            m_encoder->takeData(device, policy.frameId(), &encodedData) :
+            KisKraParallelDeviceEncoder::NotEncoded;
+
+        const bool result =
+            encoderResult == KisKraParallelDeviceEncoder::NotEncoded ?
+            policy.write(device, *m_writer) :
+            encoderResult == KisKraParallelDeviceEncoder::Encoded &&
+            m_writer->write(encodedData);
+
+        if (!result) {
             device->disconnect();
             m_store->close();
             return false;
@@ -398,6 +529,29 @@ bool KisKraSaveVisitor::savePaintDeviceFrame(KisPaintDeviceSP device, QString lo
     return true;
 }
 
+bool KisKraSaveVisitor::readPreviousData(const QString &location, QByteArray *data)
+{
+    if (!m_previousStore->open(location)) {
+        return false;
+    }
+
+    const qint64 size = m_previousStore->size();
+    *data = m_previousStore->read(size);
+    m_previousStore->close();
+
+    return data->size() == size;
+}
+
+bool KisKraSaveVisitor::writeData(const QString &location, const QByteArray &data)
+{
+    if (!m_store->open(location)) {
+        return false;
+    }
+
+    const bool result = m_store->write(data) == data.size();
+    return m_store->close() && result;
+}
+
 bool KisKraSaveVisitor::saveAnnotations(KisLayer* layer)
 {
     if (!layer) return false;
@@ -448,7 +602,8 @@ bool KisKraSaveVisitor::saveSelection(KisNode* node)
 
     if (selection->hasPixelSelection()) {
         KisPaintDeviceSP dev = selection->pixelSelection();
-        if (!savePaintDevice(dev, getLocation(node, DOT_PIXEL_SELECTION))) {
+        if (!savePaintDevice(dev, getLocation(node, DOT_PIXEL_SELECTION),
+                             getPreviousLocation(node, DOT_PIXEL_SELECTION))) {
             m_errorMessages << i18n("Failed to save the pixel selection data for layer %1.", node->name());
             retval = false;
         }
@@ -547,3 +702,13 @@ QString KisKraSaveVisitor::getLocation(const QString &filename, const QString& s
     location += m_name + LAYER_PATH + filename + suffix;
     return location;
 }
+
+QString KisKraSaveVisitor::getPreviousLocation(KisNode *node, const QString &suffix) const
+{
+    if (!m_previousStore) return QString();
+
+    // the previous file is always saved as an external one
+    auto it = m_unchangedNodes.constFind(node->uuid());
+    return it != m_unchangedNodes.constEnd() ?
+        m_previousName + LAYER_PATH + *it + suffix : QString();
+}
@@ -20,8 +20,10 @@
 #ifndef KIS_KRA_SAVE_VISITOR_H_
 #define KIS_KRA_SAVE_VISITOR_H_
 
+#include <QHash>
 #include <QRect>
 #include <QStringList>
+#include <QUuid>
 
 #include "kis_types.h"
 #include "kis_node_visitor.h"
@@ -29,6 +31,7 @@
 #include "kritalibkra_export.h"
 
 class KisPaintDeviceWriter;
+class KisKraParallelDeviceEncoder;
 class KoStore;
 
 class KRITALIBKRA_EXPORT KisKraSaveVisitor : public KisNodeVisitor
@@ -41,6 +44,25 @@ public:
 public:
     void setExternalUri(const QString &uri);
 
+    /**
+     * Starts compressing the paint devices of the \p root's subtree in
+     * background threads. The visitor will take the encoded data when it
+     * reaches the corresponding node. Should be called before the visitor
+     * is accepted by \p root.
+     */
+    void encodeDevicesInParallel(KisNodeSP root);
+
+    /**
+     * Makes the visitor copy the pixel data of \p unchangedNodes from
+     * \p previousStore instead of encoding it again. \p previousStore is
+     * the file written by the previous saving of the image, where it was
+     * named \p previousName. The nodes are identified by their uuids and
+     * mapped into their file names in the previous file.
+     *
+     * Should be called before encodeDevicesInParallel().
+     */
+    void setPreviousFile(KoStore *previousStore, const QString &previousName, const QHash<QUuid, QString> &unchangedNodes);
+
     bool visit(KisNode*) override {
         return true;
     }
@@ -72,17 +94,24 @@ public:
 
 private:
 
-    bool savePaintDevice(KisPaintDeviceSP device, QString location);
+    bool savePaintDevice(KisPaintDeviceSP device, QString location, const QString &previousLocation = QString());
 
     template<class DevicePolicy>
     bool savePaintDeviceFrame(KisPaintDeviceSP device, QString location, DevicePolicy policy);
 
+    void collectDevices(KisNode *node);
+    void collectDevice(KisPaintDeviceSP device);
+
+    bool readPreviousData(const QString &location, QByteArray *data);
+    bool writeData(const QString &location, const QByteArray &data);
+
     bool saveAnnotations(KisLayer* layer);
     bool saveSelection(KisNode* node);
     bool saveFilterConfiguration(KisNode* node);
     bool saveMetaData(KisNode* node);
     QString getLocation(KisNode* node, const QString& suffix = QString());
     QString getLocation(const QString &filename, const QString &suffix = QString());
+    QString getPreviousLocation(KisNode *node, const QString &suffix = QString()) const;
 
 private:
 
@@ -92,6 +121,10 @@ private:
     QString m_name;
     QMap<const KisNode*, QString> m_nodeFileNames;
     KisPaintDeviceWriter *m_writer;
+    KisKraParallelDeviceEncoder *m_encoder;
+    KoStore *m_previousStore;
+    QString m_previousName;
+    QHash<QUuid, QString> m_unchangedNodes;
     QStringList m_errorMessages;
 };
 
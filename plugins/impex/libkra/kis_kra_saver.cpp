@@ -29,6 +29,7 @@
 
 #include <QUrl>
 #include <QBuffer>
+#include <QScopedPointer>
 
 #include <KoDocumentInfo.h>
 #include <KoColorSpaceRegistry.h>
@@ -53,6 +54,7 @@
 #include "KisDocument.h"
 #include <string>
 #include "kis_dom_utils.h"
+#include "kis_config.h"
 #include "kis_grid_config.h"
 #include "kis_guides_config.h"
 #include "KisProofingConfiguration.h"
@@ -70,13 +72,15 @@ public:
     QMap<const KisNode*, QString> nodeFileNames;
     QMap<const KisNode*, QString> keyframeFilenames;
     QString imageName;
+    QString filename;
     QStringList errorMessages;
 };
 
-KisKraSaver::KisKraSaver(KisDocument* document)
+KisKraSaver::KisKraSaver(KisDocument* document, const QString &filename)
         : m_d(new Private)
 {
     m_d->doc = document;
+    m_d->filename = filename;
 
     m_d->imageName = m_d->doc->documentInfo()->aboutInfo("title");
     if (m_d->imageName.isEmpty()) {
@@ -196,6 +200,32 @@ bool KisKraSaver::saveBinaryData(KoStore* store, KisImageSP image, const QString
     if (external)
         visitor.setExternalUri(uri);
 
+    QScopedPointer<KoStore> previousStore;
+
+    if (!m_d->filename.isEmpty() && KisConfig(true).incrementalKraSaving()) {
+        const KisSavedNodesState previousState = m_d->doc->savedNodesState(m_d->filename);
+        const QHash<QUuid, QString> unchangedNodes =
+            previousState.unchangedNodes(m_d->doc->savingNodesRevisions());
+
+        /**
+         * The new file is written into a temporary location and replaces
+         * the old one only when the saving is completed, so the old file
+         * stays readable while we are saving, unless it has been changed
+         * by someone else.
+         */
+        if (!unchangedNodes.isEmpty() && previousState.isValid()) {
+            previousStore.reset(KoStore::createStore(previousState.filePath, KoStore::Read, "", KoStore::Zip));
+
+            if (!previousStore->bad()) {
+                visitor.setPreviousFile(previousStore.data(), previousState.imageName, unchangedNodes);
+            }
+        }
+    }
+
+    if (KisConfig(true).parallelKraSaving()) {
+        visitor.encodeDevicesInParallel(image->rootLayer());
+    }
+
     image->rootLayer()->accept(visitor);
 
     m_d->errorMessages.append(visitor.errorMessages());
@@ -203,6 +233,16 @@ bool KisKraSaver::saveBinaryData(KoStore* store, KisImageSP image, const QString
         return false;
     }
 
+    if (!m_d->filename.isEmpty()) {
+        QHash<QUuid, QString> fileNames;
+
+        for (auto it = m_d->nodeFileNames.constBegin(); it != m_d->nodeFileNames.constEnd(); ++it) {
+            fileNames.insert(it.key()->uuid(), it.value());
+        }
+
+        m_d->doc->setSavingNodesFileNames(m_d->filename, m_d->imageName, fileNames);
+    }
+
     // saving annotations
     // XXX this only saves EXIF and ICC info. This would probably need
     // a redesign of the dtd of the krita file to do this more generally correct
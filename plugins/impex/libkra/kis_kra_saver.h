@@ -34,7 +34,12 @@ class KRITALIBKRA_EXPORT KisKraSaver
 {
 public:
 
-    KisKraSaver(KisDocument* document);
+    /**
+     * If \p filename is set, the pixel data of the nodes, which has not
+     * been changed since the last saving of \p document into the same
+     * file, is copied from the old file instead of being encoded again.
+     */
+    KisKraSaver(KisDocument* document, const QString &filename = QString());
 
     ~KisKraSaver();
 
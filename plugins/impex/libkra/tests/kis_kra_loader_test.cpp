@@ -36,6 +36,15 @@
 #include "kis_image_animation_interface.h"
 #include "kis_keyframe_channel.h"
 #include "kis_time_range.h"
+#include "kis_config.h"
+#include "kis_paint_device_frames_interface.h"
+#include "kis_selection.h"
+#include "kis_pixel_selection.h"
+#include <generator/kis_generator.h>
+#include <generator/kis_generator_layer.h>
+#include <filter/kis_filter_configuration.h>
+
+#include <KZip>
 
 #include  <sdk/tests/kistest.h>
 
@@ -169,5 +178,189 @@ void KisKraLoaderTest::testLoadAnimated()
     QCOMPARE(dev->defaultPixel(), red);
 }
 
+void compareDevices(KisPaintDeviceSP dev1, KisPaintDeviceSP dev2, const QString &name)
+{
+    QVERIFY2(dev2, qPrintable(name));
+    QCOMPARE(dev1->exactBounds(), dev2->exactBounds());
+
+    QPoint pt;
+    QVERIFY2(TestUtil::comparePaintDevices(pt, dev1, dev2), qPrintable(name));
+
+    if (!dev1->framesInterface()) return;
+
+    QVERIFY2(dev2->framesInterface(), qPrintable(name));
+
+    const QList<int> frames1 = dev1->framesInterface()->frames();
+    const QList<int> frames2 = dev2->framesInterface()->frames();
+    QCOMPARE(frames1.size(), frames2.size());
+
+    for (int i = 0; i < frames1.size(); i++) {
+        KisPaintDeviceSP frame1 = new KisPaintDevice(dev1->colorSpace());
+        KisPaintDeviceSP frame2 = new KisPaintDevice(dev2->colorSpace());
+
+        dev1->framesInterface()->fetchFrame(frames1[i], frame1);
+        dev2->framesInterface()->fetchFrame(frames2[i], frame2);
+
+        QCOMPARE(frame1->exactBounds(), frame2->exactBounds());
+        QVERIFY2(TestUtil::comparePaintDevices(pt, frame1, frame2),
+                 qPrintable(QString("%1, frame %2").arg(name).arg(i)));
+    }
+}
+
+void compareNodes(KisNodeSP node1, KisNodeSP node2)
+{
+    QCOMPARE(node1->name(), node2->name());
+    QCOMPARE(node1->childCount(), node2->childCount());
+
+    if (node1->paintDevice()) {
+        compareDevices(node1->paintDevice(), node2->paintDevice(), node1->name());
+    }
+
+    // generator layers render their content from the loaded selection
+    if (node1->original() && node1->original() != node1->paintDevice()) {
+        compareDevices(node1->original(), node2->original(), node1->name() + " (original)");
+    }
+
+    KisNodeSP child1 = node1->firstChild();
+    KisNodeSP child2 = node2->firstChild();
+
+    while (child1 && child2) {
+        compareNodes(child1, child2);
+
+        child1 = child1->nextSibling();
+        child2 = child2->nextSibling();
+    }
+}
+
+void testParallelLoadingImpl(const QString &fileName)
+{
+    KisConfig cfg(false);
+    const bool oldParallelLoading = cfg.parallelKraLoading();
+
+    cfg.setParallelKraLoading(false);
+    QScopedPointer<KisDocument> doc1(KisPart::instance()->createDocument());
+    QVERIFY(doc1->loadNativeFormat(fileName));
+
+    cfg.setParallelKraLoading(true);
+    QScopedPointer<KisDocument> doc2(KisPart::instance()->createDocument());
+    QVERIFY(doc2->loadNativeFormat(fileName));
+
+    cfg.setParallelKraLoading(oldParallelLoading);
+
+    doc1->image()->waitForDone();
+    doc2->image()->waitForDone();
+
+    compareNodes(doc1->image()->root(), doc2->image()->root());
+}
+
+void KisKraLoaderTest::testParallelLoading()
+{
+    testParallelLoadingImpl(QString(FILES_DATA_DIR) + QDir::separator() + "load_test.kra");
+}
+
+void KisKraLoaderTest::testParallelLoadingAnimated()
+{
+    testParallelLoadingImpl(QString(FILES_DATA_DIR) + QDir::separator() + "load_test_animation.kra");
+}
+
+void collectZipEntries(const KArchiveDirectory *dir, const QString &path, QMap<QString, QByteArray> *entries)
+{
+    Q_FOREACH (const QString &name, dir->entries()) {
+        const KArchiveEntry *entry = dir->entry(name);
+        const QString entryPath = path + name;
+
+        if (entry->isDirectory()) {
+            collectZipEntries(static_cast<const KArchiveDirectory*>(entry), entryPath + "/", entries);
+        } else {
+            entries->insert(entryPath, static_cast<const KArchiveFile*>(entry)->data());
+        }
+    }
+}
+
+void KisKraLoaderTest::testParallelLoadingLegacy()
+{
+    QMap<QString, QByteArray> entries;
+
+    {
+        KZip zip(QString(FILES_DATA_DIR) + QDir::separator() + "load_test.kra");
+        QVERIFY(zip.open(QIODevice::ReadOnly));
+        collectZipEntries(zip.directory(), QString(), &entries);
+    }
+
+    /**
+     * Convert the file into the syntax of Krita 1.x: the type of the
+     * layers is stored in 'layertype' attribute and the adjustment layers
+     * store their selection as a plain paint device
+     */
+    const QString fileName("parallel_loading_legacy.kra");
+
+    {
+        KZip zip(fileName);
+        QVERIFY(zip.open(QIODevice::WriteOnly));
+
+        zip.setCompression(KZip::NoCompression);
+        zip.writeFile("mimetype", entries.take("mimetype"));
+        zip.setCompression(KZip::DeflateCompression);
+
+        for (auto it = entries.begin(); it != entries.end(); ++it) {
+            QString name = it.key();
+            QByteArray data = it.value();
+
+            if (name == "maindoc.xml") {
+                data.replace("syntaxVersion=\"2\"", "syntaxVersion=\"1\"");
+                data.replace("nodetype=", "layertype=");
+            }
+
+            // 'layer10' is the adjustment layer
+            name.replace("/layers/layer10.pixelselection", "/layers/layer10.selection");
+
+            zip.writeFile(name, data);
+        }
+    }
+
+    testParallelLoadingImpl(fileName);
+
+    QScopedPointer<KisDocument> doc(KisPart::instance()->createDocument());
+    QVERIFY(doc->loadNativeFormat(fileName));
+    doc->image()->waitForDone();
+
+    KisNodeSP adjustmentLayer = TestUtil::findNode(doc->image()->root(), "Invert");
+    QVERIFY(adjustmentLayer);
+    QVERIFY(!adjustmentLayer->paintDevice()->exactBounds().isEmpty());
+}
+
+void KisKraLoaderTest::testParallelLoadingGenerator()
+{
+    const QString fileName("parallel_loading_generator.kra");
+
+    {
+        QScopedPointer<KisDocument> doc(KisPart::instance()->createDocument());
+
+        // mask parent should be destructed before the document!
+        TestUtil::MaskParent p(QRect(0,0,512,512));
+        doc->setCurrentImage(p.image);
+
+        KisGeneratorSP generator = KisGeneratorRegistry::instance()->get("color");
+        QVERIFY(generator);
+
+        KisFilterConfigurationSP config = generator->factoryConfiguration();
+        QVariant v;
+        v.setValue(KoColor(Qt::red, p.image->colorSpace()));
+        config->setProperty("color", v);
+
+        // the generator fills only the selected area
+        KisSelectionSP selection = new KisSelection();
+        selection->pixelSelection()->select(QRect(50, 50, 200, 100));
+
+        KisGeneratorLayerSP glayer = new KisGeneratorLayer(p.image, "glayer", config, selection);
+        p.image->addNode(glayer, p.image->root(), KisNodeSP());
+        glayer->setDirty();
+        p.image->waitForDone();
+
+        QVERIFY(doc->exportDocumentSync(QUrl::fromLocalFile(fileName), doc->mimeType()));
+    }
+
+    testParallelLoadingImpl(fileName);
+}
 
 KISTEST_MAIN(KisKraLoaderTest)
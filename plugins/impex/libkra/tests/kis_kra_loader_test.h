@@ -32,6 +32,11 @@ private Q_SLOTS:
     void testObligeSingleChildNonTranspPixel();
 
     void testLoadAnimated();
+
+    void testParallelLoading();
+    void testParallelLoadingAnimated();
+    void testParallelLoadingLegacy();
+    void testParallelLoadingGenerator();
 };
 
 #endif
@@ -21,6 +21,7 @@
 #include <QTest>
 
 #include <QBitArray>
+#include <QFileInfo>
 
 #include <KisDocument.h>
 #include <KoDocumentInfo.h>
@@ -56,6 +57,9 @@
 #include <KoResourcePaths.h>
 #include  <sdk/tests/kistest.h>
 
+#include <KZip>
+#include "kis_config.h"
+
 void KisKraSaverTest::initTestCase()
 {
     KoResourcePaths::addResourceDir("ko_patterns", QString(SYSTEM_RESOURCES_DATA_DIR) + "/patterns");
@@ -540,4 +544,106 @@ void KisKraSaverTest::testRoundTripShapeSelection()
     QVERIFY(chk.testPassed());
 }
 
+void collectZipEntries(const KArchiveDirectory *dir, const QString &path, QMap<QString, QByteArray> *entries)
+{
+    Q_FOREACH (const QString &name, dir->entries()) {
+        const KArchiveEntry *entry = dir->entry(name);
+        const QString entryPath = path + name;
+
+        if (entry->isDirectory()) {
+            collectZipEntries(static_cast<const KArchiveDirectory*>(entry), entryPath + "/", entries);
+        } else {
+            entries->insert(entryPath, static_cast<const KArchiveFile*>(entry)->data());
+        }
+    }
+}
+
+QMap<QString, QByteArray> loadZipEntries(const QString &fileName)
+{
+    QMap<QString, QByteArray> entries;
+
+    KZip zip(fileName);
+    if (zip.open(QIODevice::ReadOnly)) {
+        collectZipEntries(zip.directory(), QString(), &entries);
+    }
+
+    return entries;
+}
+
+void KisKraSaverTest::testParallelSaving()
+{
+    QScopedPointer<KisDocument> doc(createCompleteDocument());
+
+    KisConfig cfg(false);
+    const bool oldParallelSaving = cfg.parallelKraSaving();
+
+    cfg.setParallelKraSaving(false);
+    doc->exportDocumentSync(QUrl::fromLocalFile("parallel_saving_sequential.kra"), doc->mimeType());
+
+    cfg.setParallelKraSaving(true);
+    doc->exportDocumentSync(QUrl::fromLocalFile("parallel_saving_parallel.kra"), doc->mimeType());
+
+    cfg.setParallelKraSaving(oldParallelSaving);
+
+    const QMap<QString, QByteArray> sequentialEntries = loadZipEntries("parallel_saving_sequential.kra");
+    const QMap<QString, QByteArray> parallelEntries = loadZipEntries("parallel_saving_parallel.kra");
+
+    QVERIFY(!sequentialEntries.isEmpty());
+    QCOMPARE(parallelEntries.keys(), sequentialEntries.keys());
+
+    Q_FOREACH (const QString &name, sequentialEntries.keys()) {
+        // documentinfo.xml contains the time of saving
+        if (!name.contains("/layers/")) continue;
+
+        QVERIFY2(parallelEntries[name] == sequentialEntries[name], qPrintable(name));
+    }
+}
+
+void KisKraSaverTest::testIncrementalSaving()
+{
+    QScopedPointer<KisDocument> doc(createCompleteDocument());
+    const QString fileName = QFileInfo("incremental_saving.kra").absoluteFilePath();
+    const QString referenceFileName = QFileInfo("incremental_saving_reference.kra").absoluteFilePath();
+
+    KisConfig cfg(false);
+    const bool oldIncrementalSaving = cfg.incrementalKraSaving();
+    cfg.setIncrementalKraSaving(true);
+
+    QVERIFY(doc->exportDocumentSync(QUrl::fromLocalFile(fileName), doc->mimeType()));
+
+    KisNodeSP changedNode = TestUtil::findNode(doc->image()->root(), "paintlayer1");
+    KisNodeSP unchangedNode = TestUtil::findNode(doc->image()->root(), "paintlayer2");
+    QVERIFY(changedNode);
+    QVERIFY(unchangedNode);
+
+    KisPaintDeviceSP dev = changedNode->paintDevice();
+    dev->fill(QRect(10, 10, 50, 50), KoColor(Qt::red, dev->colorSpace()));
+
+    const QHash<QUuid, QString> unchangedNodes =
+        doc->savedNodesState(fileName).unchangedNodes(
+            KisSavedNodesState::fetchRevisions(doc->image()->root()));
+
+    QVERIFY(!unchangedNodes.contains(changedNode->uuid()));
+    QVERIFY(unchangedNodes.contains(unchangedNode->uuid()));
+
+    QVERIFY(doc->exportDocumentSync(QUrl::fromLocalFile(fileName), doc->mimeType()));
+
+    cfg.setIncrementalKraSaving(false);
+    QVERIFY(doc->exportDocumentSync(QUrl::fromLocalFile(referenceFileName), doc->mimeType()));
+    cfg.setIncrementalKraSaving(oldIncrementalSaving);
+
+    const QMap<QString, QByteArray> entries = loadZipEntries(fileName);
+    const QMap<QString, QByteArray> referenceEntries = loadZipEntries(referenceFileName);
+
+    QVERIFY(!referenceEntries.isEmpty());
+    QCOMPARE(entries.keys(), referenceEntries.keys());
+
+    Q_FOREACH (const QString &name, referenceEntries.keys()) {
+        // documentinfo.xml contains the time of saving
+        if (!name.contains("/layers/")) continue;
+
+        QVERIFY2(entries[name] == referenceEntries[name], qPrintable(name));
+    }
+}
+
 KISTEST_MAIN(KisKraSaverTest)
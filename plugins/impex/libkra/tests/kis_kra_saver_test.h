@@ -46,6 +46,10 @@ private Q_SLOTS:
     void testRoundTripShapeLayer();
     void testRoundTripShapeSelection();
 
+    void testParallelSaving();
+
+    void testIncrementalSaving();
+
 };
 
 #endif
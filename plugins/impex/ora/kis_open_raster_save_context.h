@@ -27,6 +27,10 @@ class KisOpenRasterSaveContext
 {
 public:
     virtual ~KisOpenRasterSaveContext() {}
+    /**
+     * Returns the name of the file the device is saved to. The data
+     * itself may be written later, but not later than saveStack().
+     */
     virtual QString saveDeviceData(KisPaintDeviceSP dev, KisMetaData::Store *metaData, const QRect &imageRect, const qreal xRes, const qreal yRes) = 0;
     virtual void saveStack(const QDomDocument& doc) = 0;
 };
@@ -101,10 +101,10 @@ KisImageBuilder_Result OraConverter::buildFile(QIODevice *io, KisImageSP image,
     }
 
     KisPaintDeviceSP dev = image->projection();
-    KisPNGConverter::saveDeviceToStore("mergedimage.png", image->bounds(), image->xRes(), image->yRes(), dev, store);
+    osc.saveMergedImage(dev, image->bounds(), image->xRes(), image->yRes());
 
     delete store;
-    return KisImageBuilder_RESULT_OK;
+    return osc.isSuccessful() ? KisImageBuilder_RESULT_OK : KisImageBuilder_RESULT_FAILURE;
 }
 
 
@@ -17,7 +17,10 @@
 
 #include "ora_save_context.h"
 
+#include <QBuffer>
 #include <QDomDocument>
+#include <QThread>
+#include <QtConcurrentMap>
 
 #include <KoStore.h>
 #include <KoStoreDevice.h>
@@ -31,23 +34,87 @@
 
 #include "kis_png_converter.h"
 
-OraSaveContext::OraSaveContext(KoStore* _store) : m_id(0), m_store(_store)
+/**
+ * The zlib compression level of the layer PNG files. The files are
+ * compressed by the workers, so the store doesn't deflate them again.
+ */
+const int oraPNGCompression = 3;
+
+struct OraSaveContext::LayerEncoder {
+    void operator()(PendingLayer &layer) const {
+        QBuffer buffer(&layer.data);
+        buffer.open(QIODevice::WriteOnly);
+
+        layer.success = KisPNGConverter::saveDeviceToIODevice(&buffer, layer.imageRect, layer.xRes, layer.yRes, layer.device, layer.metaData, oraPNGCompression);
+    }
+};
+
+OraSaveContext::OraSaveContext(KoStore* _store) : m_id(0), m_store(_store), m_success(true)
 {
 
 }
 
 QString OraSaveContext::saveDeviceData(KisPaintDeviceSP dev, KisMetaData::Store* metaData, const QRect &imageRect, const qreal xRes, const qreal yRes)
 {
-    QString filename = QString("data/layer%1.png").arg(m_id++);
-    if (KisPNGConverter::saveDeviceToStore(filename, imageRect, xRes, yRes, dev, m_store, metaData)) {
-        return filename;
+    PendingLayer layer;
+    layer.filename = QString("data/layer%1.png").arg(m_id++);
+    layer.device = dev;
+    layer.metaData = metaData;
+    layer.imageRect = imageRect;
+    layer.xRes = xRes;
+    layer.yRes = yRes;
+
+    m_pendingLayers.append(layer);
+
+    if (m_pendingLayers.size() >= 2 * QThread::idealThreadCount()) {
+        savePendingLayers();
     }
-    return "";
+
+    return layer.filename;
 }
 
+void OraSaveContext::savePendingLayers()
+{
+    if (m_pendingLayers.isEmpty()) return;
+
+    QtConcurrent::blockingMap(m_pendingLayers, LayerEncoder());
+
+    m_store->setCompressionEnabled(false);
+
+    Q_FOREACH (const PendingLayer &layer, m_pendingLayers) {
+        if (!layer.success) {
+            dbgFile << "Saving PNG failed:" << layer.filename;
+            m_success = false;
+            continue;
+        }
+
+        if (m_store->open(layer.filename)) {
+            KoStoreDevice io(m_store);
+            if (io.write(layer.data) != layer.data.size()) {
+                dbgFile << "Writing of data file failed :" << layer.filename;
+                m_success = false;
+            }
+            io.close();
+            m_store->close();
+        } else {
+            dbgFile << "Opening of data file failed :" << layer.filename;
+            m_success = false;
+        }
+    }
+
+    m_store->setCompressionEnabled(true);
+    m_pendingLayers.clear();
+}
 
 void OraSaveContext::saveStack(const QDomDocument& doc)
 {
+    savePendingLayers();
+
+    if (!m_success) {
+        dbgFile << "Some of the layers were not saved, skipping stack.xml";
+        return;
+    }
+
     if (m_store->open("stack.xml")) {
         KoStoreDevice io(m_store);
         io.write(doc.toByteArray());
@@ -55,5 +122,33 @@ void OraSaveContext::saveStack(const QDomDocument& doc)
         m_store->close();
     } else {
         dbgFile << "Opening of the stack.xml file failed :";
+        m_success = false;
+    }
+}
+
+void OraSaveContext::saveMergedImage(KisPaintDeviceSP dev, const QRect &imageRect, const qreal xRes, const qreal yRes)
+{
+    m_store->setCompressionEnabled(false);
+
+    if (m_store->open("mergedimage.png")) {
+        KoStoreDevice io(m_store);
+        if (!io.open(QIODevice::WriteOnly) ||
+            !KisPNGConverter::saveDeviceToIODevice(&io, imageRect, xRes, yRes, dev, 0, oraPNGCompression, true)) {
+
+            dbgFile << "Saving PNG failed: mergedimage.png";
+            m_success = false;
+        }
+        io.close();
+        m_store->close();
+    } else {
+        dbgFile << "Opening of data file failed : mergedimage.png";
+        m_success = false;
     }
+
+    m_store->setCompressionEnabled(true);
+}
+
+bool OraSaveContext::isSuccessful() const
+{
+    return m_success;
 }
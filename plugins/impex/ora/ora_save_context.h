@@ -19,6 +19,7 @@
 #define _ORA_SAVE_CONTEXT_H_
 
 class KoStore;
+#include <QVector>
 #include <metadata/kis_meta_data_entry.h>
 
 #include "kis_open_raster_save_context.h"
@@ -30,9 +31,48 @@ public:
     ~OraSaveContext() override{}
     QString saveDeviceData(KisPaintDeviceSP dev, KisMetaData::Store *metaData, const QRect &imageRect, const qreal xRes, const qreal yRes) override;
     void saveStack(const QDomDocument& doc) override;
+
+    /**
+     * Saves the projection of the image as mergedimage.png, deflating
+     * the bands of the image in parallel
+     */
+    void saveMergedImage(KisPaintDeviceSP dev, const QRect &imageRect, const qreal xRes, const qreal yRes);
+
+    /**
+     * Returns false if any of the layers or the merged image could not
+     * be encoded or written into the store. The stack is not written
+     * in this case, because it would point to missing files.
+     */
+    bool isSuccessful() const;
+
+private:
+    /**
+     * A layer whose PNG data is encoded in a worker thread and
+     * written into the store later, in the order of the layers
+     */
+    struct PendingLayer {
+        PendingLayer() : metaData(0), xRes(1.0), yRes(1.0), success(false) {}
+
+        QString filename;
+        KisPaintDeviceSP device;
+        KisMetaData::Store *metaData;
+        QRect imageRect;
+        qreal xRes;
+        qreal yRes;
+
+        QByteArray data;
+        bool success;
+    };
+
+    struct LayerEncoder;
+
+    void savePendingLayers();
+
 private:
     int m_id;
     KoStore* m_store;
+    bool m_success;
+    QVector<PendingLayer> m_pendingLayers;
 };
 
 #endif
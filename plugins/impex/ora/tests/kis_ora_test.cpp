@@ -0,0 +1,171 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_ora_test.h"
+
+#include <QTest>
+#include <QBuffer>
+#include <QDomDocument>
+#include <QThread>
+
+#include <KoStore.h>
+#include <KoColorSpaceRegistry.h>
+#include <KisDocument.h>
+#include <KisPart.h>
+#include <kis_image.h>
+#include <kis_group_layer.h>
+#include <kis_paint_device.h>
+#include <kis_paint_layer.h>
+#include <kis_sequential_iterator.h>
+
+#include "ora_converter.h"
+#include "ora_save_context.h"
+#include "testutil.h"
+
+#include  <sdk/tests/kistest.h>
+
+namespace {
+
+void fillDevice(KisPaintDeviceSP dev, const QRect &rc, int seed)
+{
+    KisSequentialIterator it(dev, rc);
+    while (it.nextPixel()) {
+        quint8 *pixel = it.rawData();
+        pixel[0] = quint8(it.x() * seed + it.y());
+        pixel[1] = quint8(it.y() * (seed + 3));
+        pixel[2] = quint8(seed * 17);
+        pixel[3] = quint8(128 + (it.x() + it.y()) % 128);
+    }
+}
+
+}
+
+void KisOraTest::testRoundTrip()
+{
+    const QRect imageRect(0, 0, 200, 150);
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+
+    KisImageSP image = new KisImage(0, imageRect.width(), imageRect.height(), cs, "ora round trip");
+    KisGroupLayerSP group = new KisGroupLayer(image, "group", OPACITY_OPAQUE_U8);
+    image->addNode(group, image->root());
+
+    // more layers than the save context encodes in one batch
+    const int numLayers = 2 * QThread::idealThreadCount() + 1;
+
+    QList<KisPaintLayerSP> layers;
+    for (int i = 0; i < numLayers; i++) {
+        KisPaintLayerSP layer = new KisPaintLayer(image, QString("layer%1").arg(i), OPACITY_OPAQUE_U8, cs);
+        fillDevice(layer->paintDevice(), imageRect, i + 1);
+        image->addNode(layer, i % 2 ? KisNodeSP(group) : KisNodeSP(image->root()));
+        layers << layer;
+    }
+    image->initialRefreshGraph();
+
+    QScopedPointer<KisDocument> doc(KisPart::instance()->createDocument());
+    doc->setCurrentImage(image);
+
+    QByteArray data;
+    {
+        QBuffer buffer(&data);
+        OraConverter converter(doc.data());
+        QCOMPARE(converter.buildFile(&buffer, image, vKisNodeSP()), KisImageBuilder_RESULT_OK);
+    }
+
+    // every layer listed in the stack should be present in the archive
+    {
+        QBuffer buffer(&data);
+        QScopedPointer<KoStore> store(KoStore::createStore(&buffer, KoStore::Read, "image/openraster", KoStore::Zip));
+        QVERIFY(store);
+
+        QVERIFY(store->open("stack.xml"));
+        QDomDocument stack;
+        QVERIFY(stack.setContent(store->device()));
+        store->close();
+
+        QDomNodeList elements = stack.elementsByTagName("layer");
+        QCOMPARE(elements.size(), numLayers);
+
+        for (int i = 0; i < elements.size(); i++) {
+            const QString src = elements.at(i).toElement().attribute("src");
+            QVERIFY2(store->hasFile(src), src.toLatin1());
+        }
+
+        QVERIFY(store->hasFile("mergedimage.png"));
+    }
+
+    QScopedPointer<KisDocument> doc2(KisPart::instance()->createDocument());
+
+    QBuffer buffer(&data);
+    OraConverter converter(doc2.data());
+    QCOMPARE(converter.buildImage(&buffer), KisImageBuilder_RESULT_OK);
+
+    KisImageSP loadedImage = converter.image();
+    QVERIFY(loadedImage);
+    QCOMPARE(loadedImage->bounds(), imageRect);
+
+    Q_FOREACH (KisPaintLayerSP layer, layers) {
+        KisNodeSP loadedNode = loadedImage->root()->findChildByName(layer->name());
+        QVERIFY2(loadedNode, layer->name().toLatin1());
+        QCOMPARE(loadedNode->parent()->name(), layer->parent()->name());
+
+        QPoint pt;
+        QVERIFY2(TestUtil::comparePaintDevices(pt, layer->paintDevice(), loadedNode->paintDevice()),
+                 layer->name().toLatin1());
+    }
+}
+
+void KisOraTest::testEncodeFailure()
+{
+    const QRect imageRect(0, 0, 64, 64);
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+    fillDevice(dev, imageRect, 1);
+
+    QByteArray data;
+    {
+        QBuffer buffer(&data);
+        QScopedPointer<KoStore> store(KoStore::createStore(&buffer, KoStore::Write, "image/openraster", KoStore::Zip));
+        QVERIFY(store);
+
+        OraSaveContext context(store.data());
+        QVERIFY(context.isSuccessful());
+
+        // an empty image cannot be encoded as PNG
+        QCOMPARE(context.saveDeviceData(dev, 0, QRect(), 1.0, 1.0), QString("data/layer0.png"));
+        QCOMPARE(context.saveDeviceData(dev, 0, imageRect, 1.0, 1.0), QString("data/layer1.png"));
+
+        QDomDocument stack;
+        stack.appendChild(stack.createElement("image"));
+        context.saveStack(stack);
+
+        QVERIFY(!context.isSuccessful());
+    }
+
+    QBuffer buffer(&data);
+    QScopedPointer<KoStore> store(KoStore::createStore(&buffer, KoStore::Read, "image/openraster", KoStore::Zip));
+    QVERIFY(store);
+
+    QVERIFY(!store->hasFile("data/layer0.png"));
+    QVERIFY(store->hasFile("data/layer1.png"));
+
+    // the stack would point to a missing file, so it is not written
+    QVERIFY(!store->hasFile("stack.xml"));
+}
+
+KISTEST_MAIN(KisOraTest)
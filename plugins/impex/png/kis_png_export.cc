@@ -73,6 +73,7 @@ KisImportExportFilter::ConversionStatus KisPNGExport::convert(KisDocument *docum
     options.forceSRGB = configuration->getBool("forceSRGB", true);
     options.storeAuthor = configuration->getBool("storeAuthor", false);
     options.storeMetaData = configuration->getBool("storeMetaData", false);
+    options.parallelEncoding = configuration->getBool("parallelEncoding", true);
 
     vKisAnnotationSP_it beginIt = image->beginAnnotations();
     vKisAnnotationSP_it endIt = image->endAnnotations();
@@ -121,6 +122,7 @@ KisPropertiesConfigurationSP KisPNGExport::defaultConfiguration(const QByteArray
     cfg->setProperty("forceSRGB", true);
     cfg->setProperty("storeMetaData", false);
     cfg->setProperty("storeAuthor", false);
+    cfg->setProperty("parallelEncoding", true);
 
     return cfg;
 }
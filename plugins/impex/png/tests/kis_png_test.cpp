@@ -22,6 +22,9 @@
 #include <QTest>
 #include <QCoreApplication>
 
+#include <KoColorSpaceRegistry.h>
+
+#include "kis_properties_configuration.h"
 #include "filestest.h"
 
 #include  <sdk/tests/kistest.h>
@@ -36,5 +39,32 @@ void KisPngTest::testFiles()
     TestUtil::testFiles(QString(FILES_DATA_DIR) + "/sources", QStringList(), QString(), 1);
 }
 
+void KisPngTest::testRoundTripParallel()
+{
+    KisPropertiesConfigurationSP cfg = new KisPropertiesConfiguration();
+    cfg->setProperty("compression", 6);
+    cfg->setProperty("forceSRGB", false);
+    cfg->setProperty("parallelEncoding", true);
+
+    const KoColorSpace *rgb8 = KoColorSpaceRegistry::instance()->rgb8();
+    const KoColorSpace *rgb16 = KoColorSpaceRegistry::instance()->rgb16();
+
+    /**
+     * A band holds about a megabyte of pixel data, rounded down to a multiple
+     * of 64 rows: 256 rows for the 8-bit image and 128 rows for the 16-bit
+     * one. The height of the image is not a multiple of it, so the last band
+     * is shorter than the others.
+     */
+    TestUtil::testRoundTrip("test_parallel.png", "image/png", cfg, QRect(0, 0, 1000, 1000), rgb8);
+    TestUtil::testRoundTrip("test_parallel.png", "image/png", cfg, QRect(0, 0, 1000, 1000), rgb16);
+
+    /**
+     * The rows are too wide for 64 rows to fit into a megabyte, so the bands
+     * are 64 rows high and the last one consists of a single row, which is
+     * filtered against the last row of the previous band.
+     */
+    TestUtil::testRoundTrip("test_parallel.png", "image/png", cfg, QRect(0, 0, 4100, 257), rgb8);
+}
+
 KISTEST_MAIN(KisPngTest)
 
@@ -21,6 +21,8 @@
 #include <QtGlobal>
 #include <QMap>
 #include <QIODevice>
+#include <QThread>
+#include <QtConcurrentMap>
 
 
 #include <KoColorSpace.h>
@@ -391,41 +393,248 @@ psd_status psd_unzip_with_prediction(psd_uchar *src_buf, psd_int src_len,
 /* End of third party block                                           */
 /**********************************************************************/
 
-QMap<quint16, QByteArray> fetchChannelsBytes(QIODevice *io, QVector<ChannelInfo*> channelInfoRecords,
-                                            int row, int width, int channelSize, bool processMasks)
+typedef boost::function<void(int, const QMap<quint16, QByteArray>&, int, quint8*)> PixelFunc;
+
+/**
+ * The channels are decoded in stripes of rows, which are aligned to the
+ * tiles of the paint device, so that the stripes could be decoded and
+ * written into the device in parallel without fighting for the tiles.
+ */
+const int rowsPerStripe = 64;
+
+struct RowsStripe {
+    RowsStripe() : firstRow(0), numRows(0) {}
+    RowsStripe(int _firstRow, int _numRows) : firstRow(_firstRow), numRows(_numRows) {}
+
+    int firstRow;
+    int numRows;
+};
+
+QVector<RowsStripe> splitIntoStripes(const QRect &layerRect, int firstRow, int numRows)
+{
+    QVector<RowsStripe> stripes;
+
+    int row = firstRow;
+    const int endRow = firstRow + numRows;
+
+    while (row < endRow) {
+        const int y = layerRect.top() + row;
+        const int offsetInTile = ((y % rowsPerStripe) + rowsPerStripe) % rowsPerStripe;
+        const int stripeEnd = qMin(endRow, row + rowsPerStripe - offsetInTile);
+
+        stripes << RowsStripe(row, stripeEnd - row);
+        row = stripeEnd;
+    }
+
+    return stripes;
+}
+
+/**
+ * The unpacked rows of a single channel. \p data points to the row
+ * \p firstRow of the layer.
+ */
+struct ChannelPlane {
+    ChannelPlane() : channelId(0), firstRow(0), data(0) {}
+
+    qint16 channelId;
+    int firstRow;
+    const quint8 *data;
+};
+
+void convertRows(KisPaintDeviceSP dev, const QRect &layerRect, const RowsStripe &stripe,
+                 const QVector<ChannelPlane> &planes, int channelSize, PixelFunc pixelFunc)
 {
-    const int uncompressedLength = width * channelSize;
+    const int rowSize = layerRect.width() * channelSize;
 
-    QMap<quint16, QByteArray> channelBytes;
+    KisHLineIteratorSP it = dev->createHLineIteratorNG(layerRect.left(), layerRect.top() + stripe.firstRow, layerRect.width());
+    for (int i = stripe.firstRow; i < stripe.firstRow + stripe.numRows; i++) {
+        QMap<quint16, QByteArray> channelBytes;
 
-    Q_FOREACH (ChannelInfo *channelInfo, channelInfoRecords) {
-        // user supplied masks are ignored here
-        if (!processMasks && channelInfo->channelId < -1) continue;
+        Q_FOREACH (const ChannelPlane &plane, planes) {
+            const quint8 *rowPtr = plane.data + (i - plane.firstRow) * rowSize;
+            channelBytes.insert(plane.channelId, QByteArray::fromRawData(reinterpret_cast<const char*>(rowPtr), rowSize));
+        }
 
-        io->seek(channelInfo->channelDataStart + channelInfo->channelOffset);
+        for (qint64 col = 0; col < layerRect.width(); col++){
+            pixelFunc(channelSize, channelBytes, col, it->rawData());
+            it->nextPixel();
+        }
+        it->nextRow();
+    }
+}
 
-        if (channelInfo->compressionType == Compression::Uncompressed) {
-            channelBytes[channelInfo->channelId] = io->read(uncompressedLength);
-            channelInfo->channelOffset += uncompressedLength;
+struct ZipChannelJob {
+    ZipChannelJob() : info(0), status(false) {}
+
+    ChannelInfo *info;
+    QByteArray compressedBytes;
+    QByteArray uncompressedBytes;
+    bool status;
+};
+
+struct ZipChannelDecoder {
+    ZipChannelDecoder(int width, int channelSize) : m_width(width), m_channelSize(channelSize) {}
+
+    void operator()(ZipChannelJob &job) const {
+        if (job.info->compressionType == Compression::ZIP) {
+            job.status = psd_unzip_without_prediction((quint8*)job.compressedBytes.data(), job.compressedBytes.size(),
+                                                      (quint8*)job.uncompressedBytes.data(), job.uncompressedBytes.size());
+        } else {
+            job.status = psd_unzip_with_prediction((quint8*)job.compressedBytes.data(), job.compressedBytes.size(),
+                                                   (quint8*)job.uncompressedBytes.data(), job.uncompressedBytes.size(),
+                                                   m_width, m_channelSize * 8);
         }
-        else if (channelInfo->compressionType == Compression::RLE) {
-            int rleLength = channelInfo->rleRowLengths[row];
-            QByteArray compressedBytes = io->read(rleLength);
-            QByteArray uncompressedBytes = Compression::uncompress(uncompressedLength, compressedBytes, channelInfo->compressionType);
-            channelBytes.insert(channelInfo->channelId, uncompressedBytes);
-            channelInfo->channelOffset += rleLength;
+
+        // the compressed data is not needed anymore
+        job.compressedBytes = QByteArray();
+    }
+
+private:
+    int m_width;
+    int m_channelSize;
+};
+
+/**
+ * The compressed rows of a channel read from the file for the current
+ * batch of stripes. The buffers are reused for all the batches.
+ */
+struct ChannelBatch {
+    ChannelBatch() : info(0) {}
+
+    ChannelInfo *info;
+    QByteArray compressedBytes;
+    QVector<int> rowOffsets;
+    QByteArray uncompressedBytes;
+};
+
+struct StripeDecoder {
+    StripeDecoder(KisPaintDeviceSP dev, const QRect &layerRect, int batchFirstRow,
+                  const QVector<ChannelBatch> &channels, int channelSize, PixelFunc pixelFunc)
+        : m_dev(dev),
+          m_layerRect(layerRect),
+          m_batchFirstRow(batchFirstRow),
+          m_channels(channels),
+          m_channelSize(channelSize),
+          m_pixelFunc(pixelFunc)
+    {
+    }
+
+    void operator()(const RowsStripe &stripe) const {
+        const int rowSize = m_layerRect.width() * m_channelSize;
+
+        QVector<ChannelPlane> planes;
+        planes.reserve(m_channels.size());
+
+        Q_FOREACH (const ChannelBatch &channel, m_channels) {
+            // every stripe writes only into its own rows of the buffer
+            quint8 *dstPtr = reinterpret_cast<quint8*>(const_cast<char*>(channel.uncompressedBytes.constData()));
+            const quint8 *srcPtr = reinterpret_cast<const quint8*>(channel.compressedBytes.constData());
+
+            for (int i = stripe.firstRow; i < stripe.firstRow + stripe.numRows; i++) {
+                const int batchRow = i - m_batchFirstRow;
+                const int rowOffset = channel.rowOffsets[batchRow];
+                const int rowLength = channel.rowOffsets[batchRow + 1] - rowOffset;
+
+                if (channel.info->compressionType == Compression::RLE) {
+                    Compression::uncompressRLE(srcPtr + rowOffset, rowLength,
+                                               dstPtr + batchRow * rowSize, rowSize);
+                } else {
+                    memcpy(dstPtr + batchRow * rowSize, srcPtr + rowOffset, qMin(rowLength, rowSize));
+                }
+            }
+
+            ChannelPlane plane;
+            plane.channelId = channel.info->channelId;
+            plane.firstRow = m_batchFirstRow;
+            plane.data = dstPtr;
+            planes << plane;
         }
-        else {
-            QString error = QString("Unsupported Compression mode: %1").arg(channelInfo->compressionType);
-            dbgFile << "ERROR: fetchChannelsBytes:" << error;
+
+        convertRows(m_dev, m_layerRect, stripe, planes, m_channelSize, m_pixelFunc);
+    }
+
+private:
+    KisPaintDeviceSP m_dev;
+    QRect m_layerRect;
+    int m_batchFirstRow;
+    const QVector<ChannelBatch> &m_channels;
+    int m_channelSize;
+    PixelFunc m_pixelFunc;
+};
+
+struct StripeConverter {
+    StripeConverter(KisPaintDeviceSP dev, const QRect &layerRect,
+                    const QVector<ChannelPlane> &planes, int channelSize, PixelFunc pixelFunc)
+        : m_dev(dev),
+          m_layerRect(layerRect),
+          m_planes(planes),
+          m_channelSize(channelSize),
+          m_pixelFunc(pixelFunc)
+    {
+    }
+
+    void operator()(const RowsStripe &stripe) const {
+        convertRows(m_dev, m_layerRect, stripe, m_planes, m_channelSize, m_pixelFunc);
+    }
+
+private:
+    KisPaintDeviceSP m_dev;
+    QRect m_layerRect;
+    const QVector<ChannelPlane> &m_planes;
+    int m_channelSize;
+    PixelFunc m_pixelFunc;
+};
+
+/**
+ * Reads the compressed rows [firstRow, firstRow + numRows) of the channel
+ * into \p batch. The rows of a channel are stored in the file one after
+ * another, so the whole batch is fetched with a single read.
+ */
+void fetchChannelRows(QIODevice *io, ChannelBatch &batch, int firstRow, int numRows, int uncompressedLength)
+{
+    ChannelInfo *channelInfo = batch.info;
+
+    batch.rowOffsets.resize(numRows + 1);
+    batch.rowOffsets[0] = 0;
+
+    if (channelInfo->compressionType == Compression::Uncompressed) {
+        for (int i = 0; i < numRows; i++) {
+            batch.rowOffsets[i + 1] = batch.rowOffsets[i] + uncompressedLength;
+        }
+    }
+    else if (channelInfo->compressionType == Compression::RLE) {
+        if (channelInfo->rleRowLengths.size() < firstRow + numRows) {
+            QString error = QString("Not enough RLE row lengths for channel: id = %1").arg(channelInfo->channelId);
+            dbgFile << "ERROR: fetchChannelRows:" << error;
             throw KisAslReaderUtils::ASLParseException(error);
         }
+
+        for (int i = 0; i < numRows; i++) {
+            batch.rowOffsets[i + 1] = batch.rowOffsets[i] + channelInfo->rleRowLengths[firstRow + i];
+        }
+    }
+    else {
+        QString error = QString("Unsupported Compression mode: %1").arg(channelInfo->compressionType);
+        dbgFile << "ERROR: fetchChannelRows:" << error;
+        throw KisAslReaderUtils::ASLParseException(error);
     }
 
-    return channelBytes;
-}
+    const int batchLength = batch.rowOffsets[numRows];
 
-typedef boost::function<void(int, const QMap<quint16, QByteArray>&, int, quint8*)> PixelFunc;
+    if (batch.compressedBytes.size() < batchLength) {
+        batch.compressedBytes.resize(batchLength);
+    }
+
+    io->seek(channelInfo->channelDataStart + channelInfo->channelOffset);
+    const qint64 bytesRead = io->read(batch.compressedBytes.data(), batchLength);
+
+    if (bytesRead < batchLength) {
+        dbgFile << "Channel data is truncated: channelId:" << channelInfo->channelId;
+        memset(batch.compressedBytes.data() + qMax(bytesRead, qint64(0)), 0, batchLength - qMax(bytesRead, qint64(0)));
+    }
+
+    channelInfo->channelOffset += batchLength;
+}
 
 void readCommon(KisPaintDeviceSP dev,
                 QIODevice *io,
@@ -442,29 +651,35 @@ void readCommon(KisPaintDeviceSP dev,
         return;
     }
 
+    QVector<RowsStripe> allStripes = splitIntoStripes(layerRect, 0, layerRect.height());
+
     if (infoRecords.first()->compressionType == Compression::ZIP ||
         infoRecords.first()->compressionType == Compression::ZIPWithPrediction) {
 
         const int numPixels = channelSize * layerRect.width() * layerRect.height();
 
-        QMap<quint16, QByteArray> channelBytes;
+        QVector<ZipChannelJob> jobs;
 
         Q_FOREACH (ChannelInfo *info, infoRecords) {
             io->seek(info->channelDataStart);
-            QByteArray compressedBytes = io->read(info->channelDataLength);
-            QByteArray uncompressedBytes(numPixels, 0);
 
-            bool status = false;
-            if (infoRecords.first()->compressionType == Compression::ZIP) {
-                status = psd_unzip_without_prediction((quint8*)compressedBytes.data(), compressedBytes.size(),
-                                                      (quint8*)uncompressedBytes.data(), uncompressedBytes.size());
-            } else {
-                status = psd_unzip_with_prediction((quint8*)compressedBytes.data(), compressedBytes.size(),
-                                                   (quint8*)uncompressedBytes.data(), uncompressedBytes.size(),
-                                                   layerRect.width(), channelSize * 8);
-            }
+            ZipChannelJob job;
+            job.info = info;
+            job.compressedBytes = io->read(info->channelDataLength);
+            job.uncompressedBytes = QByteArray(numPixels, 0);
+            jobs << job;
+        }
+
+        // the channels are unzipped in parallel, but the errors are reported
+        // from the calling thread, since exceptions cannot leave the pool
+        QtConcurrent::blockingMap(jobs, ZipChannelDecoder(layerRect.width(), channelSize));
+
+        QVector<ChannelPlane> planes;
 
-            if (!status) {
+        Q_FOREACH (const ZipChannelJob &job, jobs) {
+            ChannelInfo *info = job.info;
+
+            if (!job.status) {
                 QString error = QString("Failed to unzip channel data: id = %1, compression = %2").arg(info->channelId).arg(info->compressionType);
                 dbgFile << "ERROR:" << error;
                 dbgFile << "      " << ppVar(info->channelId);
@@ -474,30 +689,53 @@ void readCommon(KisPaintDeviceSP dev,
                 throw KisAslReaderUtils::ASLParseException(error);
             }
 
-            channelBytes.insert(info->channelId, uncompressedBytes);
+            ChannelPlane plane;
+            plane.channelId = info->channelId;
+            plane.firstRow = 0;
+            plane.data = reinterpret_cast<const quint8*>(job.uncompressedBytes.constData());
+            planes << plane;
         }
 
-        KisSequentialIterator it(dev, layerRect);
-        int col = 0;
-        while (it.nextPixel()) {
-            pixelFunc(channelSize, channelBytes, col, it.rawData());
-            col++;
-        }
+        QtConcurrent::blockingMap(allStripes, StripeConverter(dev, layerRect, planes, channelSize, pixelFunc));
 
     } else {
-        KisHLineIteratorSP it = dev->createHLineIteratorNG(layerRect.left(), layerRect.top(), layerRect.width());
-        for (int i = 0 ; i < layerRect.height(); i++) {
-            QMap<quint16, QByteArray> channelBytes;
+        const int uncompressedLength = layerRect.width() * channelSize;
 
-            channelBytes = fetchChannelsBytes(io, infoRecords,
-                                              i, layerRect.width(),
-                                              channelSize, processMasks);
+        QVector<ChannelBatch> channels;
 
-            for (qint64 col = 0; col < layerRect.width(); col++){
-                pixelFunc(channelSize, channelBytes, col, it->rawData());
-                it->nextPixel();
+        Q_FOREACH (ChannelInfo *info, infoRecords) {
+            // user supplied masks are ignored here
+            if (!processMasks && info->channelId < -1) continue;
+
+            ChannelBatch batch;
+            batch.info = info;
+            channels << batch;
+        }
+
+        /**
+         * The compressed data is read from the file sequentially batch by
+         * batch, every batch is decoded by the thread pool. The batches
+         * limit the memory consumed by the unpacked rows.
+         */
+        const int stripesPerBatch = qMax(1, 2 * QThread::idealThreadCount());
+
+        for (int stripeIndex = 0; stripeIndex < allStripes.size(); stripeIndex += stripesPerBatch) {
+            QVector<RowsStripe> stripes = allStripes.mid(stripeIndex, stripesPerBatch);
+
+            const int batchFirstRow = stripes.first().firstRow;
+            const int batchNumRows = stripes.last().firstRow + stripes.last().numRows - batchFirstRow;
+
+            for (int i = 0; i < channels.size(); i++) {
+                ChannelBatch &batch = channels[i];
+
+                fetchChannelRows(io, batch, batchFirstRow, batchNumRows, uncompressedLength);
+
+                if (batch.uncompressedBytes.size() < batchNumRows * uncompressedLength) {
+                    batch.uncompressedBytes.resize(batchNumRows * uncompressedLength);
+                }
             }
-            it->nextRow();
+
+            QtConcurrent::blockingMap(stripes, StripeDecoder(dev, layerRect, batchFirstRow, channels, channelSize, pixelFunc));
         }
     }
 }
@@ -543,53 +781,6 @@ void readAlphaMaskChannels(QIODevice *io,
     readCommon(device, io, layerRect, infoRecords, channelSize, &readAlphaMaskPixelCommon, true);
 }
 
-void writeChannelDataRLE(QIODevice *io, const quint8 *plane, const int channelSize, const QRect &rc, const qint64 sizeFieldOffset, const qint64 rleBlockOffset, const bool writeCompressionType)
-{
-    typedef KisAslWriterUtils::OffsetStreamPusher<quint32> Pusher;
-    QScopedPointer<Pusher> channelBlockSizeExternalTag;
-    if (sizeFieldOffset >= 0) {
-        channelBlockSizeExternalTag.reset(new Pusher(io, 0, sizeFieldOffset));
-    }
-
-    if (writeCompressionType) {
-        SAFE_WRITE_EX(io, (quint16)Compression::RLE);
-    }
-
-    const bool externalRleBlock = rleBlockOffset >= 0;
-
-    // the start of RLE sizes block
-    const qint64 channelRLESizePos = externalRleBlock ? rleBlockOffset : io->pos();
-
-    {
-        QScopedPointer<KisOffsetKeeper> rleOffsetKeeper;
-
-        if (externalRleBlock) {
-            rleOffsetKeeper.reset(new KisOffsetKeeper(io));
-            io->seek(rleBlockOffset);
-        }
-
-        // write zero's for the channel lengths block
-        for(int i = 0; i < rc.height(); ++i) {
-            // XXX: choose size for PSB!
-            const quint16 fakeRLEBLockSize = 0;
-            SAFE_WRITE_EX(io, fakeRLEBLockSize);
-        }
-    }
-
-    quint32 stride = channelSize * rc.width();
-    for (qint32 row = 0; row < rc.height(); ++row) {
-
-        QByteArray uncompressed = QByteArray::fromRawData((const char*)plane + row * stride, stride);
-        QByteArray compressed = Compression::compress(uncompressed, Compression::RLE);
-
-        KisAslWriterUtils::OffsetStreamPusher<quint16> rleExternalTag(io, 0, channelRLESizePos + row * sizeof(quint16));
-
-        if (io->write(compressed) != compressed.size()) {
-            throw KisAslWriterUtils::ASLWriteException("Failed to write image data");
-        }
-    }
-}
-
 inline void preparePixelForWrite(quint8 *dataPlane,
                                  int numPixels,
                                  int channelSize,
@@ -633,6 +824,180 @@ inline void preparePixelForWrite(quint8 *dataPlane,
     }
 }
 
+/**
+ * Writes the rows of a channel, which have already been packed with RLE.
+ * The i-th row is stored at \p compressed + i * \p slotSize.
+ */
+void writeCompressedChannelRLE(QIODevice *io,
+                               const quint8 *compressed,
+                               const int slotSize,
+                               const quint16 *rowLengths,
+                               const int numRows,
+                               const qint64 sizeFieldOffset,
+                               const qint64 rleBlockOffset,
+                               const bool writeCompressionType)
+{
+    typedef KisAslWriterUtils::OffsetStreamPusher<quint32> Pusher;
+    QScopedPointer<Pusher> channelBlockSizeExternalTag;
+    if (sizeFieldOffset >= 0) {
+        channelBlockSizeExternalTag.reset(new Pusher(io, 0, sizeFieldOffset));
+    }
+
+    if (writeCompressionType) {
+        SAFE_WRITE_EX(io, (quint16)Compression::RLE);
+    }
+
+    const bool externalRleBlock = rleBlockOffset >= 0;
+
+    {
+        QScopedPointer<KisOffsetKeeper> rleOffsetKeeper;
+
+        if (externalRleBlock) {
+            rleOffsetKeeper.reset(new KisOffsetKeeper(io));
+            io->seek(rleBlockOffset);
+        }
+
+        // the rows are already packed, so the lengths block is written
+        // right away instead of being patched row by row
+        for(int i = 0; i < numRows; ++i) {
+            // XXX: choose size for PSB!
+            const quint16 rleBlockSize = rowLengths[i];
+            SAFE_WRITE_EX(io, rleBlockSize);
+        }
+    }
+
+    for (int row = 0; row < numRows; ++row) {
+        const char *rowPtr = reinterpret_cast<const char*>(compressed + row * slotSize);
+
+        if (io->write(rowPtr, rowLengths[row]) != rowLengths[row]) {
+            throw KisAslWriterUtils::ASLWriteException("Failed to write image data");
+        }
+    }
+}
+
+/**
+ * A channel being packed with RLE. Every row is packed into its own slot
+ * of \p compressed, so all the rows can be packed in parallel.
+ */
+struct RleChannel {
+    RleChannel() : plane(0), channelId(0), compressed(0), rowLengths(0) {}
+
+    quint8 *plane;
+    qint16 channelId;
+    quint8 *compressed;
+    quint16 *rowLengths;
+};
+
+struct RleChannelStripe {
+    RleChannelStripe() : channel(0) {}
+    RleChannelStripe(const RleChannel *_channel, const RowsStripe &_stripe) : channel(_channel), stripe(_stripe) {}
+
+    const RleChannel *channel;
+    RowsStripe stripe;
+};
+
+struct RleStripeEncoder {
+    RleStripeEncoder(int width, int channelSize, psd_color_mode colorMode, bool preparePixels)
+        : m_width(width),
+          m_channelSize(channelSize),
+          m_colorMode(colorMode),
+          m_preparePixels(preparePixels)
+    {
+    }
+
+    void operator()(const RleChannelStripe &job) const {
+        const int rowSize = m_width * m_channelSize;
+        const int slotSize = Compression::rleMaxCompressedSize(rowSize);
+        const RleChannel *channel = job.channel;
+
+        quint8 *rowsPtr = channel->plane + job.stripe.firstRow * rowSize;
+
+        if (m_preparePixels) {
+            preparePixelForWrite(rowsPtr, job.stripe.numRows * m_width, m_channelSize, channel->channelId, m_colorMode);
+        }
+
+        for (int i = job.stripe.firstRow; i < job.stripe.firstRow + job.stripe.numRows; i++) {
+            const int compressedLength =
+                Compression::compressRLE(channel->plane + i * rowSize, rowSize,
+                                         channel->compressed + i * slotSize);
+
+            channel->rowLengths[i] = compressedLength;
+        }
+    }
+
+private:
+    int m_width;
+    int m_channelSize;
+    psd_color_mode m_colorMode;
+    bool m_preparePixels;
+};
+
+/**
+ * Packs the prepared \p planes with RLE using the global thread pool and
+ * writes them into \p io in the order of \p writingInfoList.
+ */
+void writeChannelsRLE(QIODevice *io,
+                      const QVector<quint8*> &planes,
+                      const QVector<ChannelWritingInfo> &writingInfoList,
+                      const QRect &rc,
+                      int channelSize,
+                      psd_color_mode colorMode,
+                      bool preparePixels,
+                      const bool writeCompressionType)
+{
+    const int rowSize = rc.width() * channelSize;
+    const int slotSize = Compression::rleMaxCompressedSize(rowSize);
+    const int numChannels = writingInfoList.size();
+
+    QVector<QByteArray> compressedBuffers(numChannels);
+    QVector<QVector<quint16>> rowLengthBuffers(numChannels);
+    QVector<RleChannel> channels(numChannels);
+
+    for (int i = 0; i < numChannels; i++) {
+        compressedBuffers[i].resize(slotSize * rc.height());
+        rowLengthBuffers[i].resize(rc.height());
+
+        RleChannel &channel = channels[i];
+        channel.plane = planes[i];
+        channel.channelId = writingInfoList[i].channelId;
+        channel.compressed = reinterpret_cast<quint8*>(compressedBuffers[i].data());
+        channel.rowLengths = rowLengthBuffers[i].data();
+    }
+
+    QVector<RleChannelStripe> jobs;
+    const QVector<RowsStripe> stripes = splitIntoStripes(rc, 0, rc.height());
+
+    for (int i = 0; i < numChannels; i++) {
+        Q_FOREACH (const RowsStripe &stripe, stripes) {
+            jobs << RleChannelStripe(&channels[i], stripe);
+        }
+    }
+
+    QtConcurrent::blockingMap(jobs, RleStripeEncoder(rc.width(), channelSize, colorMode, preparePixels));
+
+    for (int i = 0; i < numChannels; i++) {
+        const ChannelWritingInfo &info = writingInfoList[i];
+
+        dbgFile << "\tWriting channel" << i << "psd channel id" << info.channelId;
+        dbgFile << "\t\tchannel start" << ppVar(io->pos());
+
+        writeCompressedChannelRLE(io, channels[i].compressed, slotSize, channels[i].rowLengths, rc.height(),
+                                  info.sizeFieldOffset, info.rleBlockOffset, writeCompressionType);
+    }
+}
+
+void writeChannelDataRLE(QIODevice *io, const quint8 *plane, const int channelSize, const QRect &rc, const qint64 sizeFieldOffset, const qint64 rleBlockOffset, const bool writeCompressionType)
+{
+    QVector<quint8*> planes;
+    planes << const_cast<quint8*>(plane);
+
+    QVector<ChannelWritingInfo> writingInfoList;
+    writingInfoList << ChannelWritingInfo(0, sizeFieldOffset, rleBlockOffset);
+
+    // the plane is only read when the pixels are not prepared
+    writeChannelsRLE(io, planes, writingInfoList, rc, channelSize, COLORMODE_UNKNOWN, false, writeCompressionType);
+}
+
 void writePixelDataCommon(QIODevice *io,
                           KisPaintDeviceSP dev,
                           const QRect &rc,
@@ -686,23 +1051,10 @@ void writePixelDataCommon(QIODevice *io,
 
     KIS_ASSERT_RECOVER_RETURN(planes.size() >= writingInfoList.size());
 
-    const int numPixels = rc.width() * rc.height();
-
     // write down the planes
 
     try {
-        for (int i = 0; i < writingInfoList.size(); i++) {
-            const ChannelWritingInfo &info = writingInfoList[i];
-
-            dbgFile << "\tWriting channel" << i << "psd channel id" << info.channelId;
-
-            preparePixelForWrite(planes[i], numPixels, channelSize, info.channelId, colorMode);
-
-            dbgFile << "\t\tchannel start" << ppVar(io->pos());
-
-            writeChannelDataRLE(io, planes[i], channelSize, rc, info.sizeFieldOffset, info.rleBlockOffset, writeCompressionType);
-        }
-
+        writeChannelsRLE(io, planes, writingInfoList, rc, channelSize, colorMode, true, writeCompressionType);
     } catch (KisAslWriterUtils::ASLWriteException &e) {
         qDeleteAll(planes);
         planes.clear();
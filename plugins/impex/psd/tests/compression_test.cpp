@@ -52,6 +52,87 @@ void CompressionTest::testCompressionRLE()
 
 }
 
+namespace {
+
+QByteArray byteRange(int first, int count)
+{
+    QByteArray result;
+    for (int i = 0; i < count; ++i) {
+        result.append(char(first + i));
+    }
+    return result;
+}
+
+void checkRLERow(const QByteArray &row, const QByteArray &expected)
+{
+    const int maxSize = Compression::rleMaxCompressedSize(row.size());
+    QByteArray compressed(maxSize, 0);
+
+    const int compressedSize =
+        Compression::compressRLE(reinterpret_cast<const quint8*>(row.constData()), row.size(),
+                                 reinterpret_cast<quint8*>(compressed.data()));
+    QVERIFY(compressedSize <= maxSize);
+    compressed.truncate(compressedSize);
+
+    if (!expected.isNull()) {
+        QCOMPARE(compressed.toHex(), expected.toHex());
+    }
+
+    QByteArray uncompressed(row.size(), 'z');
+    Compression::uncompressRLE(reinterpret_cast<const quint8*>(compressed.constData()), compressed.size(),
+                               reinterpret_cast<quint8*>(uncompressed.data()), uncompressed.size());
+    QCOMPARE(uncompressed, row);
+
+    QCOMPARE(Compression::uncompress(row.size(), compressed, Compression::RLE), row);
+}
+
+}
+
+void CompressionTest::testCompressionRLEBuffers()
+{
+    // a single byte is written as a one byte literal
+    checkRLERow(QByteArray(1, 'a'), QByteArray::fromHex("0061"));
+
+    // a run of two followed by a trailing single byte
+    checkRLERow("aab", QByteArray::fromHex("ff61" "0062"));
+
+    // a literal stops right before a repeat of three bytes
+    checkRLERow("abccc", QByteArray::fromHex("016162" "fe63"));
+    checkRLERow("abcdef", QByteArray::fromHex("0461626364650066"));
+    checkRLERow(QByteArray("aaaab") + byteRange(10, 3) + "zz",
+                QByteArray::fromHex("fd61" "04620a0b0c7a" "007a"));
+
+    // runs are split at 128 bytes
+    checkRLERow(QByteArray(128, 'y'), QByteArray::fromHex("8179"));
+    checkRLERow(QByteArray(129, 'y'), QByteArray::fromHex("8179" "0079"));
+    checkRLERow(QByteArray(300, 'x'), QByteArray::fromHex("8178" "8178" "d578"));
+
+    // and so are the literals; the last byte of a row always ends up
+    // in a literal of its own
+    checkRLERow(byteRange(0, 128),
+                QByteArray(1, char(0x7e)) + byteRange(0, 127) +
+                QByteArray(1, char(0x00)) + byteRange(127, 1));
+    checkRLERow(byteRange(0, 129),
+                QByteArray(1, char(0x7f)) + byteRange(0, 128) +
+                QByteArray(1, char(0x00)) + byteRange(128, 1));
+    checkRLERow(byteRange(0, 130),
+                QByteArray(1, char(0x7f)) + byteRange(0, 128) +
+                QByteArray(1, char(0x00)) + byteRange(128, 1) +
+                QByteArray(1, char(0x00)) + byteRange(129, 1));
+
+    // longer rows are only checked for the round trip
+    QByteArray noise;
+    for (int i = 0; i < 1000; ++i) {
+        noise.append(char(rand()));
+    }
+    checkRLERow(noise, QByteArray());
+
+    QByteArray pairs;
+    for (int i = 0; i < 1000; ++i) {
+        pairs.append(char(i / 2));
+    }
+    checkRLERow(pairs, QByteArray());
+}
 
 void CompressionTest::testCompressionZIP()
 {
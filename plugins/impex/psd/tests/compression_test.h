@@ -27,6 +27,7 @@ class CompressionTest : public QObject
 private Q_SLOTS:
 
     void testCompressionRLE();
+    void testCompressionRLEBuffers();
     void testCompressionZIP();
     void testCompressionUncompressed();
 
@@ -59,6 +59,7 @@ void KisTIFFOptionsWidget::setConfiguration(const KisPropertiesConfigurationSP c
     kComboBoxFaxMode->setCurrentIndex(cfg->getInt("faxmode", 0));
     compressionLevelPixarLog->setValue(cfg->getInt("pixarlog", 6));
     chkSaveProfile->setChecked(cfg->getBool("saveProfile", true));
+    chkTiled->setChecked(cfg->getBool("tiled", false));
 
     if (cfg->getInt("type", -1) == KoChannelInfo::FLOAT16 || cfg->getInt("type", -1) == KoChannelInfo::FLOAT32) {
         kComboBoxPredictor->removeItem(1);
@@ -86,6 +87,7 @@ KisPropertiesConfigurationSP KisTIFFOptionsWidget::configuration() const
     cfg->setProperty("faxmode", kComboBoxFaxMode->currentIndex());
     cfg->setProperty("pixarlog", compressionLevelPixarLog->value());
     cfg->setProperty("saveProfile", chkSaveProfile->isChecked());
+    cfg->setProperty("tiled", chkTiled->isChecked());
 
     return cfg;
 }
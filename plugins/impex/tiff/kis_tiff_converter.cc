@@ -23,6 +23,8 @@
 
 #include <QFile>
 #include <QApplication>
+#include <QThread>
+#include <QtConcurrentMap>
 
 #include <QFileInfo>
 
@@ -163,6 +165,245 @@ QPair<QString, QString> getColorSpaceForColorType(uint16 sampletype, uint16 colo
     }
     return QPair<QString, QString>();
 }
+
+/**
+ * Reads the tiles or the strips of a TIFF directory one by one into the
+ * paint device. The decoder owns the buffers, so every thread reading
+ * the file in parallel uses its own decoder with its own TIFF handle.
+ */
+class KisTIFFChunkDecoder
+{
+public:
+    struct Layout {
+        bool tiled = false;
+        uint16 planarconfig = PLANARCONFIG_CONTIG;
+        uint16 nbchannels = 0;
+        uint16 depth = 0;
+        uint32 width = 0;
+        uint32 height = 0;
+        uint32 tileWidth = 0;
+        uint32 tileHeight = 0;
+        uint32 rowsPerStrip = 0;
+        uint16 vsubsampling = 1;
+        QVector<uint16> lineSizeCoeffs;
+
+        int numChunks() const {
+            if (tiled) {
+                return ((width + tileWidth - 1) / tileWidth) * ((height + tileHeight - 1) / tileHeight);
+            }
+            return (height + rowsPerStrip - 1) / rowsPerStrip;
+        }
+    };
+
+    KisTIFFChunkDecoder(TIFF *image, const Layout &layout, KisTIFFReaderBase *tiffReader)
+        : m_image(image),
+          m_layout(layout),
+          m_tiffReader(tiffReader),
+          m_buf(0)
+    {
+        const uint16 nbchannels = layout.nbchannels;
+        const uint16 depth = layout.depth;
+
+        if (layout.tiled) {
+            uint32 linewidth = (layout.tileWidth * depth * nbchannels) / 8;
+            if (layout.planarconfig == PLANARCONFIG_CONTIG) {
+                m_buf = _TIFFmalloc(TIFFTileSize(image));
+                if (depth < 16) {
+                    m_tiffstream.reset(new KisBufferStreamContigBelow16((uint8*)m_buf, depth, linewidth));
+                }
+                else if (depth < 32) {
+                    m_tiffstream.reset(new KisBufferStreamContigBelow32((uint8*)m_buf, depth, linewidth));
+                }
+                else {
+                    m_tiffstream.reset(new KisBufferStreamContigAbove32((uint8*)m_buf, depth, linewidth));
+                }
+            }
+            else {
+                m_planeBufs.resize(nbchannels);
+                QVector<uint32> lineSizes(nbchannels);
+                tmsize_t baseSize = TIFFTileSize(image) / nbchannels;
+                for (uint i = 0; i < nbchannels; i++) {
+                    m_planeBufs[i] = _TIFFmalloc(baseSize);
+                    lineSizes[i] = layout.tileWidth; // baseSize / lineSizeCoeffs[i];
+                }
+                m_tiffstream.reset(new KisBufferStreamSeperate((uint8**) m_planeBufs.data(), nbchannels, depth, lineSizes.data()));
+            }
+        }
+        else {
+            tsize_t stripsize = TIFFStripSize(image);
+            if (layout.planarconfig == PLANARCONFIG_CONTIG) {
+                m_buf = _TIFFmalloc(stripsize);
+                if (depth < 16) {
+                    m_tiffstream.reset(new KisBufferStreamContigBelow16((uint8*)m_buf, depth, stripsize / layout.rowsPerStrip));
+                }
+                else if (depth < 32) {
+                    m_tiffstream.reset(new KisBufferStreamContigBelow32((uint8*)m_buf, depth, stripsize / layout.rowsPerStrip));
+                }
+                else {
+                    m_tiffstream.reset(new KisBufferStreamContigAbove32((uint8*)m_buf, depth, stripsize / layout.rowsPerStrip));
+                }
+            }
+            else {
+                m_planeBufs.resize(nbchannels);
+                uint32 scanLineSize = stripsize / layout.rowsPerStrip;
+                dbgFile << " scanLineSize for each plan =" << scanLineSize;
+                QVector<uint32> lineSizes(nbchannels);
+                for (uint i = 0; i < nbchannels; i++) {
+                    m_planeBufs[i] = _TIFFmalloc(stripsize);
+                    lineSizes[i] = scanLineSize / layout.lineSizeCoeffs[i];
+                }
+                m_tiffstream.reset(new KisBufferStreamSeperate((uint8**) m_planeBufs.data(), nbchannels, depth, lineSizes.data()));
+            }
+        }
+    }
+
+    ~KisTIFFChunkDecoder() {
+        m_tiffstream.reset();
+
+        if (m_buf) {
+            _TIFFfree(m_buf);
+        }
+        Q_FOREACH (tdata_t buf, m_planeBufs) {
+            _TIFFfree(buf);
+        }
+    }
+
+    /**
+     * Reads the chunk with index \p chunk, as counted by Layout::numChunks()
+     */
+    void readChunk(int chunk) {
+        if (m_layout.tiled) {
+            const uint32 tilesAcross = (m_layout.width + m_layout.tileWidth - 1) / m_layout.tileWidth;
+            readTile((chunk % tilesAcross) * m_layout.tileWidth, (chunk / tilesAcross) * m_layout.tileHeight);
+        } else {
+            readStrip(chunk * m_layout.rowsPerStrip);
+        }
+    }
+
+    void readTile(uint32 x, uint32 y) {
+        dbgFile << "Reading tile x =" << x << " y =" << y;
+        if (m_layout.planarconfig == PLANARCONFIG_CONTIG) {
+            TIFFReadTile(m_image, m_buf, x, y, 0, (tsample_t) - 1);
+        }
+        else {
+            for (uint i = 0; i < m_layout.nbchannels; i++) {
+                TIFFReadTile(m_image, m_planeBufs[i], x, y, 0, i);
+            }
+        }
+        uint32 realTileWidth = (x + m_layout.tileWidth) < m_layout.width ? m_layout.tileWidth : m_layout.width - x;
+        for (uint yintile = 0; y + yintile < m_layout.height && yintile < m_layout.tileHeight / m_layout.vsubsampling;) {
+            m_tiffReader->copyDataToChannels(x, y + yintile , realTileWidth, m_tiffstream.data());
+            yintile += 1;
+            m_tiffstream->moveToLine(yintile);
+        }
+        m_tiffstream->restart();
+    }
+
+    /**
+     * Reads the strip containing row \p y starting from this row
+     * @return the first row after the strip
+     */
+    uint32 readStrip(uint32 y) {
+        if (m_layout.planarconfig == PLANARCONFIG_CONTIG) {
+            TIFFReadEncodedStrip(m_image, TIFFComputeStrip(m_image, y, 0) , m_buf, (tsize_t) - 1);
+        }
+        else {
+            for (uint i = 0; i < m_layout.nbchannels; i++) {
+                TIFFReadEncodedStrip(m_image, TIFFComputeStrip(m_image, y, i), m_planeBufs[i], (tsize_t) - 1);
+            }
+        }
+        for (uint32 yinstrip = 0 ; yinstrip < m_layout.rowsPerStrip && y < m_layout.height ;) {
+            uint linesread = m_tiffReader->copyDataToChannels(0, y, m_layout.width, m_tiffstream.data());
+            y += linesread;
+            yinstrip += linesread;
+            m_tiffstream->moveToLine(yinstrip);
+        }
+        m_tiffstream->restart();
+        return y;
+    }
+
+private:
+    TIFF *m_image;
+    Layout m_layout;
+    KisTIFFReaderBase *m_tiffReader;
+    tdata_t m_buf;
+    QVector<tdata_t> m_planeBufs; // used only for planar configuration separated
+    QScopedPointer<KisBufferStreamBase> m_tiffstream;
+};
+
+struct KisTIFFChunkRange {
+    KisTIFFChunkRange() : first(0), last(0) {}
+    KisTIFFChunkRange(int _first, int _last) : first(_first), last(_last) {}
+
+    int first;
+    int last;
+};
+
+/**
+ * libtiff handles cannot be shared between threads, so every job opens
+ * the file once more and decodes its own range of the chunks. The TIFF
+ * tiles and strips are disjoint, so the jobs write into different pixels
+ * of the paint device.
+ */
+struct KisTIFFParallelChunkReader {
+    KisTIFFParallelChunkReader(const QString &filename, tdir_t directory,
+                               const KisTIFFChunkDecoder::Layout &layout,
+                               KisTIFFReaderBase *tiffReader, QAtomicInt *failed)
+        : m_filename(filename),
+          m_directory(directory),
+          m_layout(layout),
+          m_tiffReader(tiffReader),
+          m_failed(failed)
+    {
+    }
+
+    void operator()(const KisTIFFChunkRange &range) const {
+        TIFF *image = TIFFOpen(QFile::encodeName(m_filename), "r");
+        if (!image) {
+            m_failed->ref();
+            return;
+        }
+
+        if (TIFFSetDirectory(image, m_directory)) {
+            KisTIFFChunkDecoder decoder(image, m_layout, m_tiffReader);
+            for (int chunk = range.first; chunk < range.last; chunk++) {
+                decoder.readChunk(chunk);
+            }
+        } else {
+            m_failed->ref();
+        }
+
+        TIFFClose(image);
+    }
+
+private:
+    QString m_filename;
+    tdir_t m_directory;
+    KisTIFFChunkDecoder::Layout m_layout;
+    KisTIFFReaderBase *m_tiffReader;
+    QAtomicInt *m_failed;
+};
+
+bool readChunksInParallel(const QString &filename, TIFF *image,
+                          const KisTIFFChunkDecoder::Layout &layout,
+                          KisTIFFReaderBase *tiffReader)
+{
+    const int numChunks = layout.numChunks();
+    const int numJobs = qMin(numChunks, QThread::idealThreadCount());
+
+    if (filename.isEmpty() || numJobs < 2) return false;
+
+    // every job gets a consequent range of chunks to keep the reads local
+    QVector<KisTIFFChunkRange> ranges;
+    for (int i = 0; i < numJobs; i++) {
+        ranges << KisTIFFChunkRange(qint64(numChunks) * i / numJobs, qint64(numChunks) * (i + 1) / numJobs);
+    }
+
+    QAtomicInt failed(0);
+    QtConcurrent::blockingMap(ranges, KisTIFFParallelChunkReader(filename, TIFFCurrentDirectory(image), layout, tiffReader, &failed));
+
+    return !failed.load();
+}
 }
 
 KisPropertiesConfigurationSP KisTIFFOptions::toProperties() const
@@ -189,6 +430,7 @@ KisPropertiesConfigurationSP KisTIFFOptions::toProperties() const
     cfg->setProperty("faxmode", faxMode - 1);
     cfg->setProperty("pixarlog", pixarLogCompress);
     cfg->setProperty("saveProfile", saveProfile);
+    cfg->setProperty("tiled", tiled);
 
     return cfg;
 }
@@ -219,6 +461,7 @@ void KisTIFFOptions::fromProperties(KisPropertiesConfigurationSP cfg)
     faxMode = cfg->getInt("faxmode", 0) + 1;
     pixarLogCompress = cfg->getInt("pixarlog", 6);
     saveProfile = cfg->getBool("saveProfile", true);
+    tiled = cfg->getBool("tiled", false);
 }
 
 
@@ -246,7 +489,7 @@ KisImageBuilder_Result KisTIFFConverter::decode(const QString &filename)
     }
     do {
         dbgFile << "Read new sub-image";
-        KisImageBuilder_Result result = readTIFFDirectory(image);
+        KisImageBuilder_Result result = readTIFFDirectory(image, filename);
         if (result != KisImageBuilder_RESULT_OK) {
             return result;
         }
@@ -256,7 +499,7 @@ KisImageBuilder_Result KisTIFFConverter::decode(const QString &filename)
     return KisImageBuilder_RESULT_OK;
 }
 
-KisImageBuilder_Result KisTIFFConverter::readTIFFDirectory(TIFF* image)
+KisImageBuilder_Result KisTIFFConverter::readTIFFDirectory(TIFF* image, const QString &filename)
 {
     // Read information about the tiff
     uint32 width, height;
@@ -440,9 +683,6 @@ KisImageBuilder_Result KisTIFFConverter::readTIFFDirectory(TIFF* image)
         }
     }
     KisPaintLayer* layer = new KisPaintLayer(m_image.data(), m_image -> nextLayerName(), quint8_MAX);
-    tdata_t buf = 0;
-    tdata_t* ps_buf = 0; // used only for planar configuration separated
-    KisBufferStreamBase* tiffstream;
 
     KisTIFFReaderBase* tiffReader = 0;
 
@@ -559,123 +799,64 @@ KisImageBuilder_Result KisTIFFConverter::readTIFFDirectory(TIFF* image)
         return KisImageBuilder_RESULT_INVALID_ARG;
     }
 
+    KisTIFFChunkDecoder::Layout layout;
+    layout.planarconfig = planarconfig;
+    layout.nbchannels = nbchannels;
+    layout.depth = depth;
+    layout.width = width;
+    layout.height = height;
+    layout.vsubsampling = vsubsampling;
+    for (uint i = 0; i < nbchannels; i++) {
+        layout.lineSizeCoeffs << lineSizeCoeffs[i];
+    }
+
     if (TIFFIsTiled(image)) {
         dbgFile << "tiled image";
-        uint32 tileWidth, tileHeight;
-        uint32 x, y;
-        TIFFGetField(image, TIFFTAG_TILEWIDTH, &tileWidth);
-        TIFFGetField(image, TIFFTAG_TILELENGTH, &tileHeight);
-        uint32 linewidth = (tileWidth * depth * nbchannels) / 8;
-        if (planarconfig == PLANARCONFIG_CONTIG) {
-            buf = _TIFFmalloc(TIFFTileSize(image));
-            if (depth < 16) {
-                tiffstream = new KisBufferStreamContigBelow16((uint8*)buf, depth, linewidth);
-            }
-            else if (depth < 32) {
-                tiffstream = new KisBufferStreamContigBelow32((uint8*)buf, depth, linewidth);
-            }
-            else {
-                tiffstream = new KisBufferStreamContigAbove32((uint8*)buf, depth, linewidth);
-            }
-        }
-        else {
-            ps_buf = new tdata_t[nbchannels];
-            uint32 * lineSizes = new uint32[nbchannels];
-            tmsize_t baseSize = TIFFTileSize(image) / nbchannels;
-            for (uint i = 0; i < nbchannels; i++) {
-                ps_buf[i] = _TIFFmalloc(baseSize);
-                lineSizes[i] = tileWidth; // baseSize / lineSizeCoeffs[i];
-            }
-            tiffstream = new KisBufferStreamSeperate((uint8**) ps_buf, nbchannels, depth, lineSizes);
-            delete [] lineSizes;
-        }
-        dbgFile << linewidth << "" << nbchannels << "" << layer->paintDevice()->colorSpace()->colorChannelCount();
-        for (y = 0; y < height; y += tileHeight) {
-            for (x = 0; x < width; x += tileWidth) {
-                dbgFile << "Reading tile x =" << x << " y =" << y;
-                if (planarconfig == PLANARCONFIG_CONTIG) {
-                    TIFFReadTile(image, buf, x, y, 0, (tsample_t) - 1);
-                }
-                else {
-                    for (uint i = 0; i < nbchannels; i++) {
-                        TIFFReadTile(image, ps_buf[i], x, y, 0, i);
-                    }
-                }
-                uint32 realTileWidth = (x + tileWidth) < width ? tileWidth : width - x;
-                for (uint yintile = 0; y + yintile < height && yintile < tileHeight / vsubsampling;) {
-                    tiffReader->copyDataToChannels(x, y + yintile , realTileWidth, tiffstream);
-                    yintile += 1;
-                    tiffstream->moveToLine(yintile);
-                }
-                tiffstream->restart();
-            }
-        }
+        layout.tiled = true;
+        TIFFGetField(image, TIFFTAG_TILEWIDTH, &layout.tileWidth);
+        TIFFGetField(image, TIFFTAG_TILELENGTH, &layout.tileHeight);
+        dbgFile << (layout.tileWidth * depth * nbchannels) / 8 << "" << nbchannels << "" << layer->paintDevice()->colorSpace()->colorChannelCount();
     }
     else {
         dbgFile << "striped image";
-        tsize_t stripsize = TIFFStripSize(image);
         uint32 rowsPerStrip;
         TIFFGetFieldDefaulted(image, TIFFTAG_ROWSPERSTRIP, &rowsPerStrip);
         dbgFile << rowsPerStrip << "" << height;
         rowsPerStrip = qMin(rowsPerStrip, height); // when TIFFNumberOfStrips(image) == 1 it might happen that rowsPerStrip is incorrectly set
-        if (planarconfig == PLANARCONFIG_CONTIG) {
-            buf = _TIFFmalloc(stripsize);
-            if (depth < 16) {
-                tiffstream = new KisBufferStreamContigBelow16((uint8*)buf, depth, stripsize / rowsPerStrip);
-            }
-            else if (depth < 32) {
-                tiffstream = new KisBufferStreamContigBelow32((uint8*)buf, depth, stripsize / rowsPerStrip);
-            }
-            else {
-                tiffstream = new KisBufferStreamContigAbove32((uint8*)buf, depth, stripsize / rowsPerStrip);
-            }
-        }
-        else {
-            ps_buf = new tdata_t[nbchannels];
-            uint32 scanLineSize = stripsize / rowsPerStrip;
-            dbgFile << " scanLineSize for each plan =" << scanLineSize;
-            uint32 * lineSizes = new uint32[nbchannels];
-            for (uint i = 0; i < nbchannels; i++) {
-                ps_buf[i] = _TIFFmalloc(stripsize);
-                lineSizes[i] = scanLineSize / lineSizeCoeffs[i];
-            }
-            tiffstream = new KisBufferStreamSeperate((uint8**) ps_buf, nbchannels, depth, lineSizes);
-            delete [] lineSizes;
-        }
-
-        dbgFile << "Scanline size =" << TIFFRasterScanlineSize(image) << " / strip size =" << TIFFStripSize(image) << " / rowsPerStrip =" << rowsPerStrip << " stripsize/rowsPerStrip =" << stripsize / rowsPerStrip;
-        uint32 y = 0;
-        dbgFile << " NbOfStrips =" << TIFFNumberOfStrips(image) << " rowsPerStrip =" << rowsPerStrip << " stripsize =" << stripsize;
-        for (uint32 strip = 0; y < height; strip++) {
-            if (planarconfig == PLANARCONFIG_CONTIG) {
-                TIFFReadEncodedStrip(image, TIFFComputeStrip(image, y, 0) , buf, (tsize_t) - 1);
-            }
-            else {
-                for (uint i = 0; i < nbchannels; i++) {
-                    TIFFReadEncodedStrip(image, TIFFComputeStrip(image, y, i), ps_buf[i], (tsize_t) - 1);
+        layout.rowsPerStrip = rowsPerStrip;
+        dbgFile << "Scanline size =" << TIFFRasterScanlineSize(image) << " / strip size =" << TIFFStripSize(image) << " / rowsPerStrip =" << rowsPerStrip << " stripsize/rowsPerStrip =" << TIFFStripSize(image) / rowsPerStrip;
+        dbgFile << " NbOfStrips =" << TIFFNumberOfStrips(image) << " rowsPerStrip =" << rowsPerStrip << " stripsize =" << TIFFStripSize(image);
+    }
+
+    /**
+     * The readers write into the paint device only, so the chunks can be
+     * decoded by several threads. The exceptions are the YCbCr reader,
+     * which buffers the data until finalize(), and the profile conversion
+     * transform, which is not reentrant.
+     */
+    const bool canReadInParallel =
+        color_type != PHOTOMETRIC_YCBCR && !transform &&
+        (layout.tiled ? layout.tileWidth > 0 && layout.tileHeight > 0 : layout.rowsPerStrip > 0);
+
+    if (!canReadInParallel || !readChunksInParallel(filename, image, layout, tiffReader)) {
+        KisTIFFChunkDecoder decoder(image, layout, tiffReader);
+
+        if (layout.tiled) {
+            for (uint32 y = 0; y < height; y += layout.tileHeight) {
+                for (uint32 x = 0; x < width; x += layout.tileWidth) {
+                    decoder.readTile(x, y);
                 }
             }
-            for (uint32 yinstrip = 0 ; yinstrip < rowsPerStrip && y < height ;) {
-                uint linesread = tiffReader->copyDataToChannels(0, y, width, tiffstream);
-                y += linesread;
-                yinstrip += linesread;
-                tiffstream->moveToLine(yinstrip);
+        } else {
+            for (uint32 y = 0; y < height;) {
+                y = decoder.readStrip(y);
             }
-            tiffstream->restart();
         }
     }
+
     tiffReader->finalize();
     delete[] lineSizeCoeffs;
     delete tiffReader;
-    delete tiffstream;
-    if (planarconfig == PLANARCONFIG_CONTIG) {
-        _TIFFfree(buf);
-    } else {
-        for (uint i = 0; i < nbchannels; i++) {
-            _TIFFfree(ps_buf[i]);
-        }
-        delete[] ps_buf;
-    }
 
     m_image->addNode(KisNodeSP(layer), m_image->rootLayer().data());
     return KisImageBuilder_RESULT_OK;
@@ -41,6 +41,7 @@ struct KisTIFFOptions {
     quint16 faxMode = 1;
     quint16 pixarLogCompress = 6;
     bool saveProfile = true;
+    bool tiled = false;
 
     KisPropertiesConfigurationSP toProperties() const;
     void fromProperties(KisPropertiesConfigurationSP cfg);
@@ -62,7 +63,7 @@ public Q_SLOTS:
     virtual void cancel();
 private:
     KisImageBuilder_Result decode(const QString &filename);
-    KisImageBuilder_Result readTIFFDirectory(TIFF* image);
+    KisImageBuilder_Result readTIFFDirectory(TIFF* image, const QString &filename);
 private:
     KisImageSP m_image;
     KisDocument *m_doc;
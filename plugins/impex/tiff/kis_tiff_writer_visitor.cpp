@@ -23,6 +23,9 @@
 #include <KoColorSpace.h>
 #include <KoID.h>
 
+#include <QThread>
+#include <QtConcurrentMap>
+
 #include <KoConfig.h>
 #ifdef HAVE_OPENEXR
 #include <half.h>
@@ -58,8 +61,244 @@ namespace
         return false;
 
     }
+
+    bool samplePoses(uint16 color_type, uint16 sample_format, quint8 *poses, uint8 &nbcolorssamples)
+    {
+        switch (color_type) {
+        case PHOTOMETRIC_MINISBLACK:
+            poses[0] = 0; poses[1] = 1;
+            nbcolorssamples = 1;
+            return true;
+        case PHOTOMETRIC_RGB:
+            if (sample_format == SAMPLEFORMAT_IEEEFP) {
+                poses[2] = 2; poses[1] = 1; poses[0] = 0; poses[3] = 3;
+            } else {
+                poses[0] = 2; poses[1] = 1; poses[2] = 0; poses[3] = 3;
+            }
+            nbcolorssamples = 3;
+            return true;
+        case PHOTOMETRIC_SEPARATED:
+            poses[0] = 0; poses[1] = 1; poses[2] = 2; poses[3] = 3; poses[4] = 4;
+            nbcolorssamples = 4;
+            return true;
+        case PHOTOMETRIC_ICCLAB:
+            poses[0] = 0; poses[1] = 1; poses[2] = 2; poses[3] = 3;
+            nbcolorssamples = 3;
+            return true;
+        }
+        return false;
+    }
+
+#if TIFFLIB_VERSION < 20111221
+    typedef uint32 tiff_offset_t;
+#else
+    typedef uint64 tiff_offset_t;
+#endif
+
+    /**
+     * The size of the tiles of tiled TIFF files, which is a multiple of the
+     * size of the tiles of the paint devices
+     */
+    const uint32 tiffTileSize = 256;
+
+    /**
+     * libtiff compresses the data in the thread calling TIFFWrite*(), and the
+     * calls on a single handle cannot run in parallel. So every tile is
+     * encoded in a TIFF file in memory with the same settings. The
+     * encoded bytes are then appended to the real file with TIFFWriteRawTile().
+     * This works only for codecs which do not share any state between the
+     * tiles, e.g. JPEG tables are stored in the directory of the file.
+     */
+    bool canEncodeTilesInParallel(uint16 compression)
+    {
+        return compression == COMPRESSION_LZW ||
+               compression == COMPRESSION_DEFLATE ||
+               compression == COMPRESSION_ADOBE_DEFLATE ||
+               compression == COMPRESSION_PACKBITS;
+    }
+
+    struct MemoryTiffFile {
+        QByteArray data;
+        qint64 pos = 0;
+    };
+
+    tsize_t memoryTiffRead(thandle_t handle, tdata_t buf, tsize_t size)
+    {
+        MemoryTiffFile *file = reinterpret_cast<MemoryTiffFile*>(handle);
+        const qint64 bytesRead = qBound(qint64(0), qint64(file->data.size()) - file->pos, qint64(size));
+        memcpy(buf, file->data.constData() + file->pos, bytesRead);
+        file->pos += bytesRead;
+        return bytesRead;
+    }
+
+    tsize_t memoryTiffWrite(thandle_t handle, tdata_t buf, tsize_t size)
+    {
+        MemoryTiffFile *file = reinterpret_cast<MemoryTiffFile*>(handle);
+        if (file->pos + size > file->data.size()) {
+            file->data.resize(file->pos + size);
+        }
+        memcpy(file->data.data() + file->pos, buf, size);
+        file->pos += size;
+        return size;
+    }
+
+    toff_t memoryTiffSeek(thandle_t handle, toff_t offset, int whence)
+    {
+        MemoryTiffFile *file = reinterpret_cast<MemoryTiffFile*>(handle);
+        switch (whence) {
+        case SEEK_SET:
+            file->pos = offset;
+            break;
+        case SEEK_CUR:
+            file->pos += offset;
+            break;
+        case SEEK_END:
+            file->pos = file->data.size() + offset;
+            break;
+        }
+        return file->pos;
+    }
+
+    int memoryTiffClose(thandle_t)
+    {
+        return 0;
+    }
+
+    toff_t memoryTiffSize(thandle_t handle)
+    {
+        return reinterpret_cast<MemoryTiffFile*>(handle)->data.size();
+    }
+
+    int memoryTiffMap(thandle_t, tdata_t*, toff_t*)
+    {
+        return 0;
+    }
+
+    void memoryTiffUnmap(thandle_t, tdata_t, toff_t)
+    {
+    }
 }
 
+struct KisTIFFWriterVisitor::TileCodec {
+    uint16 depth = 8;
+    uint16 samplesPerPixel = 0;
+    bool alpha = false;
+    uint16 colorType = PHOTOMETRIC_RGB;
+    uint16 sampleFormat = SAMPLEFORMAT_UINT;
+    uint16 compression = COMPRESSION_NONE;
+    uint16 predictor = 1;
+    int zipQuality = 6;
+    bool encodeInParallel = false;
+
+    /**
+     * Compresses a single tile by writing it into a one-tile TIFF file in
+     * memory. The pixels in \\p tile may be modified by the predictor.
+     * @return the compressed bytes of the tile, or an empty array on failure
+     */
+    QByteArray encodeTile(QByteArray &tile) const {
+        MemoryTiffFile file;
+
+        TIFF *image = TIFFClientOpen("tile", "w", reinterpret_cast<thandle_t>(&file),
+                                     memoryTiffRead, memoryTiffWrite, memoryTiffSeek, memoryTiffClose,
+                                     memoryTiffSize, memoryTiffMap, memoryTiffUnmap);
+        if (!image) return QByteArray();
+
+        TIFFSetField(image, TIFFTAG_IMAGEWIDTH, tiffTileSize);
+        TIFFSetField(image, TIFFTAG_IMAGELENGTH, tiffTileSize);
+        TIFFSetField(image, TIFFTAG_TILEWIDTH, tiffTileSize);
+        TIFFSetField(image, TIFFTAG_TILELENGTH, tiffTileSize);
+        TIFFSetField(image, TIFFTAG_BITSPERSAMPLE, depth);
+        TIFFSetField(image, TIFFTAG_SAMPLESPERPIXEL, samplesPerPixel);
+        if (alpha) {
+            uint16 sampleinfo[1] = { EXTRASAMPLE_UNASSALPHA };
+            TIFFSetField(image, TIFFTAG_EXTRASAMPLES, 1, sampleinfo);
+        }
+        TIFFSetField(image, TIFFTAG_PHOTOMETRIC, colorType);
+        TIFFSetField(image, TIFFTAG_SAMPLEFORMAT, sampleFormat);
+        TIFFSetField(image, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+        TIFFSetField(image, TIFFTAG_COMPRESSION, compression);
+        if (compression == COMPRESSION_DEFLATE || compression == COMPRESSION_ADOBE_DEFLATE) {
+            TIFFSetField(image, TIFFTAG_ZIPQUALITY, zipQuality);
+        }
+        TIFFSetField(image, TIFFTAG_PREDICTOR, predictor);
+
+        QByteArray result;
+
+        if (TIFFWriteEncodedTile(image, 0, tile.data(), tile.size()) >= 0) {
+            tiff_offset_t *offsets = 0;
+            tiff_offset_t *byteCounts = 0;
+
+            if (TIFFGetField(image, TIFFTAG_TILEOFFSETS, &offsets) &&
+                TIFFGetField(image, TIFFTAG_TILEBYTECOUNTS, &byteCounts) &&
+                offsets && byteCounts &&
+                offsets[0] + byteCounts[0] <= tiff_offset_t(file.data.size())) {
+
+                result = file.data.mid(offsets[0], byteCounts[0]);
+            }
+        }
+
+        TIFFClose(image);
+        return result;
+    }
+};
+
+struct KisTIFFWriterVisitor::TileJob {
+    TileJob() : x(0), y(0) {}
+    TileJob(int _x, int _y) : x(_x), y(_y) {}
+
+    int x;
+    int y;
+    QByteArray data;
+};
+
+/**
+ * Copies the pixels of a tile from the paint device and, if possible,
+ * compresses them. Runs in the global thread pool.
+ */
+struct KisTIFFWriterVisitor::TileEncoder {
+    TileEncoder(KisTIFFWriterVisitor *visitor, KisPaintDeviceSP pd, const QRect &bounds,
+                const TileCodec &codec, tsize_t tileSize, tsize_t tileRowSize,
+                uint8 nbcolorssamples, quint8 *poses)
+        : m_visitor(visitor),
+          m_pd(pd),
+          m_bounds(bounds),
+          m_codec(codec),
+          m_tileSize(tileSize),
+          m_tileRowSize(tileRowSize),
+          m_nbcolorssamples(nbcolorssamples),
+          m_poses(poses)
+    {
+    }
+
+    void operator()(TileJob &job) const {
+        // the pixels outside the image are stored as zeros
+        QByteArray tile(m_tileSize, 0);
+
+        const QRect rc = QRect(job.x, job.y, tiffTileSize, tiffTileSize) & m_bounds;
+
+        for (int row = 0; row < rc.height(); row++) {
+            KisHLineConstIteratorSP it = m_pd->createHLineConstIteratorNG(rc.x(), rc.y() + row, rc.width());
+            if (!m_visitor->copyDataToStrips(it, tile.data() + row * m_tileRowSize,
+                                             m_codec.depth, m_codec.sampleFormat,
+                                             m_nbcolorssamples, m_poses)) {
+                return;
+            }
+        }
+
+        job.data = m_codec.encodeInParallel ? m_codec.encodeTile(tile) : tile;
+    }
+
+private:
+    KisTIFFWriterVisitor *m_visitor;
+    KisPaintDeviceSP m_pd;
+    QRect m_bounds;
+    const TileCodec &m_codec;
+    tsize_t m_tileSize;
+    tsize_t m_tileRowSize;
+    uint8 m_nbcolorssamples;
+    quint8 *m_poses;
+};
+
 KisTIFFWriterVisitor::KisTIFFWriterVisitor(TIFF*image, KisTIFFOptions* options)
     : m_image(image)
     , m_options(options)
@@ -170,8 +409,13 @@ bool KisTIFFWriterVisitor::saveLayerProjection(KisLayer *layer)
 
     // Use contiguous configuration
     TIFFSetField(image(), TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
-    // Use 8 rows per strip
-    TIFFSetField(image(), TIFFTAG_ROWSPERSTRIP, 8);
+    if (m_options->tiled) {
+        TIFFSetField(image(), TIFFTAG_TILEWIDTH, tiffTileSize);
+        TIFFSetField(image(), TIFFTAG_TILELENGTH, tiffTileSize);
+    } else {
+        // Use 8 rows per strip
+        TIFFSetField(image(), TIFFTAG_ROWSPERSTRIP, 8);
+    }
 
     // Save profile
     if (m_options->saveProfile) {
@@ -181,41 +425,42 @@ bool KisTIFFWriterVisitor::saveLayerProjection(KisLayer *layer)
             TIFFSetField(image(), TIFFTAG_ICCPROFILE, ba.size(), ba.constData());
         }
     }
-    tsize_t stripsize = TIFFStripSize(image());
-    tdata_t buff = _TIFFmalloc(stripsize);
+
+    quint8 poses[5];
+    uint8 nbcolorssamples = 0;
+    if (!samplePoses(color_type, sample_format, poses, nbcolorssamples)) {
+        return false;
+    }
+
     qint32 height = layer->image()->height();
     qint32 width = layer->image()->width();
+
+    if (m_options->tiled) {
+        TileCodec codec;
+        codec.depth = depth;
+        codec.samplesPerPixel = m_options->alpha ? pd->channelCount() : pd->channelCount() - 1;
+        codec.alpha = m_options->alpha;
+        codec.colorType = color_type;
+        codec.sampleFormat = sample_format;
+        codec.compression = m_options->compressionType;
+        codec.predictor = m_options->predictor;
+        codec.zipQuality = m_options->deflateCompress;
+        codec.encodeInParallel = canEncodeTilesInParallel(m_options->compressionType);
+
+        if (!saveTiles(pd, QRect(0, 0, width, height), codec, nbcolorssamples, poses)) {
+            return false;
+        }
+
+        TIFFWriteDirectory(image());
+        return true;
+    }
+
+    tsize_t stripsize = TIFFStripSize(image());
+    tdata_t buff = _TIFFmalloc(stripsize);
     bool r = true;
     for (int y = 0; y < height; y++) {
         KisHLineConstIteratorSP it = pd->createHLineConstIteratorNG(0, y, width);
-        switch (color_type) {
-        case PHOTOMETRIC_MINISBLACK: {
-                quint8 poses[] = { 0, 1 };
-                r = copyDataToStrips(it, buff, depth, sample_format, 1, poses);
-            }
-            break;
-        case PHOTOMETRIC_RGB: {
-                quint8 poses[4];
-                if (sample_format == SAMPLEFORMAT_IEEEFP) {
-                    poses[2] = 2; poses[1] = 1; poses[0] = 0; poses[3] = 3;
-                } else {
-                    poses[0] = 2; poses[1] = 1; poses[2] = 0; poses[3] = 3;
-                }
-                r = copyDataToStrips(it, buff, depth, sample_format, 3, poses);
-            }
-            break;
-        case PHOTOMETRIC_SEPARATED: {
-                quint8 poses[] = { 0, 1, 2, 3, 4 };
-                r = copyDataToStrips(it, buff, depth, sample_format, 4, poses);
-            }
-            break;
-        case PHOTOMETRIC_ICCLAB: {
-                quint8 poses[] = { 0, 1, 2, 3 };
-                r = copyDataToStrips(it, buff, depth, sample_format, 3, poses);
-            }
-            break;
-            return false;
-        }
+        r = copyDataToStrips(it, buff, depth, sample_format, nbcolorssamples, poses);
         if (!r) return false;
         TIFFWriteScanline(image(), buff, y, (tsample_t) - 1);
     }
@@ -223,3 +468,39 @@ bool KisTIFFWriterVisitor::saveLayerProjection(KisLayer *layer)
     TIFFWriteDirectory(image());
     return true;
 }
+
+bool KisTIFFWriterVisitor::saveTiles(KisPaintDeviceSP pd, const QRect &bounds, const TileCodec &codec, uint8 nbcolorssamples, quint8* poses)
+{
+    const tsize_t tileSize = TIFFTileSize(image());
+    const tsize_t tileRowSize = TIFFTileRowSize(image());
+
+    QVector<TileJob> jobs;
+    for (int y = 0; y < bounds.height(); y += tiffTileSize) {
+        for (int x = 0; x < bounds.width(); x += tiffTileSize) {
+            jobs << TileJob(x, y);
+        }
+    }
+
+    // the tiles are encoded in batches to limit the memory
+    // taken by the tiles waiting for writing
+    const int batchSize = 4 * QThread::idealThreadCount();
+
+    for (int i = 0; i < jobs.size(); i += batchSize) {
+        QVector<TileJob> batch = jobs.mid(i, batchSize);
+        QtConcurrent::blockingMap(batch, TileEncoder(this, pd, bounds, codec, tileSize, tileRowSize, nbcolorssamples, poses));
+
+        for (int j = 0; j < batch.size(); j++) {
+            TileJob &job = batch[j];
+            if (job.data.isEmpty()) return false;
+
+            const ttile_t tile = TIFFComputeTile(image(), job.x, job.y, 0, 0);
+            const tsize_t written = codec.encodeInParallel ?
+                TIFFWriteRawTile(image(), tile, job.data.data(), job.data.size()) :
+                TIFFWriteEncodedTile(image(), tile, job.data.data(), job.data.size());
+
+            if (written < 0) return false;
+        }
+    }
+
+    return true;
+}
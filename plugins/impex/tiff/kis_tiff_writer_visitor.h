@@ -111,6 +111,11 @@ private:
     }
     bool copyDataToStrips(KisHLineConstIteratorSP it, tdata_t buff, uint8 depth, uint16 sample_format, uint8 nbcolorssamples, quint8* poses);
     bool saveLayerProjection(KisLayer *);
+
+    struct TileCodec;
+    struct TileJob;
+    struct TileEncoder;
+    bool saveTiles(KisPaintDeviceSP pd, const QRect &bounds, const TileCodec &codec, uint8 nbcolorssamples, quint8* poses);
 private:
     TIFF* m_image;
     KisTIFFOptions* m_options;
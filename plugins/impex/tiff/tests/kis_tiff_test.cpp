@@ -26,6 +26,9 @@
 
 #include <KoColorModelStandardIds.h>
 #include <KoColor.h>
+#include <KoColorSpaceRegistry.h>
+
+#include "kis_properties_configuration.h"
 
 #include "kisexiv2/kis_exiv2.h"
 #include  <sdk/tests/kistest.h>
@@ -115,5 +118,28 @@ void KisTiffTest::testRoundTripRGBF16()
 #endif
 }
 
+void KisTiffTest::testRoundTripTiled()
+{
+    // deflate with horizontal differencing is compressed in the thread pool
+    KisPropertiesConfigurationSP cfg = new KisPropertiesConfiguration();
+    cfg->setProperty("compressiontype", 2);
+    cfg->setProperty("predictor", 1);
+    cfg->setProperty("tiled", true);
+
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+
+    // the tiles are 256x256, so the right and bottom edge tiles are partial
+    TestUtil::testRoundTrip("test_tiled.tif", "image/tiff", cfg, QRect(0, 0, 700, 500), cs);
+
+    // no partial tiles at all
+    TestUtil::testRoundTrip("test_tiled.tif", "image/tiff", cfg, QRect(0, 0, 512, 256), cs);
+
+    // the only tile of the image is partial
+    TestUtil::testRoundTrip("test_tiled.tif", "image/tiff", cfg, QRect(0, 0, 100, 60), cs);
+
+    // the edge tiles are only one pixel wide or high
+    TestUtil::testRoundTrip("test_tiled.tif", "image/tiff", cfg, QRect(0, 0, 257, 257), cs);
+}
+
 KISTEST_MAIN(KisTiffTest)
 
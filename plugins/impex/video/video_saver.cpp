@@ -45,6 +45,10 @@
 #include <QTime>
 
 #include "KisPart.h"
+#include "kis_image_config.h"
+#include "KisAnimationFramesStream.h"
+#include "KisAsyncAnimationFramesStreamingRenderer.h"
+#include "dialogs/KisAsyncAnimationFramesStreamDialog.h"
 
 class KisFFMpegProgressWatcher : public QObject {
     Q_OBJECT
@@ -268,6 +272,9 @@ KisImageBuilder_Result VideoSaver::encode(const QString &filename, KisProperties
 
     const QStringList additionalOptionsList = configuration->getString("customUserOptions").split(' ', QString::SkipEmptyParts);
 
+    // gif needs two passes over the frames, so it is always encoded from the saved sequence
+    const bool streamFrames = configuration->getBool("stream_frames", false) && suffix != "gif";
+
     if (suffix == "gif") {
         {
             QStringList args;
@@ -316,10 +323,18 @@ KisImageBuilder_Result VideoSaver::encode(const QString &filename, KisProperties
         }
     } else {
         QStringList args;
-        args << "-r" << QString::number(frameRate)
-             << "-start_number" << QString::number(clipRange.start())
-             << "-i" << savedFilesMask;
 
+        if (streamFrames) {
+            args << "-f" << "rawvideo"
+                 << "-pix_fmt" << KisAsyncAnimationFramesStreamingRenderer::pixelFormat()
+                 << "-s" << QString("%1x%2").arg(m_image->width()).arg(m_image->height())
+                 << "-r" << QString::number(frameRate)
+                 << "-i" << "-";
+        } else {
+            args << "-r" << QString::number(frameRate)
+                 << "-start_number" << QString::number(clipRange.start())
+                 << "-i" << savedFilesMask;
+        }
 
 
         QFileInfo audioFileInfo = animation->audioChannelFileName();
@@ -349,14 +364,57 @@ KisImageBuilder_Result VideoSaver::encode(const QString &filename, KisProperties
              << "-y" << resultFile;
 
 
-        result = m_runner->runFFMpeg(args, i18n("Encoding frames..."),
-                                     framesDir.filePath("log_encode.log"),
-                                     clipRange.duration());
+        if (streamFrames) {
+            const KisTimeRange renderRange =
+                KisTimeRange::fromTime(configuration->getInt("first_frame", fullRange.start()),
+                                       configuration->getInt("last_frame", fullRange.end()));
+
+            result = encodeStreaming(args, framesDir.filePath("log_encode.log"), renderRange);
+        } else {
+            result = m_runner->runFFMpeg(args, i18n("Encoding frames..."),
+                                         framesDir.filePath("log_encode.log"),
+                                         clipRange.duration());
+        }
     }
 
     return result;
 }
 
+KisImageBuilder_Result VideoSaver::encodeStreaming(const QStringList &specialArgs,
+                                                   const QString &logPath,
+                                                   const KisTimeRange &range)
+{
+    // every pending frame takes the size of the whole uncompressed image
+    const int maxPendingFrames = 2 * qMax(1, KisImageConfig(true).frameRenderingClones());
+
+    KisAnimationFramesStream stream(range, maxPendingFrames);
+
+    QStringList args;
+    args << "-v" << "debug"
+         << specialArgs;
+
+    qDebug() << "\t" << m_ffmpegPath << args.join(" ");
+
+    if (!stream.start(m_ffmpegPath, args, logPath)) {
+        return KisImageBuilder_RESULT_FAILURE;
+    }
+
+    KisAsyncAnimationFramesStreamDialog dlg(m_image, range, &stream);
+    dlg.setBatchMode(m_batchMode);
+
+    const KisAsyncAnimationFramesStreamDialog::Result renderResult = dlg.regenerateRange(0);
+
+    if (renderResult != KisAsyncAnimationFramesStreamDialog::RenderComplete) {
+        stream.cancel();
+        stream.finish();
+
+        return renderResult == KisAsyncAnimationFramesStreamDialog::RenderCancelled ?
+            KisImageBuilder_RESULT_CANCEL : KisImageBuilder_RESULT_FAILURE;
+    }
+
+    return stream.finish() ? KisImageBuilder_RESULT_OK : KisImageBuilder_RESULT_FAILURE;
+}
+
 void VideoSaver::cancel()
 {
     m_runner->cancel();
@@ -29,6 +29,7 @@
 #include "kritavideoexport_export.h"
 
 class KisFFMpegRunner;
+class KisTimeRange;
 
 /* The KisImageBuilder_Result definitions come from kis_png_converter.h here */
 
@@ -49,6 +50,15 @@ public:
 private Q_SLOTS:
     void cancel();
 
+private:
+    /**
+     * Renders the frames of \p range and pipes them directly into the
+     * standard input of ffmpeg, without saving them to disk
+     */
+    KisImageBuilder_Result encodeStreaming(const QStringList &specialArgs,
+                                           const QString &logPath,
+                                           const KisTimeRange &range);
+
 private:
     KisImageSP m_image;
     KisDocument* m_doc;
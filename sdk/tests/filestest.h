@@ -34,6 +34,9 @@
 #include <KoColorSpace.h>
 #include <KoColorSpaceRegistry.h>
 #include <KisPart.h>
+#include <kis_paint_layer.h>
+#include <kis_iterator_ng.h>
+#include <kis_properties_configuration.h>
 
 #include <QTemporaryFile>
 #include <QFileInfo>
@@ -115,5 +118,54 @@ void testFiles(const QString& _dirname, const QStringList& exclusions, const QSt
     QFAIL("Failed testing files");
 }
 
+/**
+ * Saves an image of \p imageRect size in \p cs color space into \p fileName
+ * with \p mimeType and \p exportConfiguration, loads it back and checks that
+ * the pixels are preserved. The pattern changes with every row and column,
+ * so a tile or a band written into a wrong place is detected.
+ */
+void testRoundTrip(const QString &fileName, const QByteArray &mimeType,
+                   KisPropertiesConfigurationSP exportConfiguration,
+                   const QRect &imageRect, const KoColorSpace *cs)
+{
+    KisImageSP image = new KisImage(0, imageRect.width(), imageRect.height(), cs, "round trip");
+    KisPaintLayerSP layer = new KisPaintLayer(image, "layer1", OPACITY_OPAQUE_U8, cs);
+
+    KisSequentialIterator it(layer->paintDevice(), imageRect);
+    while (it.nextPixel()) {
+        cs->fromNormalisedChannelsValue(it.rawData(), QVector<float>()
+                                        << quint8(it.x() * 7 + it.y()) / 255.0f
+                                        << quint8(it.y() * 13) / 255.0f
+                                        << quint8((it.x() / 16) * (it.y() / 16)) / 255.0f
+                                        << 1.0f);
+    }
+
+    image->addNode(layer, image->root());
+    image->initialRefreshGraph();
+
+    QScopedPointer<KisDocument> doc(KisPart::instance()->createDocument());
+    doc->setCurrentImage(image);
+    doc->setFileBatchMode(true);
+
+    const QString filePath = QDir::currentPath() + QDir::separator() + fileName;
+    QVERIFY(doc->exportDocumentSync(QUrl::fromLocalFile(filePath), mimeType, exportConfiguration));
+
+    QScopedPointer<KisDocument> doc2(KisPart::instance()->createDocument());
+    doc2->setFileBatchMode(true);
+    QVERIFY(doc2->importDocument(QUrl::fromLocalFile(filePath)));
+    QVERIFY(doc2->image());
+    QCOMPARE(doc2->image()->bounds(), imageRect);
+    QCOMPARE(doc2->image()->colorSpace()->colorDepthId(), cs->colorDepthId());
+
+    QPoint pt;
+    if (!TestUtil::comparePaintDevices(pt, layer->paintDevice(), doc2->image()->root()->firstChild()->paintDevice())) {
+        QFAIL(QString("Round trip of %1x%2 image failed at pixel (%3,%4)")
+              .arg(imageRect.width()).arg(imageRect.height())
+              .arg(pt.x()).arg(pt.y()).toLatin1());
+    }
+
+    QFile::remove(filePath);
+}
+
 }
 #endif